@@ -938,7 +938,7 @@ function module.generate_hpp(prtcl, printer, namespaces, scheme_name)
       o:iput('struct per_thread_data {'):nl()
       o:increase_indent()
 
-      o:iput('std::vector<std::vector<size_t>> neighbors;'):nl()
+      o:iput('std::vector<NeighborList> neighbors;'):nl()
 
       -- TODO: reductions?
 
@@ -23,6 +23,7 @@ hpp_header = [===[
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <vector>
 
@@ -36,7 +37,6 @@ hpp_header = [===[
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 ]===]
 -- }}}
 
@@ -460,6 +460,12 @@ end
 
 -- }}}
 
+-- sums of real scalars are accumulated in (at least) double precision
+local function accumulates_in_double(r, td)
+  return set:new { '+=', '-=' }:contains(r.operator)
+    and td.type.type == 'real' and #td.type.extents == 0
+end
+
 -- {{{ fmt_stmt: foreach_particle
 function fmt_stmt:foreach_particle(o, n)
   local description = 'foreach ' .. n.groups_name .. ' particle ' .. n.index_name
@@ -500,7 +506,11 @@ function fmt_stmt:foreach_particle(o, n)
 
         local name = 'r_' .. field_name(td)
 
-        o:iput(ndtype_t(td.type) .. ' ' .. name)
+        if accumulates_in_double(r, td) then
+          o:iput('Tensor<std::common_type_t<real, double>> ' .. name)
+        else
+          o:iput(ndtype_t(td.type) .. ' ' .. name)
+        end
         o:put(' = ')
         the_fmt_math_expr:dispatch(o, tr)
         o:put(';'):nl()
@@ -528,7 +538,7 @@ function fmt_stmt:foreach_particle(o, n)
   o:iput('{'):nl()
   o:increase_indent()
 
-  o:iput('PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=' .. n.groups_name .. '");'):nl()
+  o:iput('PRTCL_PROFILE_SCOPE("' .. description .. '");'):nl()
   o:nl()
 
   local needs_neighbors = ast.contains_instance(n, ast.foreach_neighbor)
@@ -557,6 +567,9 @@ function fmt_stmt:foreach_particle(o, n)
     omp_for_extra = omp_for_extra .. ' schedule(static)'
   end
 
+  -- the implicit barrier is replaced by a profiled one
+  omp_for_extra = omp_for_extra .. ' nowait'
+
   cxx_pragma(o, 'omp for' .. omp_for_extra)
 
   o:iput('for (size_t i = 0; i < p._count; ++i) {'):nl()
@@ -584,6 +597,9 @@ function fmt_stmt:foreach_particle(o, n)
 
   o:decrease_indent()
   o:iput('}'):nl()
+  o:nl()
+
+  o:iput('PRTCL_PROFILE_BARRIER();'):nl()
 
   o:decrease_indent()
   o:iput('}'):nl()
@@ -610,7 +626,11 @@ function fmt_stmt:foreach_particle(o, n)
 
         o:iput('')
         the_fmt_math_expr:dispatch(o, tr)
-        o:put(' = ' .. name .. ';'):nl()
+        if accumulates_in_double(r, td) then
+          o:put(' = static_cast<real>(' .. name .. ');'):nl()
+        else
+          o:put(' = ' .. name .. ';'):nl()
+        end
       else
         raise_error('cannot reduce into anything but global fields', r)
       end
@@ -997,7 +1017,7 @@ function module.generate(_, prtcl, printer, namespaces, scheme_name)
       o:iput('struct per_thread_data {'):nl()
       o:increase_indent()
 
-      o:iput('std::vector<std::vector<size_t>> neighbors;'):nl()
+      o:iput('std::vector<NeighborList> neighbors;'):nl()
 
       -- TODO: reductions?
 
@@ -40,16 +40,22 @@ def _load_shape(file):
 
 def _load_uniform_field(file):
     name = _load_string(file)
+    return name, _load_uniform_field_data(file)
+
+def _load_uniform_field_data(file):
     ctype = _load_ctype(file)
     shape = _load_shape(file)
     count = np.prod(shape, initial=1, dtype='i')
     array = np.fromfile(file, dtype=ctype, count=count)
     array = np.reshape(array, shape)
 
-    return name, {'ctype': ctype, 'item_shape': shape, 'data': array}
+    return {'ctype': ctype, 'item_shape': shape, 'data': array}
 
 def _load_varying_field(file):
     name = _load_string(file)
+    return name, _load_varying_field_data(file)
+
+def _load_varying_field_data(file):
     ctype = _load_ctype(file)
     shape = _load_shape(file)
     item_count = _load_size(file)
@@ -57,7 +63,7 @@ def _load_varying_field(file):
     array = np.fromfile(file, dtype=ctype, count=total_count)
     array = np.reshape(array, [item_count, *shape])
 
-    return name, {'ctype': ctype, 'item_shape': shape, 'data': array}
+    return {'ctype': ctype, 'item_shape': shape, 'data': array}
 
 
 def _load_group(file):
@@ -111,6 +117,110 @@ def load_model(file):
 
     return model
 
+class FrameArchive:
+    """Random access reader for multi-frame archives (see FrameArchiveWriter).
+
+    The footers of all frames are read when the archive is opened, afterwards
+    every (frame, group, field) chunk is loaded by seeking directly to it.
+    Global fields use the empty string as group name.
+    """
+
+    _MAGIC = b'PRTCLFRA'
+    _VERSION = 1
+
+    _KIND_GLOBAL = 0
+    _KIND_UNIFORM = 1
+    _KIND_VARYING = 2
+
+    def __init__(self, file_name):
+        self._file = open(file_name, 'rb')
+
+        if self._file.read(len(self._MAGIC)) != self._MAGIC:
+            raise ValueError('invalid frame archive')
+        if _load_size(self._file) != self._VERSION:
+            raise ValueError('unsupported frame archive version')
+
+        size_t = ctypes.sizeof(ctypes.c_size_t)
+        self._file.seek(-(2 * size_t + len(self._MAGIC)), 2)
+        footer_offset = _load_size(self._file)
+        frame_count = _load_size(self._file)
+        if self._file.read(len(self._MAGIC)) != self._MAGIC:
+            raise ValueError('invalid frame archive')
+
+        self._frames = [None] * frame_count
+        for frame in reversed(range(frame_count)):
+            self._file.seek(footer_offset)
+            footer_offset = _load_size(self._file)
+
+            groups = {}
+            for group_index in range(_load_size(self._file)):
+                name = _load_string(self._file)
+                type = _load_string(self._file)
+                tags = [_load_string(self._file) for tag_index in range(_load_size(self._file))]
+                item_count = _load_size(self._file)
+                groups[name] = {'type': type, 'tags': tags, 'item_count': item_count}
+
+            fields = {}
+            for field_index in range(_load_size(self._file)):
+                group = _load_string(self._file)
+                field = _load_string(self._file)
+                kind = _load_size(self._file)
+                offset = _load_size(self._file)
+                length = _load_size(self._file)
+                fields[(group, field)] = (kind, offset, length)
+
+            self._frames[frame] = {'groups': groups, 'fields': fields}
+
+    def close(self):
+        self._file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    @property
+    def frame_count(self):
+        return len(self._frames)
+
+    def field_names(self, frame, group):
+        return [f for g, f in self._frames[frame]['fields'] if g == group]
+
+    def load_field(self, frame, group, field):
+        kind, offset, length = self._frames[frame]['fields'][(group, field)]
+        self._file.seek(offset)
+        if kind == self._KIND_VARYING:
+            return _load_varying_field_data(self._file)
+        else:
+            return _load_uniform_field_data(self._file)
+
+    def load_frame(self, frame):
+        """Loads a frame in the same layout as load_model."""
+        index = self._frames[frame]
+
+        model = {
+            'global_fields': {},
+            'groups': {},
+        }
+
+        for name, group in index['groups'].items():
+            model['groups'][name] = {
+                'type': group['type'], 'tags': group['tags'],
+                'varying_fields': {}, 'uniform_fields': {}}
+
+        for (group, field), (kind, offset, length) in index['fields'].items():
+            data = self.load_field(frame, group, field)
+            if kind == self._KIND_GLOBAL:
+                model['global_fields'][field] = data
+            elif kind == self._KIND_UNIFORM:
+                model['groups'][group]['uniform_fields'][field] = data
+            else:
+                model['groups'][group]['varying_fields'][field] = data
+
+        return model
+
+
 def compute_total_momentum(data):
     speed = np.linalg.norm(data['varying_fields']['velocity']['data'], axis=1)
     mass = data['varying_fields']['mass']['data']
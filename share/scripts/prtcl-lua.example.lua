@@ -121,6 +121,9 @@ cfg = {}
 
 model.global:get_field("smoothing_scale"):set(0.025)
 model.global:get_field("time_step"):set(0.001) -- :set(0.002)
+-- adaptive time steps (CFL, force and viscosity limits, aligned to frames)
+--local dt_controller = prtcl.util.time_step_controller.new()
+--dt_controller.max_time_step = 0.002
 model.global:get_field("fade_duration"):set(2 * seconds_per_frame)
 
 model.global:get_field("gravity_center"):set(rvec.new { 0, 0, 0 })
@@ -228,24 +231,17 @@ schedule:schedule_at(0, function(s, delay)
 
 
   local tracer = prtcl.util.sphere_tracer.new(camera)
-  local image = tracer:trace(model)
+  local image = tracer:trace(model, nhood)
   print('IMAGE', image.width, image.height)
 
-  local ppm = io.open('output/image.' .. current_frame .. '.ppm', 'wb')
-  ppm:write("P6\n")
-  ppm:write(tostring(image.width) .. "\n")
-  ppm:write(tostring(image.height) .. "\n")
-  ppm:write("255\n")
-  for iy = 0, image.height - 1, 1 do
-    for ix = 0, image.width - 1, 1 do
-      local gray = math.floor(image:get_pixel(ix, iy) * 255)
-      ppm:write(string.char(gray, gray, gray))
-      --ppm:write(string.char(ix % 256))
-      --ppm:write(string.char(ix % 256))
-      --ppm:write(string.char(ix % 256))
-    end
-  end
-  io.close(ppm)
+  image:save('output/image.' .. current_frame .. '.ppm')
+
+  --[[ surface extraction without a horason group
+  local horas = prtcl.util.horas_engine.new(camera)
+  local parameter, intensity, stats = horas:extract(model, nhood)
+  print('HORAS', stats.marched_rays, stats.interpolated_pixels)
+  intensity:save('output/horas.' .. current_frame .. '.ppm')
+  --]]
 
   --[[
   horasons:resize(0)
@@ -367,6 +363,7 @@ while schedule.clock.seconds <= 10 do
 
   local t = model.global:get_field("current_time")
   t:set(schedule.clock.seconds)
+  --dt_controller:update(model, schedule)
 
   --g_angle = g_angle_vel * t:get()
   --model.global:get_field('gravity'):set(g_base + rvec.new { math.cos(g_angle), 0, math.sin(g_angle) })
@@ -379,8 +376,10 @@ while schedule.clock.seconds <= 10 do
   else
     nhood:update(model)
     if steps_since_permute >= 8 then
-      nhood:permute(model)
-      model.dirty = false
+      -- removed particles leave the model dirty, the schemes are reloaded
+      if not nhood:permute(model) then
+        model.dirty = false
+      end
       steps_since_permute = 0
     end
   end
@@ -458,5 +457,6 @@ while schedule.clock.seconds <= 10 do
   --]]
 
   schedule:get_clock():advance(model.global:get_field("time_step"):get())
+  --dt_controller:advance(schedule) -- instead of the line above
   schedule:tick()
 end
@@ -0,0 +1,45 @@
+local prtcl = require 'prtcl'
+local rvec = prtcl.math.rvec
+
+-- Renders all frames of a simulation into images:
+--
+--   prtcl-lua prtcl-lua.render.lua OUTPUT_PATTERN MODEL...
+--   prtcl-lua prtcl-lua.render.lua OUTPUT_PATTERN --frame-archive PATH
+--
+-- The last run of # in OUTPUT_PATTERN is replaced by the frame index, e.g.
+-- output/image.####.png, the extension selects PNG or PPM.  The frames are
+-- either one native binary model archive each (in order) or all frames of a
+-- frame archive.
+
+local output_pattern = args[3]
+
+local renderer = prtcl.util.batch_renderer.new()
+renderer.threshold = 0.95
+
+local frame_count = #args - 3
+if args[4] == '--frame-archive' then
+  frame_count = prtcl.data.frame_archive_reader.new(args[5]).frame_count
+end
+
+-- [[ camera settings for the rotating cube scene, circling it once
+for key = 0, 4 do
+  local angle = 2 * math.pi * key / 4
+  local camera = prtcl.geometry.pinhole_camera.new()
+  camera.sensor_width, camera.sensor_height = 800, 600
+  camera.focal_length = 1
+  camera.origin = rvec.new { 2.8 * math.sin(angle), 0.7, 2.8 * math.cos(angle) }
+  camera.principal = (-1 / camera.origin:norm()) * camera.origin
+  camera.up = rvec.new { 0, 1, 0 }
+  renderer:add_camera_key(key * frame_count / 4, camera)
+end
+--]]
+
+if args[4] == '--frame-archive' then
+  renderer:render_frame_archive(args[5], output_pattern)
+else
+  local paths = {}
+  for argi = 4, #args do
+    table.insert(paths, args[argi])
+  end
+  renderer:render_native_binary_files(paths, output_pattern)
+end
@@ -241,8 +241,10 @@ while schedule.clock.seconds <= 10 do
   else
     nhood:update(model)
     if steps_since_permute >= 8 then
-      nhood:permute(model)
-      model.dirty = false
+      -- removed particles leave the model dirty, the schemes are reloaded
+      if not nhood:permute(model) then
+        model.dirty = false
+      end
       steps_since_permute = 0
     end
   end
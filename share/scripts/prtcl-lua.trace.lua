@@ -31,19 +31,4 @@ tracer.threshold = 0.95
 local image = tracer:trace(model)
 print('IMAGE', image.width, image.height)
 
-local ppm = io.open(ppm_path, 'wb')
-ppm:write("P6\n")
-ppm:write(tostring(image.width) .. "\n")
-ppm:write(tostring(image.height) .. "\n")
-ppm:write("255\n")
-for iy = 0, image.height - 1, 1 do
-  for ix = 0, image.width - 1, 1 do
-    local gray = math.floor(image:get_pixel(ix, iy) * 255)
-    ppm:write(string.char(gray, gray, gray))
-    --ppm:write(string.char(ix % 256))
-    --ppm:write(string.char(ix % 256))
-    --ppm:write(string.char(ix % 256))
-  end
-end
-io.close(ppm)
-
+image:save(ppm_path)
@@ -0,0 +1,67 @@
+#include "common.hpp"
+
+#include <prtcl/util/archive.hpp>
+
+#include <sstream>
+#include <string>
+
+namespace prtcl::bench {
+
+namespace {
+
+void BenchmarkSave(benchmark::State &state) {
+  auto const model = MakeBlockModel(static_cast<size_t>(state.range(0)));
+
+  size_t byte_count = 0;
+  for (auto _ : state) {
+    std::ostringstream stream;
+    NativeBinaryArchiveWriter archive{stream};
+    model->Save(archive);
+    byte_count = stream.str().size();
+  }
+
+  SetParticlesProcessed(state, GetItemCount(*model));
+  state.SetBytesProcessed(
+      state.iterations() * static_cast<int64_t>(byte_count));
+}
+
+void BenchmarkLoad(benchmark::State &state) {
+  auto const model = MakeBlockModel(static_cast<size_t>(state.range(0)));
+
+  std::string data;
+  {
+    std::ostringstream stream;
+    NativeBinaryArchiveWriter archive{stream};
+    model->Save(archive);
+    data = stream.str();
+  }
+
+  for (auto _ : state) {
+    std::istringstream stream{data};
+    NativeBinaryArchiveReader archive{stream};
+    Model loaded;
+    loaded.Load(archive);
+    benchmark::DoNotOptimize(loaded.GetGroupCount());
+  }
+
+  SetParticlesProcessed(state, GetItemCount(*model));
+  state.SetBytesProcessed(
+      state.iterations() * static_cast<int64_t>(data.size()));
+}
+
+} // namespace
+
+void RegisterArchiveBenchmarks() {
+  for (auto [name, function] : {
+           std::pair{"archive/save", &BenchmarkSave},
+           std::pair{"archive/load", &BenchmarkLoad},
+       }) {
+    benchmark::RegisterBenchmark(name, function)
+        ->ArgsProduct({GetParticleCounts()})
+        ->ArgNames({"particles"})
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+  }
+}
+
+} // namespace prtcl::bench
@@ -0,0 +1,141 @@
+#include "common.hpp"
+
+#include <prtcl/util/neighborhood.hpp>
+
+#include <functional>
+
+#include <omp.h>
+
+namespace prtcl::bench {
+
+namespace {
+
+using ModelFactory = std::function<std::unique_ptr<Model>(int64_t)>;
+
+std::unique_ptr<Model>
+MakeModel(benchmark::State &state, ModelFactory const &make) {
+  auto model = make(state.range(0));
+  SetThreadCount(state, state.range(1));
+  return model;
+}
+
+void LoadNeighborhood(Neighborhood &nhood, Model const &model) {
+  nhood.Load(model);
+  nhood.SetRadius(2 * kSmoothingScale);
+}
+
+void BenchmarkUpdate(benchmark::State &state, ModelFactory const &make) {
+  auto model = MakeModel(state, make);
+
+  Neighborhood nhood;
+  LoadNeighborhood(nhood, *model);
+
+  for (auto _ : state)
+    nhood.Update();
+
+  SetParticlesProcessed(state, GetItemCount(*model));
+}
+
+void BenchmarkPermute(benchmark::State &state, ModelFactory const &make) {
+  auto model = MakeModel(state, make);
+
+  Neighborhood nhood;
+  LoadNeighborhood(nhood, *model);
+  nhood.Update();
+
+  // the first permutation sorts the particles, the following iterations
+  // measure the steady state of an already sorted model
+  nhood.Permute(*model, true);
+
+  for (auto _ : state)
+    nhood.Permute(*model, false);
+
+  SetParticlesProcessed(state, GetItemCount(*model));
+}
+
+void BenchmarkQuery(benchmark::State &state, ModelFactory const &make) {
+  auto model = MakeModel(state, make);
+
+  Neighborhood nhood;
+  LoadNeighborhood(nhood, *model);
+  nhood.Update();
+  nhood.Permute(*model, true);
+
+  auto const group_count = model->GetGroupCount();
+
+  size_t query_count = 0, neighbor_count = 0;
+  for (auto _ : state) {
+    query_count = 0;
+    neighbor_count = 0;
+
+    for (auto const &group : model->GetGroups()) {
+      using x_index_t = std::ptrdiff_t;
+      auto const g = static_cast<size_t>(group.GetGroupIndex());
+      auto const item_count = static_cast<x_index_t>(group.GetItemCount());
+      query_count += group.GetItemCount();
+
+#pragma omp parallel reduction(+ : neighbor_count)
+      {
+        std::vector<NeighborList> neighbors(group_count);
+
+#pragma omp for schedule(static)
+        for (x_index_t i = 0; i < item_count; ++i) {
+          for (auto &list : neighbors)
+            list.clear();
+
+          nhood.CopyNeighbors(g, static_cast<size_t>(i), neighbors);
+
+          for (auto const &list : neighbors)
+            neighbor_count += list.size();
+        }
+      }
+    }
+
+    benchmark::DoNotOptimize(neighbor_count);
+  }
+
+  SetParticlesProcessed(state, query_count);
+  state.counters["neighbors_per_particle"] =
+      query_count > 0 ? static_cast<double>(neighbor_count) /
+                            static_cast<double>(query_count)
+                      : 0.0;
+}
+
+void Register(
+    std::string const &prefix, ModelFactory const &make,
+    std::vector<int64_t> const &particle_counts) {
+  using Function = void (*)(benchmark::State &, ModelFactory const &);
+  std::pair<char const *, Function> const benchmarks[] = {
+      {"update", &BenchmarkUpdate},
+      {"permute", &BenchmarkPermute},
+      {"query", &BenchmarkQuery},
+  };
+
+  for (auto [name, function] : benchmarks) {
+    benchmark::RegisterBenchmark(
+        (prefix + name).c_str(),
+        [function, make](benchmark::State &state) { function(state, make); })
+        ->ArgsProduct({particle_counts, GetThreadCounts()})
+        ->ArgNames({"particles", "threads"})
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+  }
+}
+
+} // namespace
+
+void RegisterNeighborhoodBenchmarks() {
+  Register(
+      "neighborhood/",
+      [](int64_t count) { return MakeBlockModel(static_cast<size_t>(count)); },
+      GetParticleCounts());
+
+  // the particle count argument is ignored for the scene model
+  if (auto const &path = GetSceneModelPath()) {
+    Register(
+        "scene/neighborhood/",
+        [path = *path](int64_t) { return LoadModel(path); }, {0});
+  }
+}
+
+} // namespace prtcl::bench
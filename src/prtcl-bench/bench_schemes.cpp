@@ -0,0 +1,73 @@
+#include "common.hpp"
+
+#include <prtcl/schemes/scheme_base.hpp>
+#include <prtcl/util/neighborhood.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace prtcl::bench {
+
+namespace {
+
+//! Only the configuration used by the example scenes is benchmarked.
+constexpr std::string_view kSchemeConfiguration = "[T=f32, N=3, ";
+
+constexpr std::string_view kSchemeNamespace = "prtcl::schemes::";
+
+void BenchmarkProcedure(
+    benchmark::State &state, std::string const &scheme_name,
+    std::string const &procedure) {
+  auto model = MakeBlockModel(static_cast<size_t>(state.range(0)));
+  SetThreadCount(state, state.range(1));
+
+  auto scheme = GetSchemeRegistry().NewScheme(scheme_name);
+  scheme->Load(*model);
+  SetDefaultParameters(*model);
+
+  Neighborhood nhood;
+  nhood.Load(*model);
+  nhood.SetRadius(2 * kSmoothingScale);
+  nhood.Update();
+  nhood.Permute(*model, true);
+
+  // initialize all fields the procedures compute from each other
+  for (auto const &name : scheme->GetProcedureNames())
+    scheme->RunProcedure(name, nhood);
+
+  for (auto _ : state)
+    scheme->RunProcedure(procedure, nhood);
+
+  SetParticlesProcessed(state, GetItemCount(*model));
+}
+
+} // namespace
+
+void RegisterSchemeBenchmarks() {
+  for (auto const &scheme_name : GetSchemeRegistry().GetSchemeNames()) {
+    auto const configuration = scheme_name.find(kSchemeConfiguration);
+    if (configuration == std::string::npos)
+      continue;
+
+    // prtcl::schemes::<name>[...] becomes <name>
+    auto short_name = scheme_name.substr(0, configuration);
+    if (short_name.rfind(kSchemeNamespace, 0) == 0)
+      short_name.erase(0, kSchemeNamespace.size());
+
+    auto const scheme = GetSchemeRegistry().NewScheme(scheme_name);
+    for (auto const &procedure : scheme->GetProcedureNames()) {
+      benchmark::RegisterBenchmark(
+          ("scheme/" + short_name + "/" + procedure).c_str(),
+          [scheme_name = std::string{scheme_name},
+           procedure = std::string{procedure}](benchmark::State &state) {
+            BenchmarkProcedure(state, scheme_name, procedure);
+          })
+          ->ArgsProduct({GetParticleCounts(), GetThreadCounts()})
+          ->ArgNames({"particles", "threads"})
+          ->UseRealTime()
+          ->Unit(benchmark::kMillisecond);
+    }
+  }
+}
+
+} // namespace prtcl::bench
@@ -0,0 +1,68 @@
+#include "common.hpp"
+
+#include <prtcl/solver/cg_openmp.hpp>
+
+#include <vector>
+
+namespace prtcl::bench {
+
+namespace {
+
+constexpr float kDiagonal = 2.5f;
+
+//! Stands in for the group data of the generated schemes.
+struct SolverGroup {
+  size_t _count;
+};
+
+//! Solves a diagonally dominant tridiagonal system with a Jacobi
+//! preconditioned CGOpenMP, a fixed number of iterations is enforced by a
+//! tolerance of zero.
+void BenchmarkCG(benchmark::State &state) {
+  constexpr size_t kIterations = 50;
+
+  auto const count = static_cast<size_t>(state.range(0));
+  SetThreadCount(state, state.range(1));
+
+  SolverGroup const group{count};
+  std::vector<float> result(count);
+
+  auto rhs = [](auto const &, size_t i, auto &b) { b[i] = 1; };
+  auto guess = [](auto const &, size_t i, auto &x) { x[i] = 0; };
+  auto system = [](auto const &g, size_t i, auto &out, auto const &in) {
+    out[i] = kDiagonal * in[i];
+    if (i > 0)
+      out[i] -= in[i - 1];
+    if (i + 1 < g._count)
+      out[i] -= in[i + 1];
+  };
+  auto precond = [](auto const &, size_t i, auto &out, auto const &in) {
+    out[i] = in[i] / kDiagonal;
+  };
+  auto apply = [&result](auto const &, size_t i, auto const &x) {
+    result[i] = x[i];
+  };
+
+  CGOpenMP<float> solver;
+  size_t iterations = 0;
+  for (auto _ : state) {
+    iterations = solver.solve(
+        group, rhs, guess, system, precond, apply, 0.0f, kIterations);
+    benchmark::DoNotOptimize(result.data());
+  }
+
+  SetParticlesProcessed(state, count);
+  state.counters["cg_iterations"] = static_cast<double>(iterations);
+}
+
+} // namespace
+
+void RegisterSolverBenchmarks() {
+  benchmark::RegisterBenchmark("solver/cg", &BenchmarkCG)
+      ->ArgsProduct({GetParticleCounts(), GetThreadCounts()})
+      ->ArgNames({"particles", "threads"})
+      ->UseRealTime()
+      ->Unit(benchmark::kMillisecond);
+}
+
+} // namespace prtcl::bench
@@ -0,0 +1,167 @@
+#include "common.hpp"
+
+#include <prtcl/math.hpp>
+#include <prtcl/util/archive.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <string_view>
+
+#include <omp.h>
+
+namespace prtcl::bench {
+
+namespace {
+
+using RVec3 = TensorT<double, 3>;
+
+void SetUniform(
+    UniformManager const &uniform, std::string_view name, double value) {
+  if (uniform.HasField(name))
+    uniform.FieldWrap<double>(name) = value;
+}
+
+void SetPositions(Group &group, std::vector<RVec3> const &positions) {
+  auto indices = group.CreateItems(positions.size());
+  auto x = group.GetVarying().FieldWrap<double, 3>("position");
+  if (not indices.empty())
+    x.SetBlock(indices.front(), positions);
+}
+
+} // namespace
+
+std::vector<int64_t> GetParticleCounts() {
+  return {int64_t{1} << 12, int64_t{1} << 15, int64_t{1} << 18};
+}
+
+std::vector<int64_t> GetThreadCounts() {
+  auto const max_threads = static_cast<int64_t>(omp_get_max_threads());
+
+  std::vector<int64_t> result;
+  for (int64_t threads = 1; threads < max_threads; threads *= 2)
+    result.push_back(threads);
+  result.push_back(max_threads);
+  return result;
+}
+
+std::unique_ptr<Model> MakeBlockModel(size_t fluid_count) {
+  constexpr double h = kSmoothingScale;
+
+  std::mt19937 rng{42};
+  std::uniform_real_distribution<double> jitter{-0.1 * h, 0.1 * h};
+
+  auto const side = static_cast<size_t>(
+      std::ceil(std::cbrt(static_cast<double>(fluid_count))));
+
+  std::vector<RVec3> fluid;
+  fluid.reserve(fluid_count);
+  for (size_t iy = 0; fluid.size() < fluid_count; ++iy) {
+    for (size_t iz = 0; iz < side and fluid.size() < fluid_count; ++iz) {
+      for (size_t ix = 0; ix < side and fluid.size() < fluid_count; ++ix) {
+        fluid.push_back(RVec3{
+            h * static_cast<double>(ix) + jitter(rng),
+            h * static_cast<double>(iy + 1) + jitter(rng),
+            h * static_cast<double>(iz) + jitter(rng)});
+      }
+    }
+  }
+  std::shuffle(fluid.begin(), fluid.end(), rng);
+
+  // two layers of boundary particles below the fluid
+  std::vector<RVec3> boundary;
+  for (size_t iy = 0; iy < 2; ++iy) {
+    for (size_t iz = 0; iz < side; ++iz) {
+      for (size_t ix = 0; ix < side; ++ix) {
+        boundary.push_back(RVec3{
+            h * static_cast<double>(ix), -h * static_cast<double>(iy),
+            h * static_cast<double>(iz)});
+      }
+    }
+  }
+
+  auto model = std::make_unique<Model>();
+  model->AddGlobalFieldImpl<float>("smoothing_scale");
+
+  auto &f = model->AddGroup("f", "fluid");
+  f.AddTag("dynamic");
+  f.AddTag("visible");
+  f.AddVaryingFieldImpl<float, 3>("position");
+  f.AddVaryingFieldImpl<float>("mass");
+  SetPositions(f, fluid);
+
+  auto &b = model->AddGroup("b", "boundary");
+  b.AddVaryingFieldImpl<float, 3>("position");
+  SetPositions(b, boundary);
+
+  SetDefaultParameters(*model);
+  return model;
+}
+
+std::optional<std::string> &GetSceneModelPath() {
+  static std::optional<std::string> path;
+  return path;
+}
+
+std::unique_ptr<Model> LoadModel(std::string const &path) {
+  std::fstream file{path, file.in};
+  NativeBinaryArchiveReader archive{file};
+  auto model = std::make_unique<Model>();
+  model->Load(archive);
+  return model;
+}
+
+void SetDefaultParameters(Model &model) {
+  auto const &global = model.GetGlobal();
+  SetUniform(global, "smoothing_scale", kSmoothingScale);
+  SetUniform(global, "time_step", 0.001);
+  SetUniform(global, "fade_duration", 0.1);
+  SetUniform(global, "iisph_relaxation", 0.5);
+  if (global.HasField("gravity"))
+    global.FieldWrap<double, 3>("gravity") = RVec3{0, -9.81, 0};
+
+  for (auto &group : model.GetGroups()) {
+    auto const &uniform = group.GetUniform();
+    SetUniform(uniform, "rest_density", 1000);
+    SetUniform(uniform, "compressibility", 10e6);
+    SetUniform(uniform, "surface_tension", 1);
+    SetUniform(uniform, "adhesion", 0);
+    SetUniform(
+        uniform, "dynamic_viscosity",
+        group.GetGroupType() == "fluid" ? 1 : 10);
+    SetUniform(uniform, "wkbb18_maximum_error", 0.05);
+    SetUniform(uniform, "wkbb18_maximum_iterations", 100);
+    SetUniform(uniform, "pt16_maximum_error", 0.001);
+    SetUniform(uniform, "pt16_maximum_iterations", 500);
+
+    if (group.GetGroupType() == "fluid" and
+        group.GetVarying().HasField("mass")) {
+      double const h = kSmoothingScale;
+      auto mass = group.GetVarying().FieldWrap<double>("mass");
+      for (size_t i = 0; i < group.GetItemCount(); ++i)
+        mass.Set(i, h * h * h * 1000);
+    }
+  }
+}
+
+size_t GetItemCount(Model const &model) {
+  size_t count = 0;
+  for (auto const &group : model.GetGroups())
+    count += group.GetItemCount();
+  return count;
+}
+
+void SetThreadCount(benchmark::State &state, int64_t thread_count) {
+  omp_set_num_threads(static_cast<int>(thread_count));
+  state.counters["threads"] = static_cast<double>(thread_count);
+}
+
+void SetParticlesProcessed(benchmark::State &state, size_t particle_count) {
+  state.SetItemsProcessed(
+      state.iterations() * static_cast<int64_t>(particle_count));
+  state.counters["particles"] = static_cast<double>(particle_count);
+}
+
+} // namespace prtcl::bench
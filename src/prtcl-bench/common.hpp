@@ -0,0 +1,62 @@
+#ifndef PRTCL_SRC_PRTCL_BENCH_COMMON_HPP
+#define PRTCL_SRC_PRTCL_BENCH_COMMON_HPP
+
+#include <prtcl/data/model.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+namespace prtcl::bench {
+
+//! Smoothing scale (and particle spacing) of the synthetic particle sets.
+constexpr double kSmoothingScale = 0.025;
+
+//! Numbers of fluid particles of the synthetic particle sets.
+std::vector<int64_t> GetParticleCounts();
+
+//! Numbers of OpenMP threads for the scaling curves, powers of two up to
+//! (and including) the maximum number of threads.
+std::vector<int64_t> GetThreadCounts();
+
+//! Creates a block of about fluid_count fluid particles (group "f") resting
+//! on a slab of boundary particles (group "b").  The positions are jittered
+//! and the fluid particles shuffled with a fixed seed, such that every run
+//! starts from the same unordered particle set.
+std::unique_ptr<Model> MakeBlockModel(size_t fluid_count);
+
+//! Path of a model saved with model:save_native_binary, benchmarked in
+//! addition to the synthetic particle sets if given (--prtcl_model=<path>).
+std::optional<std::string> &GetSceneModelPath();
+
+std::unique_ptr<Model> LoadModel(std::string const &path);
+
+//! Sets the global and uniform fields that the schemes read to the values
+//! of the example scenes, and the masses of the fluid particles.
+void SetDefaultParameters(Model &model);
+
+//! Returns the number of items of all groups of the model.
+size_t GetItemCount(Model const &model);
+
+//! Sets the number of OpenMP threads and reports it as a counter.
+void SetThreadCount(benchmark::State &state, int64_t thread_count);
+
+//! Reports the throughput in particles per second.
+void SetParticlesProcessed(benchmark::State &state, size_t particle_count);
+
+void RegisterNeighborhoodBenchmarks();
+
+void RegisterSchemeBenchmarks();
+
+void RegisterSolverBenchmarks();
+
+void RegisterArchiveBenchmarks();
+
+} // namespace prtcl::bench
+
+#endif // PRTCL_SRC_PRTCL_BENCH_COMMON_HPP
@@ -0,0 +1,51 @@
+#include "common.hpp"
+
+#include <prtcl/util/thread_affinity.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <omp.h>
+
+namespace {
+
+constexpr std::string_view kModelOption = "--prtcl_model=";
+
+} // namespace
+
+int main(int argc, char **argv) {
+  using namespace ::prtcl::bench;
+
+  // take our own options out before Google Benchmark parses the rest
+  std::vector<char *> args;
+  for (int argi = 0; argi < argc; ++argi) {
+    std::string_view const arg{argv[argi]};
+    if (arg.rfind(kModelOption, 0) == 0)
+      GetSceneModelPath() = std::string{arg.substr(kModelOption.size())};
+    else
+      args.push_back(argv[argi]);
+  }
+  int args_count = static_cast<int>(args.size());
+
+  // bind the OpenMP threads like prtcl-lua does
+  ::prtcl::ApplyThreadAffinityPolicy();
+
+  benchmark::AddCustomContext(
+      "omp_max_threads", std::to_string(omp_get_max_threads()));
+  if (auto const &path = GetSceneModelPath())
+    benchmark::AddCustomContext("prtcl_model", *path);
+
+  RegisterNeighborhoodBenchmarks();
+  RegisterSchemeBenchmarks();
+  RegisterSolverBenchmarks();
+  RegisterArchiveBenchmarks();
+
+  benchmark::Initialize(&args_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_count, args.data()))
+    return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -4,11 +4,19 @@
 
 #include <prtcl/cxx.hpp>
 #include <prtcl/log.hpp>
+#include <prtcl/log/async_logger.hpp>
+#include <prtcl/log/ostream_logger.hpp>
+#include <prtcl/util/thread_affinity.hpp>
 
+#include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include <cstdlib>
+
 #include <sol/sol.hpp>
 
 namespace prtcl::lua {
@@ -20,10 +28,26 @@ local prtcl = require 'prtcl'
 prtcl.log:errorf("default_script", "no file specified")
 )==";
 
+//! Formats and writes the log on a background thread, unless disabled with
+//! PRTCL_LOG_ASYNC=0.
+static void InstallAsyncLogger() {
+  if (auto const *env = std::getenv("PRTCL_LOG_ASYNC");
+      env and std::string_view{env} == "0")
+    return;
+
+  log::SetLogger(new log::AsyncLogger{
+      std::make_unique<log::OStreamLogger>(&std::cerr, false)});
+}
+
 static int Main(cxx::span<std::string const> argv) {
+  InstallAsyncLogger();
+
   ::prtcl::log::Debug(
       "app", "prtcl-lua", "prtcl::lua::main(#argv=", argv.size(), ")");
 
+  // bind the OpenMP threads before any particle data is allocated
+  ApplyThreadAffinityPolicy();
+
   sol::state lua;
   lua.open_libraries(
       sol::lib::base, sol::lib::string, sol::lib::package, sol::lib::math,
@@ -64,5 +88,11 @@ int main(int argc, char **argv_ptr) {
   for (int argi = 0; argi < argc; ++argi)
     argv.push_back({argv_ptr[argi]});
 
-  return ::prtcl::lua::Main(argv);
+  try {
+    return ::prtcl::lua::Main(argv);
+  } catch (...) {
+    // output the deferred messages before terminating
+    ::prtcl::log::Flush();
+    throw;
+  }
 }
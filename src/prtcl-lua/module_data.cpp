@@ -1,6 +1,7 @@
 #include "module_data.hpp"
 
 #include <prtcl/data/component_type.hpp>
+#include <prtcl/data/field_filter.hpp>
 #include <prtcl/data/group.hpp>
 #include <prtcl/data/model.hpp>
 #include <prtcl/data/shape.hpp>
@@ -10,9 +11,17 @@
 #include <prtcl/data/varying_field.hpp>
 #include <prtcl/data/varying_manager.hpp>
 
+#include <prtcl/errors/invalid_shape_error.hpp>
+
+#include <prtcl/util/frame_archive.hpp>
 #include <prtcl/util/save_vtk.hpp>
+#include <prtcl/util/sharded_checkpoint.hpp>
 
 #include <fstream>
+#include <memory>
+#include <vector>
+
+#include <boost/range/numeric.hpp>
 
 namespace prtcl::lua {
 
@@ -78,22 +87,148 @@ sol::table ModuleData(sol::state_view lua) {
     t["add_global_field"] = &Model::AddGlobalField;
     t["remove_global_field"] = &Model::RemoveGlobalField;
 
+    t["position_origin"] = sol::property(
+        [](Model const &self) {
+          auto const origin = self.GetPositionOrigin();
+          RealVector result(static_cast<math::Index>(origin.size()));
+          std::copy(origin.begin(), origin.end(), result.data());
+          return result;
+        },
+        [](Model &self, RealVector const &origin) {
+          self.SetPositionOrigin(
+              {origin.data(), static_cast<size_t>(origin.size())});
+        });
+
     t["group_names"] = &Model::GetGroupNames;
 
-    t.set_function(
-        "save_native_binary", [](Model const &self, std::string path) {
+    t["save_native_binary"] = sol::overload(
+        [](Model const &self, std::string path) {
           std::fstream file{path, file.out};
           NativeBinaryArchiveWriter archive{file};
           self.Save(archive);
+        },
+        [](Model const &self, std::string path, FieldFilter const &filter) {
+          std::fstream file{path, file.out};
+          NativeBinaryArchiveWriter archive{file};
+          self.Save(archive, filter);
         });
 
-    t.set_function("load_native_binary", [](std::string path) {
-      std::fstream file{path, file.in};
-      NativeBinaryArchiveReader archive{file};
-      Model *model = new Model;
-      model->Load(archive);
-      return model;
-    });
+    t["load_native_binary"] = sol::overload(
+        [](std::string path) {
+          std::fstream file{path, file.in};
+          NativeBinaryArchiveReader archive{file};
+          Model *model = new Model;
+          model->Load(archive);
+          return model;
+        },
+        [](std::string path, FieldFilter const &filter) {
+          std::fstream file{path, file.in};
+          NativeBinaryArchiveReader archive{file};
+          Model *model = new Model;
+          model->Load(archive, filter);
+          return model;
+        });
+
+    t["save_sharded"] = sol::overload(
+        [](Model const &self, std::string const &directory) {
+          SaveShardedCheckpoint(self, directory);
+        },
+        [](Model const &self, std::string const &directory,
+           size_t max_shard_size) {
+          SaveShardedCheckpoint(self, directory, max_shard_size);
+        },
+        [](Model const &self, std::string const &directory,
+           size_t max_shard_size, FieldFilter const &filter) {
+          SaveShardedCheckpoint(self, directory, max_shard_size, filter);
+        });
+
+    t["load_sharded"] = sol::overload(
+        [](std::string const &directory) {
+          auto model = std::make_unique<Model>();
+          LoadShardedCheckpoint(directory, *model);
+          return model;
+        },
+        [](std::string const &directory, FieldFilter const &filter) {
+          auto model = std::make_unique<Model>();
+          LoadShardedCheckpoint(directory, *model, filter);
+          return model;
+        });
+  }
+
+  {
+    // kind is one of "global", "uniform", "varying" or nil (any kind of field)
+    auto ParseKind = [](sol::optional<std::string_view> kind) {
+      return kind ? FieldKindFromString(*kind) : std::nullopt;
+    };
+
+    auto t = m.new_usertype<FieldFilter>(
+        "field_filter",
+        sol::constructors<FieldFilter(), FieldFilter(bool)>());
+
+    t.set_function(
+        "include",
+        [ParseKind](
+            FieldFilter &self, std::string_view pattern,
+            sol::optional<std::string_view> kind,
+            sol::optional<std::string_view> group_tag) -> FieldFilter & {
+          return self.Include(
+              pattern, ParseKind(kind), group_tag.value_or(""));
+        });
+
+    t.set_function(
+        "exclude",
+        [ParseKind](
+            FieldFilter &self, std::string_view pattern,
+            sol::optional<std::string_view> kind,
+            sol::optional<std::string_view> group_tag) -> FieldFilter & {
+          return self.Exclude(
+              pattern, ParseKind(kind), group_tag.value_or(""));
+        });
+
+    t["restart_set"] = &FieldFilter::RestartSet;
+  }
+
+  {
+    auto t = m.new_usertype<FrameArchiveWriter>(
+        "frame_archive_writer",
+        sol::constructors<FrameArchiveWriter(std::string const &)>());
+    t["frame_count"] = sol::property(&FrameArchiveWriter::GetFrameCount);
+    t["append_frame"] = sol::overload(
+        sol::resolve<size_t(Model const &)>(&FrameArchiveWriter::AppendFrame),
+        sol::resolve<size_t(Model const &, FieldFilter const &)>(
+            &FrameArchiveWriter::AppendFrame));
+  }
+
+  {
+    auto t = m.new_usertype<FrameArchiveReader>(
+        "frame_archive_reader",
+        sol::constructors<FrameArchiveReader(std::string const &)>());
+    t["frame_count"] = sol::property(&FrameArchiveReader::GetFrameCount);
+
+    t["load_frame"] = sol::overload(
+        [](FrameArchiveReader &self, size_t frame) {
+          auto model = std::make_unique<Model>();
+          self.LoadFrame(frame, *model);
+          return model;
+        },
+        [](FrameArchiveReader &self, size_t frame, FieldFilter const &filter) {
+          auto model = std::make_unique<Model>();
+          self.LoadFrame(frame, *model, filter);
+          return model;
+        },
+        [](FrameArchiveReader &self, size_t frame, Model &model) {
+          self.LoadFrame(frame, model);
+        },
+        [](FrameArchiveReader &self, size_t frame, Model &model,
+           FieldFilter const &filter) { self.LoadFrame(frame, model, filter); });
+
+    t["load_field"] = &FrameArchiveReader::LoadField;
+
+    t.set_function(
+        "has_field", [](FrameArchiveReader const &self, size_t frame,
+                        std::string_view group, std::string_view field) {
+          return nullptr != self.GetFrameIndex(frame).FindField(group, field);
+        });
   }
 
   {
@@ -119,8 +254,19 @@ sol::table ModuleData(sol::state_view lua) {
     t["remove_field"] = &Group::RemoveField;
 
     t["create_items"] = &Group::CreateItems;
-    // TODO: t["destroy_items"] = &Group::DestroyItems;
+    t["destroy_items"] = [](Group &self,
+                            sol::as_table_t<std::vector<size_t>> indices) {
+      self.DestroyItems(indices.value());
+    };
+    // the items are removed by the next permute of the neighborhood
+    t["destroy_items_deferred"] =
+        [](Group &self, sol::as_table_t<std::vector<size_t>> indices) {
+          self.DestroyItemsDeferred(indices.value());
+        };
+    t["deferred_destroy_count"] =
+        sol::property(&Group::GetDeferredDestroyCount);
     t["resize"] = &Group::Resize;
+    t["reserve"] = &Group::ReserveItems;
     // TODO: t["permute"] = &Group::Permute;
 
     t["save_vtk"] = [](Group const &self, std::string path) {
@@ -128,30 +274,35 @@ sol::table ModuleData(sol::state_view lua) {
       SaveVTK(file, self);
     };
 
+    using RVec3 = TensorT<double, 3>;
+    using RMat3 = TensorT<double, 3, 3>;
+
     t.set_function("translate", [](Group const &self, RealVector const &delta) {
       if (auto x = self.GetVarying().FieldWrap<double, 3>("position")) {
-        for (size_t i = 0; i < x.size(); ++i) {
-          x.Set(i, x.Get(i) + delta);
-        }
+        RVec3 const d{delta};
+        x.Transform(0, x.size(), [&d](RVec3 const &x_i) -> RVec3 {
+          return x_i + d;
+        });
       }
     });
 
     t.set_function("scale", [](Group const &self, RealVector const &factors) {
       if (auto x = self.GetVarying().FieldWrap<double, 3>("position")) {
-        for (size_t i = 0; i < x.size(); ++i) {
-          x.Set(i, math::cmul(factors, x.Get(i)));
-        }
+        RVec3 const f{factors};
+        x.Transform(0, x.size(), [&f](RVec3 const &x_i) -> RVec3 {
+          return math::cmul(f, x_i);
+        });
       }
     });
 
     t.set_function(
         "rotate",
         [](Group const &self, RealScalar angle, RealVector const &axis) {
-          auto R = math::RotationMatrixFromAngleAxis(angle, axis);
+          RMat3 const R = math::RotationMatrixFromAngleAxis(angle, axis);
           if (auto x = self.GetVarying().FieldWrap<double, 3>("position")) {
-            for (size_t i = 0; i < x.size(); ++i) {
-              x.Set(i, R * x.Get(i));
-            }
+            x.Transform(0, x.size(), [&R](RVec3 const &x_i) -> RVec3 {
+              return R * x_i;
+            });
           }
         });
   }
@@ -282,6 +433,80 @@ sol::table ModuleData(sol::state_view lua) {
                       RealVector const &value) { self.Set(index, value); },
                    [](VaryingField &self, size_t index,
                       RealMatrix const &value) { self.Set(index, value); }));
+
+    // bulk access to ranges of items, the components of all items are
+    // flattened into a single array
+    t["item_count"] = sol::property(&VaryingField::GetSize);
+    // the components of one item, one for scalars (the type counts none)
+    auto item_component_count = [](VaryingField const &self) {
+      return boost::accumulate(
+          self.GetType().GetShape().GetExtents(), size_t{1},
+          std::multiplies<void>{});
+    };
+    t["item_component_count"] = sol::property(item_component_count);
+    t["component_type"] = sol::property([](VaryingField const &self) {
+      return self.GetType().GetComponentType().ToStringView();
+    });
+    // written such that huge (or negative) first and count cannot wrap around
+    auto check_range = [](VaryingField const &self, size_t first,
+                          size_t count) {
+      if (first > self.GetSize() or count > self.GetSize() - first)
+        throw InvalidShapeError{};
+    };
+    t.set_function(
+        "get_range", [check_range, item_component_count](
+                         VaryingField const &self, size_t first, size_t count) {
+          check_range(self, first, count);
+          std::vector<double> values(count * item_component_count(self));
+          self.GetRealRange(first, count, values.data());
+          return sol::as_table(std::move(values));
+        });
+    t.set_function(
+        "set_range", [check_range, item_component_count](
+                         VaryingField const &self, size_t first,
+                         sol::as_table_t<std::vector<double>> values) {
+          auto const &vec = values.value();
+          auto const component_count = item_component_count(self);
+          if (component_count == 0 or vec.size() % component_count != 0)
+            throw InvalidShapeError{};
+          check_range(self, first, vec.size() / component_count);
+          self.SetRealRange(first, vec.size() / component_count, vec.data());
+        });
+    auto fill_range = [check_range, item_component_count](
+                          VaryingField const &self, size_t first, size_t count,
+                          double const *item, size_t component_count) {
+      if (component_count != item_component_count(self))
+        throw InvalidShapeError{};
+      check_range(self, first, count);
+      self.FillRealRange(first, count, item);
+    };
+    t.set_function(
+        "fill",
+        sol::overload(
+            [fill_range](
+                VaryingField const &self, size_t first, size_t count,
+                RealScalar const &value) {
+              fill_range(self, first, count, &value, 1);
+            },
+            [fill_range](
+                VaryingField const &self, size_t first, size_t count,
+                RealVector const &value) {
+              fill_range(
+                  self, first, count, value.data(),
+                  static_cast<size_t>(value.size()));
+            },
+            [fill_range](
+                VaryingField const &self, size_t first, size_t count,
+                RealMatrix const &value) {
+              fill_range(
+                  self, first, count, value.data(),
+                  static_cast<size_t>(value.size()));
+            }));
+    // the raw storage pointer can be cast by the LuaJIT FFI according to
+    // component_type, it is invalidated when the group outgrows its capacity
+    t.set_function("data_pointer", [](VaryingField const &self) {
+      return self.GetRawData();
+    });
   }
 
   return m;
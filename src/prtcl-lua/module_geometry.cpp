@@ -2,13 +2,13 @@
 
 #include <prtcl/data/group.hpp>
 #include <prtcl/data/model.hpp>
+#include <prtcl/geometry/camera_path.hpp>
 #include <prtcl/geometry/pinhole_camera.hpp>
 #include <prtcl/geometry/sample_surface.hpp>
 #include <prtcl/geometry/sample_volume.hpp>
 #include <prtcl/geometry/triangle_mesh.hpp>
 #include <prtcl/math.hpp>
 
-#include <fstream>
 #include <vector>
 
 namespace prtcl::lua {
@@ -22,10 +22,13 @@ sol::table ModuleGeometry(sol::state_view lua) {
   {
     auto t = m.new_usertype<TriangleMesh>("triangle_mesh", sol::no_constructor);
 
-    t.set_function("from_obj_file", [](std::string path) {
-      std::ifstream file{path};
-      return TriangleMesh::load_from_obj(file);
-    });
+    t["from_obj_file"] = sol::overload(
+        [](std::string const &path) {
+          return TriangleMesh::load_from_obj_file(path);
+        },
+        [](std::string const &path, bool use_cache) {
+          return TriangleMesh::load_from_obj_file(path, use_cache);
+        });
 
     t.set_function("scale", [](TriangleMesh &mesh, RealVector const &factors) {
       mesh.Scale(RVec3{factors});
@@ -52,8 +55,8 @@ sol::table ModuleGeometry(sol::state_view lua) {
           SampleSurface(mesh, std::back_inserter(samples), params);
           auto indices = group.CreateItems(samples.size());
           auto x = group.GetVarying().FieldWrap<double, 3>("position");
-          for (size_t i = 0; i < samples.size(); ++i)
-            x[indices[i]] = samples[i];
+          if (not indices.empty())
+            x.SetBlock(indices.front(), samples);
         });
 
     t.set_function("sample_volume", [](TriangleMesh const &mesh, Group &group) {
@@ -64,9 +67,17 @@ sol::table ModuleGeometry(sol::state_view lua) {
       SampleVolume(mesh, std::back_inserter(samples), params);
       auto indices = group.CreateItems(samples.size());
       auto x = group.GetVarying().FieldWrap<double, 3>("position");
-      for (size_t i = 0; i < samples.size(); ++i)
-        x[indices[i]] = samples[i];
+      if (not indices.empty())
+        x.SetBlock(indices.front(), samples);
     });
+
+    // the extension (.obj or .ply) selects the format
+    t.set_function("save", &TriangleMesh::save_to_file);
+
+    t["vertex_count"] = sol::property(
+        [](TriangleMesh const &mesh) { return mesh.Vertices().size(); });
+    t["face_count"] = sol::property(
+        [](TriangleMesh const &mesh) { return mesh.Faces().size(); });
   }
 
   {
@@ -162,16 +173,26 @@ sol::table ModuleGeometry(sol::state_view lua) {
       auto o = group.GetVarying().FieldWrap<double, 3>("initial_position");
       auto t = group.GetVarying().FieldWrap<double>("initial_parameter");
       auto d = group.GetVarying().FieldWrap<double, 3>("direction");
-      for (size_t i = 0; i < indices.size(); ++i) {
-        s[indices[i]] = samples_s[i];
-        x[indices[i]] = samples_x[i];
-        o[indices[i]] = samples_x[i];
-        t[indices[i]] = samples_t[i];
-        d[indices[i]] = samples_d[i];
+      if (not indices.empty()) {
+        auto const first = indices.front();
+        s.SetBlock(first, samples_s);
+        x.SetBlock(first, samples_x);
+        o.SetBlock(first, samples_x);
+        t.SetBlock(first, samples_t);
+        d.SetBlock(first, samples_d);
       }
     });
   }
 
+  {
+    auto t = m.new_usertype<CameraPath>(
+        "camera_path", sol::constructors<CameraPath()>());
+
+    t["key_count"] = sol::property(&CameraPath::GetKeyCount);
+    t["add_key"] = &CameraPath::AddKey;
+    t["get_camera"] = &CameraPath::GetCamera;
+  }
+
   return m;
 }
 
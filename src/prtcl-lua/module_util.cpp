@@ -1,13 +1,25 @@
 #include "module_util.hpp"
 
+#include <prtcl/geometry/camera_path.hpp>
 #include <prtcl/geometry/pinhole_camera.hpp>
+#include <prtcl/util/batch_renderer.hpp>
 #include <prtcl/util/hcp_lattice_source.hpp>
+#include <prtcl/util/horas_engine.hpp>
+#include <prtcl/util/huge_page_pool.hpp>
+#include <prtcl/util/image_io.hpp>
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/particle_sink.hpp>
+#include <prtcl/util/perf_counters.hpp>
+#include <prtcl/util/profiler.hpp>
 #include <prtcl/util/scheduler.hpp>
 #include <prtcl/util/sphere_tracer.hpp>
+#include <prtcl/util/surface_mesher.hpp>
+#include <prtcl/util/time_step_controller.hpp>
 
+#include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <tuple>
 
 namespace prtcl::lua {
 
@@ -56,13 +68,15 @@ sol::table ModuleUtil(sol::state_view lua) {
           return self.RescheduleAt(VirtualDuration{when});
         });
 
+    // Lua callbacks always use Dispatch::kSerial, calling them from the
+    // threads of a parallel batch would race on the Lua state
     t.set_function(
         "schedule_at",
         [](VirtualScheduler &self, double when,
            std::function<typename VirtualScheduler::CallbackSignature>
                callback) {
           VirtualScheduler::TimePoint when_tp{VirtualScheduler::Duration{when}};
-          self.ScheduleAt(when_tp, callback);
+          return self.ScheduleAt(when_tp, callback);
         });
 
     t.set_function(
@@ -71,7 +85,25 @@ sol::table ModuleUtil(sol::state_view lua) {
            std::function<typename VirtualScheduler::CallbackSignature>
                callback) {
           VirtualScheduler::Duration after_dur{after};
-          self.ScheduleAfter(after_dur, callback);
+          return self.ScheduleAfter(after_dur, callback);
+        });
+
+    // the schedule functions return handles of the scheduled tasks
+    t["cancel"] = &VirtualScheduler::Cancel;
+    t["is_scheduled"] = &VirtualScheduler::IsScheduled;
+    t.set_function(
+        "move_task", [](VirtualScheduler &self,
+                        VirtualScheduler::TaskHandle const &handle,
+                        double when) {
+          return self.Reschedule(
+              handle, VirtualScheduler::TimePoint{VirtualDuration{when}});
+        });
+    t["task_count"] = sol::property(&VirtualScheduler::GetTaskCount);
+    t["next_time"] = sol::property(
+        [](VirtualScheduler &self, sol::this_state state) -> sol::object {
+          if (auto next = self.GetNextTime())
+            return sol::make_object(state, next->time_since_epoch().count());
+          return sol::lua_nil;
         });
   }
 
@@ -131,9 +163,109 @@ sol::table ModuleUtil(sol::state_view lua) {
         "neighborhood", sol::constructors<Neighborhood()>());
 
     t["set_radius"] = &Neighborhood::SetRadius;
+    t["get_radius"] = &Neighborhood::GetRadius;
     t["load"] = &Neighborhood::Load;
     t["update"] = &Neighborhood::Update;
-    t["permute"] = &Neighborhood::Permute;
+    // returns true if items were removed, the model then stays dirty
+    t["permute"] = sol::overload(
+        [](Neighborhood &self, Model &model) { return self.Permute(model); },
+        [](Neighborhood &self, Model &model, bool grid_is_current) {
+          return self.Permute(model, grid_is_current);
+        });
+  }
+
+  {
+    auto t = lua.create_table();
+
+    t["enable"] = [](sol::optional<bool> value) {
+      Profiler::SetEnabled(value.value_or(true));
+    };
+    t["disable"] = [] { Profiler::SetEnabled(false); };
+    t["is_enabled"] = &Profiler::IsEnabled;
+    t["reset"] = &Profiler::Reset;
+    t["set_trace_capacity"] = &Profiler::SetTraceCapacity;
+
+    t["get_scopes"] = [](sol::this_state state) {
+      sol::state_view lua{state};
+      auto scopes = lua.create_table();
+      for (auto const &node : Profiler::GetNodes()) {
+        auto scope = lua.create_table();
+        scope["name"] = node.name;
+        scope["path"] = node.path;
+        scope["depth"] = node.depth;
+        scope["count"] = node.count;
+        scope["total_seconds"] = node.total_seconds;
+        scope["min_seconds"] = node.min_seconds;
+        scope["max_seconds"] = node.max_seconds;
+        scope["thread_count"] = node.thread_count;
+        scope["mean_thread_seconds"] = node.mean_thread_seconds;
+        scope["max_thread_seconds"] = node.max_thread_seconds;
+        scopes.add(scope);
+      }
+      return scopes;
+    };
+
+    t["save_json"] = [](std::string path) {
+      std::fstream file{path, file.out};
+      Profiler::SaveJSON(file);
+    };
+
+    t["save_chrome_trace"] = [](std::string path) {
+      std::fstream file{path, file.out};
+      Profiler::SaveChromeTrace(file);
+    };
+
+    m["profiler"] = t;
+  }
+
+  {
+    auto t = lua.create_table();
+
+    t["enable"] = &PerfCounters::Enable;
+    t["disable"] = &PerfCounters::Disable;
+    t["is_enabled"] = &PerfCounters::IsEnabled;
+    t["reset"] = &PerfCounters::Reset;
+
+    t["get_stats"] = [](sol::this_state state) {
+      sol::state_view lua{state};
+      auto result = lua.create_table();
+      for (auto const &stats : PerfCounters::GetStats()) {
+        auto entry = lua.create_table();
+        entry["name"] = stats.name;
+        entry["count"] = stats.count;
+        entry["seconds"] = stats.seconds;
+        for (size_t event = 0; event < kPerfEventCount; ++event) {
+          std::string name{GetPerfEventName(static_cast<PerfEvent>(event))};
+          if (auto value = stats.values[event])
+            entry[name] = *value;
+        }
+        if (auto ipc = stats.GetIPC())
+          entry["ipc"] = *ipc;
+        if (auto rate = stats.GetCacheMissRate())
+          entry["cache_miss_rate"] = *rate;
+        if (auto bandwidth = stats.GetEstimatedBandwidth())
+          entry["estimated_bandwidth"] = *bandwidth;
+        result.add(entry);
+      }
+      return result;
+    };
+
+    m["perf_counters"] = t;
+  }
+
+  {
+    auto t = lua.create_table();
+
+    t["trim"] = [] { HugePagePool::Get().Trim(); };
+    t["trim_excess"] = [] { return HugePagePool::Get().TrimExcess(); };
+    t["get_mapped_byte_size"] = [] {
+      return HugePagePool::Get().GetMappedByteSize();
+    };
+    t["get_cached_byte_size"] = [] {
+      return HugePagePool::Get().GetCachedByteSize();
+    };
+
+    m["huge_page_pool"] = t;
   }
 
   {
@@ -147,6 +279,16 @@ sol::table ModuleUtil(sol::state_view lua) {
         sol::property(&HCPLatticeSource::GetRegularSpawnInterval);
   }
 
+  {
+    auto t = m.new_usertype<HCPLatticeSourceBatch>(
+        "hcp_lattice_source_batch",
+        sol::constructors<HCPLatticeSourceBatch(Group &)>());
+
+    t["add"] = &HCPLatticeSourceBatch::Add;
+
+    t["source_count"] = sol::property(&HCPLatticeSourceBatch::GetSourceCount);
+  }
+
   {
     auto t = m.new_usertype<Image>(sol::no_constructor);
 
@@ -157,6 +299,10 @@ sol::table ModuleUtil(sol::state_view lua) {
         "get_pixel", [](Image const &self, size_t const ix, size_t const iy) {
           return self(ix, iy);
         });
+
+    t.set_function("save", [](Image const &self, std::string const &path) {
+      SaveImage(path, self);
+    });
   }
 
   {
@@ -168,10 +314,183 @@ sol::table ModuleUtil(sol::state_view lua) {
     t["threshold"] =
         sol::property(&Tracer::GetThreshold, &Tracer::SetThreshold);
 
-    t.set_function(
-        "trace", [](Tracer const &self, Model const &model) -> Image {
+    t["max_steps"] = sol::property(&Tracer::GetMaxSteps, &Tracer::SetMaxSteps);
+
+    // the variants with a neighborhood reuse its grid
+    t["trace"] = sol::overload(
+        [](Tracer const &self, Model const &model) -> Image {
           return self.Trace(model);
+        },
+        [](Tracer const &self, Model const &model,
+           Neighborhood const &nhood) -> Image {
+          return self.Trace(model, nhood);
+        });
+
+    t["trace_progressive"] = sol::overload(
+        [](Tracer const &self, Model const &model, size_t pass_count,
+           sol::function on_pass) -> Image {
+          return self.TraceProgressive(
+              model, pass_count, [&on_pass](Image const &image, size_t pass) {
+                on_pass(image, pass);
+              });
+        },
+        [](Tracer const &self, Model const &model, Neighborhood const &nhood,
+           size_t pass_count, sol::function on_pass) -> Image {
+          return self.TraceProgressive(
+              model, nhood, pass_count,
+              [&on_pass](Image const &image, size_t pass) {
+                on_pass(image, pass);
+              });
+        });
+  }
+
+  {
+    auto t = m.new_usertype<HorasEngine>(
+        "horas_engine", sol::constructors<HorasEngine(PinholeCamera)>());
+
+    t["camera"] =
+        sol::property(&HorasEngine::GetCamera, &HorasEngine::SetCamera);
+
+    t["level_count"] = sol::property(
+        &HorasEngine::GetLevelCount, &HorasEngine::SetLevelCount);
+
+    t["max_steps"] = sol::property(
+        &HorasEngine::GetMaxSteps, &HorasEngine::SetMaxSteps);
+
+    t["tolerance"] = sol::property(
+        &HorasEngine::GetTolerance, &HorasEngine::SetTolerance);
+
+    t["depth_tolerance"] = sol::property(
+        &HorasEngine::GetDepthTolerance, &HorasEngine::SetDepthTolerance);
+
+    // returns the parameter and intensity images and a table of statistics
+    t["extract"] = [](HorasEngine const &self, Model const &model,
+                      Neighborhood const &nhood, sol::this_state state) {
+      auto result = self.Extract(model, nhood);
+      auto const &s = result.statistics;
+      auto statistics = sol::state_view{state}.create_table_with(
+          "marched_rays", s.marched_rays, "interpolated_pixels",
+          s.interpolated_pixels, "steps", s.steps, "sweeps", s.sweeps);
+      return std::make_tuple(
+          std::move(result.parameter), std::move(result.intensity),
+          statistics);
+    };
+  }
+
+  {
+    auto t = m.new_usertype<SurfaceMesher>(
+        "surface_mesher", sol::constructors<SurfaceMesher()>());
+
+    t["threshold"] = sol::property(
+        &SurfaceMesher::GetThreshold, &SurfaceMesher::SetThreshold);
+
+    t["cell_size"] = sol::property(
+        &SurfaceMesher::GetCellSize, &SurfaceMesher::SetCellSize);
+
+    t["extract"] = &SurfaceMesher::Extract;
+  }
+
+  {
+    auto t = m.new_usertype<ParticleSink>(
+        "particle_sink", sol::constructors<ParticleSink()>());
+
+    using RVec3 = TensorT<double, 3>;
+
+    t.set_function(
+        "add_box",
+        [](ParticleSink &self, RealVector const &lo, RealVector const &hi) {
+          self.AddBox(RVec3{lo}, RVec3{hi});
+        });
+
+    t.set_function(
+        "add_half_space", [](ParticleSink &self, RealVector const &point,
+                             RealVector const &normal) {
+          self.AddHalfSpace(RVec3{point}, RVec3{normal});
+        });
+
+    t.set_function("add_mesh", [](ParticleSink &self, TriangleMesh mesh) {
+      self.AddMesh(std::move(mesh));
+    });
+
+    t["region_count"] = sol::property(&ParticleSink::GetRegionCount);
+
+    // only marks the particles, the next permute of the neighborhood removes
+    // them
+    t["apply"] = &ParticleSink::Apply;
+  }
+
+  {
+    auto t = m.new_usertype<TimeStepController>(
+        "time_step_controller", sol::constructors<TimeStepController()>());
+
+    t["cfl_number"] = sol::property(
+        &TimeStepController::GetCFLNumber, &TimeStepController::SetCFLNumber);
+    t["force_number"] = sol::property(
+        &TimeStepController::GetForceNumber,
+        &TimeStepController::SetForceNumber);
+    t["viscosity_number"] = sol::property(
+        &TimeStepController::GetViscosityNumber,
+        &TimeStepController::SetViscosityNumber);
+    t["min_time_step"] = sol::property(
+        &TimeStepController::GetMinTimeStep,
+        &TimeStepController::SetMinTimeStep);
+    t["max_time_step"] = sol::property(
+        &TimeStepController::GetMaxTimeStep,
+        &TimeStepController::SetMaxTimeStep);
+    t["max_growth"] = sol::property(
+        &TimeStepController::GetMaxGrowth, &TimeStepController::SetMaxGrowth);
+
+    t["time_step"] = sol::property(&TimeStepController::GetTimeStep);
+
+    t["limits"] = sol::property(
+        [](TimeStepController const &self, sol::this_state state) {
+          auto const &l = self.GetLimits();
+          return sol::state_view{state}.create_table_with(
+              "cfl", l.cfl, "force", l.force, "viscosity", l.viscosity);
         });
+
+    t["update"] = sol::overload(
+        [](TimeStepController &self, Model &model) {
+          return self.Update(model);
+        },
+        [](TimeStepController &self, Model &model,
+           VirtualScheduler &scheduler) {
+          return self.Update(model, scheduler);
+        });
+
+    t["advance"] = &TimeStepController::Advance;
+  }
+
+  {
+    auto t = m.new_usertype<BatchRenderer>(
+        "batch_renderer", sol::constructors<BatchRenderer()>());
+
+    t["camera_path"] = sol::property(
+        [](BatchRenderer const &self) { return self.GetCameraPath(); },
+        &BatchRenderer::SetCameraPath);
+
+    t["threshold"] = sol::property(
+        &BatchRenderer::GetThreshold, &BatchRenderer::SetThreshold);
+
+    t["max_steps"] = sol::property(
+        &BatchRenderer::GetMaxSteps, &BatchRenderer::SetMaxSteps);
+
+    t["frame_concurrency"] = sol::property(
+        &BatchRenderer::GetFrameConcurrency,
+        &BatchRenderer::SetFrameConcurrency);
+
+    t["add_camera_key"] = [](BatchRenderer &self, double frame,
+                             PinholeCamera const &camera) {
+      self.GetCameraPath().AddKey(frame, camera);
+    };
+
+    t["render_native_binary_files"] =
+        [](BatchRenderer const &self,
+           sol::as_table_t<std::vector<std::string>> paths,
+           std::string const &output_pattern) {
+          self.RenderNativeBinaryFiles(paths.value(), output_pattern);
+        };
+    t["render_frame_archive"] = &BatchRenderer::RenderFrameArchive;
   }
 
   return m;
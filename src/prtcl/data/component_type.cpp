@@ -20,6 +20,23 @@ void ComponentType::Load(ArchiveReader &archive) {
   *this = ComponentType::FromString(archive.LoadString());
 }
 
+size_t ComponentType::GetByteSize() const {
+  switch (ctype_) {
+  case CType::kBoolean:
+    return sizeof(bool);
+  case CType::kSInt32:
+    return sizeof(int32_t);
+  case CType::kSInt64:
+    return sizeof(int64_t);
+  case CType::kFloat32:
+    return sizeof(float);
+  case CType::kFloat64:
+    return sizeof(double);
+  default:
+    return 0;
+  }
+}
+
 std::string_view ComponentType::ToStringView() const {
   switch (ctype_) {
   case CType::kBoolean:
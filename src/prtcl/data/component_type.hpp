@@ -25,6 +25,9 @@ public:
 public:
   constexpr bool IsValid() const { return ctype_ != CType::kInvalid; }
 
+  //! Size of a single component in bytes (zero if invalid).
+  size_t GetByteSize() const;
+
 public:
   template <typename T>
   static ComponentType FromType();
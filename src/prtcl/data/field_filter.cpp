@@ -0,0 +1,77 @@
+#include "field_filter.hpp"
+#include "group.hpp"
+
+namespace prtcl {
+
+std::optional<FieldKind> FieldKindFromString(std::string_view input) {
+  if (input == "global")
+    return FieldKind::kGlobal;
+  if (input == "uniform")
+    return FieldKind::kUniform;
+  if (input == "varying")
+    return FieldKind::kVarying;
+  return std::nullopt;
+}
+
+bool MatchesGlob(std::string_view pattern, std::string_view input) {
+  // iterative matching with backtracking to the last '*'
+  size_t p = 0, i = 0;
+  size_t star = std::string_view::npos, mark = 0;
+  while (i < input.size()) {
+    if (p < pattern.size() and (pattern[p] == '?' or pattern[p] == input[i])) {
+      ++p, ++i;
+    } else if (p < pattern.size() and pattern[p] == '*') {
+      star = p++;
+      mark = i;
+    } else if (star != std::string_view::npos) {
+      p = star + 1;
+      i = ++mark;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() and pattern[p] == '*')
+    ++p;
+  return p == pattern.size();
+}
+
+FieldFilter &FieldFilter::Include(
+    std::string_view pattern, std::optional<FieldKind> kind,
+    std::string_view group_tag) {
+  rules_.push_back(
+      {true, std::string{pattern}, kind, std::string{group_tag}});
+  return *this;
+}
+
+FieldFilter &FieldFilter::Exclude(
+    std::string_view pattern, std::optional<FieldKind> kind,
+    std::string_view group_tag) {
+  rules_.push_back(
+      {false, std::string{pattern}, kind, std::string{group_tag}});
+  return *this;
+}
+
+bool FieldFilter::Selects(
+    FieldKind kind, std::string_view name, Group const *group) const {
+  for (auto it = rules_.rbegin(); it != rules_.rend(); ++it) {
+    if (it->kind and *it->kind != kind)
+      continue;
+    if (not it->group_tag.empty() and
+        (group == nullptr or not group->HasTag(it->group_tag)))
+      continue;
+    if (MatchesGlob(it->pattern, name))
+      return it->include;
+  }
+  return inclusive_;
+}
+
+FieldFilter FieldFilter::RestartSet() {
+  FieldFilter filter;
+  for (auto *scheme :
+       {"aat13", "aiast12", "he14", "iisph", "pt16", "sesph", "wkbb18"})
+    filter.Exclude(std::string{scheme} + "_*", FieldKind::kVarying);
+  filter.Exclude("acceleration", FieldKind::kVarying);
+  return filter;
+}
+
+} // namespace prtcl
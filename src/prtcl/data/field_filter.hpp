@@ -0,0 +1,70 @@
+#ifndef PRTCL_SRC_PRTCL_DATA_FIELD_FILTER_HPP
+#define PRTCL_SRC_PRTCL_DATA_FIELD_FILTER_HPP
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+
+namespace prtcl {
+
+class Group;
+
+enum class FieldKind : size_t {
+  kGlobal = 0,
+  kUniform = 1,
+  kVarying = 2,
+};
+
+std::optional<FieldKind> FieldKindFromString(std::string_view input);
+
+//! Matches input against a glob pattern that may contain '*' and '?'.
+bool MatchesGlob(std::string_view pattern, std::string_view input);
+
+//! Selects fields for saving and loading models.
+//!
+//! The filter is an ordered list of include and exclude rules.  Each rule
+//! matches the field name against a glob pattern and can be restricted to one
+//! kind of field and to groups carrying a tag.  The last matching rule decides,
+//! fields matched by no rule are selected if the filter is inclusive.
+class FieldFilter {
+public:
+  explicit FieldFilter(bool inclusive = true) : inclusive_{inclusive} {}
+
+public:
+  FieldFilter &Include(
+      std::string_view pattern, std::optional<FieldKind> kind = std::nullopt,
+      std::string_view group_tag = {});
+
+  FieldFilter &Exclude(
+      std::string_view pattern, std::optional<FieldKind> kind = std::nullopt,
+      std::string_view group_tag = {});
+
+public:
+  //! Check if a field is selected, group is nullptr for global fields.
+  bool Selects(
+      FieldKind kind, std::string_view name, Group const *group) const;
+
+public:
+  //! Only the state required to resume a simulation: all global and uniform
+  //! fields, and all varying fields except solver scratch (prefixed by the
+  //! scheme name, e.g. iisph_helper_c) and per-step accelerations.
+  static FieldFilter RestartSet();
+
+private:
+  struct Rule {
+    bool include;
+    std::string pattern;
+    std::optional<FieldKind> kind;
+    std::string group_tag;
+  };
+
+  bool inclusive_;
+  std::vector<Rule> rules_;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_DATA_FIELD_FILTER_HPP
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "field_filter.hpp"
+#include "model.hpp"
+
+#include <sstream>
+#include <string>
+
+using namespace prtcl;
+
+TEST(FieldFilter, MatchesGlob) {
+  ASSERT_TRUE(MatchesGlob("position", "position"));
+  ASSERT_FALSE(MatchesGlob("position", "positions"));
+  ASSERT_TRUE(MatchesGlob("*", ""));
+  ASSERT_TRUE(MatchesGlob("iisph_*", "iisph_helper_c"));
+  ASSERT_FALSE(MatchesGlob("iisph_*", "wkbb18_system_diagonal"));
+  ASSERT_TRUE(MatchesGlob("*_diagonal*", "wkbb18_system_diagonal"));
+  ASSERT_TRUE(MatchesGlob("ma?s", "mass"));
+  ASSERT_FALSE(MatchesGlob("ma?s", "masses"));
+}
+
+TEST(FieldFilter, Selects) {
+  Model model;
+  auto &fluid = model.AddGroup("fluid", "fluid");
+  fluid.AddTag("dynamic");
+  auto &boundary = model.AddGroup("boundary", "boundary");
+
+  FieldFilter filter{false};
+  filter.Include("*");
+  filter.Exclude("*_helper_*", FieldKind::kVarying);
+  filter.Include("velocity", FieldKind::kVarying, "dynamic");
+  filter.Exclude("velocity", std::nullopt, "static");
+
+  ASSERT_TRUE(filter.Selects(FieldKind::kGlobal, "iisph_helper_c", nullptr));
+  ASSERT_FALSE(filter.Selects(FieldKind::kVarying, "iisph_helper_c", &fluid));
+  ASSERT_TRUE(filter.Selects(FieldKind::kVarying, "velocity", &fluid));
+  ASSERT_TRUE(filter.Selects(FieldKind::kVarying, "velocity", &boundary));
+
+  auto restart = FieldFilter::RestartSet();
+  ASSERT_TRUE(restart.Selects(FieldKind::kVarying, "position", &fluid));
+  ASSERT_FALSE(
+      restart.Selects(FieldKind::kVarying, "wkbb18_system_diagonal", &fluid));
+  ASSERT_FALSE(restart.Selects(FieldKind::kVarying, "acceleration", &fluid));
+  // solver parameters are needed to resume
+  ASSERT_TRUE(
+      restart.Selects(FieldKind::kGlobal, "wkbb18_maximum_error", nullptr));
+}
+
+TEST(FieldFilter, SaveLoadTest) {
+  std::string data;
+
+  {
+    std::ostringstream os;
+    NativeBinaryArchiveWriter ar{os};
+
+    Model model;
+    model.AddGlobalFieldImpl<float>("iisph_relaxation");
+    auto &group = model.AddGroup("fluid", "fluid");
+    group.CreateItems(4);
+    group.AddVaryingFieldImpl<float, 3>("position");
+    group.AddVaryingFieldImpl<float, 3>("acceleration");
+    group.AddVaryingFieldImpl<float>("iisph_helper_c");
+    group.AddUniformFieldImpl<float>("rest_density");
+
+    model.Save(ar, FieldFilter::RestartSet());
+
+    data = os.str();
+  }
+
+  {
+    std::istringstream is{data};
+    NativeBinaryArchiveReader ar{is};
+
+    Model model;
+    model.Load(ar);
+
+    ASSERT_TRUE(model.GetGlobal().HasField("iisph_relaxation"));
+    auto *group = model.TryGetGroup("fluid");
+    ASSERT_NE(nullptr, group);
+    ASSERT_EQ(4, group->GetItemCount());
+    ASSERT_EQ(1, group->GetVarying().GetFieldCount());
+    ASSERT_TRUE(group->GetVarying().HasField("position"));
+    ASSERT_TRUE(group->GetUniform().HasField("rest_density"));
+  }
+
+  {
+    // skip the payload of unselected fields on loading
+    std::istringstream is{data};
+    NativeBinaryArchiveReader ar{is};
+
+    Model model;
+    model.Load(ar, FieldFilter{}.Exclude("position"));
+
+    auto *group = model.TryGetGroup("fluid");
+    ASSERT_NE(nullptr, group);
+    ASSERT_EQ(4, group->GetItemCount());
+    ASSERT_EQ(0, group->GetVarying().GetFieldCount());
+    ASSERT_TRUE(group->GetUniform().HasField("rest_density"));
+  }
+}
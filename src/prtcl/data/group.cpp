@@ -29,6 +29,12 @@ Group::Group(
 }
 
 void Group::Save(ArchiveWriter &archive) const {
+  Save(archive, FieldFilter{});
+}
+
+void Group::Load(ArchiveReader &archive) { Load(archive, FieldFilter{}); }
+
+void Group::Save(ArchiveWriter &archive, FieldFilter const &filter) const {
   // model_ and index_ are set in the constructor (on loading from a model)
   // name_ and type_ are stored by the model
 
@@ -37,11 +43,15 @@ void Group::Save(ArchiveWriter &archive) const {
     archive.SaveString(tag);
   }
 
-  this->varying_.Save(archive);
-  this->uniform_.Save(archive);
+  this->varying_.Save(archive, [this, &filter](std::string_view name) {
+    return filter.Selects(FieldKind::kVarying, name, this);
+  });
+  this->uniform_.Save(archive, [this, &filter](std::string_view name) {
+    return filter.Selects(FieldKind::kUniform, name, this);
+  });
 }
 
-void Group::Load(ArchiveReader &archive) {
+void Group::Load(ArchiveReader &archive, FieldFilter const &filter) {
   // model_ and index_ are set in the constructor (on loading from a model)
   // name_ and type_ are stored by the model
 
@@ -54,8 +64,13 @@ void Group::Load(ArchiveReader &archive) {
     this->AddTag(tag);
   }
 
-  this->varying_.Load(archive);
-  this->uniform_.Load(archive);
+  // the tags are loaded first, such that the filter can match them
+  this->varying_.Load(archive, [this, &filter](std::string_view name) {
+    return filter.Selects(FieldKind::kVarying, name, this);
+  });
+  this->uniform_.Load(archive, [this, &filter](std::string_view name) {
+    return filter.Selects(FieldKind::kUniform, name, this);
+  });
 }
 
 } // namespace prtcl
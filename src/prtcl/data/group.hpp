@@ -4,6 +4,7 @@
 #include "../cxx/set.hpp"
 #include "../errors/field_of_different_kind_already_exists_error.hpp"
 #include "../log.hpp"
+#include "field_filter.hpp"
 #include "uniform_manager.hpp"
 #include "varying_manager.hpp"
 
@@ -110,6 +111,19 @@ public:
       throw FieldOfDifferentKindAlreadyExistsError{};
   }
 
+  //! Returns the varying field name, for type independent bulk access (see
+  //! VaryingField::SetRealRange).
+  VaryingField GetVaryingField(std::string_view name) {
+    return varying_.GetField(name);
+  }
+
+  //! See VaryingManager::SetFieldOrigin.
+  void SetFieldOrigin(
+      std::string_view name, cxx::span<double const> origin,
+      bool rebase = true) {
+    varying_.SetFieldOrigin(name, origin, rebase);
+  }
+
 public:
   void RemoveField(std::string_view name) {
     uniform_.RemoveField(name);
@@ -123,6 +137,20 @@ public:
     varying_.DestroyItems(indices);
   }
 
+  void DestroyItemsDeferred(cxx::span<size_t const> indices) {
+    varying_.DestroyItemsDeferred(indices);
+  }
+
+  void CompactItems() { varying_.CompactItems(); }
+
+  size_t GetDeferredDestroyCount() const {
+    return varying_.GetDeferredDestroyCount();
+  }
+
+  void ReserveItems(size_t capacity) { varying_.ReserveItems(capacity); }
+
+  size_t GetCapacity() const { return varying_.GetCapacity(); }
+
   bool IsDirty() const { return varying_.IsDirty(); }
 
   void SetDirty(bool value) { varying_.SetDirty(value); }
@@ -139,6 +167,10 @@ public:
 
   void Load(ArchiveReader &archive);
 
+  void Save(ArchiveWriter &archive, FieldFilter const &filter) const;
+
+  void Load(ArchiveReader &archive, FieldFilter const &filter);
+
 private:
   Model *model_;
 
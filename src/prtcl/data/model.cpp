@@ -8,6 +8,30 @@ namespace prtcl {
 PRTCL_DEFINE_LOG_FOR_INSTANCE(Debug, prtcl::data, Model)
 PRTCL_DEFINE_LOG_FOR_INSTANCE(Warning, prtcl::data, Model)
 
+namespace {
+
+// the varying fields that hold points and are stored relative to the origin
+constexpr std::string_view kVaryingPointFields[] = {
+    "position", "initial_position"};
+
+// the global fields that hold points and are stored relative to the origin
+constexpr std::string_view kGlobalPointFields[] = {
+    "gravity_center", "position_aabb_min", "position_aabb_max"};
+
+void SetGroupOrigin(
+    Group &group, cxx::span<double const> origin, bool rebase) {
+  for (auto name : kVaryingPointFields)
+    group.SetFieldOrigin(name, origin, rebase);
+}
+
+void SetGlobalOrigin(
+    UniformManager &global, cxx::span<double const> origin, bool rebase) {
+  for (auto name : kGlobalPointFields)
+    global.SetFieldOrigin(name, origin, rebase);
+}
+
+} // namespace
+
 Model::Model() { LogDebug(this, "Model()"); }
 
 Group &Model::AddGroup(std::string_view name, std::string_view type) {
@@ -19,6 +43,9 @@ Group &Model::AddGroup(std::string_view name, std::string_view type) {
     auto group_index = static_cast<GroupIndex>(groups_by_index_.size());
     it->second.reset(new Group{*this, name, type});
     groups_by_index_.emplace_back(it->second.get());
+
+    if (auto origin = GetPositionOrigin(); not origin.empty())
+      SetGroupOrigin(*it->second, origin, false);
   } else if (it->second->GetGroupType() != type) {
     throw GroupOfDifferentTypeAlreadyExists{};
   }
@@ -51,26 +78,69 @@ void Model::RemoveGroup(std::string_view name) {
   }
 }
 
+void Model::SetPositionOrigin(
+    cxx::span<double const> origin, bool rebase) {
+  LogDebug(this, "SetPositionOrigin(", origin.size(), " components)");
+
+  // the shape of the stored origin follows the dimension of the positions
+  global_.RemoveField(kPositionOriginField);
+  TensorType const type{ComponentType::kFloat64, {origin.size()}};
+  auto field = global_.AddField(kPositionOriginField, type);
+  RealVector value(static_cast<math::Index>(origin.size()));
+  std::copy(origin.begin(), origin.end(), value.data());
+  field.Set(value);
+
+  SetGlobalOrigin(global_, origin, rebase);
+  for (auto &group : GetGroups())
+    SetGroupOrigin(group, origin, rebase);
+}
+
+std::vector<double> Model::GetPositionOrigin() const {
+  for (auto const &[name, field] : global_.GetNamedFields()) {
+    if (name != kPositionOriginField)
+      continue;
+
+    RealVector value;
+    field.Get(value);
+    return {value.data(), value.data() + value.size()};
+  }
+  return {};
+}
+
 void Model::Save(ArchiveWriter &archive) const {
-  global_.Save(archive);
+  Save(archive, FieldFilter{});
+}
+
+void Model::Load(ArchiveReader &archive) { Load(archive, FieldFilter{}); }
+
+void Model::Save(ArchiveWriter &archive, FieldFilter const &filter) const {
+  global_.Save(archive, [&filter](std::string_view name) {
+    return filter.Selects(FieldKind::kGlobal, name, nullptr);
+  });
 
   archive.SaveSize(groups_.size());
   for (auto &[group_name, group_ptr] : groups_) {
     archive.SaveString(group_name);
     archive.SaveString(group_ptr->GetGroupType());
-    group_ptr->Save(archive);
+    group_ptr->Save(archive, filter);
   }
 }
 
-void Model::Load(ArchiveReader &archive) {
-  global_.Load(archive);
+void Model::Load(ArchiveReader &archive, FieldFilter const &filter) {
+  global_.Load(archive, [&filter](std::string_view name) {
+    return filter.Selects(FieldKind::kGlobal, name, nullptr);
+  });
+
+  // points that are loaded are relative to the loaded origin
+  if (auto origin = GetPositionOrigin(); not origin.empty())
+    SetPositionOrigin(origin, false);
 
   size_t group_count = archive.LoadSize();
   for (size_t group_index = 0; group_index < group_count; ++group_index) {
     auto group_name = archive.LoadString();
     auto group_type = archive.LoadString();
     auto &group = this->AddGroup(group_name, group_type);
-    group.Load(archive);
+    group.Load(archive, filter);
   }
 }
 
@@ -3,6 +3,7 @@
 
 #include "../cxx/map.hpp"
 #include "../cxx/set.hpp"
+#include "field_filter.hpp"
 #include "group.hpp"
 #include "prtcl/util/is_valid_identifier.hpp"
 
@@ -93,11 +94,45 @@ public:
 
   void RemoveGlobalField(std::string_view name) { global_.RemoveField(name); }
 
+public:
+  //! Sets the double precision origin that all points of the model are
+  //! stored relative to, the stored points are rebased.  Points are the
+  //! varying fields position and initial_position of all groups and the
+  //! global fields gravity_center, position_aabb_min and position_aabb_max.
+  //! The schemes only see relative points, keeping the origin close to the
+  //! simulated domain preserves the resolution of single precision positions
+  //! far away from zero.  The origin is kept in the global field
+  //! position_origin and thus saved with the model.  Without rebase, the
+  //! stored points are taken to be relative to the origin already (e.g.
+  //! because they were loaded together with it).
+  //!
+  //! There is one origin per model, not per cell or tile: the resolution of
+  //! a float position is still about 6e-8 times its distance to the origin,
+  //! i.e. to the extent of the domain (6 micrometres for 100 metres).
+  //! Per-cell origins would require every difference of positions in the
+  //! generated schemes to add the offset between the cells and particles to
+  //! be rebased when they change cells.  Neither is there a precision per
+  //! field, a scheme is instantiated for one real type that all its fields
+  //! share (only the reductions into real scalars and the dot products of
+  //! the CG solver accumulate in double).
+  void
+  SetPositionOrigin(cxx::span<double const> origin, bool rebase = true);
+
+  //! The name of the global field that holds the origin.
+  static constexpr std::string_view kPositionOriginField = "position_origin";
+
+  //! Returns the origin of the positions, empty if none was set.
+  std::vector<double> GetPositionOrigin() const;
+
 public:
   void Save(ArchiveWriter &archive) const;
 
   void Load(ArchiveReader &archive);
 
+  void Save(ArchiveWriter &archive, FieldFilter const &filter) const;
+
+  void Load(ArchiveReader &archive, FieldFilter const &filter);
+
 private:
   UniformManager global_;
 
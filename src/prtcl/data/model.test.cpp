@@ -101,3 +101,106 @@ TEST(Model, SaveLoadTest) {
     ASSERT_TRUE((model.GetGlobal().FieldSpan<bool, 1, 2>("bx1x2")));
   }
 }
+
+TEST(Model, PositionOrigin) {
+  using RVec3 = math::Tensor<double, 3>;
+
+  Model model;
+  auto &fluid = model.AddGroup("fluid", "fluid");
+  fluid.AddVaryingFieldImpl<float, 3>("position");
+  fluid.CreateItems(2);
+
+  // far away from zero, a millimetre is below the resolution of float
+  RVec3 const far{1e5, 2e5, -3e5};
+  auto x = fluid.GetVarying().FieldWrap<double, 3>("position");
+  x.Set(0, far);
+  x.Set(1, far + RVec3{1e-3, 0, 0});
+  ASSERT_EQ(x.Get(0), x.Get(1));
+
+  double const origin[] = {1e5, 2e5, -3e5};
+  model.SetPositionOrigin(origin);
+  ASSERT_EQ(std::vector<double>(origin, origin + 3), model.GetPositionOrigin());
+
+  x = fluid.GetVarying().FieldWrap<double, 3>("position");
+  x.Set(1, far + RVec3{1e-3, 0, 0});
+  RVec3 const delta = x.Get(1) - x.Get(0);
+  ASSERT_NEAR(1e-3, delta[0], 1e-9);
+  ASSERT_EQ(far, x.Get(0));
+
+  // the spans hold the relative positions
+  auto span = fluid.GetVarying().FieldSpan<float, 3>("position");
+  ASSERT_EQ(0.0f, span[0][0]);
+
+  // groups and fields that are added later share the origin
+  auto &boundary = model.AddGroup("boundary", "boundary");
+  boundary.AddVaryingFieldImpl<float, 3>("position");
+  boundary.CreateItems(1);
+  auto y = boundary.GetVarying().FieldWrap<double, 3>("position");
+  y.Set(0, far);
+  auto boundary_span = boundary.GetVarying().FieldSpan<float, 3>("position");
+  ASSERT_EQ(0.0f, boundary_span[0][2]);
+
+  // the origin is saved with the model
+  std::ostringstream os;
+  NativeBinaryArchiveWriter writer{os};
+  model.Save(writer);
+
+  std::istringstream is{os.str()};
+  NativeBinaryArchiveReader reader{is};
+  Model loaded;
+  loaded.Load(reader);
+  auto z = loaded.TryGetGroup("fluid")->GetVarying().FieldWrap<double, 3>(
+      "position");
+  ASSERT_EQ(far, z.Get(0));
+}
+
+TEST(Model, PositionOriginPointFields) {
+  using RVec3 = math::Tensor<double, 3>;
+
+  Model model;
+  auto const &global = model.GetGlobal();
+  RVec3 const center{1, 2, 3};
+  auto c = model.AddGlobalFieldImpl<float, 3>("gravity_center");
+  auto c_wrap = global.FieldWrap<double, 3>("gravity_center");
+  c_wrap.Set(center);
+
+  double const origin[] = {1e5, 2e5, -3e5};
+  RVec3 const far{1e5, 2e5, -3e5};
+  model.SetPositionOrigin(origin);
+
+  // the stored center is rebased, the wrap still sees the absolute center
+  ASSERT_EQ(center, c_wrap.Get());
+  ASSERT_EQ(1.0f - 1e5f, (*c)[0]);
+
+  // initial positions share the origin of the positions, such that the
+  // schemes combine relative points only
+  auto &horason = model.AddGroup("horason", "horason");
+  horason.AddVaryingFieldImpl<float, 3>("position");
+  horason.AddVaryingFieldImpl<float, 3>("initial_position");
+  horason.CreateItems(1);
+  auto x0 = horason.GetVarying().FieldWrap<double, 3>("initial_position");
+  x0.Set(0, far + RVec3{1, 0, 0});
+  auto x0_span = horason.GetVarying().FieldSpan<float, 3>("initial_position");
+  ASSERT_EQ(1.0f, x0_span[0][0]);
+
+  // global points that are added later share the origin as well
+  auto x_min = model.AddGlobalFieldImpl<float, 3>("position_aabb_min");
+  *x_min = math::zeros<float, 3>();
+  auto x_min_wrap = global.FieldWrap<double, 3>("position_aabb_min");
+  ASSERT_EQ(far, x_min_wrap.Get());
+
+  // the loaded points are relative to the loaded origin
+  std::ostringstream os;
+  NativeBinaryArchiveWriter writer{os};
+  model.Save(writer);
+
+  std::istringstream is{os.str()};
+  NativeBinaryArchiveReader reader{is};
+  Model loaded;
+  loaded.Load(reader);
+  auto d_wrap = loaded.GetGlobal().FieldWrap<double, 3>("gravity_center");
+  ASSERT_EQ(center, d_wrap.Get());
+  auto y0 = loaded.TryGetGroup("horason")->GetVarying().FieldWrap<double, 3>(
+      "initial_position");
+  ASSERT_EQ(x0.Get(0), y0.Get(0));
+}
@@ -2,13 +2,16 @@
 #define PRTCL_SRC_PRTCL_DATA_UNIFORM_FIELD_HPP
 
 #include "../cxx/span.hpp"
+#include "../errors/invalid_shape_error.hpp"
 #include "../math.hpp"
 #include "../util/archive.hpp"
 #include "tensor_type.hpp"
 
+#include <algorithm>
 #include <any>
 #include <functional>
 #include <optional>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -16,6 +19,8 @@
 
 #include <boost/hana.hpp>
 
+#include <boost/range/numeric.hpp>
+
 namespace prtcl {
 
 template <typename T, size_t... N>
@@ -136,6 +141,13 @@ public:
 
   virtual void SetMatrix(BooleanMatrix const &matrix) = 0;
 
+public:
+  //! Sets the double precision origin (one value per component) that the
+  //! value of a floating point field is stored relative to, see
+  //! VaryingFieldBase::SetOrigin.  Spans hold the relative value, all other
+  //! accessors convert from and to the absolute value.
+  virtual void SetOrigin(cxx::span<double const> origin, bool rebase) = 0;
+
 public:
   virtual void Save(ArchiveWriter &archive) const = 0;
 
@@ -155,7 +167,7 @@ private:
   void GetImpl(OutItem &out) const {
     if constexpr (Rank == sizeof...(N)) {
       if constexpr (IsComponentConvertible<T, OutComp>())
-        out = math::ComponentCast<OutComp>(data_);
+        out = ToAbsolute<OutComp>(data_, origin_);
       else
         throw "INVALID TYPE";
     } else
@@ -204,7 +216,7 @@ private:
   void SetImpl(InpItem const &inp) {
     if constexpr (Rank == sizeof...(N)) {
       if constexpr (IsComponentConvertible<InpComp, T>())
-        data_ = math::ComponentCast<T>(inp);
+        data_ = ToRelative(inp, origin_);
       else
         throw "INVALID TYPE";
     } else
@@ -248,6 +260,59 @@ public:
     SetImpl<2, BooleanScalar>(matrix);
   }
 
+public:
+  void SetOrigin(cxx::span<double const> origin, bool rebase) final {
+    if constexpr (std::is_floating_point_v<T>) {
+      if (origin.size() != (size_t{1} * ... * N))
+        throw InvalidShapeError{};
+
+      OriginType new_origin;
+      std::copy(origin.begin(), origin.end(), OriginComponents(new_origin));
+
+      if (rebase)
+        data_ = ToRelative(ToAbsolute<double>(data_, origin_), new_origin);
+
+      origin_ = new_origin;
+      has_origin_ = std::any_of(
+          origin.begin(), origin.end(), [](double c) { return c != 0; });
+    } else
+      throw "INVALID TYPE";
+  }
+
+private:
+  using OriginType = math::Tensor<double, N...>;
+
+  static double *OriginComponents(OriginType &origin) {
+    if constexpr (0 == sizeof...(N))
+      return &origin;
+    else
+      return origin.data();
+  }
+
+  // converts the stored value to an absolute value with components of type U
+  template <typename U>
+  static math::Tensor<U, N...>
+  ToAbsolute(ItemType const &item, OriginType const &origin) {
+    if constexpr (std::is_floating_point_v<T>)
+      return math::ComponentCast<U>(
+          OriginType{math::ComponentCast<double>(item) + origin});
+    else
+      return math::ComponentCast<U>(item);
+  }
+
+  // converts an absolute value to a stored value
+  template <typename Value>
+  static ItemType ToRelative(Value const &value, OriginType const &origin) {
+    if constexpr (std::is_floating_point_v<T>)
+      return math::ComponentCast<T>(
+          OriginType{math::ComponentCast<double>(value) - origin});
+    else
+      return math::ComponentCast<T>(value);
+  }
+
+  OriginType origin_ = math::zeros<double, N...>();
+  bool has_origin_ = false;
+
 public:
   void Save(ArchiveWriter &archive) const final {
     if constexpr (sizeof...(N) == 0)
@@ -270,27 +335,33 @@ public:
 public:
   UniformFieldSpan<T, N...> Span() { return {&data_}; }
 
+  //! The wrap reads the origin of this field when it is used, so it stays
+  //! valid across SetOrigin.
   template <typename U>
   UniformFieldWrap<U, N...> Wrap() {
     namespace hana = boost::hana;
-    if constexpr (hana::type_c<T> == hana::type_c<U>) {
-      return {
-          // getter
-          [this]() -> ItemType { return data_; },
-          // setter
-          [this](ItemType const &value) mutable { data_ = value; },
-      };
-    } else {
-      using WrapItemType = typename UniformFieldWrap<U, N...>::ItemType;
-      return {
-          // getter
-          [this]() -> WrapItemType { return math::ComponentCast<U>(data_); },
-          // setter
-          [this](WrapItemType const &value) mutable {
-            data_ = math::ComponentCast<T>(value);
-          },
-      };
-    }
+    // the item is accessed directly as long as there is no origin
+    constexpr bool kSameType = hana::type_c<T> == hana::type_c<U>;
+
+    using WrapItemType = typename UniformFieldWrap<U, N...>::ItemType;
+    return {
+        // getter
+        [this]() -> WrapItemType {
+          if constexpr (kSameType)
+            if (not has_origin_)
+              return data_;
+          return ToAbsolute<U>(data_, origin_);
+        },
+        // setter
+        [this](WrapItemType const &value) mutable {
+          if constexpr (kSameType)
+            if (not has_origin_) {
+              data_ = value;
+              return;
+            }
+          data_ = ToRelative(value, origin_);
+        },
+    };
   }
 
 private:
@@ -360,6 +431,19 @@ public:
 
   void Load(ArchiveReader &archive) const { data_->Load(archive); }
 
+  void SetOrigin(cxx::span<double const> origin, bool rebase = true) const {
+    data_->SetOrigin(origin, rebase);
+  }
+
+  //! Skips the data of a field with the given type as written by Save.
+  static void Skip(ArchiveReader &archive, TensorType const &type) {
+    // a scalar is stored as one component, the type counts none
+    auto const component_count = boost::accumulate(
+        type.GetShape().GetExtents(), size_t{1}, std::multiplies<void>{});
+    archive.SkipValues(
+        component_count, type.GetComponentType().GetByteSize());
+  }
+
 public:
   template <typename T, size_t... N>
   UniformFieldSpan<T, N...> Span() const {
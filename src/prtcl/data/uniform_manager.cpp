@@ -1,5 +1,7 @@
 #include "uniform_manager.hpp"
 
+#include <algorithm>
+
 namespace prtcl {
 
 UniformField UniformManager::AddField(std::string_view name, TensorType type) {
@@ -18,17 +20,41 @@ UniformField UniformManager::GetField(std::string_view name) {
     throw FieldDoesNotExist{};
 }
 
+void UniformManager::SetFieldOrigin(
+    std::string_view name, cxx::span<double const> origin, bool rebase) {
+  if (auto it = fields_.find(name); it != fields_.end())
+    it->second.SetOrigin(origin, rebase);
+
+  auto &stored = origins_[std::string{name}];
+  stored.assign(origin.begin(), origin.end());
+}
 
 void UniformManager::Save(ArchiveWriter &archive) const {
-  archive.SaveSize(this->fields_.size());
+  Save(archive, [](std::string_view) { return true; });
+}
+
+void UniformManager::Load(ArchiveReader &archive) {
+  Load(archive, [](std::string_view) { return true; });
+}
+
+void UniformManager::Save(
+    ArchiveWriter &archive, FieldPredicate const &select) const {
+  auto const field_count = static_cast<size_t>(std::count_if(
+      fields_.begin(), fields_.end(),
+      [&select](auto const &entry) { return select(entry.first); }));
+
+  archive.SaveSize(field_count);
   for (auto const &[name, field] : this->fields_) {
+    if (not select(name))
+      continue;
+
     archive.SaveString(name);
     field.GetType().Save(archive);
     field.Save(archive);
   }
 }
 
-void UniformManager::Load(ArchiveReader &archive) {
+void UniformManager::Load(ArchiveReader &archive, FieldPredicate const &select) {
   size_t const field_count = archive.LoadSize();
   for (size_t field_index = 0; field_index < field_count; ++field_index) {
     auto const name = archive.LoadString();
@@ -36,7 +62,10 @@ void UniformManager::Load(ArchiveReader &archive) {
     TensorType type;
     type.Load(archive);
 
-    this->AddField(name, type).Load(archive);
+    if (select(name))
+      this->AddField(name, type).Load(archive);
+    else
+      UniformField::Skip(archive, type);
   }
 }
 
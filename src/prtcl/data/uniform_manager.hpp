@@ -9,8 +9,10 @@
 #include "prtcl/util/is_valid_identifier.hpp"
 #include "uniform_field.hpp"
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include <cstddef>
 
@@ -33,6 +35,10 @@ public:
     if (not inserted and it->second.GetType() != GetTensorTypeCRef<T, N...>())
       throw FieldOfDifferentTypeAlreadyExistsError{};
 
+    if (inserted)
+      if (auto origin = origins_.find(name); origin != origins_.end())
+        it->second.SetOrigin(origin->second, false);
+
     return it->second.template Span<T, N...>();
   }
 
@@ -65,6 +71,14 @@ public:
     return fields_.find(name) != fields_.end();
   }
 
+public:
+  //! Sets the origin that the value of the field name is stored relative to
+  //! (see UniformFieldBase::SetOrigin), fields of that name that are added
+  //! later are stored relative to the same origin.
+  void SetFieldOrigin(
+      std::string_view name, cxx::span<double const> origin,
+      bool rebase = true);
+
 public:
   size_t GetFieldCount() const { return fields_.size(); }
 
@@ -86,12 +100,22 @@ public:
   }
 
 public:
+  using FieldPredicate = std::function<bool(std::string_view)>;
+
   void Save(ArchiveWriter &archive) const;
 
   void Load(ArchiveReader &archive);
 
+  //! Only saves the fields whose names satisfy the predicate.
+  void Save(ArchiveWriter &archive, FieldPredicate const &select) const;
+
+  //! Only loads the fields whose names satisfy the predicate, the data of all
+  //! other fields is skipped.
+  void Load(ArchiveReader &archive, FieldPredicate const &select);
+
 private:
   cxx::het_flat_map<std::string, UniformField> fields_ = {};
+  cxx::het_flat_map<std::string, std::vector<double>> origins_;
 };
 
 } // namespace prtcl
@@ -2,26 +2,57 @@
 #define PRTCL_SRC_PRTCL_DATA_VARYING_FIELD_HPP
 
 #include "../cxx/span.hpp"
+#include "../errors/invalid_shape_error.hpp"
 #include "../math.hpp"
 #include "../util/archive.hpp"
+#include "../util/first_touch_allocator.hpp"
 #include "tensor_type.hpp"
 
+#include <algorithm>
 #include <any>
 #include <functional>
+#include <new>
 #include <optional>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#include <cassert>
 #include <cstddef>
 
-#include <boost/algorithm/apply_permutation.hpp>
-
 #include <boost/container/small_vector.hpp>
 
 #include <boost/hana.hpp>
 
+#include <boost/range/numeric.hpp>
+
 namespace prtcl {
 
+namespace detail {
+
+//! Removes the elements at the sorted and unique indices from the container,
+//! only the elements after the first removed index are moved.
+template <typename Container_>
+void EraseSortedIndices(Container_ &data, cxx::span<size_t const> indices) {
+  if (indices.empty())
+    return;
+
+  assert(indices.back() < data.size());
+
+  size_t out = indices.front(), next = 0;
+  for (size_t in = indices.front(); in < data.size(); ++in) {
+    if (next < indices.size() and indices[next] == in)
+      ++next;
+    else
+      data[out++] = std::move(data[in]);
+  }
+
+  data.resize(out);
+}
+
+} // namespace detail
+
 template <typename T, size_t... N>
 class VaryingFieldSpan {
 public:
@@ -47,6 +78,40 @@ public:
     (*this)[index] = value;
   }
 
+public:
+  ItemType *data() const { return span_.data(); }
+
+  //! Copies the items starting at first into values.
+  void GetBlock(size_t first, cxx::span<ItemType> values) const {
+    assert(first + values.size() <= size());
+    std::copy_n(span_.data() + first, values.size(), values.data());
+  }
+
+  //! Copies values into the items starting at first.
+  void SetBlock(size_t first, cxx::span<ItemType const> values) const {
+    assert(first + values.size() <= size());
+    std::copy(values.begin(), values.end(), span_.data() + first);
+  }
+
+  //! Sets count items starting at first to value.
+  void Fill(size_t first, size_t count, ItemType const &value) const {
+    assert(first + count <= size());
+    std::fill_n(span_.data() + first, count, value);
+  }
+
+  //! Replaces count items starting at first by the result of fn(item), the
+  //! items are processed in parallel.
+  template <typename Fn_>
+  void Transform(size_t first, size_t count, Fn_ &&fn) const {
+    assert(first + count <= size());
+    auto *items = span_.data() + first;
+
+    using item_index_t = std::ptrdiff_t;
+#pragma omp parallel for schedule(static)
+    for (item_index_t i = 0; i < static_cast<item_index_t>(count); ++i)
+      items[i] = fn(static_cast<ItemType const &>(items[i]));
+  }
+
 public:
   VaryingFieldSpan() = default;
 
@@ -98,6 +163,55 @@ public:
     return set_(index, value);
   }
 
+public:
+  //! Number of items converted at once by Fill and Transform.
+  static constexpr size_t kBlockSize = 1024;
+
+  //! Copies the items starting at first into values.
+  void GetBlock(size_t first, cxx::span<ItemType> values) const {
+    get_block_(first, values);
+  }
+
+  //! Copies values into the items starting at first.
+  void SetBlock(size_t first, cxx::span<ItemType const> values) const {
+    set_block_(first, values);
+  }
+
+  //! Sets count items starting at first to value.
+  void Fill(size_t first, size_t count, ItemType const &value) const {
+    std::vector<ItemType> block(std::min(count, kBlockSize), value);
+    for (size_t offset = 0; offset < count; offset += block.size()) {
+      auto const block_size = std::min(block.size(), count - offset);
+      set_block_(first + offset, {block.data(), block_size});
+    }
+  }
+
+  //! Replaces count items starting at first by the result of fn(item), the
+  //! items are processed in parallel in blocks of kBlockSize items.
+  template <typename Fn_>
+  void Transform(size_t first, size_t count, Fn_ &&fn) const {
+    auto const block_count = (count + kBlockSize - 1) / kBlockSize;
+
+    using block_index_t = std::ptrdiff_t;
+#pragma omp parallel
+    {
+      std::vector<ItemType> block(std::min(count, kBlockSize));
+
+#pragma omp for schedule(static)
+      for (block_index_t b = 0; b < static_cast<block_index_t>(block_count);
+           ++b) {
+        auto const offset = static_cast<size_t>(b) * kBlockSize;
+        auto const block_size = std::min(kBlockSize, count - offset);
+
+        cxx::span<ItemType> values{block.data(), block_size};
+        get_block_(first + offset, values);
+        for (auto &value : values)
+          value = fn(static_cast<ItemType const &>(value));
+        set_block_(first + offset, values);
+      }
+    }
+  }
+
 public:
   VaryingFieldWrap() = default;
   VaryingFieldWrap(VaryingFieldWrap const &) = delete;
@@ -106,14 +220,21 @@ public:
   VaryingFieldWrap &operator=(VaryingFieldWrap &&) = default;
 
 public:
-  template <typename Getter, typename Setter, typename Size>
-  VaryingFieldWrap(Getter &&getter, Setter &&setter, Size &&size)
+  template <
+      typename Getter, typename Setter, typename BlockGetter,
+      typename BlockSetter, typename Size>
+  VaryingFieldWrap(
+      Getter &&getter, Setter &&setter, BlockGetter &&block_getter,
+      BlockSetter &&block_setter, Size &&size)
       : get_{std::forward<Getter>(getter)}, set_{std::forward<Setter>(setter)},
-        size_{size} {}
+        get_block_{std::forward<BlockGetter>(block_getter)},
+        set_block_{std::forward<BlockSetter>(block_setter)}, size_{size} {}
 
 private:
   std::function<ItemType(size_t)> get_;
   std::function<void(size_t, ItemType const &)> set_;
+  std::function<void(size_t, cxx::span<ItemType>)> get_block_;
+  std::function<void(size_t, cxx::span<ItemType const>)> set_block_;
   std::function<size_t()> size_;
 };
 
@@ -129,7 +250,21 @@ public:
 public:
   virtual void Resize(size_t new_size) = 0;
 
-  virtual void ConsumePermutation(cxx::span<size_t> mut_perm) = 0;
+  //! Ensures that the field can hold capacity items without reallocating.
+  virtual void Reserve(size_t capacity) = 0;
+
+  //! Removes the items at the (sorted and unique) indices, the order of the
+  //! remaining items is preserved.
+  virtual void EraseItems(cxx::span<size_t const> indices) = 0;
+
+  //! Reorders the items such that item i is the previous item perm[i], the
+  //! buffer must be able to hold all items (GetByteSize bytes, aligned to a
+  //! cache line).  Items that do not occur in a shorter perm are removed.
+  //! The storage of the field is not reallocated.
+  virtual void ApplyPermutation(cxx::span<size_t const> perm, void *buffer) = 0;
+
+  //! Number of bytes occupied by the items of this field.
+  virtual size_t GetByteSize() const = 0;
 
 public:
   virtual void GetScalar(size_t index, RealScalar &scalar) const = 0;
@@ -145,10 +280,42 @@ public:
 
   virtual void SetMatrix(size_t index, RealMatrix const &matrix) = 0;
 
+public:
+  //! Copies the components of count items starting at first into out, which
+  //! must hold count times the item component count values.
+  virtual void GetRealRange(size_t first, size_t count, double *out) const = 0;
+
+  //! Copies the components of count items starting at first from inp.
+  virtual void SetRealRange(size_t first, size_t count, double const *inp) = 0;
+
+  //! Sets count items starting at first to the components of one item.
+  virtual void
+  FillRealRange(size_t first, size_t count, double const *item) = 0;
+
+  //! Returns a pointer to the contiguous component storage of all items.
+  virtual void *GetRawData() = 0;
+
+public:
+  //! Sets the double precision origin (one value per item component) that the
+  //! items of a floating point field are stored relative to.  If rebase, the
+  //! stored items are shifted such that their absolute values are kept.
+  //! Spans and the raw data hold the relative items, all other accessors
+  //! convert from and to absolute values.
+  virtual void SetOrigin(cxx::span<double const> origin, bool rebase) = 0;
+
 public:
   virtual void Save(ArchiveWriter &archive) const = 0;
 
   virtual void Load(ArchiveReader &archive) = 0;
+
+  //! Saves the values of count items starting at first (without any size).
+  virtual void
+  SaveRange(ArchiveWriter &archive, size_t first, size_t count) const = 0;
+
+  //! Loads the values of count items starting at first, the field must
+  //! already be big enough.
+  virtual void
+  LoadRange(ArchiveReader &archive, size_t first, size_t count) = 0;
 };
 
 template <typename T, size_t... N>
@@ -163,19 +330,40 @@ public:
 
 public:
   void Resize(size_t new_size) final {
-    data_.resize(new_size, math::zeros<T, N...>());
+    auto const old_size = data_.size();
+    // new items are initialized in parallel instead of by the calling thread
+    data_.resize(new_size, boost::container::default_init);
+    if (new_size > old_size)
+      ParallelFill(
+          data_.data() + old_size, new_size - old_size,
+          static_cast<ItemType>(math::zeros<T, N...>()));
+  }
+
+  void Reserve(size_t capacity) final { data_.reserve(capacity); }
+
+  void EraseItems(cxx::span<size_t const> indices) final {
+    detail::EraseSortedIndices(data_, indices);
   }
 
-  void ConsumePermutation(cxx::span<size_t> mut_perm) final {
-    boost::algorithm::apply_permutation(data_, mut_perm);
+  void ApplyPermutation(cxx::span<size_t const> perm, void *buffer) final {
+    assert(perm.size() <= data_.size());
+    auto *scratch = static_cast<ItemType *>(buffer);
+    // gather into the buffer and copy back, the copy is sequential and keeps
+    // all spans of this field valid
+    for (size_t i = 0; i < perm.size(); ++i)
+      new (scratch + i) ItemType(data_[perm[i]]);
+    std::copy_n(scratch, perm.size(), data_.data());
+    data_.resize(perm.size());
   }
 
+  size_t GetByteSize() const final { return data_.size() * sizeof(ItemType); }
+
 private:
   template <size_t Rank, typename OutComp, typename OutItem>
   void GetImpl(size_t index, OutItem &out) const {
     if constexpr (Rank == sizeof...(N)) {
       if constexpr (IsComponentConvertible<T, OutComp>())
-        out = math::ComponentCast<OutComp>(data_[index]);
+        out = ToAbsolute<OutComp>(data_[index], origin_);
       else
         throw "INVALID TYPE";
     } else
@@ -200,7 +388,7 @@ private:
   void SetImpl(size_t index, InpItem const &inp) {
     if constexpr (Rank == sizeof...(N)) {
       if constexpr (IsComponentConvertible<InpComp, T>())
-        data_[index] = math::ComponentCast<T>(inp);
+        data_[index] = ToRelative(inp, origin_);
       else
         throw "INVALID TYPE";
     } else
@@ -220,6 +408,135 @@ public:
     SetImpl<2, RealScalar>(index, matrix);
   }
 
+private:
+  static constexpr size_t kItemComponentCount = (size_t{1} * ... * N);
+
+  T *ComponentData(size_t index) {
+    // TODO: relies on the Eigen math library
+    if constexpr (0 == sizeof...(N))
+      return &data_[index];
+    else
+      return data_[index].data();
+  }
+
+  T const *ComponentData(size_t index) const {
+    return const_cast<VaryingFieldData *>(this)->ComponentData(index);
+  }
+
+public:
+  void GetRealRange(size_t first, size_t count, double *out) const final {
+    assert(first + count <= data_.size());
+    if constexpr (IsComponentConvertible<T, double>()) {
+      if (count == 0)
+        return;
+      auto const *components = ComponentData(first);
+      auto const *origin = OriginComponents();
+      for (size_t i = 0; i < count; ++i)
+        for (size_t c = 0; c < kItemComponentCount; ++c, ++components, ++out)
+          *out = static_cast<double>(*components) + origin[c];
+    } else
+      throw "INVALID TYPE";
+  }
+
+  void SetRealRange(size_t first, size_t count, double const *inp) final {
+    assert(first + count <= data_.size());
+    if constexpr (IsComponentConvertible<double, T>()) {
+      if (count == 0)
+        return;
+      auto *components = ComponentData(first);
+      auto const *origin = OriginComponents();
+      for (size_t i = 0; i < count; ++i)
+        for (size_t c = 0; c < kItemComponentCount; ++c, ++components, ++inp)
+          *components = static_cast<T>(*inp - origin[c]);
+    } else
+      throw "INVALID TYPE";
+  }
+
+  void FillRealRange(size_t first, size_t count, double const *item) final {
+    assert(first + count <= data_.size());
+    if constexpr (IsComponentConvertible<double, T>()) {
+      ItemType value;
+      T *components;
+      if constexpr (0 == sizeof...(N))
+        components = &value;
+      else
+        components = value.data();
+      auto const *origin = OriginComponents();
+      for (size_t c = 0; c < kItemComponentCount; ++c)
+        components[c] = static_cast<T>(item[c] - origin[c]);
+      std::fill_n(data_.data() + first, count, value);
+    } else
+      throw "INVALID TYPE";
+  }
+
+  void *GetRawData() final {
+    return data_.empty() ? nullptr : ComponentData(0);
+  }
+
+public:
+  void SetOrigin(cxx::span<double const> origin, bool rebase) final {
+    if constexpr (std::is_floating_point_v<T>) {
+      if (origin.size() != kItemComponentCount)
+        throw InvalidShapeError{};
+
+      OriginType new_origin;
+      std::copy(origin.begin(), origin.end(), OriginComponents(new_origin));
+
+      if (rebase) {
+        OriginType const shift = origin_ - new_origin;
+        using item_index_t = std::ptrdiff_t;
+#pragma omp parallel for schedule(static)
+        for (item_index_t i = 0; i < static_cast<item_index_t>(data_.size());
+             ++i)
+          data_[static_cast<size_t>(i)] =
+              ToRelative(data_[static_cast<size_t>(i)], -shift);
+      }
+
+      origin_ = new_origin;
+      has_origin_ = std::any_of(
+          origin.begin(), origin.end(), [](double c) { return c != 0; });
+    } else
+      throw "INVALID TYPE";
+  }
+
+private:
+  using OriginType = math::Tensor<double, N...>;
+
+  static double *OriginComponents(OriginType &origin) {
+    if constexpr (0 == sizeof...(N))
+      return &origin;
+    else
+      return origin.data();
+  }
+
+  double const *OriginComponents() const {
+    return OriginComponents(const_cast<OriginType &>(origin_));
+  }
+
+  // converts a stored item to an absolute item with components of type U
+  template <typename U>
+  static math::Tensor<U, N...>
+  ToAbsolute(ItemType const &item, OriginType const &origin) {
+    if constexpr (std::is_floating_point_v<T>)
+      return math::ComponentCast<U>(
+          OriginType{math::ComponentCast<double>(item) + origin});
+    else
+      return math::ComponentCast<U>(item);
+  }
+
+  // converts an absolute value to a stored item
+  template <typename Value>
+  static ItemType ToRelative(Value const &value, OriginType const &origin) {
+    if constexpr (std::is_floating_point_v<T>)
+      return math::ComponentCast<T>(
+          OriginType{math::ComponentCast<double>(value) - origin});
+    else
+      return math::ComponentCast<T>(value);
+  }
+
+  OriginType origin_ = math::zeros<double, N...>();
+  bool has_origin_ = false;
+
 public:
   void Save(ArchiveWriter &archive) const final {
     auto const count = data_.size();
@@ -249,38 +566,91 @@ public:
     }
   }
 
+  void
+  SaveRange(ArchiveWriter &archive, size_t first, size_t count) const final {
+    assert(first + count <= data_.size());
+    if (count > 0) {
+      // TODO: relies on the Eigen math library
+      if constexpr (0 == sizeof...(N)) {
+        archive.SaveValues(count, &data_[first]);
+      } else {
+        auto const component_count = static_cast<size_t>(ItemType{}.size());
+        archive.SaveValues(count * component_count, data_[first].data());
+      }
+    }
+  }
+
+  void LoadRange(ArchiveReader &archive, size_t first, size_t count) final {
+    assert(first + count <= data_.size());
+    if (count > 0) {
+      // TODO: relies on the Eigen math library
+      if constexpr (0 == sizeof...(N)) {
+        archive.LoadValues(count, &data_[first]);
+      } else {
+        auto const component_count = static_cast<size_t>(ItemType{}.size());
+        archive.LoadValues(count * component_count, data_[first].data());
+      }
+    }
+  }
+
 public:
   VaryingFieldSpan<T, N...> Span() { return {data_}; }
 
+  //! The wrap reads the origin of this field when it is used, so it stays
+  //! valid across SetOrigin (but not across resizes, like a span).
   template <typename U>
   VaryingFieldWrap<U, N...> Wrap() {
     namespace hana = boost::hana;
     auto span = Span();
-    if constexpr (hana::type_c<T> == hana::type_c<U>) {
-      return {
-          // getter
-          [span](size_t index) -> ItemType { return span[index]; },
-          // setter
-          [span](size_t index, ItemType const &value) { span[index] = value; },
-          // size
-          [span]() { return span.size(); }};
-    } else {
-      using WrapItemType = typename VaryingFieldWrap<U, N...>::ItemType;
-      return {// getter
-              [span](size_t index) -> WrapItemType {
-                return math::ComponentCast<U>(span[index]);
-              },
-              // setter
-              [span](size_t index, WrapItemType const &value) {
-                span[index] = math::ComponentCast<T>(value);
-              },
-              // size
-              [span]() { return span.size(); }};
-    }
+    // the items are accessed directly as long as there is no origin
+    constexpr bool kSameType = hana::type_c<T> == hana::type_c<U>;
+
+    using WrapItemType = typename VaryingFieldWrap<U, N...>::ItemType;
+    return {// getter
+            [this, span](size_t index) -> WrapItemType {
+              if constexpr (kSameType)
+                if (not has_origin_)
+                  return span[index];
+              return ToAbsolute<U>(span[index], origin_);
+            },
+            // setter
+            [this, span](size_t index, WrapItemType const &value) {
+              if constexpr (kSameType)
+                if (not has_origin_) {
+                  span[index] = value;
+                  return;
+                }
+              span[index] = ToRelative(value, origin_);
+            },
+            // block getter
+            [this, span](size_t first, cxx::span<WrapItemType> values) {
+              if constexpr (kSameType)
+                if (not has_origin_) {
+                  span.GetBlock(first, values);
+                  return;
+                }
+              assert(first + values.size() <= span.size());
+              for (size_t i = 0; i < values.size(); ++i)
+                values[i] = ToAbsolute<U>(span[first + i], origin_);
+            },
+            // block setter
+            [this, span](size_t first, cxx::span<WrapItemType const> values) {
+              if constexpr (kSameType)
+                if (not has_origin_) {
+                  span.SetBlock(first, values);
+                  return;
+                }
+              assert(first + values.size() <= span.size());
+              for (size_t i = 0; i < values.size(); ++i)
+                span[first + i] = ToRelative(values[i], origin_);
+            },
+            // size
+            [span]() { return span.size(); }};
   }
 
 private:
-  boost::container::small_vector<ItemType, 0> data_;
+  boost::container::small_vector<ItemType, 0, FirstTouchAllocator<ItemType>>
+      data_;
 };
 
 class VaryingField;
@@ -308,10 +678,18 @@ public:
 public:
   void Resize(size_t new_size) { data_->Resize(new_size); }
 
-  void ConsumePermutation(cxx::span<size_t> mut_perm) {
-    data_->ConsumePermutation(mut_perm);
+  void Reserve(size_t capacity) { data_->Reserve(capacity); }
+
+  void EraseItems(cxx::span<size_t const> indices) {
+    data_->EraseItems(indices);
   }
 
+  void ApplyPermutation(cxx::span<size_t const> perm, void *buffer) {
+    data_->ApplyPermutation(perm, buffer);
+  }
+
+  size_t GetByteSize() const { return data_->GetByteSize(); }
+
 public:
   void Get(size_t index, RealScalar &scalar) const {
     data_->GetScalar(index, scalar);
@@ -338,11 +716,48 @@ public:
     data_->SetMatrix(index, matrix);
   }
 
+public:
+  void GetRealRange(size_t first, size_t count, double *out) const {
+    data_->GetRealRange(first, count, out);
+  }
+
+  void SetRealRange(size_t first, size_t count, double const *inp) const {
+    data_->SetRealRange(first, count, inp);
+  }
+
+  void FillRealRange(size_t first, size_t count, double const *item) const {
+    data_->FillRealRange(first, count, item);
+  }
+
+  void *GetRawData() const { return data_->GetRawData(); }
+
+  void SetOrigin(cxx::span<double const> origin, bool rebase = true) const {
+    data_->SetOrigin(origin, rebase);
+  }
+
 public:
   void Save(ArchiveWriter &archive) const { data_->Save(archive); }
 
   void Load(ArchiveReader &archive) { data_->Load(archive); }
 
+  void SaveRange(ArchiveWriter &archive, size_t first, size_t count) const {
+    data_->SaveRange(archive, first, count);
+  }
+
+  void LoadRange(ArchiveReader &archive, size_t first, size_t count) const {
+    data_->LoadRange(archive, first, count);
+  }
+
+  //! Skips the data of a field with the given type as written by Save.
+  static void Skip(ArchiveReader &archive, TensorType const &type) {
+    auto const count = archive.LoadSize();
+    // one component per scalar item, GetComponentCount counts none
+    auto const component_count = boost::accumulate(
+        type.GetShape().GetExtents(), size_t{1}, std::multiplies<void>{});
+    archive.SkipValues(
+        count * component_count, type.GetComponentType().GetByteSize());
+  }
+
 public:
   template <typename T, size_t... N>
   VaryingFieldSpan<T, N...> Span() const {
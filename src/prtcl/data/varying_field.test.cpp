@@ -63,4 +63,69 @@ TEST(VaryingField, SaveLoad) {
         ASSERT_EQ(789, span[2](2, 0));
       }
     }
-}
\ No newline at end of file
+}
+
+TEST(VaryingField, BulkAccess) {
+  using RVec3 = math::Tensor<double, 3>;
+  using FVec3 = math::Tensor<float, 3>;
+
+  auto field = MakeVaryingField<float, 3>();
+  field.Resize(3000);
+
+  auto wrap = field.Wrap<double, 3>();
+  ASSERT_TRUE(wrap);
+
+  std::vector<RVec3> values(2500);
+  for (size_t i = 0; i < values.size(); ++i)
+    values[i] = RVec3{static_cast<double>(i), 1, 2};
+
+  wrap.SetBlock(500, values);
+  wrap.Fill(0, 500, RVec3{-1, -1, -1});
+  wrap.Transform(
+      0, wrap.size(), [](RVec3 const &x) -> RVec3 { return 2 * x; });
+
+  auto span = field.Span<float, 3>();
+  ASSERT_EQ(FVec3(-2, -2, -2), span[499]);
+  ASSERT_EQ(FVec3(0, 2, 4), span[500]);
+  ASSERT_EQ(FVec3(4998, 2, 4), span[2999]);
+
+  std::vector<RVec3> block(2);
+  wrap.GetBlock(1000, block);
+  ASSERT_EQ(RVec3(1000, 2, 4), block[0]);
+
+  std::vector<double> reals(6);
+  field.GetRealRange(500, 2, reals.data());
+  ASSERT_EQ((std::vector<double>{0, 2, 4, 2, 2, 4}), reals);
+
+  double const item[] = {7, 8, 9};
+  field.FillRealRange(10, 2, item);
+  ASSERT_EQ(FVec3(7, 8, 9), span[11]);
+
+  field.SetRealRange(0, 2, reals.data());
+  ASSERT_EQ(FVec3(2, 2, 4), span[1]);
+
+  ASSERT_EQ(static_cast<void *>(span.data()), field.GetRawData());
+}
+
+TEST(VaryingField, WrapFollowsOrigin) {
+  using FVec3 = math::Tensor<float, 3>;
+
+  auto field = MakeVaryingField<float, 3>();
+  field.Resize(2);
+
+  // created before the origin is set, with and without conversion
+  auto same = field.Wrap<float, 3>();
+  auto real = field.Wrap<double, 3>();
+  same.Set(0, FVec3{1, 2, 3});
+
+  double const origin[] = {1, 1, 1};
+  field.SetOrigin(origin);
+
+  auto span = field.Span<float, 3>();
+  ASSERT_EQ(FVec3(0, 1, 2), span[0]);
+  ASSERT_EQ(FVec3(1, 2, 3), same.Get(0));
+  ASSERT_EQ((math::Tensor<double, 3>(1, 2, 3)), real.Get(0));
+
+  same.Set(1, FVec3{4, 4, 4});
+  ASSERT_EQ(FVec3(3, 3, 3), span[1]);
+}
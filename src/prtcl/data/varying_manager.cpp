@@ -1,7 +1,31 @@
 #include "varying_manager.hpp"
 
+#include <algorithm>
+
+#include <omp.h>
+
 namespace prtcl {
 
+namespace {
+
+// Returns a per-thread buffer of at least byte_size bytes.  The buffer only
+// ever grows, such that repeated permutations do not allocate.
+void *GetPermutationBuffer(size_t byte_size) {
+  struct alignas(64) CacheLine {
+    std::byte bytes[64];
+  };
+
+  thread_local std::vector<CacheLine> buffer;
+
+  auto const line_count =
+      (byte_size + sizeof(CacheLine) - 1) / sizeof(CacheLine);
+  if (buffer.size() < line_count)
+    buffer.resize(line_count);
+  return buffer.data();
+}
+
+} // namespace
+
 VaryingField VaryingManager::AddField(std::string_view name, TensorType type) {
   log::Debug(
       "lib", "VaryingManager::AddField",
@@ -18,21 +42,199 @@ VaryingField VaryingManager::GetField(std::string_view name) {
     throw FieldDoesNotExist{};
 }
 
+void VaryingManager::SetFieldOrigin(
+    std::string_view name, cxx::span<double const> origin, bool rebase) {
+  if (auto it = fields_.find(name); it != fields_.end())
+    it->second.SetOrigin(origin, rebase);
+
+  auto &stored = origins_[std::string{name}];
+  stored.assign(origin.begin(), origin.end());
+}
+
+void VaryingManager::ResizeItems(size_t new_size) {
+  if (new_size > capacity_)
+    ReserveItems(std::max(new_size, capacity_ + capacity_ / 2));
+
+  for (auto &[name, field] : fields_)
+    field.Resize(new_size);
+
+  if (tombstone_count_ > 0) {
+    tombstones_.resize(new_size, 0);
+    tombstone_count_ = static_cast<size_t>(
+        std::count(tombstones_.begin(), tombstones_.end(), 1));
+  }
+
+  size_ = new_size;
+
+  SetDirty(true);
+}
+
+void VaryingManager::ReserveItems(size_t capacity) {
+  if (capacity <= capacity_)
+    return;
+
+  for (auto &[name, field] : fields_)
+    field.Reserve(capacity);
+
+  capacity_ = capacity;
+}
+
+void VaryingManager::PermuteItems(cxx::span<size_t const> input_perm) {
+  if (omp_in_parallel()) {
+    PermuteItemsImpl(input_perm);
+  } else {
+#pragma omp parallel
+    PermuteItemsImpl(input_perm);
+  }
+}
+
+void VaryingManager::PermuteItemsImpl(cxx::span<size_t const> input_perm) {
+  assert(input_perm.size() == GetItemCount());
+
+#pragma omp single
+  {
+    // drop the items whose destruction was deferred from the permutation
+    permute_input_ = input_perm;
+    if (tombstone_count_ > 0) {
+      permute_compacted_.clear();
+      for (auto const index : input_perm)
+        if (not tombstones_[index])
+          permute_compacted_.push_back(index);
+      permute_input_ = permute_compacted_;
+    }
+
+    // schedule the largest fields first to balance the load
+    permute_order_.clear();
+    for (auto &entry : fields_)
+      permute_order_.push_back(&entry.second);
+    std::stable_sort(
+        permute_order_.begin(), permute_order_.end(),
+        [](auto const *lhs, auto const *rhs) {
+          return lhs->GetByteSize() > rhs->GetByteSize();
+        });
+  }
+
+  using fidx_t = std::ptrdiff_t;
+#pragma omp for schedule(dynamic)
+  for (fidx_t fidx = 0; fidx < static_cast<fidx_t>(permute_order_.size());
+       ++fidx) {
+    auto &field = *permute_order_[static_cast<size_t>(fidx)];
+    assert(GetItemCount() == field.GetSize());
+    field.ApplyPermutation(
+        permute_input_, GetPermutationBuffer(field.GetByteSize()));
+  }
+
+#pragma omp single
+  {
+    size_ = permute_input_.size();
+    tombstones_.clear();
+    tombstone_count_ = 0;
+
+    // set the dirty flag if particles were reordered
+    SetDirty(true);
+  }
+}
+
+void VaryingManager::DestroyItems(cxx::span<size_t const> indices) {
+  if (indices.size() == 0)
+    return;
+
+  // copy, sort and deduplicate the indices that are to be destroyed
+  destroy_items_.assign(indices.begin(), indices.end());
+  std::sort(destroy_items_.begin(), destroy_items_.end());
+  destroy_items_.erase(
+      std::unique(destroy_items_.begin(), destroy_items_.end()),
+      destroy_items_.end());
+
+  EraseDestroyedItems();
+}
+
+void VaryingManager::EraseDestroyedItems() {
+  assert(destroy_items_.back() < GetItemCount());
+
+  // only the items behind the first destroyed item are moved
+  using fidx_t = std::ptrdiff_t;
+#pragma omp parallel for schedule(dynamic)
+  for (fidx_t fidx = 0; fidx < static_cast<fidx_t>(fields_.size()); ++fidx)
+    fields_.begin()[fidx].second.EraseItems(destroy_items_);
+
+  if (tombstone_count_ > 0) {
+    detail::EraseSortedIndices(tombstones_, destroy_items_);
+    tombstone_count_ = static_cast<size_t>(
+        std::count(tombstones_.begin(), tombstones_.end(), 1));
+  }
+
+  size_ -= destroy_items_.size();
+
+  SetDirty(true);
+}
+
+void VaryingManager::DestroyItemsDeferred(cxx::span<size_t const> indices) {
+  if (indices.size() == 0)
+    return;
+
+  if (tombstone_count_ == 0)
+    tombstones_.assign(GetItemCount(), 0);
+
+  for (auto const index : indices) {
+    assert(index < GetItemCount());
+    if (not tombstones_[index]) {
+      tombstones_[index] = 1;
+      ++tombstone_count_;
+    }
+  }
+}
+
+void VaryingManager::CompactItems() {
+  if (tombstone_count_ == 0)
+    return;
+
+  destroy_items_.clear();
+  for (size_t index = 0; index < tombstones_.size(); ++index)
+    if (tombstones_[index])
+      destroy_items_.push_back(index);
+
+  tombstones_.clear();
+  tombstone_count_ = 0;
+
+  EraseDestroyedItems();
+}
+
 void VaryingManager::Save(ArchiveWriter &archive) const {
+  Save(archive, [](std::string_view) { return true; });
+}
+
+void VaryingManager::Load(ArchiveReader &archive) {
+  Load(archive, [](std::string_view) { return true; });
+}
+
+void VaryingManager::Save(
+    ArchiveWriter &archive, FieldPredicate const &select) const {
   archive.SaveSize(size_);
 
-  archive.SaveSize(this->fields_.size());
+  auto const field_count = static_cast<size_t>(std::count_if(
+      fields_.begin(), fields_.end(),
+      [&select](auto const &entry) { return select(entry.first); }));
+
+  archive.SaveSize(field_count);
   for (auto const &[name, field] : this->fields_) {
+    if (not select(name))
+      continue;
+
     archive.SaveString(name);
     field.GetType().Save(archive);
     field.Save(archive);
   }
 }
 
-void VaryingManager::Load(ArchiveReader &archive) {
+void VaryingManager::Load(ArchiveReader &archive, FieldPredicate const &select) {
   size_ = archive.LoadSize();
+  capacity_ = std::max(capacity_, size_);
   this->dirty_ = true;
 
+  tombstones_.clear();
+  tombstone_count_ = 0;
+
   size_t const field_count = archive.LoadSize();
   for (size_t field_index = 0; field_index < field_count; ++field_index) {
     auto const name = archive.LoadString();
@@ -40,8 +242,16 @@ void VaryingManager::Load(ArchiveReader &archive) {
     TensorType type;
     type.Load(archive);
 
-    this->AddField(name, type).Load(archive);
+    if (select(name))
+      this->AddField(name, type).Load(archive);
+    else
+      VaryingField::Skip(archive, type);
   }
+
+  // fields that already existed but were not loaded must match the new size
+  for (auto &[name, field] : fields_)
+    if (field.GetSize() != size_)
+      field.Resize(size_);
 }
 
 } // namespace prtcl
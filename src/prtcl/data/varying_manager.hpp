@@ -12,17 +12,17 @@
 #include "../log.hpp"
 
 #include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <boost/container/flat_map.hpp>
 
 #include <boost/range/adaptor/map.hpp>
 #include <boost/range/adaptor/transformed.hpp>
-#include <boost/range/algorithm/copy.hpp>
-#include <boost/range/algorithm/copy_backward.hpp>
-#include <boost/range/algorithm/set_algorithm.hpp>
 #include <boost/range/irange.hpp>
 #include <boost/range/iterator_range.hpp>
 
@@ -40,6 +40,11 @@ public:
     if (not inserted and it->second.GetType() != GetTensorTypeCRef<T, N...>())
       throw FieldOfDifferentTypeAlreadyExistsError{};
 
+    if (inserted)
+      if (auto origin = origins_.find(name); origin != origins_.end())
+        it->second.SetOrigin(origin->second, false);
+
+    it->second.Reserve(capacity_);
     it->second.Resize(GetItemCount());
     return it->second.template Span<T, N...>();
   }
@@ -74,32 +79,43 @@ public:
   }
 
 public:
-  void ResizeItems(size_t new_size) {
-    for (auto &[name, field] : fields_)
-      field.Resize(new_size);
+  //! Sets the origin that the items of the field name are stored relative to
+  //! (see VaryingFieldBase::SetOrigin), fields of that name that are added
+  //! later are stored relative to the same origin.
+  void SetFieldOrigin(
+      std::string_view name, cxx::span<double const> origin,
+      bool rebase = true);
+
+  //! Returns the origin of the field name, empty if none was set.
+  cxx::span<double const> GetFieldOrigin(std::string_view name) const {
+    if (auto it = origins_.find(name); it != origins_.end())
+      return it->second;
+    else
+      return {};
+  }
 
-    size_ = new_size;
+public:
+  //! Resizes all fields, the capacity grows geometrically such that repeated
+  //! creation of items only reallocates the fields occasionally.
+  void ResizeItems(size_t new_size);
 
-    SetDirty(true);
-  }
+  //! Ensures that capacity items can be held without reallocating any field.
+  void ReserveItems(size_t capacity);
 
-  void PermuteItems(cxx::span<size_t const> input_perm) {
-    thread_local std::vector<size_t> work_perm;
-    work_perm.reserve(GetItemCount());
-
-    using fidx_t = typename decltype(fields_)::difference_type;
-#pragma omp for schedule(dynamic)
-    for (fidx_t fidx = 0; fidx < static_cast<fidx_t>(fields_.size()); ++fidx) {
-      auto &field = fields_.begin()[fidx].second;
-      assert(GetItemCount() == field.GetSize());
-      work_perm.clear();
-      boost::copy(input_perm, std::back_inserter(work_perm));
-      field.ConsumePermutation(work_perm);
-    }
-
-    // set the dirty flag if particles were reordered
-    SetDirty(true);
-  }
+  size_t GetCapacity() const { return capacity_; }
+
+  //! Reorders the items of all fields such that item i is the previous item
+  //! input_perm[i].  The fields are distributed over the threads, largest
+  //! first; if called from inside a parallel region, all threads of the team
+  //! must call this.  Items whose destruction was deferred are removed.
+  void PermuteItems(cxx::span<size_t const> input_perm);
+
+private:
+  void PermuteItemsImpl(cxx::span<size_t const> input_perm);
+
+  std::vector<VaryingField *> permute_order_;
+  cxx::span<size_t const> permute_input_;
+  std::vector<size_t> permute_compacted_;
 
 public:
   boost::integer_range<size_t> CreateItems(size_t count) {
@@ -109,33 +125,32 @@ public:
     return boost::irange(old_size, new_size);
   }
 
-  void DestroyItems(cxx::span<size_t const> indices) {
-    if (indices.size() == 0)
-      return;
-
-    // ensure the permutation buffer is big enough
-    destroy_items_perm_.resize(GetItemCount());
+  //! Immediately removes the items, the order of the remaining items is
+  //! preserved.
+  void DestroyItems(cxx::span<size_t const> indices);
 
-    // copy and sort the indices that are to be destroyed
-    auto first = boost::copy_backward(indices, destroy_items_perm_.end());
-    std::sort(first, destroy_items_perm_.end());
+  //! Marks the items for destruction, they stay valid until they are removed
+  //! by the next PermuteItems or CompactItems.
+  void DestroyItemsDeferred(cxx::span<size_t const> indices);
 
-    // generate the remaining indices of the permutation
-    boost::range::set_difference(
-        boost::irange<size_t>(0, GetItemCount()),
-        boost::make_iterator_range(first, destroy_items_perm_.end()),
-        destroy_items_perm_.begin());
+  //! Removes all items whose destruction was deferred.
+  void CompactItems();
 
-    // permute this groups fields such that all particles that are to be
-    // destroyed are in the end
-    PermuteItems(destroy_items_perm_);
+  size_t GetDeferredDestroyCount() const { return tombstone_count_; }
 
-    // remove the particles by resizing this group
-    ResizeItems(GetItemCount() - indices.size());
+  bool IsDestroyDeferred(size_t index) const {
+    return tombstone_count_ > 0 and tombstones_[index];
   }
 
 private:
-  std::vector<size_t> destroy_items_perm_;
+  // removes the items in destroy_items_ (sorted and unique)
+  void EraseDestroyedItems();
+
+  std::vector<size_t> destroy_items_;
+
+  // one flag per item if any destruction is deferred, empty otherwise
+  std::vector<uint8_t> tombstones_;
+  size_t tombstone_count_ = 0;
 
 public:
   bool IsDirty() const { return dirty_; }
@@ -167,15 +182,26 @@ public:
   }
 
 public:
+  using FieldPredicate = std::function<bool(std::string_view)>;
+
   void Save(ArchiveWriter &archive) const;
 
   void Load(ArchiveReader &archive);
 
+  //! Only saves the fields whose names satisfy the predicate.
+  void Save(ArchiveWriter &archive, FieldPredicate const &select) const;
+
+  //! Only loads the fields whose names satisfy the predicate, the data of all
+  //! other fields is skipped.
+  void Load(ArchiveReader &archive, FieldPredicate const &select);
+
 private:
   size_t size_ = 0;
+  size_t capacity_ = 0;
   bool dirty_ = false;
 
   cxx::het_flat_map<std::string, VaryingField> fields_;
+  cxx::het_flat_map<std::string, std::vector<double>> origins_;
 };
 
 } // namespace prtcl
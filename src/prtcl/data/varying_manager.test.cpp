@@ -155,3 +155,67 @@ TEST(VaryingManager, SaveLoadTest) {
     ASSERT_EQ(90.0, d[4](1, 1));
   }
 }
+
+TEST(VaryingManager, PermuteItems) {
+  VaryingManager manager;
+  manager.ResizeItems(4);
+
+  auto a = manager.AddFieldImpl<int32_t>("a");
+  auto b = manager.AddFieldImpl<double, 3>("b");
+  for (size_t i = 0; i < 4; ++i) {
+    a[i] = static_cast<int32_t>(i);
+    b[i] = math::Tensor<double, 3>{static_cast<double>(i), 0, 1};
+  }
+
+  auto const *b_data = b.data();
+
+  std::vector<size_t> const perm{2, 0, 3, 1};
+  manager.PermuteItems(perm);
+
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(static_cast<int32_t>(perm[i]), a[i]);
+    ASSERT_EQ(static_cast<double>(perm[i]), b[i][0]);
+  }
+
+  // the storage is permuted in place, existing spans stay valid
+  auto const b_after = manager.FieldSpan<double, 3>("b");
+  ASSERT_EQ(b_data, b_after.data());
+}
+
+TEST(VaryingManager, DestroyItems) {
+  VaryingManager manager;
+  auto a = manager.AddFieldImpl<int32_t>("a");
+
+  manager.CreateItems(6);
+  ASSERT_LE(6, manager.GetCapacity());
+  a = manager.FieldSpan<int32_t>("a");
+  for (size_t i = 0; i < 6; ++i)
+    a[i] = static_cast<int32_t>(i);
+
+  // immediate destruction preserves the order of the remaining items
+  std::vector<size_t> const destroy{4, 1, 4};
+  manager.DestroyItems(destroy);
+  ASSERT_EQ(4, manager.GetItemCount());
+  for (auto [i, value] : {std::pair{0, 0}, {1, 2}, {2, 3}, {3, 5}})
+    ASSERT_EQ(value, a[static_cast<size_t>(i)]);
+
+  // deferred destruction keeps the items until the next permutation
+  std::vector<size_t> const deferred{0, 2};
+  manager.DestroyItemsDeferred(deferred);
+  ASSERT_EQ(2, manager.GetDeferredDestroyCount());
+  ASSERT_EQ(4, manager.GetItemCount());
+  ASSERT_TRUE(manager.IsDestroyDeferred(2));
+  ASSERT_FALSE(manager.IsDestroyDeferred(1));
+
+  std::vector<size_t> const perm{3, 2, 1, 0};
+  manager.PermuteItems(perm);
+  ASSERT_EQ(0, manager.GetDeferredDestroyCount());
+  ASSERT_EQ(2, manager.GetItemCount());
+  ASSERT_EQ(5, a[0]);
+  ASSERT_EQ(2, a[1]);
+
+  manager.DestroyItemsDeferred(std::vector<size_t>{1});
+  manager.CompactItems();
+  ASSERT_EQ(1, manager.GetItemCount());
+  ASSERT_EQ(5, a[0]);
+}
@@ -0,0 +1 @@
+#include "invalid_archive_error.hpp"
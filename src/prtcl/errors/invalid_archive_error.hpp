@@ -0,0 +1,15 @@
+#ifndef PRTCL_SRC_PRTCL_ERRORS_INVALID_ARCHIVE_ERROR_HPP
+#define PRTCL_SRC_PRTCL_ERRORS_INVALID_ARCHIVE_ERROR_HPP
+
+#include <stdexcept>
+
+namespace prtcl {
+
+class InvalidArchiveError : public std::exception {
+public:
+  char const *what() const noexcept final { return "invalid archive"; }
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_ERRORS_INVALID_ARCHIVE_ERROR_HPP
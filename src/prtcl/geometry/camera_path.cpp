@@ -0,0 +1,45 @@
+#include "camera_path.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include <cassert>
+
+namespace prtcl {
+
+void CameraPath::AddKey(double frame, PinholeCamera const &camera) {
+  auto it = std::lower_bound(
+      keys_.begin(), keys_.end(), frame,
+      [](auto const &key, double value) { return key.first < value; });
+  if (it != keys_.end() and it->first == frame)
+    it->second = camera;
+  else
+    keys_.emplace(it, frame, camera);
+}
+
+PinholeCamera CameraPath::GetCamera(double frame) const {
+  assert(not keys_.empty());
+
+  auto const next = std::upper_bound(
+      keys_.begin(), keys_.end(), frame,
+      [](double value, auto const &key) { return value < key.first; });
+  if (next == keys_.begin())
+    return keys_.front().second;
+  if (next == keys_.end())
+    return keys_.back().second;
+
+  auto const &[frame_a, a] = *std::prev(next);
+  auto const &[frame_b, b] = *next;
+  double const t = (frame - frame_a) / (frame_b - frame_a);
+
+  PinholeCamera result = a;
+  result.camera.origin = (1 - t) * a.camera.origin + t * b.camera.origin;
+  result.camera.principal =
+      (1 - t) * a.camera.principal + t * b.camera.principal;
+  result.camera.up = (1 - t) * a.camera.up + t * b.camera.up;
+  result.camera.focal_length =
+      (1 - t) * a.camera.focal_length + t * b.camera.focal_length;
+  return result;
+}
+
+} // namespace prtcl
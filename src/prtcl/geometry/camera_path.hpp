@@ -0,0 +1,37 @@
+#ifndef PRTCL_SRC_PRTCL_GEOMETRY_CAMERA_PATH_HPP
+#define PRTCL_SRC_PRTCL_GEOMETRY_CAMERA_PATH_HPP
+
+#include "pinhole_camera.hpp"
+
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+namespace prtcl {
+
+//! Camera that moves along key frames, the origin, the principal and up
+//! directions and the focal length are interpolated linearly.  Before the
+//! first and after the last key the camera stands still.
+class CameraPath {
+public:
+  bool IsEmpty() const { return keys_.empty(); }
+
+  size_t GetKeyCount() const { return keys_.size(); }
+
+  //! Adds a key at the (fractional) frame, a previous key at the same frame
+  //! is replaced.
+  void AddKey(double frame, PinholeCamera const &camera);
+
+  //! Returns the camera at the frame, the sensor is taken from the previous
+  //! key.  The path must not be empty.
+  PinholeCamera GetCamera(double frame) const;
+
+private:
+  //! Sorted by frame.
+  std::vector<std::pair<double, PinholeCamera>> keys_;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_GEOMETRY_CAMERA_PATH_HPP
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "camera_path.hpp"
+
+using namespace prtcl;
+
+namespace {
+
+PinholeCamera MakeCamera(double x, double focal_length) {
+  PinholeCamera camera;
+  camera.camera.origin = {x, 0, 0};
+  camera.camera.principal = {0, 0, 1};
+  camera.camera.up = {0, 1, 0};
+  camera.camera.focal_length = focal_length;
+  camera.sensor.width = 4;
+  camera.sensor.height = 3;
+  return camera;
+}
+
+TEST(CameraPath, Interpolation) {
+  CameraPath path;
+  EXPECT_TRUE(path.IsEmpty());
+
+  // keys can be added in any order
+  path.AddKey(10, MakeCamera(2, 3));
+  path.AddKey(0, MakeCamera(0, 1));
+  EXPECT_EQ(path.GetKeyCount(), 2);
+
+  auto const middle = path.GetCamera(5);
+  EXPECT_DOUBLE_EQ(middle.camera.origin[0], 1);
+  EXPECT_DOUBLE_EQ(middle.camera.focal_length, 2);
+  EXPECT_EQ(middle.sensor.width, 4);
+
+  // the camera stands still outside of the keys
+  EXPECT_DOUBLE_EQ(path.GetCamera(-3).camera.origin[0], 0);
+  EXPECT_DOUBLE_EQ(path.GetCamera(20).camera.origin[0], 2);
+
+  // keys at the same frame are replaced
+  path.AddKey(10, MakeCamera(4, 3));
+  EXPECT_EQ(path.GetKeyCount(), 2);
+  EXPECT_DOUBLE_EQ(path.GetCamera(10).camera.origin[0], 4);
+}
+
+} // namespace
@@ -2,6 +2,8 @@
 
 #include "../math.hpp"
 
+#include <utility>
+
 #include <cmath>
 
 namespace prtcl {
@@ -29,37 +31,58 @@ public:
   } sensor;
 
 public:
-  template <typename PerRay>
-  void Cast(PerRay per_ray) const {
-    // vertical, principal and horizontal directions of the camera
-    RVec const v = math::normalized(camera.up);
-    RVec const p = math::normalized(camera.principal);
-    RVec const h = math::normalized(math::cross(v, p));
-
-    // width of a single pixel
-    Real const pixel_size = static_cast<Real>(1) / static_cast<Real>(sensor.width);
-
-    // origin of the sensor in the 2d image plane
-    Real const sensor_origin_x = -static_cast<Real>(sensor.width - 1) / 2;
-    Real const sensor_origin_y = -static_cast<Real>(sensor.height - 1) / 2;
-
-    auto const O = camera.origin;
-    auto const f = camera.focal_length;
+  //! The basis of the camera and the origin of the sensor, which are shared
+  //! by all rays of an image.
+  class Projection {
+  public:
+    explicit Projection(PinholeCamera const &camera_) {
+      auto const &camera = camera_.camera;
+      auto const &sensor = camera_.sensor;
+
+      // vertical, principal and horizontal directions of the camera
+      v_ = math::normalized(camera.up);
+      p_ = math::normalized(camera.principal);
+      h_ = math::normalized(math::cross(v_, p_));
+
+      // width of a single pixel
+      pixel_size_ = Real{1} / static_cast<Real>(sensor.width);
+
+      // origin of the sensor in the 2d image plane
+      sensor_origin_x_ = -static_cast<Real>(sensor.width - 1) / 2;
+      sensor_origin_y_ = -static_cast<Real>(sensor.height - 1) / 2;
+
+      origin_ = camera.origin;
+      focal_length_ = camera.focal_length;
+    }
 
-    // log::debug(
-    //    "camera", "cast", "v=", h, " h=", v, " p=", p, " sox=",
-    //    sensor_origin_x, " soy=", sensor_origin_y, " O=", O, " f=", f);
+  public:
+    //! Returns the origin and the direction of the ray through pixel (ix, iy).
+    std::pair<RVec, RVec> GetRay(size_t ix, size_t iy) const {
+      Real const pixel_x =
+          (sensor_origin_x_ + static_cast<Real>(ix)) * pixel_size_;
+      Real const pixel_y =
+          (sensor_origin_y_ + static_cast<Real>(iy)) * pixel_size_;
+      RVec const pixel_point =
+          origin_ + pixel_x * h_ + pixel_y * v_ - focal_length_ * p_;
+
+      return {origin_, math::normalized(origin_ - pixel_point)};
+    }
 
-    auto pixel_point = [=](auto ix, auto iy) -> RVec {
-      Real const pixel_x = (sensor_origin_x + ix) * pixel_size;
-      Real const pixel_y = (sensor_origin_y + iy) * pixel_size;
+  private:
+    RVec v_, p_, h_, origin_;
+    Real pixel_size_, sensor_origin_x_, sensor_origin_y_, focal_length_;
+  };
 
-      return O + pixel_x * h + pixel_y * v - f * p;
-    };
+  //! Computes the projection once for all rays of an image.
+  Projection GetProjection() const { return Projection{*this}; }
 
+  template <typename PerRay>
+  void Cast(PerRay per_ray) const {
+    auto const projection = GetProjection();
     for (size_t ix = 0; ix < sensor.width; ++ix) {
       for (size_t iy = 0; iy < sensor.height; ++iy) {
-        per_ray(ix, iy, O, math::normalized(O - pixel_point(ix, iy)));
+        auto const [origin, direction] = projection.GetRay(ix, iy);
+        per_ray(ix, iy, origin, direction);
       }
     }
   }
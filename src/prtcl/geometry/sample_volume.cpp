@@ -1 +1,213 @@
 #include "sample_volume.hpp"
+
+#include "../log.hpp"
+#include "triangle_bvh.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <utility>
+
+namespace prtcl::detail {
+
+namespace {
+
+using Real = double;
+using RVec = TensorT<Real, 3>;
+using RVec2 = TensorT<Real, 2>;
+
+struct EdgeValue {
+  Real value;
+  int sign;
+};
+
+// Evaluates the edge function of the directed edge p -> q at x.  The value is
+// always computed with the endpoints in a canonical order, such that the two
+// faces sharing an edge see exactly negated values.  If x lies on the edge,
+// the sign is taken as if x was displaced by (eps, eps^2), which assigns x to
+// exactly one of the two faces (simulation of simplicity).
+EdgeValue Edge(RVec2 p, RVec2 q, RVec2 const &x) {
+  bool const flip = q[0] < p[0] or (q[0] == p[0] and q[1] < p[1]);
+  if (flip)
+    std::swap(p, q);
+
+  Real const value =
+      (q[0] - p[0]) * (x[1] - p[1]) - (q[1] - p[1]) * (x[0] - p[0]);
+
+  Real tie = value;
+  if (tie == 0)
+    tie = -(q[1] - p[1]);
+  if (tie == 0)
+    tie = q[0] - p[0];
+
+  int const sign = (tie > 0) - (tie < 0);
+  return flip ? EdgeValue{-value, -sign} : EdgeValue{value, sign};
+}
+
+struct Crossing {
+  Real z;
+  // orientation of the face as seen along the ray
+  int sign;
+};
+
+// Intersects the line through x parallel to the z-axis with the face abc.
+std::optional<Crossing>
+CrossFace(RVec const &a, RVec const &b, RVec const &c, RVec2 const &x) {
+  RVec2 const pa{a[0], a[1]}, pb{b[0], b[1]}, pc{c[0], c[1]};
+
+  auto const ea = Edge(pb, pc, x), eb = Edge(pc, pa, x), ec = Edge(pa, pb, x);
+  if (ea.sign == 0 or ea.sign != eb.sign or eb.sign != ec.sign)
+    return std::nullopt;
+
+  Real const sum = ea.value + eb.value + ec.value;
+  if (sum == 0)
+    return std::nullopt;
+
+  return Crossing{
+      (ea.value * a[2] + eb.value * b[2] + ec.value * c[2]) / sum, ea.sign};
+}
+
+} // namespace
+
+std::vector<TensorT<double, 3>>
+SampleVolume(TriangleMesh const &mesh, SampleVolumeParameters const &p_) {
+  static constexpr size_t N = 3;
+
+  // compute aabb of the mesh
+  RVec x_lo = math::positive_infinity<Real, N>(),
+       x_hi = math::negative_infinity<Real, N>();
+  for (auto const &x : mesh.Vertices()) {
+    x_lo = math::cmin(x_lo, x);
+    x_hi = math::cmax(x_hi, x);
+  }
+
+  // create a grid over the meshes aabb
+  RVec step;
+  std::array<size_t, N> extents;
+  for (size_t n = 0; n < N; ++n) {
+    auto const d = static_cast<int>(n);
+
+    auto const delta = x_hi - x_lo;
+    extents[n] =
+        static_cast<size_t>(std::round(delta[d] / p_.maximum_sample_distance));
+    step[d] = delta[d] / static_cast<Real>(extents[n]);
+    log::Debug(
+        "lib", "SampleVolume", "extent=", n, " ", delta[d], " ",
+        p_.maximum_sample_distance, " ", extents[n], " ", step[d]);
+  }
+
+  TriangleBVH const bvh{mesh};
+
+  auto const &vertices = mesh.Vertices();
+  auto const &faces = mesh.Faces();
+
+  bool const parity = p_.inside_test == SampleVolumeInsideTest::kParity;
+
+  // Each row of grid points along the z-axis is served by a single line
+  // query, the sorted crossings are then swept to fill the interior spans.
+  // Rows are processed in parallel in slabs of constant x, the samples of
+  // each slab are kept separately to preserve the order of the grid.
+  std::vector<std::vector<RVec>> slabs(extents[0]);
+
+  using slab_index_t = std::ptrdiff_t;
+#pragma omp parallel
+  {
+    std::vector<Crossing> crossings;
+
+#pragma omp for schedule(dynamic)
+    for (slab_index_t i0 = 0; i0 < static_cast<slab_index_t>(extents[0]);
+         ++i0) {
+      auto &samples = slabs[static_cast<size_t>(i0)];
+
+      for (size_t i1 = 0; i1 < extents[1]; ++i1) {
+        RVec const origin =
+            x_lo + math::cmul(
+                       RVec{
+                           static_cast<Real>(i0), static_cast<Real>(i1),
+                           Real{0}},
+                       step);
+        RVec2 const x{origin[0], origin[1]};
+
+        crossings.clear();
+        bvh.ForEachCandidate(
+            origin, RVec{0, 0, 1}, -std::numeric_limits<Real>::infinity(),
+            std::numeric_limits<Real>::infinity(), [&](auto f) {
+              auto const &face = faces[f];
+              if (auto crossing = CrossFace(
+                      vertices[face[0]], vertices[face[1]], vertices[face[2]],
+                      x))
+                crossings.push_back(*crossing);
+            });
+
+        if (crossings.empty())
+          continue;
+
+        std::sort(
+            crossings.begin(), crossings.end(),
+            [](auto const &lhs, auto const &rhs) { return lhs.z < rhs.z; });
+
+        size_t next = 0;
+        int crossed = 0, winding = 0;
+        for (size_t i2 = 0; i2 < extents[2]; ++i2) {
+          RVec g = origin;
+          g[2] = x_lo[2] + static_cast<Real>(i2) * step[2];
+
+          for (; next < crossings.size() and crossings[next].z < g[2]; ++next) {
+            crossed ^= 1;
+            winding += crossings[next].sign;
+          }
+
+          if (parity ? crossed == 1 : winding != 0)
+            samples.push_back(g);
+        }
+      }
+    }
+  }
+
+  std::vector<RVec> result;
+  size_t total = 0;
+  for (auto const &samples : slabs)
+    total += samples.size();
+  result.reserve(total);
+  for (auto const &samples : slabs)
+    result.insert(result.end(), samples.begin(), samples.end());
+
+  log::Debug(
+      "lib", "SampleVolume", "sampled ", result.size(), " points using ",
+      bvh.GetNodeCount(), " bvh nodes");
+
+  return result;
+}
+
+} // namespace prtcl::detail
+
+namespace prtcl {
+
+bool IsInsideMesh(
+    TriangleBVH const &bvh, TensorT<double, 3> const &x,
+    SampleVolumeInsideTest inside_test) {
+  auto const &mesh = bvh.GetMesh();
+  auto const &vertices = mesh.Vertices();
+  auto const &faces = mesh.Faces();
+  detail::RVec2 const x2{x[0], x[1]};
+
+  // like SampleVolume, count the crossings of the line parallel to the
+  // z-axis below x
+  int crossed = 0, winding = 0;
+  bvh.ForEachCandidate(
+      x, detail::RVec{0, 0, 1}, -std::numeric_limits<detail::Real>::infinity(),
+      0, [&](auto f) {
+        auto const &face = faces[f];
+        if (auto crossing = detail::CrossFace(
+                vertices[face[0]], vertices[face[1]], vertices[face[2]], x2);
+            crossing and crossing->z < x[2]) {
+          crossed ^= 1;
+          winding += crossing->sign;
+        }
+      });
+
+  return inside_test == SampleVolumeInsideTest::kParity ? crossed == 1
+                                                         : winding != 0;
+}
+
+} // namespace prtcl
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "sample_volume.hpp"
+#include "triangle_bvh.hpp"
+
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+using namespace prtcl;
+
+namespace {
+
+TriangleMesh MakeUnitCube() {
+  std::istringstream input{"v 0 0 0\n"
+                           "v 1 0 0\n"
+                           "v 1 1 0\n"
+                           "v 0 1 0\n"
+                           "v 0 0 1\n"
+                           "v 1 0 1\n"
+                           "v 1 1 1\n"
+                           "v 0 1 1\n"
+                           "f 1 4 3 2\n"
+                           "f 5 6 7 8\n"
+                           "f 1 2 6 5\n"
+                           "f 2 3 7 6\n"
+                           "f 3 4 8 7\n"
+                           "f 4 1 5 8\n"};
+  return TriangleMesh::load_from_obj(input);
+}
+
+} // namespace
+
+TEST(TriangleBVH, ForEachCandidate) {
+  auto const mesh = MakeUnitCube();
+  TriangleBVH const bvh{mesh};
+
+  std::vector<TriangleBVH::index_type> faces;
+  bvh.ForEachCandidate(
+      TensorT<double, 3>{0.5, 0.5, -1}, TensorT<double, 3>{0, 0, 1}, 0, 10,
+      [&faces](auto f) { faces.push_back(f); });
+  // at least the bottom and the top face must be candidates
+  ASSERT_LE(2, faces.size());
+
+  faces.clear();
+  bvh.ForEachCandidate(
+      TensorT<double, 3>{2, 2, -1}, TensorT<double, 3>{0, 0, 1}, 0, 10,
+      [&faces](auto f) { faces.push_back(f); });
+  ASSERT_TRUE(faces.empty());
+}
+
+TEST(SampleVolume, UnitCube) {
+  auto const mesh = MakeUnitCube();
+
+  for (auto inside_test :
+       {SampleVolumeInsideTest::kParity,
+        SampleVolumeInsideTest::kNonZeroWinding}) {
+    std::vector<TensorT<double, 3>> samples;
+    SampleVolume(
+        mesh, std::back_inserter(samples),
+        SampleVolumeParameters{0.1, inside_test});
+
+    // the grid has 10 points per axis, the points on the lower boundary
+    // planes are ambiguous, all others are strictly inside
+    ASSERT_LE(9 * 9 * 9, samples.size());
+    ASSERT_GE(10 * 10 * 10, samples.size());
+
+    for (auto const &x : samples) {
+      for (int n = 0; n < 3; ++n) {
+        ASSERT_LE(0.0, x[n]);
+        ASSERT_GT(1.0, x[n]);
+      }
+    }
+  }
+}
+
+TEST(SampleVolume, IsInsideMesh) {
+  auto const mesh = MakeUnitCube();
+  TriangleBVH const bvh{mesh};
+
+  using RVec3 = TensorT<double, 3>;
+  for (auto const test :
+       {SampleVolumeInsideTest::kParity,
+        SampleVolumeInsideTest::kNonZeroWinding}) {
+    EXPECT_TRUE(IsInsideMesh(bvh, RVec3{0.5, 0.5, 0.5}, test));
+    EXPECT_TRUE(IsInsideMesh(bvh, RVec3{0.1, 0.9, 0.99}, test));
+    EXPECT_FALSE(IsInsideMesh(bvh, RVec3{0.5, 0.5, 1.5}, test));
+    EXPECT_FALSE(IsInsideMesh(bvh, RVec3{0.5, 0.5, -0.5}, test));
+    EXPECT_FALSE(IsInsideMesh(bvh, RVec3{1.5, 0.5, 0.5}, test));
+  }
+}
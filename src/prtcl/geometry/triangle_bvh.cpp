@@ -0,0 +1,174 @@
+#include "triangle_bvh.hpp"
+
+#include "../log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+
+namespace prtcl {
+
+namespace {
+
+constexpr uint32_t kMaxLeafSize = 4;
+constexpr uint32_t kMaxSAHLeafSize = 16;
+constexpr size_t kMaxDepth = 48;
+constexpr size_t kBinCount = 16;
+
+// relative cost of traversing an inner node compared to testing one face
+constexpr double kTraversalCost = 1.0;
+
+template <typename RVec3_>
+double HalfArea(RVec3_ const &lo, RVec3_ const &hi) {
+  auto const d = (hi - lo).cwiseMax(0).eval();
+  return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+}
+
+} // namespace
+
+TriangleBVH::TriangleBVH(TriangleMesh const &mesh) : mesh_{&mesh} {
+  auto const &vertices = mesh.Vertices();
+  auto const &faces = mesh.Faces();
+  auto const face_count = static_cast<uint32_t>(faces.size());
+
+  std::vector<RVec3> centroids(face_count), lo(face_count), hi(face_count);
+  for (uint32_t f = 0; f < face_count; ++f) {
+    auto const &v0 = vertices[faces[f][0]], &v1 = vertices[faces[f][1]],
+               &v2 = vertices[faces[f][2]];
+    lo[f] = math::cmin(v0, math::cmin(v1, v2));
+    hi[f] = math::cmax(v0, math::cmax(v1, v2));
+    centroids[f] = (lo[f] + hi[f]) / 2;
+  }
+
+  face_indices_.resize(face_count);
+  std::iota(face_indices_.begin(), face_indices_.end(), index_type{0});
+
+  nodes_.reserve(2 * static_cast<size_t>(face_count));
+  if (face_count > 0)
+    Build(centroids, lo, hi, 0, face_count, 0);
+
+  log::Debug(
+      "lib", "TriangleBVH", "built hierarchy with ", nodes_.size(),
+      " nodes over ", face_count, " faces");
+}
+
+uint32_t TriangleBVH::Build(
+    std::vector<RVec3> const &centroids, std::vector<RVec3> const &lo,
+    std::vector<RVec3> const &hi, uint32_t first, uint32_t last,
+    size_t depth) {
+  auto const node_index = static_cast<uint32_t>(nodes_.size());
+  nodes_.emplace_back();
+
+  RVec3 node_lo = math::positive_infinity<Real, 3>(),
+        node_hi = math::negative_infinity<Real, 3>();
+  RVec3 c_lo = node_lo, c_hi = node_hi;
+  for (uint32_t i = first; i < last; ++i) {
+    auto const f = face_indices_[i];
+    node_lo = math::cmin(node_lo, lo[f]);
+    node_hi = math::cmax(node_hi, hi[f]);
+    c_lo = math::cmin(c_lo, centroids[f]);
+    c_hi = math::cmax(c_hi, centroids[f]);
+  }
+
+  nodes_[node_index].lo = node_lo;
+  nodes_[node_index].hi = node_hi;
+
+  auto make_leaf = [&] {
+    nodes_[node_index].first = first;
+    nodes_[node_index].count = last - first;
+    return node_index;
+  };
+
+  uint32_t const count = last - first;
+  if (count <= kMaxLeafSize or depth >= kMaxDepth)
+    return make_leaf();
+
+  // split along the axis with the largest extent of the centroids
+  int axis;
+  (c_hi - c_lo).maxCoeff(&axis);
+  Real const c_min = c_lo[axis], c_extent = c_hi[axis] - c_lo[axis];
+  if (not(c_extent > 0))
+    return make_leaf();
+
+  auto bin_of = [&](index_type f) {
+    auto const b = static_cast<size_t>(
+        static_cast<Real>(kBinCount) * (centroids[f][axis] - c_min) /
+        c_extent);
+    return std::min(b, kBinCount - 1);
+  };
+
+  struct Bin {
+    RVec3 lo = math::positive_infinity<Real, 3>();
+    RVec3 hi = math::negative_infinity<Real, 3>();
+    uint32_t count = 0;
+  };
+  std::array<Bin, kBinCount> bins;
+  for (uint32_t i = first; i < last; ++i) {
+    auto const f = face_indices_[i];
+    auto &bin = bins[bin_of(f)];
+    bin.lo = math::cmin(bin.lo, lo[f]);
+    bin.hi = math::cmax(bin.hi, hi[f]);
+    ++bin.count;
+  }
+
+  // sweep from the right to accumulate the costs of the right sides
+  std::array<Real, kBinCount> right_cost;
+  {
+    Bin acc;
+    for (size_t b = kBinCount - 1; b > 0; --b) {
+      acc.lo = math::cmin(acc.lo, bins[b].lo);
+      acc.hi = math::cmax(acc.hi, bins[b].hi);
+      acc.count += bins[b].count;
+      right_cost[b] = acc.count ? acc.count * HalfArea(acc.lo, acc.hi) : 0;
+    }
+  }
+
+  size_t best_split = 0;
+  Real best_cost = std::numeric_limits<Real>::infinity();
+  {
+    Bin acc;
+    for (size_t b = 1; b < kBinCount; ++b) {
+      acc.lo = math::cmin(acc.lo, bins[b - 1].lo);
+      acc.hi = math::cmax(acc.hi, bins[b - 1].hi);
+      acc.count += bins[b - 1].count;
+      Real const cost =
+          (acc.count ? acc.count * HalfArea(acc.lo, acc.hi) : 0) +
+          right_cost[b];
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_split = b;
+      }
+    }
+  }
+
+  Real const node_area = HalfArea(node_lo, node_hi);
+  Real const split_cost =
+      kTraversalCost + (node_area > 0 ? best_cost / node_area : 0);
+  if (count <= kMaxSAHLeafSize and split_cost >= static_cast<Real>(count))
+    return make_leaf();
+
+  auto *mid_it = std::partition(
+      face_indices_.data() + first, face_indices_.data() + last,
+      [&](index_type f) { return bin_of(f) < best_split; });
+  auto mid = static_cast<uint32_t>(mid_it - face_indices_.data());
+
+  if (mid == first or mid == last) {
+    // all centroids fall into one bin, fall back to a median split
+    mid = first + count / 2;
+    std::nth_element(
+        face_indices_.data() + first, face_indices_.data() + mid,
+        face_indices_.data() + last, [&](index_type lhs, index_type rhs) {
+          return centroids[lhs][axis] < centroids[rhs][axis];
+        });
+  }
+
+  Build(centroids, lo, hi, first, mid, depth + 1);
+  auto const right = Build(centroids, lo, hi, mid, last, depth + 1);
+
+  nodes_[node_index].first = right;
+  nodes_[node_index].count = 0;
+  return node_index;
+}
+
+} // namespace prtcl
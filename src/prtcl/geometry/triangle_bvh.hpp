@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../math.hpp"
+#include "triangle_mesh.hpp"
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prtcl {
+
+//! Bounding volume hierarchy over the faces of a TriangleMesh.
+//!
+//! The hierarchy is built top-down with the binned surface area heuristic and
+//! stored as a flat array in depth-first order: the left child of an inner
+//! node directly follows it, the index of the right child is stored in the
+//! node.  The BVH keeps a reference to the mesh, which must outlive it.
+class TriangleBVH {
+public:
+  using index_type = TriangleMesh::index_type;
+
+private:
+  using Real = double;
+  using RVec3 = TensorT<Real, 3>;
+
+public:
+  explicit TriangleBVH(TriangleMesh const &mesh);
+
+public:
+  TriangleMesh const &GetMesh() const { return *mesh_; }
+
+  size_t GetNodeCount() const { return nodes_.size(); }
+
+public:
+  //! Calls visit(face_index) for each face whose bounds are hit by the ray
+  //! origin + t * direction with t in [t_min, t_max].
+  template <typename Visit_>
+  void ForEachCandidate(
+      RVec3 const &origin, RVec3 const &direction, Real t_min, Real t_max,
+      Visit_ &&visit) const {
+    if (nodes_.empty())
+      return;
+
+    uint32_t stack[64];
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+      auto const &node = nodes_[stack[--stack_size]];
+      if (not HitsBounds(node, origin, direction, t_min, t_max))
+        continue;
+
+      if (node.count > 0) {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i)
+          visit(face_indices_[i]);
+      } else {
+        auto const self = static_cast<uint32_t>(&node - nodes_.data());
+        stack[stack_size++] = node.first;
+        stack[stack_size++] = self + 1;
+      }
+    }
+  }
+
+private:
+  struct Node {
+    RVec3 lo, hi;
+    // leaf: index of the first face in face_indices_
+    // inner: index of the right child
+    uint32_t first;
+    // number of faces of a leaf, zero for inner nodes
+    uint32_t count;
+  };
+
+  static bool HitsBounds(
+      Node const &node, RVec3 const &origin, RVec3 const &direction,
+      Real t_min, Real t_max) {
+    for (int n = 0; n < 3; ++n) {
+      if (direction[n] == 0) {
+        // the ray is parallel to the slab
+        if (origin[n] < node.lo[n] or origin[n] > node.hi[n])
+          return false;
+      } else {
+        Real const inv = 1 / direction[n];
+        Real t0 = (node.lo[n] - origin[n]) * inv;
+        Real t1 = (node.hi[n] - origin[n]) * inv;
+        if (t0 > t1)
+          std::swap(t0, t1);
+        t_min = std::max(t_min, t0);
+        t_max = std::min(t_max, t1);
+        if (t_min > t_max)
+          return false;
+      }
+    }
+    return true;
+  }
+
+  uint32_t Build(
+      std::vector<RVec3> const &centroids, std::vector<RVec3> const &lo,
+      std::vector<RVec3> const &hi, uint32_t first, uint32_t last,
+      size_t depth);
+
+private:
+  TriangleMesh const *mesh_;
+  std::vector<Node> nodes_;
+  std::vector<index_type> face_indices_;
+};
+
+} // namespace prtcl
@@ -1 +1,456 @@
 #include "triangle_mesh.hpp"
+
+#include "../errors/invalid_archive_error.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <omp.h>
+
+namespace prtcl {
+
+namespace {
+
+using Real = double;
+using RVec3 = TensorT<Real, 3>;
+using index_type = TriangleMesh::index_type;
+
+// Chunks are parsed independently, relative (negative) indices can only be
+// resolved after the vertex counts of all previous chunks are known.
+struct ObjTriangle {
+  std::array<int64_t, 3> indices;
+  // bit k is set if indices[k] is relative to the first vertex of the chunk
+  uint8_t relative;
+};
+
+struct ObjChunk {
+  std::vector<RVec3> vertices;
+  std::vector<ObjTriangle> triangles;
+  size_t polygon_count = 0;
+  size_t ignored_count = 0;
+};
+
+bool IsBlank(char c) { return c == ' ' or c == '\t' or c == '\r'; }
+
+char const *SkipBlanks(char const *first, char const *last) {
+  while (first != last and IsBlank(*first))
+    ++first;
+  return first;
+}
+
+char const *SkipToken(char const *first, char const *last) {
+  while (first != last and not IsBlank(*first))
+    ++first;
+  return first;
+}
+
+template <typename T>
+bool ParseNumber(char const *&first, char const *last, T &value) {
+  first = SkipBlanks(first, last);
+  // from_chars does not accept a leading plus sign
+  if (first != last and *first == '+')
+    ++first;
+  auto [ptr, ec] = std::from_chars(first, last, value);
+  if (ec != std::errc{})
+    return false;
+  first = ptr;
+  return true;
+}
+
+void ParseVertex(char const *first, char const *last, ObjChunk &chunk) {
+  RVec3 vertex;
+  for (int dim = 0; dim < 3; ++dim) {
+    if (not ParseNumber(first, last, vertex[dim])) {
+      ++chunk.ignored_count;
+      return;
+    }
+  }
+  chunk.vertices.emplace_back(vertex);
+}
+
+void ParseFace(
+    char const *first, char const *last, ObjChunk &chunk,
+    std::vector<std::pair<int64_t, bool>> &polygon) {
+  polygon.clear();
+
+  auto const vertex_count = static_cast<int64_t>(chunk.vertices.size());
+  for (first = SkipBlanks(first, last); first != last;
+       first = SkipBlanks(first, last)) {
+    int64_t index;
+    if (not ParseNumber(first, last, index) or index == 0) {
+      ++chunk.ignored_count;
+      return;
+    }
+
+    // positive indices are absolute and one-based, negative indices are
+    // relative to the most recently defined vertex
+    if (index > 0)
+      polygon.emplace_back(index - 1, false);
+    else
+      polygon.emplace_back(vertex_count + index, true);
+
+    // skip texture coordinate and normal references (v/vt/vn, v//vn)
+    first = SkipToken(first, last);
+  }
+
+  if (polygon.size() < 3) {
+    ++chunk.ignored_count;
+    return;
+  }
+
+  // triangulate as a fan around the first vertex
+  ++chunk.polygon_count;
+  for (size_t k = 1; k + 1 < polygon.size(); ++k) {
+    ObjTriangle triangle;
+    triangle.relative = 0;
+    size_t const corners[] = {0, k, k + 1};
+    for (size_t c = 0; c < 3; ++c) {
+      triangle.indices[c] = polygon[corners[c]].first;
+      if (polygon[corners[c]].second)
+        triangle.relative |= static_cast<uint8_t>(1u << c);
+    }
+    chunk.triangles.push_back(triangle);
+  }
+}
+
+void ParseChunk(char const *first, char const *last, ObjChunk &chunk) {
+  std::vector<std::pair<int64_t, bool>> polygon;
+
+  while (first != last) {
+    auto const *eol = std::find(first, last, '\n');
+    auto const *line = SkipBlanks(first, eol);
+
+    if (eol - line >= 2 and IsBlank(line[1])) {
+      if (line[0] == 'v')
+        ParseVertex(line + 2, eol, chunk);
+      else if (line[0] == 'f')
+        ParseFace(line + 2, eol, chunk, polygon);
+    }
+    // everything else (comments, vt, vn, groups, materials, ...) is ignored
+
+    first = (eol == last) ? last : eol + 1;
+  }
+}
+
+} // namespace
+
+TriangleMesh TriangleMesh::load_from_obj(std::istream &i_) {
+  std::string buffer{
+      std::istreambuf_iterator<char>{i_}, std::istreambuf_iterator<char>{}};
+  return load_from_obj_buffer(buffer);
+}
+
+TriangleMesh TriangleMesh::load_from_obj_buffer(std::string_view buffer) {
+  // split the buffer into chunks of complete lines
+  constexpr size_t kMinChunkSize = size_t{1} << 20;
+  size_t const chunk_count = std::clamp<size_t>(
+      buffer.size() / kMinChunkSize, 1,
+      4 * static_cast<size_t>(omp_get_max_threads()));
+
+  std::vector<char const *> bounds(chunk_count + 1);
+  bounds.front() = buffer.data();
+  bounds.back() = buffer.data() + buffer.size();
+  for (size_t i = 1; i < chunk_count; ++i) {
+    auto const *split = buffer.data() + i * (buffer.size() / chunk_count);
+    split = std::max(split, bounds[i - 1]);
+    auto const *eol = std::find(split, bounds.back(), '\n');
+    bounds[i] = (eol == bounds.back()) ? eol : eol + 1;
+  }
+
+  std::vector<ObjChunk> chunks(chunk_count);
+
+  using chunk_index_t = std::ptrdiff_t;
+#pragma omp parallel for schedule(dynamic)
+  for (chunk_index_t i = 0; i < static_cast<chunk_index_t>(chunk_count); ++i) {
+    auto const ci = static_cast<size_t>(i);
+    ParseChunk(bounds[ci], bounds[ci + 1], chunks[ci]);
+  }
+
+  // compute the offsets of the chunks in the merged arrays
+  std::vector<size_t> vertex_offsets(chunk_count + 1, 0);
+  std::vector<size_t> face_offsets(chunk_count + 1, 0);
+  size_t polygon_count = 0, ignored_count = 0;
+  for (size_t i = 0; i < chunk_count; ++i) {
+    vertex_offsets[i + 1] = vertex_offsets[i] + chunks[i].vertices.size();
+    face_offsets[i + 1] = face_offsets[i] + chunks[i].triangles.size();
+    polygon_count += chunks[i].polygon_count;
+    ignored_count += chunks[i].ignored_count;
+  }
+
+  TriangleMesh mesh;
+  mesh.vertices_.resize(vertex_offsets.back());
+  mesh.faces_.resize(face_offsets.back());
+
+  auto const vertex_count = static_cast<int64_t>(vertex_offsets.back());
+  std::vector<uint8_t> invalid(face_offsets.back(), 0);
+
+#pragma omp parallel for schedule(dynamic)
+  for (chunk_index_t i = 0; i < static_cast<chunk_index_t>(chunk_count); ++i) {
+    auto const ci = static_cast<size_t>(i);
+    auto const &chunk = chunks[ci];
+
+    std::copy(
+        chunk.vertices.begin(), chunk.vertices.end(),
+        mesh.vertices_.begin() +
+            static_cast<std::ptrdiff_t>(vertex_offsets[ci]));
+
+    auto const base = static_cast<int64_t>(vertex_offsets[ci]);
+    for (size_t t = 0; t < chunk.triangles.size(); ++t) {
+      auto const &triangle = chunk.triangles[t];
+      auto &face = mesh.faces_[face_offsets[ci] + t];
+      for (size_t c = 0; c < 3; ++c) {
+        auto index = triangle.indices[c];
+        if (triangle.relative & (1u << c))
+          index += base;
+        if (index < 0 or index >= vertex_count)
+          invalid[face_offsets[ci] + t] = 1;
+        face[c] = static_cast<index_type>(index);
+      }
+    }
+  }
+
+  // remove faces that reference vertices which do not exist
+  if (auto invalid_count = static_cast<size_t>(
+          std::count(invalid.begin(), invalid.end(), 1));
+      invalid_count > 0) {
+    size_t out = 0;
+    for (size_t f = 0; f < mesh.faces_.size(); ++f)
+      if (not invalid[f])
+        mesh.faces_[out++] = mesh.faces_[f];
+    mesh.faces_.resize(out);
+    ignored_count += invalid_count;
+  }
+
+  if (ignored_count > 0)
+    log::Warning(
+        "lib", "TriangleMesh", "ignored ", ignored_count,
+        " invalid vertices or faces in .obj file");
+
+  log::Debug(
+      "lib", "TriangleMesh", "loaded .obj file with ", mesh.vertices_.size(),
+      " vertices and ", polygon_count, " faces (", mesh.faces_.size(),
+      " triangles) using ", chunk_count, " chunks");
+
+  return mesh;
+}
+
+TriangleMesh
+TriangleMesh::load_from_obj_file(std::string const &path, bool use_cache) {
+  namespace fs = std::filesystem;
+
+  auto const cache_path = path + ".cache";
+  if (use_cache and fs::exists(cache_path) and
+      fs::last_write_time(cache_path) >= fs::last_write_time(path)) {
+    std::ifstream file{cache_path, std::ios::binary};
+    NativeBinaryArchiveReader archive{file};
+    TriangleMesh mesh;
+    try {
+      // a truncated cache fails on the first read past its end, before any
+      // of the values read is used
+      file.exceptions(std::ios::failbit | std::ios::badbit);
+      try {
+        mesh.Load(archive);
+      } catch (std::ios::failure const &) {
+        throw InvalidArchiveError{};
+      }
+      log::Debug("lib", "TriangleMesh", "loaded cached mesh ", cache_path);
+      return mesh;
+    } catch (std::exception const &) {
+      log::Warning("lib", "TriangleMesh", "ignoring invalid ", cache_path);
+    }
+  }
+
+  TriangleMesh mesh;
+
+  int const fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error{"could not open " + path};
+
+  struct stat info;
+  if (::fstat(fd, &info) == 0 and info.st_size > 0) {
+    auto const size = static_cast<size_t>(info.st_size);
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      ::madvise(data, size, MADV_SEQUENTIAL);
+      mesh = load_from_obj_buffer({static_cast<char const *>(data), size});
+      ::munmap(data, size);
+    } else {
+      std::ifstream file{path, std::ios::binary};
+      mesh = load_from_obj(file);
+    }
+  }
+  ::close(fd);
+
+  if (use_cache) {
+    // the cache is replaced atomically, such that it is never read partially
+    // written
+    auto const temp_path = cache_path + ".tmp";
+    std::ofstream file{temp_path, std::ios::binary};
+    NativeBinaryArchiveWriter archive{file};
+    mesh.Save(archive);
+    file.close();
+
+    std::error_code ec;
+    if (file)
+      fs::rename(temp_path, cache_path, ec);
+    if (not file or ec) {
+      log::Warning("lib", "TriangleMesh", "could not write ", cache_path);
+      fs::remove(temp_path, ec);
+    }
+  }
+
+  return mesh;
+}
+
+namespace {
+
+//! Appends the shortest representation of value that parses back to it.
+template <typename T>
+void AppendNumber(std::string &buffer, T value) {
+  char digits[32];
+  auto const result =
+      std::to_chars(std::begin(digits), std::end(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+template <typename T>
+void WriteLittleEndian(std::ostream &o_, T value) {
+  static_assert(sizeof(T) == 4);
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  char const bytes[4] = {
+      static_cast<char>(bits & 0xFF), static_cast<char>((bits >> 8) & 0xFF),
+      static_cast<char>((bits >> 16) & 0xFF),
+      static_cast<char>((bits >> 24) & 0xFF)};
+  o_.write(bytes, sizeof(bytes));
+}
+
+} // namespace
+
+void TriangleMesh::save_to_obj(std::ostream &o_) const {
+  std::string line;
+  for (auto const &vertex : vertices_) {
+    line = "v";
+    for (size_t dim = 0; dim < 3; ++dim) {
+      line += ' ';
+      AppendNumber(line, vertex[static_cast<Eigen::Index>(dim)]);
+    }
+    line += '\n';
+    o_ << line;
+  }
+  for (auto const &face : faces_) {
+    line = "f";
+    for (auto const index : face) {
+      line += ' ';
+      AppendNumber(line, index + 1);
+    }
+    line += '\n';
+    o_ << line;
+  }
+}
+
+void TriangleMesh::save_to_ply(std::ostream &o_) const {
+  o_ << "ply\n"
+     << "format binary_little_endian 1.0\n"
+     << "element vertex " << vertices_.size() << "\n"
+     << "property float x\n"
+     << "property float y\n"
+     << "property float z\n"
+     << "element face " << faces_.size() << "\n"
+     << "property list uchar int vertex_indices\n"
+     << "end_header\n";
+
+  for (auto const &vertex : vertices_)
+    for (size_t dim = 0; dim < 3; ++dim)
+      WriteLittleEndian(
+          o_, static_cast<float>(vertex[static_cast<Eigen::Index>(dim)]));
+
+  for (auto const &face : faces_) {
+    o_.put(3);
+    for (auto const index : face)
+      WriteLittleEndian(o_, static_cast<int32_t>(index));
+  }
+}
+
+void TriangleMesh::save_to_file(std::string const &path) const {
+  auto const ends_with = [&path](std::string_view suffix) {
+    return path.size() >= suffix.size() and
+           std::equal(suffix.rbegin(), suffix.rend(), path.rbegin());
+  };
+
+  void (TriangleMesh::*write)(std::ostream &) const = nullptr;
+  if (ends_with(".obj")) {
+    write = &TriangleMesh::save_to_obj;
+  } else if (ends_with(".ply")) {
+    write = &TriangleMesh::save_to_ply;
+  } else {
+    throw std::runtime_error{"unknown mesh format of " + path};
+  }
+
+  std::ofstream file{path, std::ios::binary};
+  if (not file)
+    throw std::runtime_error{"could not open " + path};
+  (this->*write)(file);
+  log::Debug(
+      "lib", "TriangleMesh", "saved ", path, " with ", vertices_.size(),
+      " vertices and ", faces_.size(), " faces");
+}
+
+namespace {
+
+constexpr std::string_view kMeshMagic = "PRTCLMSH";
+constexpr size_t kMeshVersion = 1;
+
+} // namespace
+
+void TriangleMesh::Save(ArchiveWriter &archive) const {
+  static_assert(sizeof(index_type) == sizeof(int32_t));
+
+  archive.SaveString(kMeshMagic);
+  archive.SaveSize(kMeshVersion);
+
+  archive.SaveSize(vertices_.size());
+  if (not vertices_.empty())
+    archive.SaveValues(3 * vertices_.size(), vertices_.front().data());
+
+  archive.SaveSize(faces_.size());
+  if (not faces_.empty())
+    archive.SaveValues(
+        3 * faces_.size(),
+        reinterpret_cast<int32_t const *>(faces_.front().data()));
+}
+
+void TriangleMesh::Load(ArchiveReader &archive) {
+  if (archive.LoadString() != kMeshMagic or archive.LoadSize() != kMeshVersion)
+    throw InvalidArchiveError{};
+
+  vertices_.resize(archive.LoadSize());
+  if (not vertices_.empty())
+    archive.LoadValues(3 * vertices_.size(), vertices_.front().data());
+
+  faces_.resize(archive.LoadSize());
+  if (not faces_.empty())
+    archive.LoadValues(
+        3 * faces_.size(), reinterpret_cast<int32_t *>(faces_.front().data()));
+
+  // the faces must only reference existing vertices
+  auto const vertex_count = vertices_.size();
+  for (auto const &face : faces_)
+    for (auto const index : face)
+      if (static_cast<size_t>(index) >= vertex_count)
+        throw InvalidArchiveError{};
+}
+
+} // namespace prtcl
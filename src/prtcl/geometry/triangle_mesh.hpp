@@ -2,18 +2,18 @@
 
 #include "../log.hpp"
 #include "../math.hpp"
+#include "../util/archive.hpp"
 
 #include <array>
-#include <iostream>
 #include <istream>
-#include <regex>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include <cstddef>
 
-#include <boost/lexical_cast.hpp>
-
 #include <boost/range/iterator_range.hpp>
 
 namespace prtcl {
@@ -22,12 +22,17 @@ class TriangleMesh {
 public:
   using index_type = unsigned int;
 
-private:
   using Real = double;
   using RVec3 = TensorT<Real, 3>;
 
   using Face = std::array<index_type, 3>;
 
+public:
+  TriangleMesh() = default;
+
+  TriangleMesh(std::vector<RVec3> vertices, std::vector<Face> faces)
+      : vertices_{std::move(vertices)}, faces_{std::move(faces)} {}
+
 public:
   auto &Scale(Real factor) {
     for (auto &v : vertices_)
@@ -64,95 +69,35 @@ private:
   std::vector<Face> faces_;
 
 public:
-  static auto load_from_obj(std::istream &i_) {
-    TriangleMesh mesh;
-
-    // NOTE: .*? is a non-greedy match
-
-    // regex to match numbers in decimal point notation
-    // static std::string const f = R"((-?\d*(?:[.]\d*)?))";
-    static std::string const f =
-        R"(([-+]?[0-9]*[.]?[0-9]+(?:[eE][-+]?[0-9]+)?))";
-
-    // matches comments
-    static std::regex const re_comment{R"(^(?:#.*|\s*)?$)"};
-
-    // matches groups, captures the name of the group in the first match group
-    static std::regex const re_group{R"(^g\s+(.*?)\s*$)"};
-
-    // matches vertices (x y z)
-    static std::regex const re_vertex_generic{R"(^v\s+.*$)"};
-    static std::regex const re_vertex3{
-        R"(^v\s+)" + f + R"(\s+)" + f + R"(\s+)" + f + R"(\s*$)"};
-
-    // matches faces (v/t/n v/t/n v/t/n ...)
-    static std::regex const re_face_generic{
-        R"(^f(?:\s+(?:\d+)(?:[/]\d*(?:[/]\d*)?)?)*\s*$)"};
-    static std::regex const re_face3{
-        R"(^f\s+(\d+)(?:[/]\d*(?:[/]\d*)?)?\s+(\d+)(?:[/]\d*(?:[/]\d*)?)?\s+(\d+)(?:[/]\d*(?:[/]\d*)?)?\s*$)"};
-    static std::regex const re_face4{
-        R"(^f\s+(\d+)(?:[/]\d*(?:[/]\d*)?)?\s+(\d+)(?:[/]\d*(?:[/]\d*)?)?\s+(\d+)(?:[/]\d*(?:[/]\d*)?)?\s+(\d+)(?:[/]\d*(?:[/]\d*)?)?\s*$)"};
-
-    size_t vertex_count = 0, face_count = 0;
-
-    for (std::string line; std::getline(i_, line);) {
-      // remove potential artifacts from line endings of other OSs
-      while (line.size() > 0 and
-             ('\r' == line[line.size() - 1] or '\n' == line[line.size() - 1]))
-        line.resize(line.size() - 1);
-
-      // ignore empty lines and comments
-      if (0 == line.size() or std::regex_match(line, re_comment))
-        continue;
-
-      std::smatch m;
-
-      // match vertices
-      // TODO: maybe include vt and vn
-      if (std::regex_match(line, m, re_vertex_generic)) {
-        if (std::regex_match(line, m, re_vertex3)) {
-          ++vertex_count;
-          Real const e0 = boost::lexical_cast<Real>(m[1]),
-                     e1 = boost::lexical_cast<Real>(m[2]),
-                     e2 = boost::lexical_cast<Real>(m[3]);
-          mesh.vertices_.emplace_back(e0, e1, e2);
-        }
-        continue;
-      }
-
-      // match faces
-      if (std::regex_match(line, m, re_face_generic)) {
-        if (std::regex_match(line, m, re_face3)) {
-          ++face_count;
-          auto const i0 = boost::lexical_cast<index_type>(m[1]) - 1,
-                     i1 = boost::lexical_cast<index_type>(m[2]) - 1,
-                     i2 = boost::lexical_cast<index_type>(m[3]) - 1;
-          mesh.faces_.push_back({i0, i1, i2});
-          continue;
-        }
-
-        if (std::regex_match(line, m, re_face4)) {
-          ++face_count;
-          auto const i0 = boost::lexical_cast<index_type>(m[1]) - 1,
-                     i1 = boost::lexical_cast<index_type>(m[2]) - 1,
-                     i2 = boost::lexical_cast<index_type>(m[3]) - 1,
-                     i3 = boost::lexical_cast<index_type>(m[4]) - 1;
-          mesh.faces_.push_back({i0, i1, i2});
-          mesh.faces_.push_back({i0, i2, i3});
-          continue;
-        }
-      }
-
-      // log::Debug("lib", "TriangleMesh", "ignoring invalid line in .obj
-      // file");
-    }
-
-    log::Debug(
-        "lib", "TriangleMesh", "loaded .obj file with ", vertex_count,
-        " vertices and ", face_count, " faces");
-
-    return mesh;
-  }
+  //! Parses a Wavefront .obj file.  Polygons are fan-triangulated, negative
+  //! (relative) indices are resolved and texture coordinates and normals
+  //! (vt, vn and the v/vt/vn face syntax) are accepted but not stored.
+  static TriangleMesh load_from_obj(std::istream &i_);
+
+  static TriangleMesh load_from_obj_buffer(std::string_view buffer);
+
+  //! Memory-maps and parses the file at path.  If use_cache is set, the parsed
+  //! mesh is stored in a binary cache next to the file (path + ".cache") and
+  //! reused as long as the cache is not older than the .obj file.
+  static TriangleMesh
+  load_from_obj_file(std::string const &path, bool use_cache = false);
+
+public:
+  //! Writes a Wavefront .obj file with one line per vertex and face.
+  void save_to_obj(std::ostream &o_) const;
+
+  //! Writes a binary little endian .ply file, the vertices are stored as
+  //! single precision floats.
+  void save_to_ply(std::ostream &o_) const;
+
+  //! Writes the mesh to path, the extension (.obj or .ply) selects the
+  //! format.
+  void save_to_file(std::string const &path) const;
+
+public:
+  void Save(ArchiveWriter &archive) const;
+
+  void Load(ArchiveReader &archive);
 };
 
 } // namespace prtcl
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include "triangle_mesh.hpp"
+
+#include "../errors/invalid_archive_error.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace prtcl;
+
+TEST(TriangleMesh, LoadFromObj) {
+  std::istringstream input{"# comment\n"
+                           "o object\n"
+                           "v 0 0 0\n"
+                           "v 1.5 0 0\r\n"
+                           "v 1 1e0 +0\n"
+                           "vt 0.5 0.5\n"
+                           "vn 0 0 1\n"
+                           "f 1 2 3\n"
+                           "v 0 1 0\n"
+                           "f 1/1/1 2//1 -2/1 -1\n"
+                           "f 1 2\n"
+                           "f 1 2 9\n"};
+
+  auto mesh = TriangleMesh::load_from_obj(input);
+
+  std::vector<TensorT<double, 3>> vertices{
+      mesh.Vertices().begin(), mesh.Vertices().end()};
+  ASSERT_EQ(4, vertices.size());
+  ASSERT_EQ(1.5, vertices[1][0]);
+  ASSERT_EQ(1.0, vertices[2][1]);
+
+  std::vector<std::array<TriangleMesh::index_type, 3>> faces{
+      mesh.Faces().begin(), mesh.Faces().end()};
+  // the triangle, the fan-triangulated quad, the degenerate and the
+  // out-of-range face are dropped
+  ASSERT_EQ(3, faces.size());
+  ASSERT_EQ((std::array<TriangleMesh::index_type, 3>{0, 1, 2}), faces[0]);
+  ASSERT_EQ((std::array<TriangleMesh::index_type, 3>{0, 1, 2}), faces[1]);
+  ASSERT_EQ((std::array<TriangleMesh::index_type, 3>{0, 2, 3}), faces[2]);
+}
+
+TEST(TriangleMesh, SaveLoadTest) {
+  std::istringstream input{"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n"};
+  auto const mesh = TriangleMesh::load_from_obj(input);
+
+  std::stringstream data;
+  NativeBinaryArchiveWriter writer{data};
+  mesh.Save(writer);
+
+  TriangleMesh loaded;
+  NativeBinaryArchiveReader reader{data};
+  loaded.Load(reader);
+
+  ASSERT_EQ(3, loaded.Vertices().size());
+  ASSERT_EQ(1, loaded.Faces().size());
+  ASSERT_EQ(1.0, loaded.Vertices()[2][1]);
+}
+
+TEST(TriangleMesh, SaveToObjAndPly) {
+  TriangleMesh const mesh{
+      {{0, 0, 0}, {1.5, 0, 0}, {0, 0.1, 0}, {0, 0, 1}},
+      {{0, 1, 2}, {0, 2, 3}}};
+
+  std::stringstream obj;
+  mesh.save_to_obj(obj);
+  auto const loaded = TriangleMesh::load_from_obj(obj);
+  ASSERT_EQ(4, loaded.Vertices().size());
+  ASSERT_EQ(2, loaded.Faces().size());
+  ASSERT_EQ(0.1, loaded.Vertices()[2][1]);
+  ASSERT_EQ(
+      (std::array<TriangleMesh::index_type, 3>{0, 2, 3}), loaded.Faces()[1]);
+
+  std::stringstream ply;
+  mesh.save_to_ply(ply);
+  auto const data = ply.str();
+  auto const header_end = data.find("end_header\n");
+  ASSERT_NE(std::string::npos, header_end);
+  ASSERT_NE(std::string::npos, data.find("element vertex 4\n"));
+  ASSERT_NE(std::string::npos, data.find("element face 2\n"));
+  // three floats per vertex, the count and three indices per face
+  ASSERT_EQ(
+      data.size() - header_end - 11, 4 * 3 * 4 + 2 * (1 + 3 * 4));
+}
+
+TEST(TriangleMesh, LoadFromObjChunks) {
+  // more than 2 MiB are split into multiple chunks, every face references
+  // the vertices right before it with negative indices, such that some of
+  // them cross the boundaries between chunks
+  std::string buffer;
+  size_t face_count = 0;
+  while (buffer.size() < (size_t{5} << 19)) {
+    auto const i = std::to_string(face_count++);
+    buffer += "v " + i + " 0 0\nv " + i + " 1 0\nv " + i + " 0 1\n";
+    buffer += "f -3 -2 -1\n";
+  }
+
+  auto const mesh = TriangleMesh::load_from_obj_buffer(buffer);
+  ASSERT_EQ(3 * face_count, mesh.Vertices().size());
+  ASSERT_EQ(face_count, mesh.Faces().size());
+
+  std::vector<TensorT<double, 3>> vertices{
+      mesh.Vertices().begin(), mesh.Vertices().end()};
+  std::vector<std::array<TriangleMesh::index_type, 3>> faces{
+      mesh.Faces().begin(), mesh.Faces().end()};
+  for (size_t f = 0; f < face_count; ++f) {
+    for (size_t c = 0; c < 3; ++c) {
+      ASSERT_EQ(3 * f + c, faces[f][c]);
+      ASSERT_EQ(static_cast<double>(f), vertices[faces[f][c]][0]);
+    }
+  }
+}
+
+TEST(TriangleMesh, LoadRejectsInvalidArchives) {
+  TriangleMesh const mesh{{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}}, {{0, 1, 2}}};
+
+  std::stringstream data;
+  NativeBinaryArchiveWriter writer{data};
+  mesh.Save(writer);
+  auto const bytes = data.str();
+
+  // a face that references a vertex which does not exist
+  auto invalid = bytes;
+  invalid[invalid.size() - 4] = 7;
+  std::istringstream invalid_data{invalid};
+  NativeBinaryArchiveReader invalid_reader{invalid_data};
+  TriangleMesh loaded;
+  ASSERT_THROW(loaded.Load(invalid_reader), InvalidArchiveError);
+}
+
+TEST(TriangleMesh, LoadFromObjFileCache) {
+  namespace fs = std::filesystem;
+
+  auto const path =
+      (fs::temp_directory_path() / "prtcl-triangle-mesh.test.obj").string();
+  auto const cache_path = path + ".cache";
+  std::ofstream{path} << "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+  fs::remove(cache_path);
+
+  ASSERT_EQ(1, TriangleMesh::load_from_obj_file(path, true).Faces().size());
+  ASSERT_TRUE(fs::exists(cache_path));
+  ASSERT_FALSE(fs::exists(cache_path + ".tmp"));
+
+  // a truncated cache is ignored
+  fs::resize_file(cache_path, fs::file_size(cache_path) - 6);
+  auto const mesh = TriangleMesh::load_from_obj_file(path, true);
+  ASSERT_EQ(3, mesh.Vertices().size());
+  ASSERT_EQ(1, mesh.Faces().size());
+
+  fs::remove(path);
+  fs::remove(cache_path);
+}
@@ -21,6 +21,11 @@ Logger *&GetLoggerImpl() {
   return logger;
 }
 
+//! The logger is never destroyed, deferred messages are output at exit.
+struct FlushAtExit {
+  ~FlushAtExit() { GetLoggerImpl()->Flush(); }
+} const flush_at_exit;
+
 } // namespace
 
 Logger &GetLogger() {
@@ -33,4 +38,8 @@ void SetLogger(Logger *logger) {
   GetLoggerImpl() = logger;
 }
 
+void Flush() {
+  GetLoggerImpl()->Flush();
+}
+
 } // namespace prtcl
@@ -9,6 +9,20 @@ Logger &GetLogger();
 
 void SetLogger(Logger *logger);
 
+//! Waits until the current logger has output all messages logged so far.
+void Flush();
+
+namespace detail {
+
+//! Stands in for the logger in the helpers of levels that are not compiled
+//! in, such that they do not even look up the current logger.
+inline Logger disabled_logger;
+
+} // namespace detail
+
+//! Messages of levels that are not compiled in (see PRTCL_LOG_MIN_LEVEL) are
+//! discarded before their arguments are formatted, Debug, Info, Warning and
+//! Error remove them altogether.
 template <typename... Args>
 Logger &
 Log(Level level, typename Logger::StringView target,
@@ -20,28 +34,40 @@ template <typename... Args>
 Logger &Debug(
     typename Logger::StringView target, typename Logger::StringView origin,
     Args &&... args) {
-  return Log(Level::kDebug, target, origin, std::forward<Args>(args)...);
+  if constexpr (IsCompiled(Level::kDebug))
+    return Log(Level::kDebug, target, origin, std::forward<Args>(args)...);
+  else
+    return detail::disabled_logger;
 }
 
 template <typename... Args>
 Logger &Info(
     typename Logger::StringView target, typename Logger::StringView origin,
     Args &&... args) {
-  return Log(Level::kInfo, target, origin, std::forward<Args>(args)...);
+  if constexpr (IsCompiled(Level::kInfo))
+    return Log(Level::kInfo, target, origin, std::forward<Args>(args)...);
+  else
+    return detail::disabled_logger;
 }
 
 template <typename... Args>
 Logger &Warning(
     typename Logger::StringView target, typename Logger::StringView origin,
     Args &&... args) {
-  return Log(Level::kWarning, target, origin, std::forward<Args>(args)...);
+  if constexpr (IsCompiled(Level::kWarning))
+    return Log(Level::kWarning, target, origin, std::forward<Args>(args)...);
+  else
+    return detail::disabled_logger;
 }
 
 template <typename... Args>
 Logger &Error(
     typename Logger::StringView target, typename Logger::StringView origin,
     Args &&... args) {
-  return Log(Level::kError, target, origin, std::forward<Args>(args)...);
+  if constexpr (IsCompiled(Level::kError))
+    return Log(Level::kError, target, origin, std::forward<Args>(args)...);
+  else
+    return detail::disabled_logger;
 }
 
 } // namespace prtcl::log
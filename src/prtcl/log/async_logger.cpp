@@ -0,0 +1,299 @@
+#include <prtcl/log/async_logger.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include <cstring>
+
+namespace prtcl::log {
+
+namespace {
+
+//! How long the background thread sleeps if there were no messages.
+constexpr auto kPollInterval = std::chrono::milliseconds{10};
+
+//! Records are aligned to (and prefixed by) the size of their payload.
+constexpr size_t kRecordAlignment = sizeof(uint64_t);
+
+//! Prefix of the (unused) rest of the buffer when a record did not fit.
+constexpr uint64_t kWrapMarker = std::numeric_limits<uint64_t>::max();
+
+size_t RoundUp(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+size_t GetSlotSize(size_t byte_size) {
+  return kRecordAlignment + RoundUp(byte_size, kRecordAlignment);
+}
+
+std::atomic<uint64_t> next_logger_id = 1;
+
+} // namespace
+
+//! Single producer, single consumer queue of records.  Both positions only
+//! ever increase, the position in the buffer is taken modulo its size.
+class AsyncLogger::RingBuffer {
+public:
+  explicit RingBuffer(size_t byte_size)
+      : size_{RoundUpToPowerOfTwo(std::max<size_t>(byte_size, 64))},
+        data_{new std::byte[size_]} {}
+
+public:
+  bool CanHold(size_t byte_size) const {
+    return GetSlotSize(byte_size) <= size_;
+  }
+
+  //! Returns storage for a record, or nullptr if there is no room currently.
+  //! Only called by the owning thread.
+  std::byte *Reserve(size_t byte_size) {
+    auto const slot = GetSlotSize(byte_size);
+
+    auto head = head_.load(std::memory_order_relaxed);
+    auto const offset = static_cast<size_t>(head & (size_ - 1));
+    auto const remaining = size_ - offset;
+
+    // records are contiguous, skip the rest of the buffer if necessary
+    auto const needed = slot > remaining ? remaining + slot : slot;
+    auto const tail = tail_.load(std::memory_order_acquire);
+    if (size_ - static_cast<size_t>(head - tail) < needed)
+      return nullptr;
+
+    if (slot > remaining) {
+      WritePrefix(offset, kWrapMarker);
+      head += remaining;
+    }
+
+    auto const start = static_cast<size_t>(head & (size_ - 1));
+    WritePrefix(start, byte_size);
+    pending_head_ = head + slot;
+    return data_.get() + start + kRecordAlignment;
+  }
+
+  //! Publishes the record returned by the last Reserve.
+  void Commit() { head_.store(pending_head_, std::memory_order_release); }
+
+  //! Marks the buffer as no longer used by its thread, it is released once
+  //! all of its records were consumed.
+  void Retire() { retired_.store(true, std::memory_order_release); }
+
+  bool IsRetired() const { return retired_.load(std::memory_order_acquire); }
+
+  //! Calls consume for each published record, returns false if there were
+  //! none.  Only called by one thread at a time.
+  template <typename Consume> bool ConsumeAll(Consume &&consume) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto const head = head_.load(std::memory_order_acquire);
+    if (tail == head)
+      return false;
+
+    while (tail != head) {
+      auto const offset = static_cast<size_t>(tail & (size_ - 1));
+      auto const prefix = ReadPrefix(offset);
+      if (prefix == kWrapMarker) {
+        tail += size_ - offset;
+        continue;
+      }
+
+      consume(data_.get() + offset + kRecordAlignment);
+      tail += GetSlotSize(static_cast<size_t>(prefix));
+    }
+
+    tail_.store(tail, std::memory_order_release);
+    return true;
+  }
+
+private:
+  void WritePrefix(size_t offset, uint64_t value) {
+    std::memcpy(data_.get() + offset, &value, sizeof(value));
+  }
+
+  uint64_t ReadPrefix(size_t offset) const {
+    uint64_t value;
+    std::memcpy(&value, data_.get() + offset, sizeof(value));
+    return value;
+  }
+
+private:
+  size_t size_;
+  std::unique_ptr<std::byte[]> data_;
+
+  //! Written by the producer only.
+  alignas(64) std::atomic<uint64_t> head_ = 0;
+  uint64_t pending_head_ = 0;
+
+  //! Written by the consumer only.
+  alignas(64) std::atomic<uint64_t> tail_ = 0;
+
+  std::atomic<bool> retired_ = false;
+};
+
+AsyncLogger::AsyncLogger(
+    std::unique_ptr<Logger> sink, size_t buffer_size, OverflowPolicy policy)
+    : sink_{std::move(sink)}, buffer_size_{buffer_size}, policy_{policy},
+      id_{next_logger_id.fetch_add(1, std::memory_order_relaxed)} {
+  SetDeferred(true);
+  thread_ = std::thread{[this] { Run(); }};
+}
+
+AsyncLogger::~AsyncLogger() {
+  {
+    std::lock_guard lock{wake_mutex_};
+    stop_ = true;
+  }
+  wake_.notify_all();
+  thread_.join();
+
+  Drain();
+}
+
+void AsyncLogger::Flush() {
+  Drain();
+  sink_->Flush();
+}
+
+Logger &AsyncLogger::LogImpl(
+    Duration when, Level level, StringView target, StringView origin,
+    StringView message) {
+  RecordWriter<StringView> const record{
+      std::chrono::duration_cast<std::chrono::nanoseconds>(when), level,
+      target, origin, message};
+  if (auto *data = BeginRecord(record.GetSize())) {
+    record.Write(data);
+    CommitRecord();
+  }
+  return *this;
+}
+
+std::byte *AsyncLogger::BeginRecord(size_t byte_size) {
+  auto &buffer = GetThreadBuffer();
+
+  if (buffer.CanHold(byte_size)) {
+    do {
+      if (auto *data = buffer.Reserve(byte_size))
+        return data;
+      wake_requested_.store(true, std::memory_order_relaxed);
+      wake_.notify_one();
+      std::this_thread::yield();
+    } while (policy_ == OverflowPolicy::kBlock);
+  }
+
+  dropped_count_.fetch_add(1, std::memory_order_relaxed);
+  return nullptr;
+}
+
+void AsyncLogger::CommitRecord() {
+  GetThreadBuffer().Commit();
+}
+
+auto AsyncLogger::GetThreadBuffer() -> RingBuffer & {
+  // retires the buffer when the thread exits (or switches loggers), the
+  // buffer is shared such that it outlives both the thread and the logger
+  thread_local struct Cache {
+    uint64_t logger_id = 0;
+    std::shared_ptr<RingBuffer> buffer;
+
+    ~Cache() {
+      if (buffer)
+        buffer->Retire();
+    }
+  } cache;
+
+  if (cache.logger_id != id_) {
+    if (cache.buffer)
+      cache.buffer->Retire();
+
+    std::lock_guard lock{buffers_mutex_};
+    buffers_.push_back(std::make_shared<RingBuffer>(buffer_size_));
+    cache.logger_id = id_;
+    cache.buffer = buffers_.back();
+  }
+
+  return *cache.buffer;
+}
+
+size_t AsyncLogger::GetBufferCount() const {
+  std::lock_guard lock{buffers_mutex_};
+  return buffers_.size();
+}
+
+bool AsyncLogger::Drain() {
+  std::lock_guard drain_lock{drain_mutex_};
+
+  std::vector<RingBuffer *> buffers;
+  {
+    std::lock_guard lock{buffers_mutex_};
+    for (auto const &buffer : buffers_)
+      buffers.push_back(buffer.get());
+  }
+
+  std::vector<FormattedRecord> records;
+  std::vector<RingBuffer *> retired;
+  bool drained = false;
+  for (auto *buffer : buffers) {
+    // a buffer that was retired before it is consumed is empty afterwards
+    if (buffer->IsRetired())
+      retired.push_back(buffer);
+    drained |= buffer->ConsumeAll([&records](std::byte const *data) {
+      records.push_back(FormatRecord(data));
+    });
+  }
+
+  // release the buffers of threads that exited
+  if (not retired.empty()) {
+    std::lock_guard lock{buffers_mutex_};
+    buffers_.erase(
+        std::remove_if(
+            buffers_.begin(), buffers_.end(),
+            [&retired](auto const &buffer) {
+              return std::find(retired.begin(), retired.end(), buffer.get()) !=
+                     retired.end();
+            }),
+        buffers_.end());
+  }
+
+  // interleave the messages of all threads
+  std::stable_sort(
+      records.begin(), records.end(),
+      [](auto const &lhs, auto const &rhs) { return lhs.when < rhs.when; });
+
+  for (auto const &record : records) {
+    sink_->LogMessageAt(
+        std::chrono::duration_cast<Duration>(record.when), record.level,
+        record.target, record.origin, record.message);
+  }
+
+  if (auto const dropped = GetDroppedCount();
+      dropped != reported_dropped_count_) {
+    sink_->Log(
+        Level::kWarning, "lib", "AsyncLogger", "dropped ",
+        dropped - reported_dropped_count_,
+        " messages, the ring buffers were full");
+    reported_dropped_count_ = dropped;
+  }
+
+  return drained;
+}
+
+void AsyncLogger::Run() {
+  std::unique_lock lock{wake_mutex_};
+  while (not stop_) {
+    lock.unlock();
+    bool const drained = Drain();
+    lock.lock();
+
+    if (not drained)
+      wake_.wait_for(lock, kPollInterval, [this] {
+        return stop_ or wake_requested_.exchange(false);
+      });
+  }
+}
+
+} // namespace prtcl::log
@@ -0,0 +1,110 @@
+#ifndef PRTCL_SRC_PRTCL_LOG_ASYNC_LOGGER_HPP
+#define PRTCL_SRC_PRTCL_LOG_ASYNC_LOGGER_HPP
+
+#include "logger.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prtcl::log {
+
+//! Logger that formats and outputs the messages on a background thread.
+//!
+//! Log stores the arguments in binary form (see RecordWriter) in a ring
+//! buffer of the calling thread, which is a single producer, single consumer
+//! queue and thus needs no locks.  The background thread periodically drains
+//! all ring buffers, orders the records by their timestamp, formats them and
+//! passes them to the sink.  Once a ring buffer is full, its thread either
+//! drops the message (counted and reported as a warning) or waits for the
+//! background thread, depending on the OverflowPolicy.  The buffer of a
+//! thread is released once the thread exited and its records were output.
+class AsyncLogger : public Logger {
+public:
+  enum class OverflowPolicy {
+    //! Drop the message, the thread never waits for the background thread.
+    kDrop,
+    //! Wait until the background thread made room in the buffer.
+    kBlock,
+  };
+
+  //! Default size of the ring buffer of each thread.
+  static constexpr size_t kDefaultBufferSize = size_t{1} << 20;
+
+public:
+  explicit AsyncLogger(
+      std::unique_ptr<Logger> sink, size_t buffer_size = kDefaultBufferSize,
+      OverflowPolicy policy = OverflowPolicy::kDrop);
+
+  //! Outputs all remaining messages and stops the background thread.
+  ~AsyncLogger() override;
+
+  AsyncLogger(AsyncLogger const &) = delete;
+  AsyncLogger &operator=(AsyncLogger const &) = delete;
+
+public:
+  void Flush() override;
+
+  //! Number of messages that were dropped since the logger was created.
+  size_t GetDroppedCount() const {
+    return dropped_count_.load(std::memory_order_relaxed);
+  }
+
+  Logger &GetSink() { return *sink_; }
+
+  //! Number of ring buffers, one per thread that logged and did not exit (or
+  //! whose records were not output yet).
+  size_t GetBufferCount() const;
+
+protected:
+  Logger &
+  LogImpl(Duration when, Level level, StringView target, StringView origin,
+      StringView message) override;
+
+  std::byte *BeginRecord(size_t byte_size) override;
+
+  void CommitRecord() override;
+
+private:
+  class RingBuffer;
+
+  RingBuffer &GetThreadBuffer();
+
+  //! Outputs all committed records, returns false if there were none.
+  bool Drain();
+
+  void Run();
+
+private:
+  std::unique_ptr<Logger> sink_;
+  size_t buffer_size_;
+  OverflowPolicy policy_;
+  //! Identifies this logger in the per-thread cache of GetThreadBuffer.
+  uint64_t id_;
+
+  mutable std::mutex buffers_mutex_;
+  std::vector<std::shared_ptr<RingBuffer>> buffers_;
+
+  //! Serializes the consumers (background thread and Flush).
+  std::mutex drain_mutex_;
+  size_t reported_dropped_count_ = 0;
+  std::atomic<size_t> dropped_count_ = 0;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  bool stop_ = false;
+  //! Set by threads that wait for room in their buffer.
+  std::atomic<bool> wake_requested_ = false;
+
+  std::thread thread_;
+};
+
+} // namespace prtcl::log
+
+#endif // PRTCL_SRC_PRTCL_LOG_ASYNC_LOGGER_HPP
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <prtcl/log/async_logger.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <omp.h>
+
+namespace {
+
+using prtcl::log::AsyncLogger;
+using prtcl::log::Level;
+using prtcl::log::Logger;
+
+//! Stores the messages instead of writing them anywhere.
+class CollectingLogger : public Logger {
+public:
+  struct Entry {
+    Duration when;
+    Level level;
+    std::string origin;
+    std::string message;
+  };
+
+  std::vector<Entry> entries;
+
+protected:
+  Logger &
+  LogImpl(Duration when, Level level, StringView, StringView origin,
+      StringView message) override {
+    entries.push_back({when, level, std::string{origin}, std::string{message}});
+    return *this;
+  }
+};
+
+struct Streamable {
+  int value;
+
+  friend std::ostream &operator<<(std::ostream &os, Streamable const &s) {
+    return os << "Streamable{" << s.value << "}";
+  }
+};
+
+TEST(AsyncLogger, FormatsLikeLogger) {
+  auto sink = std::make_unique<CollectingLogger>();
+  auto &entries = sink->entries;
+  AsyncLogger logger{std::move(sink)};
+
+  int const value = 0;
+  std::string const text = "text";
+  logger.Log(
+      Level::kInfo, "test", "origin", "int=", -3, " size=", size_t{7},
+      " float=", 0.25f, " double=", 1.5, " bool=", true, " char=", 'c',
+      " string=", text, " ptr=", &value, " ", Streamable{42});
+  logger.Flush();
+
+  std::ostringstream expected;
+  expected << "int=" << -3 << " size=" << size_t{7} << " float=" << 0.25f
+           << " double=" << 1.5 << " bool=" << true << " char=" << 'c'
+           << " string=" << text << " ptr=" << &value << " "
+           << Streamable{42};
+
+  ASSERT_EQ(entries.size(), 1);
+  EXPECT_EQ(entries[0].level, Level::kInfo);
+  EXPECT_EQ(entries[0].origin, "origin");
+  EXPECT_EQ(entries[0].message, expected.str());
+}
+
+TEST(AsyncLogger, InterleavesThreads) {
+  constexpr int kMessagesPerThread = 1000;
+
+  auto sink = std::make_unique<CollectingLogger>();
+  auto &entries = sink->entries;
+  AsyncLogger logger{std::move(sink)};
+  logger.Change(Level::kDebug, false);
+
+  int thread_count = 0;
+#pragma omp parallel
+  {
+#pragma omp single
+    thread_count = omp_get_num_threads();
+
+    for (int i = 0; i < kMessagesPerThread; ++i) {
+      logger.Log(Level::kInfo, "test", "thread", omp_get_thread_num(), ' ', i);
+      logger.Log(Level::kDebug, "test", "thread", "filtered");
+    }
+  }
+  logger.Flush();
+
+  EXPECT_EQ(logger.GetDroppedCount(), 0);
+  ASSERT_EQ(entries.size(), thread_count * kMessagesPerThread);
+
+  // the messages of each thread keep their order
+  std::vector<int> next(static_cast<size_t>(thread_count), 0);
+  for (auto const &entry : entries) {
+    std::istringstream ss{entry.message};
+    int thread, i;
+    ss >> thread >> i;
+    EXPECT_EQ(i, next[static_cast<size_t>(thread)]++);
+  }
+}
+
+TEST(AsyncLogger, OverflowPolicy) {
+  constexpr size_t kMessageCount = 10000;
+
+  for (auto policy :
+       {AsyncLogger::OverflowPolicy::kDrop,
+        AsyncLogger::OverflowPolicy::kBlock}) {
+    auto sink = std::make_unique<CollectingLogger>();
+    auto &entries = sink->entries;
+    AsyncLogger logger{std::move(sink), 256, policy};
+
+    for (size_t i = 0; i < kMessageCount; ++i)
+      logger.Log(Level::kInfo, "test", "overflow", "message ", i);
+    logger.Flush();
+
+    // dropped messages are reported by warnings of the logger itself
+    auto const received = std::count_if(
+        entries.begin(), entries.end(),
+        [](auto const &entry) { return entry.origin == "overflow"; });
+    auto const dropped = logger.GetDroppedCount();
+    EXPECT_EQ(static_cast<size_t>(received) + dropped, kMessageCount);
+    if (policy == AsyncLogger::OverflowPolicy::kBlock) {
+      EXPECT_EQ(dropped, 0);
+    }
+  }
+}
+
+TEST(AsyncLogger, ReleasesBuffersOfExitedThreads) {
+  auto sink = std::make_unique<CollectingLogger>();
+  auto &entries = sink->entries;
+  AsyncLogger logger{std::move(sink)};
+
+  for (int i = 0; i < 100; ++i)
+    std::thread{[&logger, i] {
+      logger.Log(Level::kInfo, "test", "thread", i);
+    }}.join();
+  logger.Flush();
+
+  EXPECT_EQ(entries.size(), 100);
+  EXPECT_EQ(logger.GetBufferCount(), 0);
+}
+
+} // namespace
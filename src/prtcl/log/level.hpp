@@ -2,6 +2,12 @@
 
 #include <type_traits>
 
+//! Lowest level that is compiled in (1 debug, 2 info, 3 warning, 4 error),
+//! messages of lower levels are removed at compile time.
+#ifndef PRTCL_LOG_MIN_LEVEL
+#define PRTCL_LOG_MIN_LEVEL 1
+#endif
+
 namespace prtcl::log {
 
 enum class Level {
@@ -13,8 +19,12 @@ enum class Level {
 
 using LevelMask = std::underlying_type_t<Level>;
 
-inline LevelMask ToMask(Level level) {
+constexpr LevelMask ToMask(Level level) {
   return static_cast<LevelMask>(level);
 }
 
+constexpr bool IsCompiled(Level level) {
+  return ToMask(level) >= (LevelMask{1} << PRTCL_LOG_MIN_LEVEL);
+}
+
 } // namespace prtcl::log
\ No newline at end of file
@@ -2,7 +2,9 @@
 #define PRTCL_LOGGER_HPP
 
 #include "level.hpp"
+#include "record.hpp"
 
+#include <atomic>
 #include <string_view>
 #include <sstream>
 #include <chrono>
@@ -15,7 +17,6 @@ public:
   using CharTraits = std::char_traits<CharType>;
   using StringView = std::basic_string_view<CharType, CharTraits>;
 
-protected:
   using Duration = std::chrono::high_resolution_clock::duration;
 
 private:
@@ -39,6 +40,21 @@ protected:
     return *this;
   }
 
+  //! Deferred loggers return storage for a record of byte_size bytes (see
+  //! RecordWriter), or nullptr if the record is to be dropped.  Each record
+  //! is followed by CommitRecord on the same thread.
+  virtual std::byte *BeginRecord(size_t byte_size) {
+    (void) (byte_size);
+    return nullptr;
+  }
+
+  virtual void CommitRecord() {}
+
+  //! Derived classes that implement BeginRecord and CommitRecord enable
+  //! them with this, Log then stores the arguments instead of formatting
+  //! them.
+  void SetDeferred(bool deferred) { deferred_ = deferred; }
+
 public:
   Logger &LogMessage(Level level, StringView target, StringView origin,
       StringView message) {
@@ -50,36 +66,64 @@ public:
       return *this;
   }
 
+  //! Outputs a message that was timestamped (and filtered) elsewhere.
+  Logger &LogMessageAt(Duration when, Level level, StringView target,
+      StringView origin, StringView message) {
+    if (Enabled(level))
+      return this->LogImpl(when, level, target, origin, message);
+    else
+      return *this;
+  }
+
   template<typename ...Args>
   Logger &
   Log(Level level, StringView target, StringView origin, Args &&...args) {
-    if (Enabled(level)) {
+    if (not Enabled(level))
+      return *this;
+
+    if (deferred_) {
+      auto const start_time = GetStartTime();
+      RecordWriter<std::decay_t<Args>...> const record{
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              GetCurrentTime() - start_time),
+          level, target, origin, args...};
+      if (auto *data = BeginRecord(record.GetSize())) {
+        record.Write(data);
+        CommitRecord();
+      }
+      return *this;
+    } else {
       std::basic_ostringstream<CharType, CharTraits> ss;
       (ss << ... << std::forward<Args>(args));
       return LogMessage(level, target, origin, ss.str());
-    } else
-      return *this;
+    }
   }
 
+  //! Waits until all messages logged so far are output.
+  virtual void Flush() {}
+
 public:
   bool Change(Level level, bool state = true) {
     if (state)
-      level_mask_ |= ToMask(level);
+      level_mask_.fetch_or(ToMask(level), std::memory_order_relaxed);
     else
-      level_mask_ &= ~ToMask(level);
+      level_mask_.fetch_and(~ToMask(level), std::memory_order_relaxed);
     return state;
   }
 
   bool Toggle(Level level) { return Change(level, not Enabled(level)); }
 
   bool Enabled(Level level) const {
-    return 0 != (level_mask_ & ToMask(level));
+    return IsCompiled(level) and
+           0 != (level_mask_.load(std::memory_order_relaxed) & ToMask(level));
   }
 
 private:
-  LevelMask level_mask_ =
+  std::atomic<LevelMask> level_mask_ =
       ToMask(Level::kDebug) | ToMask(Level::kInfo) | ToMask(Level::kWarning) |
       ToMask(Level::kError);
+
+  bool deferred_ = false;
 };
 
 } // namespace prtcl::log
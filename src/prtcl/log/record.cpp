@@ -0,0 +1,75 @@
+#include <prtcl/log/record.hpp>
+
+namespace prtcl::log {
+
+namespace {
+
+class RecordReader {
+public:
+  explicit RecordReader(std::byte const *data) : data_{data} {}
+
+public:
+  template <typename Value> Value Read() {
+    Value value;
+    std::memcpy(&value, data_, sizeof(Value));
+    data_ += sizeof(Value);
+    return value;
+  }
+
+  std::string_view ReadString(size_t size) {
+    std::string_view const value{reinterpret_cast<char const *>(data_), size};
+    data_ += size;
+    return value;
+  }
+
+private:
+  std::byte const *data_;
+};
+
+} // namespace
+
+FormattedRecord FormatRecord(std::byte const *data) {
+  RecordReader reader{data};
+  auto const header = reader.Read<RecordHeader>();
+
+  FormattedRecord record;
+  record.when = std::chrono::nanoseconds{header.when};
+  record.level = header.level;
+  record.target = reader.ReadString(header.target_size);
+  record.origin = reader.ReadString(header.origin_size);
+
+  std::ostringstream ss;
+  for (uint32_t argi = 0; argi < header.arg_count; ++argi) {
+    switch (reader.Read<RecordArgType>()) {
+    case RecordArgType::kBool:
+      ss << reader.Read<bool>();
+      break;
+    case RecordArgType::kChar:
+      ss << reader.Read<char>();
+      break;
+    case RecordArgType::kSigned:
+      ss << reader.Read<int64_t>();
+      break;
+    case RecordArgType::kUnsigned:
+      ss << reader.Read<uint64_t>();
+      break;
+    case RecordArgType::kFloat:
+      ss << reader.Read<float>();
+      break;
+    case RecordArgType::kDouble:
+      ss << reader.Read<double>();
+      break;
+    case RecordArgType::kPointer:
+      ss << reader.Read<void const *>();
+      break;
+    case RecordArgType::kString:
+      ss << reader.ReadString(reader.Read<uint32_t>());
+      break;
+    }
+  }
+  record.message = ss.str();
+
+  return record;
+}
+
+} // namespace prtcl::log
@@ -0,0 +1,195 @@
+#ifndef PRTCL_SRC_PRTCL_LOG_RECORD_HPP
+#define PRTCL_SRC_PRTCL_LOG_RECORD_HPP
+
+#include "level.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace prtcl::log {
+
+//! Binary representation of a log message whose arguments are not formatted
+//! yet.  Loggers that defer the formatting (see AsyncLogger) store records
+//! in their buffers and format them later, on another thread.
+//!
+//! A record consists of a header, the target and origin strings and the
+//! arguments, each prefixed by a RecordArgType tag.  Arithmetic values,
+//! pointers and strings are copied as they are, all other arguments are
+//! formatted into a string when the record is written.
+enum class RecordArgType : uint8_t {
+  kBool,
+  kChar,
+  kSigned,
+  kUnsigned,
+  kFloat,
+  kDouble,
+  kPointer,
+  kString,
+};
+
+struct RecordHeader {
+  int64_t when;
+  Level level;
+  uint32_t target_size;
+  uint32_t origin_size;
+  uint32_t arg_count;
+};
+
+namespace detail {
+
+//! Converts an argument to the value that is stored in the record.
+template <typename Arg> auto ToRecordArg(Arg const &arg) {
+  using T = std::decay_t<Arg>;
+  if constexpr (std::is_same_v<T, bool>)
+    return arg;
+  else if constexpr (
+      std::is_same_v<T, char> or std::is_same_v<T, signed char> or
+      std::is_same_v<T, unsigned char>)
+    return static_cast<char>(arg);
+  else if constexpr (std::is_integral_v<T> and std::is_signed_v<T>)
+    return static_cast<int64_t>(arg);
+  else if constexpr (std::is_integral_v<T>)
+    return static_cast<uint64_t>(arg);
+  else if constexpr (std::is_same_v<T, float>)
+    return arg;
+  else if constexpr (std::is_floating_point_v<T>)
+    return static_cast<double>(arg);
+  else if constexpr (
+      std::is_same_v<T, char *> or std::is_same_v<T, char const *>)
+    return std::string_view{arg};
+  else if constexpr (
+      std::is_same_v<T, std::string> or std::is_same_v<T, std::string_view>)
+    return std::string_view{arg};
+  else if constexpr (std::is_pointer_v<T>)
+    return static_cast<void const *>(arg);
+  else {
+    // no binary representation, format eagerly
+    std::ostringstream ss;
+    ss << arg;
+    return ss.str();
+  }
+}
+
+template <typename Value> constexpr RecordArgType GetRecordArgType() {
+  if constexpr (std::is_same_v<Value, bool>)
+    return RecordArgType::kBool;
+  else if constexpr (std::is_same_v<Value, char>)
+    return RecordArgType::kChar;
+  else if constexpr (std::is_same_v<Value, int64_t>)
+    return RecordArgType::kSigned;
+  else if constexpr (std::is_same_v<Value, uint64_t>)
+    return RecordArgType::kUnsigned;
+  else if constexpr (std::is_same_v<Value, float>)
+    return RecordArgType::kFloat;
+  else if constexpr (std::is_same_v<Value, double>)
+    return RecordArgType::kDouble;
+  else if constexpr (std::is_same_v<Value, void const *>)
+    return RecordArgType::kPointer;
+  else
+    return RecordArgType::kString;
+}
+
+inline size_t GetStringSize(std::string_view value) {
+  return sizeof(uint32_t) + value.size();
+}
+
+template <typename Value> size_t GetRecordArgSize(Value const &value) {
+  if constexpr (GetRecordArgType<Value>() == RecordArgType::kString)
+    return 1 + GetStringSize(value);
+  else
+    return 1 + sizeof(Value);
+}
+
+inline std::byte *WriteBytes(std::byte *out, void const *data, size_t size) {
+  std::memcpy(out, data, size);
+  return out + size;
+}
+
+inline std::byte *WriteString(std::byte *out, std::string_view value) {
+  auto const size = static_cast<uint32_t>(value.size());
+  out = WriteBytes(out, &size, sizeof(size));
+  return WriteBytes(out, value.data(), value.size());
+}
+
+template <typename Value>
+std::byte *WriteRecordArg(std::byte *out, Value const &value) {
+  constexpr auto type = GetRecordArgType<Value>();
+  out = WriteBytes(out, &type, 1);
+  if constexpr (type == RecordArgType::kString)
+    return WriteString(out, value);
+  else
+    return WriteBytes(out, &value, sizeof(Value));
+}
+
+} // namespace detail
+
+//! Encodes the arguments of one log message, see RecordHeader.
+template <typename... Args> class RecordWriter {
+public:
+  RecordWriter(
+      std::chrono::nanoseconds when, Level level, std::string_view target,
+      std::string_view origin, Args const &... args)
+      : when_{when}, level_{level}, target_{target}, origin_{origin},
+        args_{detail::ToRecordArg(args)...} {}
+
+public:
+  //! Number of bytes needed by Write.
+  size_t GetSize() const {
+    return std::apply(
+        [this](auto const &... args) {
+          return sizeof(RecordHeader) + target_.size() + origin_.size() +
+                 (size_t{0} + ... + detail::GetRecordArgSize(args));
+        },
+        args_);
+  }
+
+  //! Writes the record to out, which must provide GetSize() bytes.
+  void Write(std::byte *out) const {
+    RecordHeader const header{
+        static_cast<int64_t>(when_.count()), level_,
+        static_cast<uint32_t>(target_.size()),
+        static_cast<uint32_t>(origin_.size()),
+        static_cast<uint32_t>(sizeof...(Args))};
+    out = detail::WriteBytes(out, &header, sizeof(header));
+    out = detail::WriteBytes(out, target_.data(), target_.size());
+    out = detail::WriteBytes(out, origin_.data(), origin_.size());
+    std::apply(
+        [&out](auto const &... args) {
+          ((out = detail::WriteRecordArg(out, args)), ...);
+        },
+        args_);
+  }
+
+private:
+  std::chrono::nanoseconds when_;
+  Level level_;
+  std::string_view target_;
+  std::string_view origin_;
+  std::tuple<decltype(detail::ToRecordArg(std::declval<Args const &>()))...>
+      args_;
+};
+
+//! A record with its arguments formatted into the message.
+struct FormattedRecord {
+  std::chrono::nanoseconds when;
+  Level level;
+  std::string target;
+  std::string origin;
+  std::string message;
+};
+
+//! Decodes and formats a record written by RecordWriter, the arguments are
+//! formatted exactly as Logger::Log formats them.
+FormattedRecord FormatRecord(std::byte const *data);
+
+} // namespace prtcl::log
+
+#endif // PRTCL_SRC_PRTCL_LOG_RECORD_HPP
@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -105,7 +105,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -182,7 +182,7 @@ public:
     { // foreach fluid particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+        PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -193,7 +193,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -219,6 +219,8 @@ public:
               }
             } // foreach fluid neighbor f_f
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach fluid particle f
@@ -237,7 +239,7 @@ public:
     { // foreach fluid particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+        PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -248,7 +250,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -299,6 +301,8 @@ public:
               }
             } // foreach boundary neighbor f_b
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach fluid particle f
@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -82,7 +82,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -134,7 +134,7 @@ public:
     { // foreach boundary particle b
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=boundary");
+        PRTCL_PROFILE_SCOPE("foreach boundary particle b");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -145,7 +145,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.boundary) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -170,6 +170,8 @@ public:
             // compute
             p.v_V[i] = (static_cast<T>(1) / p.v_V[i]);
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach boundary particle b
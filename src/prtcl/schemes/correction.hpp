@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -84,7 +84,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -143,16 +143,18 @@ public:
     { // foreach fluid particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+        PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.fluid) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // compute
             p.v_L[i] = o::template identity<real, N, N>();
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach fluid particle f
@@ -171,7 +173,7 @@ public:
     { // foreach fluid particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+        PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -182,7 +184,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -211,6 +213,8 @@ public:
             // compute
             p.v_L[i] = o::invert_pm(l_L_f);
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach fluid particle f
@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -83,7 +83,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -142,16 +142,18 @@ public:
     { // foreach dynamic particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=dynamic");
+        PRTCL_PROFILE_SCOPE("foreach dynamic particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.dynamic) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // compute
             p.v_a[i] = *g.g_g;
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach dynamic particle f
@@ -170,16 +172,18 @@ public:
     { // foreach dynamic particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=dynamic");
+        PRTCL_PROFILE_SCOPE("foreach dynamic particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.dynamic) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // compute
             p.v_a[i] += *g.g_g;
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach dynamic particle f
@@ -198,12 +202,12 @@ public:
     { // foreach dynamic particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=dynamic");
+        PRTCL_PROFILE_SCOPE("foreach dynamic particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.dynamic) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // local_def ...;
             Tensor<real, N> l_xc = (p.v_x[i] - *g.g_c);
@@ -221,6 +225,8 @@ public:
                 (((-o::norm(*g.g_g)) * l_xc_o) *
                  o::reciprocal_or_zero(o::norm(l_xc_o), static_cast<T>(1e-9)));
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach dynamic particle f
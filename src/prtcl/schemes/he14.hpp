@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -106,7 +106,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -186,7 +186,7 @@ public:
     { // foreach fluid particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+        PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -197,7 +197,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -223,6 +223,8 @@ public:
               }
             } // foreach fluid neighbor f_f
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach fluid particle f
@@ -241,7 +243,7 @@ public:
     { // foreach fluid particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+        PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -252,7 +254,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -279,6 +281,8 @@ public:
             // compute
             p.v_d[i] /= p.v_c[i];
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach fluid particle f
@@ -297,7 +301,7 @@ public:
     { // foreach fluid particle f
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+        PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -308,7 +312,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -346,6 +350,8 @@ public:
               }
             } // foreach boundary neighbor f_b
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach fluid particle f
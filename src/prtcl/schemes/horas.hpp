@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -125,7 +125,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -233,12 +233,12 @@ public:
                                : r_l_x_min_dim) reduction(max                  \
                                                           : r_l_x_max_dim)
         {
-          PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=visible");
+          PRTCL_PROFILE_SCOPE("foreach visible particle i");
 
           auto &t = _per_thread[omp_get_thread_num()];
 
           for (auto &p : _data.groups.visible) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
             for (size_t i = 0; i < p._count; ++i) {
               // reduce
               r_l_x_min_dim = o::min(r_l_x_min_dim, (p.v_x[i])[i_dim]);
@@ -246,6 +246,8 @@ public:
               // reduce
               r_l_x_max_dim = o::max(r_l_x_max_dim, (p.v_x[i])[i_dim]);
             }
+
+            PRTCL_PROFILE_BARRIER();
           }
         } // omp parallel region
 
@@ -276,12 +278,12 @@ public:
     { // foreach horason particle i
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=horason");
+        PRTCL_PROFILE_SCOPE("foreach horason particle i");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.horason) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // compute
             p.v_x[i] = p.v_x0[i];
@@ -289,6 +291,8 @@ public:
             // compute
             p.v_t[i] = p.v_t0[i];
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach horason particle i
@@ -313,7 +317,7 @@ public:
     { // foreach horason particle i
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=horason");
+        PRTCL_PROFILE_SCOPE("foreach horason particle i");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -324,7 +328,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.horason) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -368,6 +372,8 @@ public:
             // compute
             p.v_x[i] = (p.v_x0[i] + (p.v_t[i] * p.v_d[i]));
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach horason particle i
@@ -398,7 +404,7 @@ public:
     { // foreach horason particle i
 #pragma omp parallel
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=horason");
+        PRTCL_PROFILE_SCOPE("foreach horason particle i");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
@@ -409,7 +415,7 @@ public:
           pgn.reserve(100);
 
         for (auto &p : _data.groups.horason) {
-#pragma omp for
+#pragma omp for nowait
           for (size_t i = 0; i < p._count; ++i) {
             // cleanup neighbor storage
             for (auto &pgn : neighbors)
@@ -462,6 +468,8 @@ public:
             // compute
             p.v_x[i] = (p.v_x0[i] + (p.v_t[i] * p.v_d[i]));
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
     }   // foreach horason particle i
@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -113,7 +113,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -196,7 +196,7 @@ public:
 
     {// foreach fluid particle f
 #pragma omp parallel
-     {PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+     {PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
     auto &t = _per_thread[omp_get_thread_num()];
 
@@ -207,7 +207,7 @@ public:
       pgn.reserve(100);
 
     for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
       for (size_t i = 0; i < p._count; ++i) {
         // cleanup neighbor storage
         for (auto &pgn : neighbors)
@@ -244,6 +244,8 @@ public:
           }
         } // foreach boundary neighbor f_b
       }
+
+      PRTCL_PROFILE_BARRIER();
     }
   } // omp parallel region
 } // foreach fluid particle f
@@ -258,7 +260,7 @@ public:
 
 #pragma omp parallel reduction(+ : r_g_nprde)
   {
-    PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+    PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
     auto &t = _per_thread[omp_get_thread_num()];
 
@@ -269,7 +271,7 @@ public:
       pgn.reserve(100);
 
     for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
       for (size_t i = 0; i < p._count; ++i) {
         // cleanup neighbor storage
         for (auto &pgn : neighbors)
@@ -345,6 +347,8 @@ public:
         // reduce
         r_g_nprde += o::template ones<integer>();
       }
+
+      PRTCL_PROFILE_BARRIER();
     }
   } // omp parallel region
 
@@ -367,7 +371,7 @@ void iteration_pressure_acceleration(Neighborhood const &nhood) {
   { // foreach fluid particle f
 #pragma omp parallel
     {
-      PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+      PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
       auto &t = _per_thread[omp_get_thread_num()];
 
@@ -378,7 +382,7 @@ void iteration_pressure_acceleration(Neighborhood const &nhood) {
         pgn.reserve(100);
 
       for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
         for (size_t i = 0; i < p._count; ++i) {
           // cleanup neighbor storage
           for (auto &pgn : neighbors)
@@ -417,6 +421,8 @@ void iteration_pressure_acceleration(Neighborhood const &nhood) {
             }
           } // foreach boundary neighbor f_b
         }
+
+        PRTCL_PROFILE_BARRIER();
       }
     } // omp parallel region
   }   // foreach fluid particle f
@@ -435,11 +441,11 @@ void iteration_pressure(Neighborhood const &nhood) {
   { // foreach fluid particle f
 
     // initialize reductions
-    Tensor<real> r_g_aprde = *g.g_aprde;
+    Tensor<std::common_type_t<real, double>> r_g_aprde = *g.g_aprde;
 
 #pragma omp parallel reduction(+ : r_g_aprde)
     {
-      PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+      PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
       auto &t = _per_thread[omp_get_thread_num()];
 
@@ -450,7 +456,7 @@ void iteration_pressure(Neighborhood const &nhood) {
         pgn.reserve(100);
 
       for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
         for (size_t i = 0; i < p._count; ++i) {
           // cleanup neighbor storage
           for (auto &pgn : neighbors)
@@ -506,11 +512,13 @@ void iteration_pressure(Neighborhood const &nhood) {
               (((p.v_Ap[i] - p.v_s[i]) / *p.u_rho0) *
                o::unit_step_l(static_cast<T>(1e-9), p.v_p[i]));
         }
+
+        PRTCL_PROFILE_BARRIER();
       }
     } // omp parallel region
 
     // finalize reductions
-    *g.g_aprde = r_g_aprde;
+    *g.g_aprde = static_cast<real>(r_g_aprde);
 
   } // foreach fluid particle f
 }
@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -121,7 +121,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -223,7 +223,7 @@ public:
 
     {// foreach fluid particle f
 #pragma omp parallel
-     {PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+     {PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
     auto &t = _per_thread[omp_get_thread_num()];
 
@@ -234,7 +234,7 @@ public:
       pgn.reserve(100);
 
     for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
       for (size_t i = 0; i < p._count; ++i) {
         // cleanup neighbor storage
         for (auto &pgn : neighbors)
@@ -285,6 +285,8 @@ public:
         // compute
         p.v_pt16_rho[i] *= *p.u_rho0;
       }
+
+      PRTCL_PROFILE_BARRIER();
     }
   } // omp parallel region
 } // foreach fluid particle f
@@ -292,7 +294,7 @@ public:
 { // foreach fluid particle f
 #pragma omp parallel
   {
-    PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+    PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
     auto &t = _per_thread[omp_get_thread_num()];
 
@@ -303,7 +305,7 @@ public:
       pgn.reserve(100);
 
     for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
       for (size_t i = 0; i < p._count; ++i) {
         // cleanup neighbor storage
         for (auto &pgn : neighbors)
@@ -358,6 +360,8 @@ public:
                           (-l_divergence_f))) +
              (*p.u_xi * l_S_f));
       }
+
+      PRTCL_PROFILE_BARRIER();
     }
   } // omp parallel region
 } // foreach fluid particle f
@@ -376,7 +380,7 @@ void solve_vorticity_diffusion(Neighborhood const &nhood) {
   { // foreach fluid particle f
 #pragma omp parallel
     {
-      PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+      PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
       auto &t = _per_thread[omp_get_thread_num()];
 
@@ -387,7 +391,7 @@ void solve_vorticity_diffusion(Neighborhood const &nhood) {
         pgn.reserve(100);
 
       for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
         for (size_t i = 0; i < p._count; ++i) {
           // cleanup neighbor storage
           for (auto &pgn : neighbors)
@@ -413,6 +417,8 @@ void solve_vorticity_diffusion(Neighborhood const &nhood) {
           // compute
           p.v_omega_rhs[i] *= *p.u_xi;
         }
+
+        PRTCL_PROFILE_BARRIER();
       }
     } // omp parallel region
   }   // foreach fluid particle f
@@ -516,17 +522,19 @@ void solve_vorticity_diffusion(Neighborhood const &nhood) {
   { // foreach fluid particle f
 #pragma omp parallel
     {
-      PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+      PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
       auto &t = _per_thread[omp_get_thread_num()];
 
       for (auto &p : _data.groups.fluid) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
         for (size_t i = 0; i < p._count; ++i) {
           // compute
           p.v_tvg[i] += o::cross_product_matrix_from_vector(
               (static_cast<T>(0.5) * p.v_omega[i]));
         }
+
+        PRTCL_PROFILE_BARRIER();
       }
     } // omp parallel region
   }   // foreach fluid particle f
@@ -545,17 +553,19 @@ void vorticity_preservation(Neighborhood const &nhood) {
   { // foreach fluid particle f
 #pragma omp parallel
     {
-      PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+      PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
       auto &t = _per_thread[omp_get_thread_num()];
 
       for (auto &p : _data.groups.fluid) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
         for (size_t i = 0; i < p._count; ++i) {
           // compute
           p.v_tvg[i] += o::cross_product_matrix_from_vector(
               (static_cast<T>(0.5) * p.v_omega[i]));
         }
+
+        PRTCL_PROFILE_BARRIER();
       }
     } // omp parallel region
   }   // foreach fluid particle f
@@ -574,7 +584,7 @@ void solve_velocity_reconstruction(Neighborhood const &nhood) {
   { // foreach fluid particle f
 #pragma omp parallel
     {
-      PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=fluid");
+      PRTCL_PROFILE_SCOPE("foreach fluid particle f");
 
       auto &t = _per_thread[omp_get_thread_num()];
 
@@ -585,7 +595,7 @@ void solve_velocity_reconstruction(Neighborhood const &nhood) {
         pgn.reserve(100);
 
       for (auto &p : _data.groups.fluid) {
-#pragma omp for
+#pragma omp for nowait
         for (size_t i = 0; i < p._count; ++i) {
           // cleanup neighbor storage
           for (auto &pgn : neighbors)
@@ -609,6 +619,8 @@ void solve_velocity_reconstruction(Neighborhood const &nhood) {
             }
           } // foreach @particle@ neighbor f_f
         }
+
+        PRTCL_PROFILE_BARRIER();
       }
     } // omp parallel region
   }   // foreach fluid particle f
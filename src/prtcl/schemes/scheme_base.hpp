@@ -5,8 +5,11 @@
 #include "../data/model.hpp"
 #include "../log.hpp"
 #include "../util/neighborhood.hpp"
+#include "../util/perf_counters.hpp"
+#include "../util/profiler.hpp"
 
 #include <functional>
+#include <optional>
 #include <string>
 #include <string_view>
 
@@ -31,9 +34,17 @@ public:
 
 public:
   void RunProcedure(std::string_view name, Neighborhood const &nhood) {
-    if (auto it = procedures_.find(name); it != procedures_.end())
-      it->second(*this, nhood);
-    else
+    if (auto it = procedures_.find(name); it != procedures_.end()) {
+      auto const &procedure = it->second;
+      // the address of the stored name is stable between calls
+      PRTCL_PROFILE_SCOPE(procedure.qualified_name.c_str());
+
+      std::optional<PerfCounterScope> counters;
+      if (PerfCounters::IsEnabled())
+        counters.emplace(procedure.qualified_name);
+
+      procedure.function(*this, nhood);
+    } else
       throw "procedure does not exist";
   }
 
@@ -53,14 +64,26 @@ protected:
     // object itself can be copied since the object itself is _not_ bound in the
     // stored std::function's
     procedures_.emplace(
-        name, [proc](SchemeBase &self, Neighborhood const &nhood) {
-          // call the pointer to the procedure implementation
-          (static_cast<Impl *>(&self)->*proc)(nhood);
-        });
+        name,
+        Procedure{
+            [proc](SchemeBase &self, Neighborhood const &nhood) {
+              // call the pointer to the procedure implementation
+              (static_cast<Impl *>(&self)->*proc)(nhood);
+            },
+            // procedures are registered by the constructor of Impl, which
+            // already provides GetFullName
+            GetFullName() + "::" + std::string{name}});
   }
 
 private:
-  cxx::het_flat_map<std::string, ProcedureFunction> procedures_;
+  struct Procedure {
+    ProcedureFunction function;
+    //! The names of the scheme and the procedure, which identify the
+    //! procedure in the profile and the performance counters.
+    std::string qualified_name;
+  };
+
+  cxx::het_flat_map<std::string, Procedure> procedures_;
 };
 
 class SchemeRegistry {
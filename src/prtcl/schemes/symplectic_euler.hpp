@@ -17,6 +17,7 @@
 #include <prtcl/log.hpp>
 
 #include <prtcl/util/neighborhood.hpp>
+#include <prtcl/util/profiler.hpp>
 
 #include <sstream>
 #include <string_view>
@@ -32,7 +33,6 @@
 #pragma GCC diagnostic ignored "-Wsign-conversion"
 #endif
 
-#define PRTCL_RT_LOG_TRACE_SCOPED(...)
 namespace prtcl {
 namespace schemes {
 
@@ -54,6 +54,7 @@ private:
     UniformFieldSpan<real> g_t;
     UniformFieldSpan<real> g_dt_fade;
     UniformFieldSpan<real> g_max_speed;
+    UniformFieldSpan<real> g_max_accel;
   };
 
 private:
@@ -87,7 +88,7 @@ private:
 
 private:
   struct per_thread_data {
-    std::vector<std::vector<size_t>> neighbors;
+    std::vector<NeighborList> neighbors;
   };
 
   std::vector<per_thread_data> _per_thread;
@@ -116,6 +117,8 @@ public:
     _data.global.g_t = model.AddGlobalFieldImpl<real>("current_time");
     _data.global.g_dt_fade = model.AddGlobalFieldImpl<real>("fade_duration");
     _data.global.g_max_speed = model.AddGlobalFieldImpl<real>("maximum_speed");
+    _data.global.g_max_accel =
+        model.AddGlobalFieldImpl<real>("maximum_acceleration");
 
     auto group_count = model.GetGroupCount();
     _data.group_count = group_count;
@@ -151,21 +154,34 @@ public:
     _per_thread.resize(omp_get_max_threads());
 
     { // foreach dynamic particle i
-#pragma omp parallel
+
+      // initialize reductions
+      Tensor<real> r_g_max_accel = *g.g_max_accel;
+
+#pragma omp parallel reduction(max : r_g_max_accel)
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=dynamic");
+        PRTCL_PROFILE_SCOPE("foreach dynamic particle i");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.dynamic) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // compute
             p.v_v[i] += (*g.g_dt * p.v_a[i]);
+
+            // reduce
+            r_g_max_accel = o::max(r_g_max_accel, o::norm(p.v_a[i]));
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
-    }   // foreach dynamic particle i
+
+      // finalize reductions
+      *g.g_max_accel = r_g_max_accel;
+
+    } // foreach dynamic particle i
   }
 
 public:
@@ -179,14 +195,18 @@ public:
     _per_thread.resize(omp_get_max_threads());
 
     { // foreach dynamic particle i
-#pragma omp parallel
+
+      // initialize reductions
+      Tensor<real> r_g_max_accel = *g.g_max_accel;
+
+#pragma omp parallel reduction(max : r_g_max_accel)
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=dynamic");
+        PRTCL_PROFILE_SCOPE("foreach dynamic particle i");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.dynamic) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // compute
             p.v_v[i] +=
@@ -194,10 +214,19 @@ public:
                  o::unit_step_l(
                      static_cast<T>(0),
                      ((*g.g_t - p.v_t_birth[i]) - *g.g_dt_fade)));
+
+            // reduce
+            r_g_max_accel = o::max(r_g_max_accel, o::norm(p.v_a[i]));
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
-    }   // foreach dynamic particle i
+
+      // finalize reductions
+      *g.g_max_accel = r_g_max_accel;
+
+    } // foreach dynamic particle i
   }
 
 public:
@@ -211,14 +240,18 @@ public:
     _per_thread.resize(omp_get_max_threads());
 
     { // foreach dynamic particle i
-#pragma omp parallel
+
+      // initialize reductions
+      Tensor<real> r_g_max_accel = *g.g_max_accel;
+
+#pragma omp parallel reduction(max : r_g_max_accel)
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=dynamic");
+        PRTCL_PROFILE_SCOPE("foreach dynamic particle i");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.dynamic) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // compute
             p.v_v[i] +=
@@ -226,10 +259,19 @@ public:
                  o::smoothstep(
                      (((*g.g_t - p.v_t_birth[i]) - *g.g_dt_fade) /
                       *g.g_dt_fade)));
+
+            // reduce
+            r_g_max_accel = o::max(r_g_max_accel, o::norm(p.v_a[i]));
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
-    }   // foreach dynamic particle i
+
+      // finalize reductions
+      *g.g_max_accel = r_g_max_accel;
+
+    } // foreach dynamic particle i
   }
 
 public:
@@ -249,12 +291,12 @@ public:
 
 #pragma omp parallel reduction(max : r_g_max_speed)
       {
-        PRTCL_RT_LOG_TRACE_SCOPED("foreach_particle", "p=dynamic");
+        PRTCL_PROFILE_SCOPE("foreach dynamic particle i");
 
         auto &t = _per_thread[omp_get_thread_num()];
 
         for (auto &p : _data.groups.dynamic) {
-#pragma omp for schedule(static)
+#pragma omp for schedule(static) nowait
           for (size_t i = 0; i < p._count; ++i) {
             // compute
             p.v_x[i] += (*g.g_dt * p.v_v[i]);
@@ -262,6 +304,8 @@ public:
             // reduce
             r_g_max_speed = o::max(r_g_max_speed, o::norm(p.v_v[i]));
           }
+
+          PRTCL_PROFILE_BARRIER();
         }
       } // omp parallel region
 
@@ -302,11 +346,14 @@ scheme symplectic_euler {
     field dt_fade = real fade_duration;
 
     field max_speed = real maximum_speed;
+    field max_accel = real maximum_acceleration;
   }
 
   procedure integrate_velocity {
     foreach dynamic particle i {
       compute v.i += dt * a.i;
+
+      reduce max_accel max= norm(a.i);
     }
   }
 
@@ -317,6 +364,8 @@ scheme symplectic_euler {
         *
           // accelerations "turn on" after a particle is older than dt_fade
           unit_step_l(0, (t - t_birth.i) - dt_fade);
+
+      reduce max_accel max= norm(a.i);
     }
   }
 
@@ -327,6 +376,8 @@ scheme symplectic_euler {
         *
           // accelerations "fade in" until a particle is older than dt_fade
           smoothstep((t - t_birth.i - dt_fade) / dt_fade);
+
+      reduce max_accel max= norm(a.i);
     }
   }
 
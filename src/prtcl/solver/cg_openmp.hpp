@@ -2,7 +2,10 @@
 #define PRTCL_SRC_PRTCL_MATH_SOLVER_CG_OPENMP_HPP
 
 #include "../math.hpp"
+#include "../util/huge_page_pool.hpp"
+#include "../util/profiler.hpp"
 
+#include <type_traits>
 #include <vector>
 
 #include <omp.h>
@@ -13,7 +16,7 @@ template <typename T, size_t... N>
 class CGOpenMP {
 private:
   using ItemType = math::Tensor<T, N...>;
-  using ItemVector = std::vector<ItemType>;
+  using ItemVector = std::vector<ItemType, PoolAllocator<ItemType>>;
 
 public:
   size_t GetSize() const { return _x.size(); }
@@ -42,6 +45,8 @@ public:
     if (group._count == 0)
       return 0;
 
+    PRTCL_PROFILE_SCOPE("cg solve");
+
     // resize the internal buffers to the group's size
     Resize(group._count);
 
@@ -112,6 +117,8 @@ public:
 
     size_t iter;
     for (iter = 0; ok(iter, r_nsq); ++iter) {
+      PRTCL_PROFILE_SCOPE("cg iteration");
+
 #ifdef PRTCL_RT_OPENMP_SOLVER_DEBUG
       PRTCL_RT_LOG_TRACE_SCOPED("cg iteration");
 
@@ -218,7 +225,8 @@ private:
   T _dot(ItemVector const &lhs, ItemVector const &rhs) const {
     using namespace ::prtcl::math;
 
-    T accumulator = 0;
+    // single precision products are summed in double precision
+    std::common_type_t<T, double> accumulator = 0;
 
 #pragma omp parallel for schedule(static) reduction(+ : accumulator)
     for (size_t i = 0; i < lhs.size(); ++i) {
@@ -232,7 +240,7 @@ private:
         accumulator += sum(cmul(lhs[i], rhs[i]));
     }
 
-    return accumulator;
+    return static_cast<T>(accumulator);
   }
 
 private:
@@ -80,4 +80,9 @@ void NativeBinaryArchiveReader::LoadValues(size_t count, double *values) {
   LoadValuesImpl(*istream_, count, values);
 }
 
+void NativeBinaryArchiveReader::SkipValues(size_t count, size_t value_size) {
+  istream_->seekg(
+      static_cast<std::streamoff>(count * value_size), std::ios_base::cur);
+}
+
 } // namespace prtcl
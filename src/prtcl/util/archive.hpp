@@ -36,6 +36,9 @@ public:
   virtual void LoadValues(size_t count, int64_t *values) = 0;
   virtual void LoadValues(size_t count, float *values) = 0;
   virtual void LoadValues(size_t count, double *values) = 0;
+
+  //! Skips count values that each occupy value_size bytes.
+  virtual void SkipValues(size_t count, size_t value_size) = 0;
 };
 
 class NativeBinaryArchiveWriter final : public ArchiveWriter {
@@ -64,6 +67,7 @@ public:
   void LoadValues(size_t count, int64_t *values);
   void LoadValues(size_t count, float *values);
   void LoadValues(size_t count, double *values);
+  void SkipValues(size_t count, size_t value_size);
 
 public:
   NativeBinaryArchiveReader(std::istream &istream) : istream_{&istream} {}
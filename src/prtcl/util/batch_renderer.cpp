@@ -0,0 +1,217 @@
+#include "batch_renderer.hpp"
+
+#include "../log.hpp"
+#include "archive.hpp"
+#include "frame_archive.hpp"
+#include "image_io.hpp"
+#include "sphere_tracer.hpp"
+#include "thread_affinity.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <omp.h>
+
+namespace prtcl {
+
+void BatchRenderer::Render(
+    size_t frame_count, LoadFrameFn const &load_frame,
+    std::string const &output_pattern) const {
+  if (camera_path_.IsEmpty())
+    throw std::runtime_error{"the camera path of the batch renderer is empty"};
+  if (frame_count == 0)
+    return;
+
+  auto const thread_count = static_cast<size_t>(omp_get_max_threads());
+  size_t worker_count = frame_concurrency_;
+  if (worker_count == 0)
+    worker_count = frame_count > thread_count ? thread_count : 1;
+  worker_count = std::clamp<size_t>(worker_count, 1, frame_count);
+  auto const threads_per_worker =
+      static_cast<int>(std::max<size_t>(thread_count / worker_count, 1));
+
+  log::Info(
+      "lib", "BatchRenderer", "rendering ", frame_count, " frames, ",
+      worker_count, " at once with ", threads_per_worker, " threads each");
+
+  std::atomic<size_t> next_frame = 0;
+  std::atomic<bool> failed = false;
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  auto const fail = [&failed, &error_mutex, &error] {
+    failed = true;
+    std::lock_guard lock{error_mutex};
+    if (not error)
+      error = std::current_exception();
+  };
+
+  // hands the models from the loader of a worker to the worker
+  struct Prefetch {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::unique_ptr<Model> model;
+    size_t frame = 0;
+    // the loader has no more frames, the worker does not take more frames
+    bool finished = false;
+    bool stopped = false;
+  };
+
+  auto const work = [&] {
+    Prefetch prefetch;
+
+    // each worker has one loader thread for all its frames, which loads the
+    // next frame while the worker traces the current one
+    std::thread loader{[&] {
+      ApplyProcessAffinity();
+      // the threads of the worker trace, the loader only reads
+      omp_set_num_threads(1);
+      try {
+        for (auto frame = next_frame.fetch_add(1);
+             frame < frame_count and not failed;
+             frame = next_frame.fetch_add(1)) {
+          auto model = std::make_unique<Model>();
+          load_frame(frame, *model);
+
+          std::unique_lock lock{prefetch.mutex};
+          prefetch.changed.wait(
+              lock, [&] { return not prefetch.model or prefetch.stopped; });
+          if (prefetch.stopped)
+            break;
+          prefetch.model = std::move(model);
+          prefetch.frame = frame;
+          prefetch.changed.notify_all();
+        }
+      } catch (...) {
+        fail();
+      }
+
+      std::lock_guard lock{prefetch.mutex};
+      prefetch.finished = true;
+      prefetch.changed.notify_all();
+    }};
+
+    try {
+      while (not failed) {
+        std::unique_ptr<Model> model;
+        size_t frame;
+        {
+          std::unique_lock lock{prefetch.mutex};
+          prefetch.changed.wait(
+              lock, [&] { return prefetch.model or prefetch.finished; });
+          if (not prefetch.model)
+            break;
+          model = std::move(prefetch.model);
+          frame = prefetch.frame;
+          prefetch.changed.notify_all();
+        }
+
+        RenderFrame(frame, *model, output_pattern);
+      }
+    } catch (...) {
+      fail();
+    }
+
+    {
+      std::lock_guard lock{prefetch.mutex};
+      prefetch.stopped = true;
+      prefetch.changed.notify_all();
+    }
+    loader.join();
+  };
+
+  if (worker_count == 1) {
+    work();
+  } else {
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < worker_count; ++worker) {
+      workers.emplace_back([&work, threads_per_worker] {
+        // do not inherit the single cpu of a pinned initial thread
+        ApplyProcessAffinity();
+        // the parallel regions of the tracer in this worker
+        omp_set_num_threads(threads_per_worker);
+        work();
+      });
+    }
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+void BatchRenderer::RenderNativeBinaryFiles(
+    std::vector<std::string> const &paths,
+    std::string const &output_pattern) const {
+  Render(
+      paths.size(),
+      [&paths](size_t frame, Model &model) {
+        std::fstream file{paths[frame], file.in | file.binary};
+        if (not file)
+          throw std::runtime_error{"could not open " + paths[frame]};
+        NativeBinaryArchiveReader archive{file};
+        model.Load(archive);
+      },
+      output_pattern);
+}
+
+void BatchRenderer::RenderFrameArchive(
+    std::string const &path, std::string const &output_pattern) const {
+  FrameArchiveReader reader{path};
+  // the reader seeks in a single file
+  std::mutex reader_mutex;
+  Render(
+      reader.GetFrameCount(),
+      [&reader, &reader_mutex](size_t frame, Model &model) {
+        std::lock_guard lock{reader_mutex};
+        reader.LoadFrame(frame, model);
+      },
+      output_pattern);
+}
+
+std::string
+BatchRenderer::FormatFramePath(std::string const &pattern, size_t frame) {
+  auto index = std::to_string(frame);
+
+  auto const last = pattern.find_last_of('#');
+  if (last == std::string::npos)
+    return pattern + index;
+
+  auto const first = pattern.find_last_not_of('#', last) + 1;
+  auto const width = last + 1 - first;
+  if (index.size() < width)
+    index.insert(0, width - index.size(), '0');
+
+  return pattern.substr(0, first) + index + pattern.substr(last + 1);
+}
+
+void BatchRenderer::RenderFrame(
+    size_t frame, Model const &model, std::string const &output_pattern) const {
+  auto const start = std::chrono::steady_clock::now();
+
+  SphereTracer<PinholeCamera> tracer{
+      camera_path_.GetCamera(static_cast<double>(frame))};
+  tracer.SetThreshold(threshold_);
+  tracer.SetMaxSteps(max_steps_);
+  auto const image = tracer.Trace(model);
+
+  auto const path = FormatFramePath(output_pattern, frame);
+  SaveImage(path, image);
+
+  std::chrono::duration<double> const seconds =
+      std::chrono::steady_clock::now() - start;
+  log::Info(
+      "lib", "BatchRenderer", "frame ", frame, " saved to ", path, " (",
+      seconds.count(), " s)");
+}
+
+} // namespace prtcl
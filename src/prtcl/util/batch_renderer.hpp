@@ -0,0 +1,90 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_BATCH_RENDERER_HPP
+#define PRTCL_SRC_PRTCL_UTIL_BATCH_RENDERER_HPP
+
+#include "../data/model.hpp"
+#include "../geometry/camera_path.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+namespace prtcl {
+
+//! Renders a sequence of frames with the SphereTracer and saves the images.
+//!
+//! Each worker has a loader thread that loads the next frame it renders
+//! while the worker traces the current one, such that loading the archives
+//! overlaps with tracing.  With fewer frames than threads the frames are rendered one
+//! after the other with all threads tracing the pixels of a frame; otherwise
+//! one worker per thread renders a frame each, which avoids the imbalance at
+//! the end of each image and overlaps the loading and saving of all workers.
+class BatchRenderer {
+public:
+  //! Loads a frame into an empty model.  Different frames are loaded
+  //! concurrently (into different models).
+  using LoadFrameFn = std::function<void(size_t frame, Model &model)>;
+
+public:
+  //! The camera of frame i is GetCamera(i) of the path, it must not be empty.
+  CameraPath &GetCameraPath() { return camera_path_; }
+
+  CameraPath const &GetCameraPath() const { return camera_path_; }
+
+  void SetCameraPath(CameraPath path) { camera_path_ = std::move(path); }
+
+  double GetThreshold() const { return threshold_; }
+
+  void SetThreshold(double value) { threshold_ = value; }
+
+  size_t GetMaxSteps() const { return max_steps_; }
+
+  void SetMaxSteps(size_t value) { max_steps_ = value; }
+
+  //! Number of frames that are rendered at once, zero selects it from the
+  //! number of frames and threads (see the class description).
+  size_t GetFrameConcurrency() const { return frame_concurrency_; }
+
+  void SetFrameConcurrency(size_t value) { frame_concurrency_ = value; }
+
+public:
+  //! Renders the frames [0, frame_count) and saves frame i to
+  //! FormatFramePath(output_pattern, i), the extension selects the format
+  //! (see SaveImage).
+  void Render(
+      size_t frame_count, LoadFrameFn const &load_frame,
+      std::string const &output_pattern) const;
+
+  //! Renders one native binary model archive per frame.
+  void RenderNativeBinaryFiles(
+      std::vector<std::string> const &paths,
+      std::string const &output_pattern) const;
+
+  //! Renders all frames of a frame archive (see FrameArchiveReader).
+  void RenderFrameArchive(
+      std::string const &path, std::string const &output_pattern) const;
+
+public:
+  //! Replaces the last run of '#' in the pattern by the frame index padded
+  //! with zeros to the length of the run, e.g. image.####.png becomes
+  //! image.0042.png.  Patterns without '#' get the index appended.
+  static std::string
+  FormatFramePath(std::string const &pattern, size_t frame);
+
+private:
+  void RenderFrame(
+      size_t frame, Model const &model,
+      std::string const &output_pattern) const;
+
+private:
+  CameraPath camera_path_;
+  // the defaults of SphereTracer
+  double threshold_ = 0.5;
+  size_t max_steps_ = 300;
+  size_t frame_concurrency_ = 0;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_BATCH_RENDERER_HPP
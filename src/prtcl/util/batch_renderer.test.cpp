@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "batch_renderer.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+using namespace prtcl;
+
+namespace {
+
+std::string ReadFile(std::string const &path) {
+  std::ifstream file{path, std::ios::binary};
+  return {std::istreambuf_iterator<char>{file}, {}};
+}
+
+} // namespace
+
+TEST(BatchRenderer, FormatFramePath) {
+  EXPECT_EQ(BatchRenderer::FormatFramePath("a.####.png", 42), "a.0042.png");
+  EXPECT_EQ(BatchRenderer::FormatFramePath("#/b.##.ppm", 123), "#/b.123.ppm");
+  EXPECT_EQ(BatchRenderer::FormatFramePath("c.", 7), "c.7");
+}
+
+TEST(BatchRenderer, ConcurrentFramesMatchSequentialFrames) {
+  auto const directory =
+      std::filesystem::temp_directory_path() / "prtcl-batch-renderer.test";
+  std::filesystem::create_directories(directory);
+
+  // a cube of particles that moves along x
+  auto const load_frame = [](size_t frame, Model &model) {
+    model.AddGlobalFieldImpl<float>("smoothing_scale") = 0.05f;
+    auto &group = model.AddGroup("f", "fluid");
+    group.AddTag("visible");
+    group.CreateItems(500);
+    auto x = group.AddVaryingFieldImpl<float, 3>("position");
+
+    std::mt19937 generator{1};
+    std::uniform_real_distribution<float> distribution{0, 0.4f};
+    for (size_t i = 0; i < x.size(); ++i)
+      x[i] = TensorT<float, 3>{
+          distribution(generator) + 0.1f * static_cast<float>(frame),
+          distribution(generator), distribution(generator)};
+  };
+
+  PinholeCamera camera;
+  camera.camera.origin = {0.3, 0.2, 3};
+  camera.camera.principal = {0, 0, -1};
+  camera.camera.up = {0, 1, 0};
+  camera.camera.focal_length = 1;
+  camera.sensor.width = 16;
+  camera.sensor.height = 12;
+
+  BatchRenderer renderer;
+  renderer.GetCameraPath().AddKey(0, camera);
+
+  auto const sequential = (directory / "s.#.png").string();
+  renderer.SetFrameConcurrency(1);
+  renderer.Render(3, load_frame, sequential);
+
+  auto const concurrent = (directory / "c.#.png").string();
+  renderer.SetFrameConcurrency(3);
+  renderer.Render(3, load_frame, concurrent);
+
+  for (size_t frame = 0; frame < 3; ++frame) {
+    auto const expected =
+        ReadFile(BatchRenderer::FormatFramePath(sequential, frame));
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(
+        ReadFile(BatchRenderer::FormatFramePath(concurrent, frame)), expected);
+  }
+
+  // the frames differ since the particles move
+  EXPECT_NE(
+      ReadFile(BatchRenderer::FormatFramePath(sequential, 0)),
+      ReadFile(BatchRenderer::FormatFramePath(sequential, 2)));
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(BatchRenderer, LoadErrorsArePropagated) {
+  BatchRenderer renderer;
+  renderer.GetCameraPath().AddKey(0, PinholeCamera{});
+  renderer.SetFrameConcurrency(2);
+  EXPECT_THROW(
+      renderer.RenderNativeBinaryFiles(
+          {"/nonexistent/a.bin", "/nonexistent/b.bin"}, "unused.#.png"),
+      std::runtime_error);
+}
@@ -0,0 +1 @@
+#include <prtcl/util/first_touch_allocator.hpp>
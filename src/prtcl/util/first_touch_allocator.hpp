@@ -0,0 +1,109 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_FIRST_TOUCH_ALLOCATOR_HPP
+#define PRTCL_SRC_PRTCL_UTIL_FIRST_TOUCH_ALLOCATOR_HPP
+
+#include "huge_page_pool.hpp"
+
+#include <algorithm>
+#include <new>
+
+#include <cstddef>
+#include <cstring>
+
+namespace prtcl {
+
+//! Allocations smaller than this are not touched in parallel.
+constexpr size_t kFirstTouchMinByteSize = size_t{1} << 20;
+
+//! Touches the memory of count items of item_size bytes with the same static
+//! partition that `#pragma omp for schedule(static)` loops over the items use.
+//! On NUMA systems each page is then placed on the node of the thread that
+//! later processes its items (given bound threads, see thread_affinity.hpp).
+inline void FirstTouch(void *ptr, size_t count, size_t item_size) {
+  if (count * item_size < kFirstTouchMinByteSize)
+    return;
+
+  auto *bytes = static_cast<std::byte *>(ptr);
+
+  using item_index_t = std::ptrdiff_t;
+#pragma omp parallel for schedule(static)
+  for (item_index_t i = 0; i < static_cast<item_index_t>(count); ++i)
+    std::memset(bytes + static_cast<size_t>(i) * item_size, 0, item_size);
+}
+
+//! Fills count items starting at first with value, large ranges are filled
+//! with the static partition of FirstTouch.
+template <typename T>
+void ParallelFill(T *first, size_t count, T const &value) {
+  if (count * sizeof(T) < kFirstTouchMinByteSize) {
+    std::fill_n(first, count, value);
+    return;
+  }
+
+  using item_index_t = std::ptrdiff_t;
+#pragma omp parallel for schedule(static)
+  for (item_index_t i = 0; i < static_cast<item_index_t>(count); ++i)
+    first[i] = value;
+}
+
+//! Allocates uninitialized, cache line aligned memory that is first touched
+//! in parallel (see FirstTouch), such that the storage of particle fields is
+//! distributed over the NUMA nodes like the loops that process it.  Blocks
+//! that are touched in parallel get untouched pages of their own from the
+//! HugePagePool, which are unmapped again on deallocation: cached blocks
+//! would keep the placement of their previous use.  Smaller blocks are taken
+//! from the pool unless T requires a stronger alignment.
+template <typename T>
+class FirstTouchAllocator {
+public:
+  using value_type = T;
+
+  static constexpr size_t kAlignment = std::max<size_t>(64, alignof(T));
+
+public:
+  FirstTouchAllocator() noexcept = default;
+
+  template <typename U>
+  FirstTouchAllocator(FirstTouchAllocator<U> const &) noexcept {}
+
+public:
+  T *allocate(size_t count) {
+    auto const byte_size = count * sizeof(T);
+    if (byte_size >= kFirstTouchMinByteSize) {
+      auto *ptr =
+          static_cast<T *>(HugePagePool::Get().AllocateUntouched(byte_size));
+      FirstTouch(ptr, count, sizeof(T));
+      return ptr;
+    }
+
+    if constexpr (kAlignment <= kHugePagePoolAlignment)
+      return static_cast<T *>(HugePagePool::Get().Allocate(byte_size));
+    else
+      return static_cast<T *>(
+          ::operator new(byte_size, std::align_val_t{kAlignment}));
+  }
+
+  void deallocate(T *ptr, size_t count) noexcept {
+    auto const byte_size = count * sizeof(T);
+    if (byte_size >= kFirstTouchMinByteSize)
+      HugePagePool::Get().DeallocateUntouched(ptr, byte_size);
+    else if constexpr (kAlignment <= kHugePagePoolAlignment)
+      HugePagePool::Get().Deallocate(ptr, byte_size);
+    else
+      ::operator delete(ptr, std::align_val_t{kAlignment});
+  }
+
+public:
+  friend bool
+  operator==(FirstTouchAllocator const &, FirstTouchAllocator const &) {
+    return true;
+  }
+
+  friend bool
+  operator!=(FirstTouchAllocator const &, FirstTouchAllocator const &) {
+    return false;
+  }
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_FIRST_TOUCH_ALLOCATOR_HPP
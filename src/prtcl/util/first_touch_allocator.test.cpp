@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include "../data/varying_field.hpp"
+#include "first_touch_allocator.hpp"
+
+#include <vector>
+
+#include <cstdint>
+
+using namespace prtcl;
+
+TEST(FirstTouchAllocator, AlignedAndZeroed) {
+  std::vector<double, FirstTouchAllocator<double>> values(
+      kFirstTouchMinByteSize / sizeof(double) + 1);
+  ASSERT_EQ(0, reinterpret_cast<uintptr_t>(values.data()) % 64);
+
+  // large fields are zeroed in parallel
+  auto field = MakeVaryingField<float, 3>();
+  field.Resize(kFirstTouchMinByteSize / sizeof(float));
+  auto span = field.Span<float, 3>();
+  ASSERT_EQ(0, reinterpret_cast<uintptr_t>(span.data()) % 64);
+  for (size_t i = 0; i < span.size(); ++i)
+    ASSERT_TRUE(span[i].isZero());
+}
+
+TEST(FirstTouchAllocator, LargeBlocksAreNotRecycled) {
+  auto &pool = HugePagePool::Get();
+  FirstTouchAllocator<double> allocator;
+  auto const count = kFirstTouchMinByteSize / sizeof(double);
+
+  // large blocks start on fresh huge pages and are unmapped again, such
+  // that their pages are always placed by the first touch
+  auto const mapped = pool.GetMappedByteSize();
+  auto const cached = pool.GetCachedByteSize();
+  double *ptr = allocator.allocate(count);
+  ASSERT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % kHugePageSize);
+  ASSERT_GT(pool.GetMappedByteSize(), mapped);
+  allocator.deallocate(ptr, count);
+  ASSERT_EQ(mapped, pool.GetMappedByteSize());
+  ASSERT_EQ(cached, pool.GetCachedByteSize());
+}
@@ -0,0 +1,429 @@
+#include "frame_archive.hpp"
+
+#include "../errors/field_does_not_exist.hpp"
+#include "../errors/invalid_archive_error.hpp"
+#include "../log.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <tuple>
+
+namespace prtcl {
+
+PRTCL_DEFINE_LOG_FOR_INSTANCE(Debug, prtcl::util, FrameArchiveWriter)
+PRTCL_DEFINE_LOG_FOR_INSTANCE(Debug, prtcl::util, FrameArchiveReader)
+
+namespace {
+
+constexpr std::string_view kMagic = "PRTCLFRA";
+constexpr size_t kVersion = 1;
+
+constexpr size_t kHeaderSize = kMagic.size() + sizeof(size_t);
+constexpr size_t kTrailerSize = 2 * sizeof(size_t) + kMagic.size();
+
+void SaveMagic(std::ostream &stream) {
+  stream.write(kMagic.data(), static_cast<std::streamsize>(kMagic.size()));
+}
+
+void CheckMagic(std::istream &stream) {
+  std::string magic(kMagic.size(), '@');
+  stream.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+  if (not stream or magic != kMagic)
+    throw InvalidArchiveError{};
+}
+
+void CheckHeader(std::istream &stream) {
+  NativeBinaryArchiveReader archive{stream};
+  CheckMagic(stream);
+  if (archive.LoadSize() != kVersion or not stream)
+    throw InvalidArchiveError{};
+}
+
+struct Trailer {
+  //! Offset of the first byte after the trailer.
+  size_t end;
+  size_t last_footer_offset;
+  size_t frame_count;
+};
+
+//! Reads the trailer that ends at end, if there is a plausible one.
+std::optional<Trailer> TryLoadTrailer(std::istream &stream, size_t end) {
+  if (end < kHeaderSize + kTrailerSize)
+    return std::nullopt;
+
+  stream.clear();
+  stream.seekg(static_cast<std::streamoff>(end - kTrailerSize));
+  NativeBinaryArchiveReader archive{stream};
+  Trailer trailer{end, archive.LoadSize(), archive.LoadSize()};
+  try {
+    CheckMagic(stream);
+  } catch (InvalidArchiveError const &) {
+    return std::nullopt;
+  }
+
+  // the last footer lies between the header and the trailer
+  bool const valid =
+      trailer.frame_count == 0
+          ? trailer.last_footer_offset == 0
+          : trailer.last_footer_offset >= kHeaderSize and
+                trailer.last_footer_offset < end - kTrailerSize and
+                trailer.frame_count <= end;
+  if (not valid)
+    return std::nullopt;
+  return trailer;
+}
+
+//! Returns the last intact trailer of the archive.  Usually it ends the file,
+//! after an interrupted append the file is scanned back to the trailer of the
+//! previous append.
+Trailer FindLastTrailer(std::istream &stream) {
+  stream.clear();
+  stream.seekg(0, std::ios::end);
+  auto const size = static_cast<size_t>(stream.tellg());
+
+  if (auto trailer = TryLoadTrailer(stream, size))
+    return *trailer;
+
+  constexpr size_t kBlockSize = size_t{1} << 16;
+  std::string block;
+  for (size_t block_end = size; block_end > kHeaderSize;) {
+    size_t const block_begin =
+        block_end > kHeaderSize + kBlockSize ? block_end - kBlockSize
+                                             : kHeaderSize;
+    // blocks overlap, such that a magic spanning two blocks is found
+    size_t const read_end = std::min(size, block_end + kMagic.size() - 1);
+
+    block.resize(read_end - block_begin);
+    stream.clear();
+    stream.seekg(static_cast<std::streamoff>(block_begin));
+    stream.read(block.data(), static_cast<std::streamsize>(block.size()));
+    if (not stream)
+      break;
+
+    for (auto pos = std::string_view{block}.rfind(kMagic);
+         pos != std::string_view::npos;
+         pos = pos > 0 ? std::string_view{block}.rfind(kMagic, pos - 1)
+                       : std::string_view::npos) {
+      // ... magics that start in the overlap were seen in the previous block
+      if (block_begin + pos >= block_end)
+        continue;
+      if (auto trailer =
+              TryLoadTrailer(stream, block_begin + pos + kMagic.size()))
+        return *trailer;
+    }
+
+    block_end = block_begin;
+  }
+
+  throw InvalidArchiveError{};
+}
+
+auto FieldKey(FrameFieldEntry const &entry) {
+  return std::tie(entry.group, entry.field);
+}
+
+template <typename Fields_>
+void SaveChunks(
+    std::fstream &file, ArchiveWriter &archive, Fields_ const &fields,
+    FieldFilter const &filter, Group const *group, FieldKind kind,
+    FrameIndex &index) {
+  auto const group_name = group ? group->GetGroupName() : std::string_view{};
+  for (auto const &[name, field] : fields) {
+    if (not filter.Selects(kind, name, group))
+      continue;
+
+    size_t const offset = static_cast<size_t>(file.tellp());
+    field.GetType().Save(archive);
+    field.Save(archive);
+    size_t const length = static_cast<size_t>(file.tellp()) - offset;
+    index.fields.push_back(
+        {std::string{group_name}, name, kind, offset, length});
+  }
+}
+
+} // namespace
+
+FrameGroupEntry const *FrameIndex::FindGroup(std::string_view name) const {
+  auto it = std::find_if(groups.begin(), groups.end(), [name](auto &entry) {
+    return entry.name == name;
+  });
+  return it != groups.end() ? &*it : nullptr;
+}
+
+FrameFieldEntry const *
+FrameIndex::FindField(std::string_view group, std::string_view field) const {
+  auto const key = std::make_tuple(group, field);
+  auto it = std::lower_bound(
+      fields.begin(), fields.end(), key, [](auto &entry, auto &value) {
+        return std::tuple<std::string_view, std::string_view>{
+                   entry.group, entry.field} < value;
+      });
+  if (it != fields.end() and it->group == group and it->field == field)
+    return &*it;
+  else
+    return nullptr;
+}
+
+FrameArchiveWriter::FrameArchiveWriter(std::string const &path) {
+  namespace fs = std::filesystem;
+
+  if (fs::exists(path) and fs::file_size(path) > 0) {
+    Trailer trailer;
+    {
+      std::ifstream file{path, std::ios::binary};
+      if (not file)
+        throw InvalidArchiveError{};
+      CheckHeader(file);
+      trailer = FindLastTrailer(file);
+    }
+
+    // drop the remains of an interrupted append
+    if (trailer.end != fs::file_size(path)) {
+      log::Warning(
+          "lib", "FrameArchiveWriter", "dropping ",
+          fs::file_size(path) - trailer.end, " bytes of an incomplete frame");
+      fs::resize_file(path, trailer.end);
+    }
+
+    file_.open(path, file_.in | file_.out | file_.binary);
+    if (not file_)
+      throw InvalidArchiveError{};
+
+    last_footer_offset_ = trailer.last_footer_offset;
+    frame_count_ = trailer.frame_count;
+
+    // frames are appended after the trailer, which stays valid until the
+    // next trailer is written
+    file_.seekp(0, file_.end);
+  } else {
+    file_.open(path, file_.out | file_.trunc | file_.binary);
+    if (not file_)
+      throw InvalidArchiveError{};
+
+    SaveMagic(file_);
+    NativeBinaryArchiveWriter archive{file_};
+    archive.SaveSize(kVersion);
+    SaveTrailer();
+  }
+
+  LogDebug(this, "FrameArchiveWriter(\"", path, "\") frames=", frame_count_);
+}
+
+void FrameArchiveWriter::SaveTrailer() {
+  NativeBinaryArchiveWriter archive{file_};
+  archive.SaveSize(last_footer_offset_);
+  archive.SaveSize(frame_count_);
+  SaveMagic(file_);
+  file_.flush();
+  if (not file_)
+    throw InvalidArchiveError{};
+}
+
+size_t FrameArchiveWriter::AppendFrame(Model const &model) {
+  return AppendFrame(model, FieldFilter{});
+}
+
+size_t FrameArchiveWriter::AppendFrame(
+    Model const &model, FieldFilter const &filter) {
+  NativeBinaryArchiveWriter archive{file_};
+
+  FrameIndex index;
+
+  SaveChunks(
+      file_, archive, model.GetGlobal().GetNamedFields(), filter, nullptr,
+      FieldKind::kGlobal, index);
+
+  for (auto const &[group_name, group] : model.GetNamedGroups()) {
+    auto &entry = index.groups.emplace_back();
+    entry.name = group_name;
+    entry.type = group.GetGroupType();
+    entry.tags.assign(group.GetTags().begin(), group.GetTags().end());
+    entry.item_count = group.GetItemCount();
+
+    SaveChunks(
+        file_, archive, group.GetVarying().GetNamedFields(), filter, &group,
+        FieldKind::kVarying, index);
+    SaveChunks(
+        file_, archive, group.GetUniform().GetNamedFields(), filter, &group,
+        FieldKind::kUniform, index);
+  }
+
+  std::sort(
+      index.fields.begin(), index.fields.end(),
+      [](auto &lhs, auto &rhs) { return FieldKey(lhs) < FieldKey(rhs); });
+
+  // write the footer of this frame
+  size_t const footer_offset = static_cast<size_t>(file_.tellp());
+  archive.SaveSize(last_footer_offset_);
+
+  archive.SaveSize(index.groups.size());
+  for (auto const &entry : index.groups) {
+    archive.SaveString(entry.name);
+    archive.SaveString(entry.type);
+    archive.SaveSize(entry.tags.size());
+    for (auto const &tag : entry.tags)
+      archive.SaveString(tag);
+    archive.SaveSize(entry.item_count);
+  }
+
+  archive.SaveSize(index.fields.size());
+  for (auto const &entry : index.fields) {
+    archive.SaveString(entry.group);
+    archive.SaveString(entry.field);
+    archive.SaveSize(static_cast<size_t>(entry.kind));
+    archive.SaveSize(entry.offset);
+    archive.SaveSize(entry.length);
+  }
+
+  last_footer_offset_ = footer_offset;
+  size_t const frame = frame_count_++;
+
+  // the new trailer follows the frame, the previous one is kept in place
+  SaveTrailer();
+
+  LogDebug(this, "AppendFrame(...) frame=", frame);
+
+  return frame;
+}
+
+FrameArchiveReader::FrameArchiveReader(std::string const &path)
+    : file_{path, file_.in | file_.binary} {
+  if (not file_)
+    throw InvalidArchiveError{};
+
+  NativeBinaryArchiveReader archive{file_};
+
+  CheckHeader(file_);
+
+  auto const trailer = FindLastTrailer(file_);
+  size_t footer_offset = trailer.last_footer_offset;
+  frames_.resize(trailer.frame_count);
+  file_.clear();
+
+  // walk the footers from the last to the first frame
+  for (size_t frame = frames_.size(); frame-- > 0;) {
+    file_.seekg(static_cast<std::streamoff>(footer_offset));
+    footer_offset = archive.LoadSize();
+
+    auto &index = frames_[frame];
+
+    index.groups.resize(archive.LoadSize());
+    for (auto &entry : index.groups) {
+      entry.name = archive.LoadString();
+      entry.type = archive.LoadString();
+      entry.tags.resize(archive.LoadSize());
+      for (auto &tag : entry.tags)
+        tag = archive.LoadString();
+      entry.item_count = archive.LoadSize();
+    }
+
+    index.fields.resize(archive.LoadSize());
+    for (auto &entry : index.fields) {
+      entry.group = archive.LoadString();
+      entry.field = archive.LoadString();
+      entry.kind = static_cast<FieldKind>(archive.LoadSize());
+      entry.offset = archive.LoadSize();
+      entry.length = archive.LoadSize();
+    }
+
+    if (not file_)
+      throw InvalidArchiveError{};
+  }
+
+  LogDebug(this, "FrameArchiveReader(\"", path, "\") frames=", frames_.size());
+}
+
+void FrameArchiveReader::LoadFrame(size_t frame, Model &model) {
+  LoadFrame(frame, model, FieldFilter{});
+}
+
+void FrameArchiveReader::LoadFrame(
+    size_t frame, Model &model, FieldFilter const &filter) {
+  auto const &index = frames_.at(frame);
+
+  // the points of the frame are stored relative to its origin
+  LoadPositionOrigin(index, model);
+
+  // create all groups first, such that the filter can match their tags
+  for (auto const &entry : index.groups) {
+    auto &group = model.AddGroup(entry.name, entry.type);
+    for (auto const &tag : entry.tags)
+      group.AddTag(tag);
+    if (group.GetItemCount() != entry.item_count)
+      group.Resize(entry.item_count);
+  }
+
+  for (auto const &entry : index.fields) {
+    if (entry.kind == FieldKind::kGlobal and
+        entry.field == Model::kPositionOriginField)
+      continue;
+
+    auto const *group =
+        entry.group.empty() ? nullptr : model.TryGetGroup(entry.group);
+    if (filter.Selects(entry.kind, entry.field, group))
+      LoadChunk(index, entry, model);
+  }
+}
+
+void FrameArchiveReader::LoadField(
+    size_t frame, std::string_view group, std::string_view field,
+    Model &model) {
+  auto const &index = frames_.at(frame);
+  auto *entry = index.FindField(group, field);
+  if (not entry)
+    throw FieldDoesNotExist{};
+
+  LoadPositionOrigin(index, model);
+  if (group.empty() and field == Model::kPositionOriginField)
+    return;
+
+  LoadChunk(index, *entry, model);
+}
+
+void FrameArchiveReader::LoadPositionOrigin(
+    FrameIndex const &index, Model &model) {
+  auto *entry = index.FindField({}, Model::kPositionOriginField);
+  if (not entry)
+    return;
+
+  LoadChunk(index, *entry, model);
+  model.SetPositionOrigin(model.GetPositionOrigin(), false);
+}
+
+void FrameArchiveReader::LoadChunk(
+    FrameIndex const &index, FrameFieldEntry const &entry, Model &model) {
+  file_.clear();
+  file_.seekg(static_cast<std::streamoff>(entry.offset));
+
+  NativeBinaryArchiveReader archive{file_};
+
+  TensorType type;
+  type.Load(archive);
+
+  if (entry.kind == FieldKind::kGlobal) {
+    model.AddGlobalField(entry.field, type).Load(archive);
+  } else {
+    auto const *group_entry = index.FindGroup(entry.group);
+    if (not group_entry)
+      throw InvalidArchiveError{};
+
+    auto &group = model.AddGroup(group_entry->name, group_entry->type);
+    for (auto const &tag : group_entry->tags)
+      group.AddTag(tag);
+
+    if (entry.kind == FieldKind::kVarying) {
+      if (group.GetItemCount() != group_entry->item_count)
+        group.Resize(group_entry->item_count);
+      group.AddVaryingField(entry.field, type).Load(archive);
+    } else {
+      group.AddUniformField(entry.field, type).Load(archive);
+    }
+  }
+
+  if (not file_)
+    throw InvalidArchiveError{};
+}
+
+} // namespace prtcl
@@ -0,0 +1,126 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_FRAME_ARCHIVE_HPP
+#define PRTCL_SRC_PRTCL_UTIL_FRAME_ARCHIVE_HPP
+
+#include "../data/field_filter.hpp"
+#include "../data/model.hpp"
+#include "archive.hpp"
+
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+
+namespace prtcl {
+
+// Layout of a frame archive (all sizes are native size_t):
+//
+//   header:  magic, version, trailer
+//   frame 0: field chunks ..., frame footer, trailer
+//   frame 1: field chunks ..., frame footer, trailer
+//   ...
+//
+// where each trailer holds the offset of the last frame footer, the frame
+// count and the magic.  Each field chunk holds the tensor type followed by the
+// field data exactly as written by Model::Save.  Each frame footer starts with
+// the offset of the previous frame footer and indexes the chunks of its
+// frame, so appending a frame costs O(frame size).  Readers locate the last
+// trailer, walk the footers once and afterwards seek directly to any (frame,
+// group, field) chunk.
+//
+// Appending never overwrites anything, so an append that is interrupted (by a
+// crash or a full disk) leaves the previous trailer intact.  Readers then scan
+// back to that trailer, writers truncate the incomplete frame.
+
+struct FrameGroupEntry {
+  std::string name;
+  std::string type;
+  std::vector<std::string> tags;
+  size_t item_count;
+};
+
+struct FrameFieldEntry {
+  // the group name is empty for global fields
+  std::string group;
+  std::string field;
+  FieldKind kind;
+  size_t offset;
+  size_t length;
+};
+
+struct FrameIndex {
+  std::vector<FrameGroupEntry> groups;
+  // sorted by (group, field)
+  std::vector<FrameFieldEntry> fields;
+
+public:
+  FrameGroupEntry const *FindGroup(std::string_view name) const;
+
+  FrameFieldEntry const *
+  FindField(std::string_view group, std::string_view field) const;
+};
+
+class FrameArchiveWriter {
+public:
+  //! Opens the archive at path for appending, creates it if it does not exist.
+  explicit FrameArchiveWriter(std::string const &path);
+
+public:
+  size_t GetFrameCount() const { return frame_count_; }
+
+  //! Appends the model as a new frame and returns the index of that frame.
+  size_t AppendFrame(Model const &model);
+
+  //! Appends only the fields of the model selected by the filter.
+  size_t AppendFrame(Model const &model, FieldFilter const &filter);
+
+private:
+  void SaveTrailer();
+
+private:
+  std::fstream file_;
+  size_t frame_count_ = 0;
+  size_t last_footer_offset_ = 0;
+};
+
+class FrameArchiveReader {
+public:
+  explicit FrameArchiveReader(std::string const &path);
+
+public:
+  size_t GetFrameCount() const { return frames_.size(); }
+
+  FrameIndex const &GetFrameIndex(size_t frame) const {
+    return frames_.at(frame);
+  }
+
+public:
+  //! Loads all groups and fields of one frame into the model.
+  void LoadFrame(size_t frame, Model &model);
+
+  //! Loads all groups and the fields selected by the filter of one frame.
+  void LoadFrame(size_t frame, Model &model, FieldFilter const &filter);
+
+  //! Loads a single field of one frame into the model, the group is created
+  //! (and resized) if necessary.  Pass an empty group name for global fields.
+  void LoadField(
+      size_t frame, std::string_view group, std::string_view field,
+      Model &model);
+
+private:
+  //! Loads the position origin of the frame (if any) and makes it the origin
+  //! of the model, without rebasing the points that are loaded afterwards.
+  void LoadPositionOrigin(FrameIndex const &index, Model &model);
+
+  void LoadChunk(
+      FrameIndex const &index, FrameFieldEntry const &entry, Model &model);
+
+private:
+  std::ifstream file_;
+  std::vector<FrameIndex> frames_;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_FRAME_ARCHIVE_HPP
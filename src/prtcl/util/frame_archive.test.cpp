@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include "frame_archive.hpp"
+
+#include "../errors/field_does_not_exist.hpp"
+#include "../errors/invalid_archive_error.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace prtcl;
+
+TEST(FrameArchive, AppendAndRandomAccess) {
+  auto const path =
+      (std::filesystem::temp_directory_path() / "prtcl-frame-archive.test.bin")
+          .string();
+  std::filesystem::remove(path);
+
+  {
+    Model model;
+    auto &group = model.AddGroup("fluid", "fluid");
+    group.AddTag("dynamic");
+    group.CreateItems(3);
+    auto x = group.AddVaryingFieldImpl<float, 3>("x");
+    auto m = group.AddUniformFieldImpl<double>("m");
+    auto t = model.AddGlobalFieldImpl<double>("t");
+
+    FrameArchiveWriter writer{path};
+    for (size_t frame = 0; frame < 2; ++frame) {
+      for (size_t i = 0; i < x.size(); ++i)
+        x[i] = math::Tensor<float, 3>::Constant(
+            static_cast<float>(10 * frame + i));
+      m = 2.0;
+      t = static_cast<double>(frame);
+      ASSERT_EQ(frame, writer.AppendFrame(model));
+    }
+  }
+
+  {
+    // reopening appends after the existing frames
+    Model model;
+    model.AddGroup("boundary", "boundary").CreateItems(1);
+    FrameArchiveWriter writer{path};
+    ASSERT_EQ(2, writer.GetFrameCount());
+    ASSERT_EQ(2, writer.AppendFrame(model));
+  }
+
+  FrameArchiveReader reader{path};
+  ASSERT_EQ(3, reader.GetFrameCount());
+  ASSERT_NE(nullptr, reader.GetFrameIndex(1).FindField("fluid", "x"));
+  ASSERT_EQ(nullptr, reader.GetFrameIndex(2).FindField("fluid", "x"));
+
+  {
+    Model model;
+    reader.LoadField(1, "fluid", "x", model);
+
+    auto *group = model.TryGetGroup("fluid");
+    ASSERT_NE(nullptr, group);
+    ASSERT_TRUE(group->HasTag("dynamic"));
+    ASSERT_EQ(3, group->GetItemCount());
+    ASSERT_FALSE(group->GetUniform().HasField("m"));
+    ASSERT_EQ(0, model.GetGlobal().GetFieldCount());
+
+    auto x = group->GetVarying().FieldSpan<float, 3>("x");
+    ASSERT_EQ(12.f, x[2][0]);
+  }
+
+  {
+    Model model;
+    reader.LoadFrame(0, model);
+    ASSERT_EQ(0., *model.GetGlobal().FieldSpan<double>("t"));
+
+    auto *group = model.TryGetGroup("fluid");
+    ASSERT_NE(nullptr, group);
+    ASSERT_EQ(2., *group->GetUniform().FieldSpan<double>("m"));
+
+    auto x = group->GetVarying().FieldSpan<float, 3>("x");
+    ASSERT_EQ(1.f, x[1][2]);
+
+    ASSERT_THROW(reader.LoadField(2, "fluid", "x", model), FieldDoesNotExist);
+  }
+
+  {
+    Model model;
+    reader.LoadFrame(2, model);
+    ASSERT_EQ(1, model.GetGroupCount());
+    ASSERT_EQ(1, model.TryGetGroup("boundary")->GetItemCount());
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST(FrameArchive, PositionOrigin) {
+  using RVec3 = math::Tensor<double, 3>;
+
+  auto const path = (std::filesystem::temp_directory_path() /
+                     "prtcl-frame-archive-origin.test.bin")
+                        .string();
+  std::filesystem::remove(path);
+
+  RVec3 const far{1e5, 2e5, -3e5};
+  {
+    Model model;
+    double const origin[] = {1e5, 2e5, -3e5};
+    model.SetPositionOrigin(origin);
+    auto &group = model.AddGroup("fluid", "fluid");
+    group.AddVaryingFieldImpl<float, 3>("position");
+    group.CreateItems(1);
+    group.GetVarying().FieldWrap<double, 3>("position").Set(0, far);
+
+    FrameArchiveWriter writer{path};
+    writer.AppendFrame(model);
+  }
+
+  FrameArchiveReader reader{path};
+
+  // the groups are created after the origin is known
+  for (bool single_field : {false, true}) {
+    Model model;
+    if (single_field)
+      reader.LoadField(0, "fluid", "position", model);
+    else
+      reader.LoadFrame(0, model);
+
+    ASSERT_EQ(3, model.GetPositionOrigin().size());
+    auto x = model.TryGetGroup("fluid")->GetVarying().FieldWrap<double, 3>(
+        "position");
+    ASSERT_EQ(far, x.Get(0));
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST(FrameArchive, InterruptedAppend) {
+  auto const path = (std::filesystem::temp_directory_path() /
+                     "prtcl-frame-archive-interrupted.test.bin")
+                        .string();
+  std::filesystem::remove(path);
+
+  Model model;
+  model.AddGroup("fluid", "fluid").CreateItems(2);
+  model.AddGlobalFieldImpl<double>("t") = 1.0;
+  {
+    FrameArchiveWriter writer{path};
+    writer.AppendFrame(model);
+    writer.AppendFrame(model);
+  }
+
+  // the start of a third frame that was never finished
+  std::ofstream{path, std::ios::binary | std::ios::app}
+      << std::string(1000, 'x');
+
+  ASSERT_EQ(2, FrameArchiveReader{path}.GetFrameCount());
+
+  {
+    // the incomplete frame is dropped when appending
+    FrameArchiveWriter writer{path};
+    ASSERT_EQ(2, writer.GetFrameCount());
+    ASSERT_EQ(2, writer.AppendFrame(model));
+  }
+
+  FrameArchiveReader reader{path};
+  ASSERT_EQ(3, reader.GetFrameCount());
+  Model loaded;
+  reader.LoadFrame(2, loaded);
+  ASSERT_EQ(2, loaded.TryGetGroup("fluid")->GetItemCount());
+
+  // files that are not frame archives are not appended to
+  std::ofstream{path, std::ios::binary | std::ios::trunc} << "not an archive";
+  ASSERT_THROW(FrameArchiveWriter{path}, InvalidArchiveError);
+
+  std::filesystem::remove(path);
+}
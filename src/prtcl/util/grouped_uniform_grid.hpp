@@ -5,14 +5,17 @@
 
 #include "../math.hpp"
 #include "constpow.hpp"
+#include "huge_page_pool.hpp"
 #include "morton_order.hpp"
 
+#include <algorithm>
 #include <array>
 #include <functional>
 #include <iterator>
 #include <utility>
 #include <vector>
 
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 
@@ -90,6 +93,10 @@ private:
   enum class cell_index : int32_t { invalid = -1 };
   using grid_index = detail::grid_index_t<N>;
 
+  // rebuilt in every update, the memory is recycled by the HugePagePool
+  template <typename T>
+  using pooled_vector = std::vector<T, PoolAllocator<T>>;
+
   // }}}
 
 public:
@@ -400,6 +407,24 @@ public:
 
   // }}}
 
+  // relabel_after_permutation() {{{
+
+  //! Updates the raw indices after each group was permuted according to
+  //! compute_group_permutations.  Since no position changed, all cells stay
+  //! the same and the grid does not need to be rebuilt.
+  void relabel_after_permutation() {
+    std::array<size_t, max_raw_group> next_index = {};
+    for (size_t n_s = 0; n_s < sorted_to_raw_.size(); ++n_s) {
+      auto &i_gr = sorted_to_raw_[n_s];
+      auto const group = i_gr.get_group();
+      auto const index = next_index[group]++;
+      i_gr.index = static_cast<raw_index>(index);
+      raw_to_sorted_[group][index] = static_cast<sorted_index>(n_s);
+    }
+  }
+
+  // }}}
+
 public:
   // neighbors(group, index, data, callback) {{{
 
@@ -440,6 +465,68 @@ public:
 
   // }}}
 
+  // neighbors(position, radius_multiple, data, callback) {{{
+
+  //! Invokes the callback for each neighbor within radius_multiple times the
+  //! radius of the position.  Larger multiples visit all cells within
+  //! ceil(radius_multiple) cells of the position, except those that are
+  //! farther away than the scaled radius.
+  template <typename X_, typename GroupedVectorData_, typename Fn_>
+  void neighbors(
+      X_ const &x_, double radius_multiple, GroupedVectorData_ const &d_,
+      Fn_ fn_) const {
+    double const radius = radius_multiple * radius_;
+    double const radius_squared = constpow(radius, 2);
+    // the distances are computed in the scalar type of the position
+    auto const x_radius_squared =
+        static_cast<typename X_::Scalar>(radius_squared);
+    auto const filter = [x_radius_squared, &fn_, &x_, &d_](
+                            size_t i_g, size_t i_r) {
+      auto const distance =
+          math::norm_squared(x_ - get_element_ref(get_group_ref(d_, i_g), i_r));
+      if (distance < x_radius_squared) {
+        std::invoke(fn_, i_g, i_r);
+      }
+    };
+
+    if (radius_multiple <= 1) {
+      potential_neighbors(x_, filter);
+      return;
+    }
+
+    auto const x_gi = x_to_gi(x_);
+    auto const reach = static_cast<int32_t>(std::ceil(radius_multiple));
+
+    // enumerate all offsets in [-reach, reach]^N
+    grid_index offset;
+    offset.fill(-reach);
+    while (true) {
+      grid_index y_gi;
+      double box_distance_squared = 0;
+      for (size_t i = 0; i < N; ++i) {
+        y_gi[i] = x_gi[i] + offset[i];
+
+        // distance of the position to the cell along axis i
+        auto const component = static_cast<double>(x_[static_cast<int>(i)]);
+        auto const lo = static_cast<double>(y_gi[i]) * radius_;
+        auto const d = std::max({lo - component, component - lo - radius_, 0.});
+        box_distance_squared += d * d;
+      }
+
+      if (box_distance_squared < radius_squared)
+        potential_neighbors(find_cell(y_gi), filter);
+
+      size_t axis = 0;
+      for (; axis < N and offset[axis] == reach; ++axis)
+        offset[axis] = -reach;
+      if (axis == N)
+        break;
+      ++offset[axis];
+    }
+  }
+
+  // }}}
+
 private:
   // potential_neighbors(cell, callback) {{{
 
@@ -542,7 +629,7 @@ private:
                          [static_cast<size_t>(i_gr.index)];
   }
 
-  std::vector<std::vector<sorted_index>> raw_to_sorted_;
+  std::vector<pooled_vector<sorted_index>> raw_to_sorted_;
 
   // }}}
 
@@ -553,7 +640,7 @@ private:
     return sorted_to_raw_[static_cast<size_t>(i_s)];
   }
 
-  std::vector<raw_grouped_index> sorted_to_raw_;
+  pooled_vector<raw_grouped_index> sorted_to_raw_;
 
   // }}}
 
@@ -564,7 +651,7 @@ private:
     return sorted_to_cell_[static_cast<size_t>(i_s)];
   }
 
-  std::vector<cell_index> sorted_to_cell_;
+  pooled_vector<cell_index> sorted_to_cell_;
 
   // }}}
 
@@ -575,7 +662,7 @@ private:
     return cell_to_sorted_range_[static_cast<size_t>(i_c)];
   }
 
-  std::vector<std::pair<sorted_index, sorted_index>> cell_to_sorted_range_;
+  pooled_vector<std::pair<sorted_index, sorted_index>> cell_to_sorted_range_;
 
   // }}}
 
@@ -586,7 +673,8 @@ private:
     return cell_to_adjacent_cells_[static_cast<size_t>(i_c)];
   }
 
-  std::vector<std::array<cell_index, static_cast<size_t>(constpow(3, N) - 1)>>
+  pooled_vector<
+      std::array<cell_index, static_cast<size_t>(constpow(3, N) - 1)>>
       cell_to_adjacent_cells_;
 
   // }}}
@@ -598,7 +686,7 @@ private:
     return cell_to_grid_[static_cast<size_t>(i_c)];
   }
 
-  std::vector<grid_index> cell_to_grid_;
+  pooled_vector<grid_index> cell_to_grid_;
 
   // }}}
 
@@ -1 +1,184 @@
 #include "hcp_lattice_source.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace prtcl {
+
+void HCPLatticeSource::BuildLayers() {
+  auto const h = smoothing_scale_;
+  auto const g = h * 1.2;
+
+  // compute the direction of the source
+  RVec3 const orientation = math::normalized(velocity_);
+
+  // sample from the plane through origin with normal orientation
+  std::array<RVec3, 3> unit_vectors = {
+      RVec3{1., 0., 0.},
+      RVec3{0., 1., 0.},
+      RVec3{0., 0., 1.},
+  };
+
+  // choose a unit vector which is not linearly dependent on orientation
+  RVec3 tmp;
+  auto const dot_limit = (1. + 1. / std::sqrt(3.)) / 2.;
+  for (size_t n = 0; n < unit_vectors.size(); ++n) {
+    tmp = unit_vectors[n];
+    auto const dot_value = math::dot(orientation, tmp);
+    if (std::abs(dot_value) <= dot_limit) {
+      break;
+    }
+  }
+
+  RVec3 const d1 = math::normalized(math::cross(orientation, tmp));
+  RVec3 const d2 = math::normalized(math::cross(orientation, d1));
+
+  using RVec2 = TensorT<double, 2>;
+
+  // column and row offsets for planar (triangular) grid
+  RVec2 const coffset{g, 0}, roffset{g / 2, SQRT_3() * g / 2};
+  // offsets of the layers a and b for planar (triangular) grid
+  std::array<RVec2, 2> const loffsets{
+      RVec2{0, 0}, RVec2{g / 2, SQRT_3() * g / 6}};
+
+  int const half_extent = static_cast<int>(std::floor(radius_ / h)) + 1;
+  log::Debug(
+      "lib", "HCPLatticeSource", "half_extent=", half_extent, " h=", h,
+      " r=", radius_);
+
+  for (size_t layer = 0; layer < layers_.size(); ++layer) {
+    layers_[layer].clear();
+    for (int i1 = -half_extent; i1 <= half_extent; ++i1) {
+      for (int i2 = -half_extent; i2 <= half_extent; ++i2) {
+        // sample a regular planar grid
+        RVec2 const plane_x = loffsets[layer] + i1 * coffset + i2 * roffset;
+        // filter out any positions not inside the radius
+        if (math::norm(plane_x) > radius_)
+          continue;
+        // accept the positions that were not filtered
+        layers_[layer].push_back(plane_x[0] * d1 + plane_x[1] * d2);
+      }
+    }
+  }
+}
+
+size_t HCPLatticeSource::AppendNextLayer(
+    Duration delay, std::vector<RVec3> &positions) {
+  auto const &layer = layers_[age_ % 2];
+
+  // correct for delayed source execution
+  RVec3 const delta_x = (regular_spawn_interval_ + delay).count() * velocity_;
+  RVec3 const shift = RVec3{center_} + delta_x;
+
+  positions.reserve(positions.size() + layer.size());
+  for (auto const &local_x : layer)
+    positions.push_back(local_x + shift);
+
+  // adjust the remaining particle count and increase the age
+  remaining_ -= static_cast<cxx::count_t>(layer.size());
+  ++age_;
+
+  return layer.size();
+}
+
+void HCPLatticeSource::ReserveItems(
+    Group &group, size_t count, size_t reserve_count) {
+  auto const size = group.GetItemCount() + count;
+  auto const capacity = group.GetCapacity();
+  if (size <= capacity)
+    return;
+
+  group.ReserveItems(std::max(size + reserve_count, capacity + capacity / 2));
+}
+
+void HCPLatticeSource::CreateParticles(
+    Group &group, std::vector<RVec3> const &positions,
+    std::vector<VelocityRun> const &velocity_runs, double smoothing_scale,
+    double time_of_birth) {
+  if (positions.empty())
+    return;
+
+  // create the new particles, the created items are contiguous
+  auto const first = group.CreateItems(positions.size()).front();
+  auto const count = positions.size();
+
+  double const rho0 = group.GetUniform().FieldWrap<double>("rest_density");
+  double const mass = constpow(smoothing_scale, 3) * rho0;
+
+  group.GetVaryingField("position")
+      .SetRealRange(first, count, positions.front().data());
+
+  auto const v = group.GetVaryingField("velocity");
+  size_t offset = first;
+  for (auto const &run : velocity_runs) {
+    v.FillRealRange(offset, run.count, run.velocity.data());
+    offset += run.count;
+  }
+
+  group.GetVaryingField("mass").FillRealRange(first, count, &mass);
+  group.GetVaryingField("time_of_birth")
+      .FillRealRange(first, count, &time_of_birth);
+}
+
+void HCPLatticeSourceBatch::Add(HCPLatticeSource const &source) {
+  if (&source.GetGroup() != group_)
+    throw std::runtime_error{"source emits into a different group"};
+  entries_.push_back({source, std::nullopt});
+}
+
+bool HCPLatticeSourceBatch::IsExhausted() const {
+  return std::all_of(entries_.begin(), entries_.end(), [](auto const &entry) {
+    return entry.source.IsExhausted();
+  });
+}
+
+VirtualScheduler::CallbackReturnType
+HCPLatticeSourceBatch::operator()(VirtualScheduler &scheduler, Duration delay) {
+  auto const now = scheduler.GetClock().now();
+
+  positions_.clear();
+  velocity_runs_.clear();
+
+  std::optional<TimePoint> next_pass;
+  size_t reserve_count = 0;
+  for (auto &entry : entries_) {
+    auto &source = entry.source;
+    // new sources are due when this pass was due
+    if (not entry.next_spawn)
+      entry.next_spawn = now - delay;
+
+    size_t count = 0;
+    while (not source.IsExhausted() and *entry.next_spawn <= now) {
+      count += source.AppendNextLayer(now - *entry.next_spawn, positions_);
+      *entry.next_spawn += source.GetRegularSpawnInterval();
+    }
+    if (count > 0)
+      velocity_runs_.push_back({count, source.GetVelocity()});
+
+    if (not source.IsExhausted()) {
+      reserve_count += source.GetReserveCount();
+      if (not next_pass or *entry.next_spawn < *next_pass)
+        next_pass = entry.next_spawn;
+    }
+  }
+
+  // all particles of the pass are created at once
+  HCPLatticeSource::ReserveItems(*group_, positions_.size(), reserve_count);
+  if (not entries_.empty())
+    HCPLatticeSource::CreateParticles(
+        *group_, positions_, velocity_runs_,
+        entries_.front().source.GetSmoothingScale(),
+        now.time_since_epoch().count());
+
+  log::Debug(
+      "lib", "HCPLatticeSourceBatch", "created ", positions_.size(),
+      " particles from ", velocity_runs_.size(), " of ", entries_.size(),
+      " sources");
+
+  if (next_pass)
+    return scheduler.RescheduleAt(*next_pass);
+  else
+    return scheduler.DoNothing();
+}
+
+} // namespace prtcl
@@ -9,6 +9,10 @@
 #include "constpow.hpp"
 #include "scheduler.hpp"
 
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <utility>
 #include <vector>
 
 namespace prtcl {
@@ -20,6 +24,15 @@ private:
 
   using Duration = typename VirtualScheduler::Duration;
 
+public:
+  using RVec3 = TensorT<double, 3>;
+
+  //! The velocity of the next count particles (see CreateParticles).
+  struct VelocityRun {
+    size_t count;
+    RVec3 velocity;
+  };
+
 public:
   HCPLatticeSource() = delete;
 
@@ -38,141 +51,88 @@ public:
 
     // compute the (virtual) time between spawns
     regular_spawn_interval_ = Duration{height / math::norm(velocity)};
+
+    BuildLayers();
   }
 
 public:
   Duration GetRegularSpawnInterval() const { return regular_spawn_interval_; }
 
-public:
-  auto operator()(VirtualScheduler &scheduler, Duration delay) {
-    // if constexpr (N == 2) {
-    //  throw "not implemented yet";
-    //}
+  Group &GetGroup() const { return *group_; }
 
-    using RVec3 = TensorT<double, 3>;
+  double GetSmoothingScale() const { return smoothing_scale_; }
 
-    auto const h = smoothing_scale_;
-    auto const g = h * 1.2;
+  RVec3 GetVelocity() const { return RVec3{velocity_}; }
 
-    // compute the direction of the source
-    RVec3 const orientation = math::normalized(velocity_);
-    // correct for delayed source execution
-    RVec3 const delta_x = (regular_spawn_interval_ + delay).count() * velocity_;
+  cxx::count_t GetRemaining() const { return remaining_; }
 
-    position_.clear();
+  bool IsExhausted() const { return remaining_ <= 0; }
+
+  //! Number of particles of the next layer.
+  size_t GetNextLayerSize() const { return layers_[age_ % 2].size(); }
+
+  //! Number of items to reserve for the particles that are still emitted,
+  //! at most kReservedLayers layers ahead.
+  size_t GetReserveCount() const {
+    auto const layer_size = std::max(layers_[0].size(), layers_[1].size());
+    return std::min(
+        static_cast<size_t>(std::max<cxx::count_t>(remaining_, 0)),
+        kReservedLayers * layer_size);
+  }
+
+  static constexpr size_t kReservedLayers = 256;
 
-    // sample from the plane through origin with normal orientation
-    // if constexpr (N == 3) {
-    std::array<RVec3, 3> unit_vectors = {
-        RVec3{1., 0., 0.},
-        RVec3{0., 1., 0.},
-        RVec3{0., 0., 1.},
-    };
-
-    // choose a unit vector which is not linearly dependent on orientation
-    RVec3 tmp;
-    auto const dot_limit = (1. + 1. / std::sqrt(3.)) / 2.;
-    for (size_t n = 0; n < unit_vectors.size(); ++n) {
-      tmp = unit_vectors[n];
-      auto const dot_value = math::dot(orientation, tmp);
-      if (std::abs(dot_value) <= dot_limit) {
-        break;
-      }
-    }
-
-    RVec3 const d1 = math::normalized(math::cross(orientation, tmp));
-    RVec3 const d2 = math::normalized(math::cross(orientation, d1));
-
-    using RVec2 = TensorT<double, 2>;
-
-    // column and row offsets for planar (triangular) grid
-    RVec2 const coffset{g, 0}, roffset{g / 2, SQRT_3() * g / 2};
-    // offset for the current layer for planar (triangular) grid
-    RVec2 loffset{0, 0};
-    switch (age_ % 2) {
-#ifdef PRTCL_RT_HCP_LATTICE_DEBUG
-    case 0:
-      log::debug("app", "source", "hcp lattice layer a");
-      break;
-#endif
-    case 1:
-#ifdef PRTCL_RT_HCP_LATTICE_DEBUG
-      log::debug("app", "source", "hcp lattice layer b");
-#endif
-      loffset = RVec2{g / 2, SQRT_3() * g / 6};
-      break;
-    }
-
-    int const half_extent = static_cast<int>(std::floor(radius_ / h)) + 1;
-    log::Debug(
-        "lib", "HCPLatticeSource", "half_extent=", half_extent, " h=", h,
-        " r=", radius_);
-    for (int i1 = -half_extent; i1 <= half_extent; ++i1) {
-      for (int i2 = -half_extent; i2 <= half_extent; ++i2) {
-        // sample a regular planar grid
-        RVec2 const plane_x = loffset + i1 * coffset + i2 * roffset;
-        RVec3 local_x = plane_x[0] * d1 + plane_x[1] * d2;
-        // filter out any positions not inside the radius
-        if (math::norm(plane_x) > radius_)
-          continue;
-        // accept the positions that were not filtered
-        position_.push_back(center_ + local_x + delta_x);
-      }
-    }
-    //}
-
-    // create the new particles
-    auto indices = group_->CreateItems(position_.size());
-    // TODO: initialize_particles(*model_, *group_, indices);
-
-    // fetch target group fields
-    auto rho0 = group_->GetUniform().FieldWrap<double>("rest_density");
-    auto x = group_->GetVarying().FieldWrap<double, 3>("position");
-    auto v = group_->GetVarying().FieldWrap<double, 3>("velocity");
-    auto m = group_->GetVarying().FieldWrap<double>("mass");
-    auto t_b = group_->GetVarying().FieldWrap<double>("time_of_birth");
-
-    // initialize created particles
-    for (size_t i = 0; i < position_.size(); ++i) {
-      using difference_type = typename decltype(indices)::difference_type;
-      auto const j = indices[static_cast<difference_type>(i)];
-      x[j] = position_[i];
-      v[j] = velocity_;
-      m[j] = constpow(h, 3) * rho0;
-      t_b[j] = scheduler.GetClock().now().time_since_epoch().count();
-    }
-
-    log::Debug(
-        "lib", "HCPLatticeSource", "created ", position_.size(), " particles");
-
-    // adjust the remaining particle count
-    remaining_ -= static_cast<ssize_t>(position_.size());
+public:
+  //! Appends the positions of the next layer to positions and advances to
+  //! the following layer.  The layer is moved along the velocity by the
+  //! regular spawn interval plus delay, the time since the layer was due.
+  //! Returns the number of appended positions.
+  size_t AppendNextLayer(Duration delay, std::vector<RVec3> &positions);
+
+  //! Creates one item per position in group and initializes the position,
+  //! velocity (given by the runs in order), mass and time of birth of all
+  //! new items with one bulk write per field and run.  The fields may have
+  //! any floating point type and origin.
+  static void CreateParticles(
+      Group &group, std::vector<RVec3> const &positions,
+      std::vector<VelocityRun> const &velocity_runs, double smoothing_scale,
+      double time_of_birth);
+
+  //! Reserves room for count new items of group and reserve_count items
+  //! ahead, but only once the new items do not fit anymore.  The capacity
+  //! grows at least geometrically, such that the fields are reallocated
+  //! rarely instead of on every spawn.
+  static void
+  ReserveItems(Group &group, size_t count, size_t reserve_count);
+
+public:
+  auto operator()(VirtualScheduler &scheduler, Duration delay) {
     position_.clear();
+    auto const count = AppendNextLayer(delay, position_);
+
+    // avoid growing the fields step by step while the source is emitting
+    ReserveItems(*group_, count, GetReserveCount());
 
-#ifdef PRTCL_RT_HCP_LATTICE_DEBUG
-    log::debug(
-        "app", "source", "at age ", _age, " created ", indices.size(), " of ",
-        _remaining, " particles in group ", _target_group->get_name());
-#endif
+    CreateParticles(
+        *group_, position_, {{count, GetVelocity()}}, smoothing_scale_,
+        scheduler.GetClock().now().time_since_epoch().count());
 
-    // increase age
-    ++age_;
+    log::Debug("lib", "HCPLatticeSource", "created ", count, " particles");
+    position_.clear();
 
     // reschedule if this source is not finished
-    if (remaining_ > 0) {
-      auto after = regular_spawn_interval_ - delay;
-#ifdef PRTCL_RT_HCP_LATTICE_DEBUG
-      log::debug("app", "source", "rescheduling after ", after.count(), "s");
-#endif
-      return scheduler.RescheduleAfter(after);
-    } else {
-#ifdef PRTCL_RT_HCP_LATTICE_DEBUG
-      log::debug("app", "source", "source exhausted, not rescheduling");
-#endif
+    if (not IsExhausted())
+      return scheduler.RescheduleAfter(regular_spawn_interval_ - delay);
+    else
       return scheduler.DoNothing();
-    }
   }
 
+private:
+  //! Computes the positions of both layers (relative to the center of the
+  //! source) once, the layers only differ by the offset of every second
+  //! layer of the hexagonal close packing.
+  void BuildLayers();
+
 private:
   Model *model_;
   Group *group_;
@@ -182,12 +142,53 @@ private:
   DynamicTensorT<double, 1> velocity_;
   cxx::count_t remaining_ = 0;
 
-  std::vector<DynamicTensorT<double, 1>> position_;
+  std::array<std::vector<RVec3>, 2> layers_;
+  std::vector<RVec3> position_;
   size_t age_ = 0;
 
   Duration regular_spawn_interval_;
 };
 
+//! Emits the layers of many sources of one group in a single pass.
+//!
+//! Each pass collects the layers of all sources that are due, creates the
+//! items of all of them at once and writes each field with one bulk write
+//! (velocities with one per source), instead of resizing all fields of the
+//! group and writing through per-item accessors for every source.  The batch
+//! reschedules itself to the next time that any of its sources is due.
+class HCPLatticeSourceBatch {
+private:
+  using Duration = typename VirtualScheduler::Duration;
+  using TimePoint = typename VirtualScheduler::TimePoint;
+
+public:
+  explicit HCPLatticeSourceBatch(Group &group) : group_{&group} {}
+
+public:
+  //! Adds a source that emits into the group of the batch, it is first due
+  //! at the first pass after it was added.
+  void Add(HCPLatticeSource const &source);
+
+  size_t GetSourceCount() const { return entries_.size(); }
+
+  bool IsExhausted() const;
+
+public:
+  VirtualScheduler::CallbackReturnType
+  operator()(VirtualScheduler &scheduler, Duration delay);
+
+private:
+  struct Entry {
+    HCPLatticeSource source;
+    std::optional<TimePoint> next_spawn;
+  };
+
+  Group *group_;
+  std::vector<Entry> entries_;
+  std::vector<HCPLatticeSource::RVec3> positions_;
+  std::vector<HCPLatticeSource::VelocityRun> velocity_runs_;
+};
+
 } // namespace prtcl
 
 #endif // PRTCL_SRC_PRTCL_UTIL_HCP_LATTICE_SOURCE_HPP
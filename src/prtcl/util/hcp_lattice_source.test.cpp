@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include "hcp_lattice_source.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+using namespace prtcl;
+
+namespace {
+
+using Item = std::array<double, 7>;
+
+Group &AddFluid(Model &model) {
+  model.AddGlobalFieldImpl<float>("smoothing_scale") = 0.025f;
+  auto &group = model.AddGroup("f", "fluid");
+  group.AddUniformFieldImpl<double>("rest_density") = 1000;
+  group.AddVaryingFieldImpl<float, 3>("position");
+  group.AddVaryingFieldImpl<double, 3>("velocity");
+  group.AddVaryingFieldImpl<float>("mass");
+  group.AddVaryingFieldImpl<double>("time_of_birth");
+  // the positions are stored relative to an origin
+  group.SetFieldOrigin("position", std::vector<double>{10, 0, 0});
+  return group;
+}
+
+//! Returns the absolute position, velocity and time of birth of all items,
+//! sorted.
+std::vector<Item> GetItems(Group const &group) {
+  auto const x = group.GetVarying().FieldWrap<double, 3>("position");
+  auto const v = group.GetVarying().FieldWrap<double, 3>("velocity");
+  auto const t_b = group.GetVarying().FieldWrap<double>("time_of_birth");
+  std::vector<Item> items;
+  for (size_t i = 0; i < group.GetItemCount(); ++i) {
+    auto const x_i = x.Get(i), v_i = v.Get(i);
+    items.push_back(
+        {x_i[0], x_i[1], x_i[2], v_i[0], v_i[1], v_i[2], t_b.Get(i)});
+  }
+  std::sort(items.begin(), items.end());
+  return items;
+}
+
+DynamicTensorT<double, 1> MakeVector(double x, double y, double z) {
+  DynamicTensorT<double, 1> result{3};
+  result << x, y, z;
+  return result;
+}
+
+} // namespace
+
+TEST(HCPLatticeSource, BatchMatchesSeparateSources) {
+  auto const make_sources = [](Model &model, Group &group) {
+    return std::vector<HCPLatticeSource>{
+        {model, group, 0.1, MakeVector(10, 0, 0), MakeVector(0, 0, 1), 200},
+        {model, group, 0.05, MakeVector(10.5, 0, 0), MakeVector(0, 2, 0),
+         100}};
+  };
+
+  Model separate_model;
+  auto &separate_group = AddFluid(separate_model);
+  VirtualScheduler separate_scheduler;
+  for (auto &source : make_sources(separate_model, separate_group))
+    separate_scheduler.ScheduleAfter(
+        VirtualScheduler::Duration{0.01}, std::move(source));
+
+  Model batch_model;
+  auto &batch_group = AddFluid(batch_model);
+  VirtualScheduler batch_scheduler;
+  HCPLatticeSourceBatch batch{batch_group};
+  for (auto const &source : make_sources(batch_model, batch_group))
+    batch.Add(source);
+  EXPECT_EQ(batch.GetSourceCount(), 2);
+  batch_scheduler.ScheduleAfter(VirtualScheduler::Duration{0.01}, batch);
+
+  // step exactly to each spawn of both sources
+  for (size_t step = 0; step < 400; ++step) {
+    separate_scheduler.GetClockPtr()->advance(0.0005);
+    separate_scheduler.Tick();
+    batch_scheduler.GetClockPtr()->advance(0.0005);
+    batch_scheduler.Tick();
+  }
+
+  auto const expected = GetItems(separate_group);
+  auto const actual = GetItems(batch_group);
+  ASSERT_GE(expected.size(), 300);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+    for (size_t c = 0; c < expected[i].size(); ++c)
+      ASSERT_NEAR(actual[i][c], expected[i][c], 1e-5);
+
+  // the particles are emitted around the center of the sources
+  for (auto const &item : actual)
+    EXPECT_NEAR(item[0], 10.25, 0.4);
+}
+
+TEST(HCPLatticeSource, ReservesGeometrically) {
+  Model model;
+  auto &group = AddFluid(model);
+  HCPLatticeSource source{
+      model, group, 0.05, MakeVector(10, 0, 0), MakeVector(1, 0, 0),
+      1'000'000'000};
+  auto const interval = source.GetRegularSpawnInterval().count();
+  VirtualScheduler scheduler;
+  scheduler.ScheduleAfter(VirtualScheduler::Duration{0}, std::move(source));
+
+  size_t reallocations = 0;
+  for (size_t spawn = 0; spawn < 1000; ++spawn) {
+    auto const capacity = group.GetCapacity();
+    scheduler.Tick();
+    scheduler.GetClockPtr()->advance(interval);
+    reallocations += capacity != group.GetCapacity();
+  }
+
+  // the fields are not reallocated on every spawn of a long running source
+  ASSERT_GE(group.GetItemCount(), 1000);
+  EXPECT_LE(reallocations, 8);
+}
@@ -0,0 +1,414 @@
+#include "horas_engine.hpp"
+
+#include "../log.hpp"
+#include "occupied_cell_tree.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+namespace prtcl {
+
+namespace {
+
+using Real = HorasEngine::Real;
+using RVec = HorasEngine::RVec;
+
+//! Rays are generated in tiles of kTileSize x kTileSize pixels (of the
+//! current level), such that consecutive rays are close to each other.
+constexpr size_t kTileSize = 8;
+
+enum class State : uint8_t { kPending, kHit, kMiss };
+
+struct GroupData {
+  //! Index of the group in the model.
+  size_t index;
+  //! The stored positions (one of them is set).
+  VaryingFieldSpan<float, 3> float_x;
+  VaryingFieldSpan<double, 3> double_x;
+
+  template <typename Fn>
+  void VisitPositions(Fn &&fn) const {
+    if (float_x)
+      fn(float_x);
+    else if (double_x)
+      fn(double_x);
+  }
+};
+
+struct Scene {
+  Neighborhood const *nhood;
+  std::vector<GroupData> groups;
+  size_t group_count;
+  //! Occupied cells of size R, the distance to them bounds the distance to
+  //! the particles from below.
+  OccupiedCellTree cell_tree;
+  //! Bounds of the particles enlarged by R, the surface lies within.
+  RVec lo, hi;
+  //! Subtracted from the origin of the rays, the neighborhood works with the
+  //! stored positions, which are relative to the position origin.
+  RVec offset;
+  //! Constants of the step procedure of horas.prtcl.
+  Real h, R, W, O, L;
+  //! Radius of the queries in multiples of the radius of the neighborhood.
+  Real radius_multiple;
+  Real tolerance;
+  size_t max_steps;
+};
+
+//! The rays of one level.
+struct Rays {
+  std::vector<size_t> pixel;
+  std::vector<RVec> origin, direction, normal;
+  std::vector<Real> parameter, exit;
+  std::vector<size_t> steps;
+  std::vector<State> state;
+
+  size_t GetSize() const { return pixel.size(); }
+
+  void Clear() {
+    pixel.clear();
+    origin.clear();
+    direction.clear();
+    normal.clear();
+    parameter.clear();
+    exit.clear();
+    steps.clear();
+    state.clear();
+  }
+
+  //! Adds a ray that starts where it enters the bounds of the scene, rays
+  //! that miss the bounds are misses right away.
+  void Add(Scene const &scene, size_t p, RVec const &o, RVec const &d) {
+    Real enter = 0, leave = math::positive_infinity<Real>();
+    for (Eigen::Index dim = 0; dim < 3; ++dim) {
+      // zero components yield infinite or NaN parameters, std::max and
+      // std::min keep their first argument when comparing with NaN
+      Real const inverse = Real{1} / d[dim];
+      Real t0 = (scene.lo[dim] - o[dim]) * inverse,
+           t1 = (scene.hi[dim] - o[dim]) * inverse;
+      if (t0 > t1)
+        std::swap(t0, t1);
+      enter = std::max(enter, t0);
+      leave = std::min(leave, t1);
+    }
+
+    pixel.push_back(p);
+    origin.push_back(o);
+    direction.push_back(d);
+    normal.push_back(math::zeros<Real, 3>());
+    parameter.push_back(enter);
+    exit.push_back(leave);
+    steps.push_back(0);
+    state.push_back(enter <= leave ? State::kPending : State::kMiss);
+  }
+};
+
+Scene Prepare(
+    Model const &model, Neighborhood const &nhood, Real tolerance,
+    size_t max_steps) {
+  Scene scene;
+  scene.nhood = &nhood;
+  scene.group_count = model.GetGroupCount();
+
+  scene.h = model.GetGlobal().FieldWrap<Real>("smoothing_scale");
+  scene.R = 2 * scene.h;
+  scene.W = scene.h / 2;
+  scene.O = scene.h;
+  scene.L = Real{1.1};
+  scene.tolerance = tolerance * scene.h;
+  scene.max_steps = max_steps;
+  // the step procedure of the scheme queries the neighbors without margin
+  scene.radius_multiple = scene.R / nhood.GetRadius();
+
+  RVec lo = math::positive_infinity<Real, 3>(),
+       hi = math::negative_infinity<Real, 3>();
+  std::vector<OccupiedCellTree::Cell> cells;
+  for (auto const &group : model.GetGroups()) {
+    auto const &varying = group.GetVarying();
+    if (not group.HasTag("visible") or not varying.HasField("position"))
+      continue;
+
+    if (group.HasTag("cannot_be_neighbor")) {
+      log::Warning(
+          "lib", "HorasEngine", "group ", group.GetGroupName(),
+          " cannot be neighbor and is ignored");
+      continue;
+    }
+
+    auto &gd = scene.groups.emplace_back(GroupData{
+        static_cast<size_t>(group.GetGroupIndex()),
+        varying.FieldSpan<float, 3>("position"),
+        varying.FieldSpan<double, 3>("position")});
+
+    gd.VisitPositions([&](auto const &x) {
+      for (size_t entry = 0; entry < x.GetSize(); ++entry) {
+        OccupiedCellTree::Cell cell;
+        for (Eigen::Index dim = 0; dim < 3; ++dim) {
+          auto const value = static_cast<Real>(x[entry][dim]);
+          lo[dim] = std::min(lo[dim], value);
+          hi[dim] = std::max(hi[dim], value);
+          cell[static_cast<size_t>(dim)] =
+              static_cast<int32_t>(std::floor(value / scene.R));
+        }
+        cells.push_back(cell);
+      }
+    });
+  }
+
+  scene.cell_tree = OccupiedCellTree{std::move(cells), scene.R};
+  for (Eigen::Index dim = 0; dim < 3; ++dim) {
+    scene.lo[dim] = lo[dim] - scene.R;
+    scene.hi[dim] = hi[dim] + scene.R;
+  }
+
+  scene.offset = math::zeros<Real, 3>();
+  if (auto const origin = model.GetPositionOrigin(); origin.size() == 3)
+    scene.offset = RVec{origin[0], origin[1], origin[2]};
+
+  return scene;
+}
+
+//! Evaluates phi(x) and the normal of the surface at x, the normal is zero
+//! if there are no particles within R.
+std::pair<Real, RVec> EvaluateImplicitFunction(
+    Scene const &scene, RVec const &x,
+    std::vector<NeighborList> &neighbors) {
+  for (auto &list : neighbors)
+    list.clear();
+  std::array<double, 3> const position{x[0], x[1], x[2]};
+  scene.nhood->CopyNeighbors(position, scene.radius_multiple, neighbors);
+
+  Real const R_sq = scene.R * scene.R;
+  Real den = 0;
+  RVec nom = math::zeros<Real, 3>();
+  for (auto const &gd : scene.groups) {
+    gd.VisitPositions([&](auto const &xs) {
+      for (auto const entry : neighbors[gd.index]) {
+        RVec x_j;
+        for (Eigen::Index dim = 0; dim < 3; ++dim)
+          x_j[dim] = static_cast<Real>(xs[entry][dim]);
+
+        Real const q_sq = math::norm_squared(x - x_j) / R_sq;
+        if (q_sq >= 1)
+          continue;
+        Real const k = (1 - q_sq) * (1 - q_sq) * (1 - q_sq);
+        den += k;
+        nom += k * x_j;
+      }
+    });
+  }
+
+  if (den <= static_cast<Real>(1e-9))
+    return {scene.O, math::zeros<Real, 3>()};
+
+  RVec const d = x - nom / den;
+  Real const distance = math::norm(d);
+  return {
+      std::min(distance - scene.W, scene.O),
+      distance > 0 ? RVec{d / distance} : math::zeros<Real, 3>()};
+}
+
+//! Advances the ray by up to kStepsPerSweep steps, or until it is retired.
+void Advance(
+    Scene const &scene, Rays &rays, size_t ray,
+    std::vector<NeighborList> &neighbors) {
+  auto &t = rays.parameter[ray];
+  auto &state = rays.state[ray];
+  Real const exit = rays.exit[ray];
+
+  for (size_t step = 0; step < HorasEngine::kStepsPerSweep; ++step) {
+    if (rays.steps[ray]++ >= scene.max_steps) {
+      state = State::kMiss;
+      return;
+    }
+
+    RVec const x = rays.origin[ray] + t * rays.direction[ray];
+
+    // without particles within R phi is O, and the surface is at least as
+    // far away as the particles minus R
+    Real const distance =
+        scene.cell_tree.GetDistance(x, exit - t + scene.R);
+    if (distance >= scene.R) {
+      t += std::max(distance - scene.R, scene.O / scene.L);
+    } else {
+      auto const [phi, normal] =
+          EvaluateImplicitFunction(scene, x, neighbors);
+      if (phi < scene.tolerance) {
+        rays.normal[ray] = normal;
+        state = State::kHit;
+        return;
+      }
+      t += phi / scene.L;
+    }
+
+    if (t > exit) {
+      state = State::kMiss;
+      return;
+    }
+  }
+}
+
+//! Marches all pending rays until they are retired.  Each sweep advances the
+//! active rays in batches and then removes the retired rays.
+void March(
+    Scene const &scene, Rays &rays, HorasEngine::Statistics &statistics) {
+  std::vector<size_t> active;
+  for (size_t ray = 0; ray < rays.GetSize(); ++ray)
+    if (rays.state[ray] == State::kPending)
+      active.push_back(ray);
+
+  while (not active.empty()) {
+    auto const batch_count = static_cast<std::ptrdiff_t>(
+        (active.size() + HorasEngine::kBatchSize - 1) /
+        HorasEngine::kBatchSize);
+
+#pragma omp parallel default(none) shared(scene, rays, active, batch_count)
+    {
+      std::vector<NeighborList> neighbors(scene.group_count);
+
+#pragma omp for schedule(dynamic)
+      for (std::ptrdiff_t batch = 0; batch < batch_count; ++batch) {
+        auto const first = static_cast<size_t>(batch) * HorasEngine::kBatchSize;
+        auto const last =
+            std::min(first + HorasEngine::kBatchSize, active.size());
+        for (size_t k = first; k < last; ++k)
+          Advance(scene, rays, active[k], neighbors);
+      }
+    }
+
+    active.erase(
+        std::remove_if(
+            active.begin(), active.end(),
+            [&rays](size_t ray) { return rays.state[ray] != State::kPending; }),
+        active.end());
+    ++statistics.sweeps;
+  }
+
+  statistics.marched_rays += rays.GetSize();
+  for (auto const steps : rays.steps)
+    statistics.steps += steps;
+}
+
+} // namespace
+
+HorasEngine::Result
+HorasEngine::Extract(Model const &model, Neighborhood const &nhood) const {
+  auto const scene = Prepare(model, nhood, tolerance_, max_steps_);
+
+  size_t const width = camera_.sensor.width, height = camera_.sensor.height;
+  std::vector<State> state(width * height, State::kPending);
+  Result result{Image{width, height}, Image{width, height}, {}};
+
+  // the value of a pixel as for SphereTracer
+  auto set_pixel = [&](size_t pixel, State value, Real t, Real intensity) {
+    state[pixel] = value;
+    result.parameter(pixel % width, pixel / width) =
+        value == State::kHit ? t : math::positive_infinity<Real>();
+    result.intensity(pixel % width, pixel / width) =
+        value == State::kHit ? intensity : Real{0.3};
+  };
+
+  // fills the pixel from the corners of the block of the previous level it
+  // lies in, if they agree
+  Real const depth_tolerance = depth_tolerance_ * scene.h;
+  auto interpolate = [&](size_t ix, size_t iy, size_t parent_stride) {
+    size_t const x0 = ix - ix % parent_stride, y0 = iy - iy % parent_stride;
+    size_t const x1 = x0 + parent_stride < width ? x0 + parent_stride : x0,
+                 y1 = y0 + parent_stride < height ? y0 + parent_stride : y0;
+    std::array<size_t, 4> const corners{
+        y0 * width + x0, y0 * width + x1, y1 * width + x0, y1 * width + x1};
+
+    auto const corner_state = state[corners[0]];
+    for (auto const corner : corners)
+      if (state[corner] != corner_state)
+        return false;
+
+    if (corner_state == State::kMiss) {
+      set_pixel(iy * width + ix, State::kMiss, 0, 0);
+      return true;
+    }
+
+    std::array<Real, 4> t, intensity;
+    for (size_t i = 0; i < 4; ++i) {
+      t[i] = result.parameter(corners[i] % width, corners[i] / width);
+      intensity[i] = result.intensity(corners[i] % width, corners[i] / width);
+    }
+    if (*std::max_element(t.begin(), t.end()) -
+            *std::min_element(t.begin(), t.end()) >
+        depth_tolerance)
+      return false;
+
+    Real const fx = x1 > x0 ? static_cast<Real>(ix - x0) /
+                                  static_cast<Real>(x1 - x0)
+                            : Real{0},
+               fy = y1 > y0 ? static_cast<Real>(iy - y0) /
+                                  static_cast<Real>(y1 - y0)
+                            : Real{0};
+    auto bilinear = [fx, fy](std::array<Real, 4> const &v) {
+      return (1 - fy) * ((1 - fx) * v[0] + fx * v[1]) +
+             fy * ((1 - fx) * v[2] + fx * v[3]);
+    };
+    set_pixel(
+        iy * width + ix, State::kHit, bilinear(t), bilinear(intensity));
+    return true;
+  };
+
+  auto const projection = camera_.GetProjection();
+  Rays rays;
+  for (size_t level = level_count_ + 1; level-- > 0;) {
+    size_t const stride = size_t{1} << level;
+    bool const coarsest = level == level_count_;
+
+    rays.Clear();
+    size_t const tiles_x = (width + kTileSize * stride - 1) /
+                           (kTileSize * stride),
+                 tiles_y = (height + kTileSize * stride - 1) /
+                           (kTileSize * stride);
+    for (size_t tile = 0; tile < tiles_x * tiles_y; ++tile) {
+      size_t const tile_x = tile % tiles_x, tile_y = tile / tiles_x;
+      for (size_t ly = 0; ly < kTileSize; ++ly) {
+        for (size_t lx = 0; lx < kTileSize; ++lx) {
+          size_t const ix = (tile_x * kTileSize + lx) * stride,
+                       iy = (tile_y * kTileSize + ly) * stride;
+          if (ix >= width or iy >= height)
+            continue;
+
+          if (not coarsest) {
+            // skip the pixels of the previous levels
+            if (ix % (2 * stride) == 0 and iy % (2 * stride) == 0)
+              continue;
+            if (interpolate(ix, iy, 2 * stride)) {
+              ++result.statistics.interpolated_pixels;
+              continue;
+            }
+          }
+
+          auto const [origin, direction] = projection.GetRay(ix, iy);
+          rays.Add(scene, iy * width + ix, origin - scene.offset, direction);
+        }
+      }
+    }
+
+    March(scene, rays, result.statistics);
+
+    for (size_t ray = 0; ray < rays.GetSize(); ++ray)
+      set_pixel(
+          rays.pixel[ray], rays.state[ray], rays.parameter[ray],
+          -math::dot(rays.direction[ray], rays.normal[ray]));
+  }
+
+  log::Debug(
+      "lib", "HorasEngine", "marched ", result.statistics.marched_rays,
+      " rays with ", result.statistics.steps, " steps in ",
+      result.statistics.sweeps, " sweeps, interpolated ",
+      result.statistics.interpolated_pixels, " pixels");
+
+  return result;
+}
+
+} // namespace prtcl
@@ -0,0 +1,109 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_HORAS_ENGINE_HPP
+#define PRTCL_SRC_PRTCL_UTIL_HORAS_ENGINE_HPP
+
+#include "../data/model.hpp"
+#include "../geometry/pinhole_camera.hpp"
+#include "../math.hpp"
+#include "image.hpp"
+#include "neighborhood.hpp"
+
+#include <cstddef>
+
+namespace prtcl {
+
+//! Extracts the surface of the visible particles seen through a camera, like
+//! the horason group of share/schemes/horas.prtcl but without adding the
+//! sensor rays to the model.
+//!
+//! The implicit function is the one of the step procedure of the scheme,
+//! phi(x) = |x - v(x)| - W with the weighted average v(x) of the particles
+//! within R = 2h and W = h/2, and a ray advances by phi / L per step.  The
+//! rays start where they enter the bounding box of the visible particles and
+//! are marched in batches of rays of neighboring pixels.  Rays that hit the
+//! surface or leave the box are removed from the active set, such that each
+//! sweep only pays for the rays that are still marching.  Far away from all
+//! particles the rays skip the empty space with the distance to the occupied
+//! cells (see OccupiedCellTree).
+//!
+//! The sensor is refined from coarse to fine.  The first level marches every
+//! 2^level_count-th pixel in both directions, each following level halves
+//! the stride and only marches the new pixels whose surrounding pixels of the
+//! previous level disagree, i.e. near silhouettes and jumps in depth.  All
+//! other pixels are interpolated, so the number of marched rays grows with
+//! the visible surface instead of with the resolution of the sensor.
+//! Features smaller than the coarsest stride may be missed.
+class HorasEngine {
+public:
+  using Real = double;
+  using RVec = TensorT<Real, 3>;
+
+  //! Number of consecutive active rays that are marched by one thread.
+  static constexpr size_t kBatchSize = 64;
+
+  //! Number of steps per ray and sweep over the active rays.
+  static constexpr size_t kStepsPerSweep = 4;
+
+  struct Statistics {
+    size_t marched_rays = 0;
+    size_t interpolated_pixels = 0;
+    size_t steps = 0;
+    size_t sweeps = 0;
+  };
+
+  struct Result {
+    //! Ray parameter of the surface (the distance from the camera) per
+    //! pixel, infinity where no surface was hit.
+    Image parameter;
+    //! Shading like SphereTracer, 0.3 where no surface was hit.
+    Image intensity;
+    Statistics statistics;
+  };
+
+public:
+  //! Extracts the surface of the visible groups of the model.  nhood must be
+  //! loaded with model and updated, visible groups that cannot be neighbors
+  //! are not part of its grid and thus ignored.
+  Result Extract(Model const &model, Neighborhood const &nhood) const;
+
+public:
+  PinholeCamera const &GetCamera() const { return camera_; }
+
+  void SetCamera(PinholeCamera const &value) { camera_ = value; }
+
+  //! Number of levels that refine the coarsest sensor, zero marches all
+  //! pixels.
+  size_t GetLevelCount() const { return level_count_; }
+
+  void SetLevelCount(size_t value) { level_count_ = value; }
+
+  //! Rays that did not converge after this many steps are misses.
+  size_t GetMaxSteps() const { return max_steps_; }
+
+  void SetMaxSteps(size_t value) { max_steps_ = value; }
+
+  //! A ray converged once phi is below the tolerance (in multiples of the
+  //! smoothing scale).
+  Real GetTolerance() const { return tolerance_; }
+
+  void SetTolerance(Real value) { tolerance_ = value; }
+
+  //! Hit pixels that differ by more than the depth tolerance (in multiples of
+  //! the smoothing scale) are refined instead of interpolated.
+  Real GetDepthTolerance() const { return depth_tolerance_; }
+
+  void SetDepthTolerance(Real value) { depth_tolerance_ = value; }
+
+public:
+  explicit HorasEngine(PinholeCamera camera) : camera_{camera} {}
+
+private:
+  PinholeCamera camera_;
+  size_t level_count_ = 3;
+  size_t max_steps_ = 200;
+  Real tolerance_ = 1e-3;
+  Real depth_tolerance_ = 1;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_HORAS_ENGINE_HPP
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "horas_engine.hpp"
+
+#include <cmath>
+
+using namespace prtcl;
+
+namespace {
+
+constexpr double kSmoothingScale = 0.025;
+constexpr double kSphereRadius = 0.4;
+
+//! A sphere of particles on a lattice around the origin.
+void LoadSphere(Model &model) {
+  model.AddGlobalFieldImpl<double>("smoothing_scale") = kSmoothingScale;
+  auto &group = model.AddGroup("f", "fluid");
+  group.AddTag("visible");
+
+  auto const n = static_cast<int>(kSphereRadius / kSmoothingScale);
+  std::vector<TensorT<double, 3>> positions;
+  for (int i = -n; i <= n; ++i)
+    for (int j = -n; j <= n; ++j)
+      for (int k = -n; k <= n; ++k)
+        if (i * i + j * j + k * k <= n * n)
+          positions.push_back(TensorT<double, 3>{
+              i * kSmoothingScale, j * kSmoothingScale,
+              k * kSmoothingScale});
+
+  group.CreateItems(positions.size());
+  auto x = group.AddVaryingFieldImpl<double, 3>("position");
+  for (size_t i = 0; i < positions.size(); ++i)
+    x[i] = positions[i];
+}
+
+PinholeCamera MakeCamera() {
+  PinholeCamera camera;
+  camera.camera.origin = {0, 0, 1.5};
+  camera.camera.principal = {0, 0, -1};
+  camera.camera.up = {0, 1, 0};
+  camera.camera.focal_length = 1;
+  camera.sensor.width = 64;
+  camera.sensor.height = 48;
+  return camera;
+}
+
+} // namespace
+
+TEST(HorasEngine, RefinementMatchesFullResolution) {
+  Model model;
+  LoadSphere(model);
+
+  Neighborhood nhood;
+  nhood.Load(model);
+  nhood.SetRadius(2 * kSmoothingScale);
+  nhood.Update();
+
+  HorasEngine engine{MakeCamera()};
+  engine.SetLevelCount(0);
+  auto const full = engine.Extract(model, nhood);
+  engine.SetLevelCount(3);
+  auto const refined = engine.Extract(model, nhood);
+
+  size_t const width = full.parameter.width(),
+               height = full.parameter.height();
+  EXPECT_EQ(full.statistics.marched_rays, width * height);
+  EXPECT_EQ(full.statistics.interpolated_pixels, 0);
+  EXPECT_EQ(
+      refined.statistics.marched_rays +
+          refined.statistics.interpolated_pixels,
+      width * height);
+  EXPECT_LT(refined.statistics.marched_rays, width * height / 2);
+
+  // the ray through the center of the sensor hits the front of the sphere
+  double const center = full.parameter(width / 2, height / 2);
+  EXPECT_NEAR(center, 1.5 - kSphereRadius, 2 * kSmoothingScale);
+
+  size_t hits = 0;
+  double intensity_error = 0;
+  for (size_t iy = 0; iy < height; ++iy) {
+    for (size_t ix = 0; ix < width; ++ix) {
+      double const expected = full.parameter(ix, iy);
+      double const actual = refined.parameter(ix, iy);
+      ASSERT_EQ(std::isinf(expected), std::isinf(actual));
+      if (not std::isinf(expected)) {
+        EXPECT_NEAR(actual, expected, kSmoothingScale);
+        intensity_error +=
+            std::abs(refined.intensity(ix, iy) - full.intensity(ix, iy));
+        ++hits;
+      } else {
+        EXPECT_EQ(actual, expected);
+        EXPECT_EQ(refined.intensity(ix, iy), 0.3);
+      }
+    }
+  }
+  EXPECT_GT(hits, 0);
+  EXPECT_LT(hits, width * height);
+  // the shading of the bumps of the lattice is smoothed by the interpolation
+  EXPECT_LT(intensity_error / static_cast<double>(hits), 0.05);
+}
@@ -0,0 +1,249 @@
+#include "huge_page_pool.hpp"
+
+#include "../log.hpp"
+
+#include <algorithm>
+#include <new>
+#include <string_view>
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <sys/mman.h>
+
+namespace prtcl {
+
+namespace {
+
+constexpr size_t kMinClassByteSize = kHugePagePoolAlignment;
+
+size_t RoundUp(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+size_t FloorLog2(size_t value) {
+  return static_cast<size_t>(63 - __builtin_clzll(value));
+}
+
+HugePageMode ReadModeFromEnvironment() {
+  char const *value = std::getenv("PRTCL_HUGE_PAGES");
+  if (value == nullptr)
+    return HugePageMode::kTransparent;
+
+  std::string_view const mode{value};
+  if (mode == "off" or mode == "0")
+    return HugePageMode::kOff;
+  if (mode == "explicit")
+    return HugePageMode::kExplicit;
+  if (mode != "transparent" and mode != "1")
+    log::Warning(
+        "lib", "HugePagePool", "unknown PRTCL_HUGE_PAGES=", mode,
+        ", using transparent huge pages");
+  return HugePageMode::kTransparent;
+}
+
+} // namespace
+
+HugePagePool &HugePagePool::Get() {
+  // The pool is never destroyed, containers with static storage duration may
+  // return their memory after it would have been destroyed otherwise.
+  static auto *pool = new HugePagePool;
+  return *pool;
+}
+
+HugePagePool::HugePagePool() : mode_{ReadModeFromEnvironment()} {}
+
+size_t HugePagePool::GetClassIndex(size_t byte_size) {
+  byte_size = std::max(byte_size, kMinClassByteSize);
+  // four classes per power of two: 2^k * {4, 5, 6, 7} / 4
+  auto const k = FloorLog2(byte_size);
+  size_t const step = size_t{1} << (k - 2);
+  return 4 * (k - FloorLog2(kMinClassByteSize)) +
+         ((byte_size + step - 1) / step - 4);
+}
+
+size_t HugePagePool::GetClassByteSizeOfIndex(size_t class_index) {
+  size_t const base = kMinClassByteSize << (class_index / 4);
+  return base + base / 4 * (class_index % 4);
+}
+
+size_t HugePagePool::GetClassByteSize(size_t byte_size) {
+  byte_size = std::max(byte_size, kMinClassByteSize);
+  size_t const step = size_t{1} << (FloorLog2(byte_size) - 2);
+  return RoundUp(byte_size, step);
+}
+
+auto HugePagePool::GetLocalShard() -> Shard & {
+  thread_local size_t const shard_index = next_shard_++ % kShardCount;
+  return shards_[shard_index];
+}
+
+void *HugePagePool::TakeFree(
+    Shard &shard, size_t class_index, size_t class_size) {
+  auto &free = shard.free[class_index];
+  if (free.empty())
+    return nullptr;
+
+  auto *ptr = free.back();
+  free.pop_back();
+  cached_ -= class_size;
+  if (class_size >= kHugePageSize)
+    cached_large_ -= class_size;
+  return ptr;
+}
+
+void *HugePagePool::Allocate(size_t byte_size) {
+  auto const class_size = GetClassByteSize(byte_size);
+  auto const class_index = GetClassIndex(byte_size);
+  if (class_index >= kClassCount)
+    throw std::bad_alloc{};
+
+  auto &shard = GetLocalShard();
+  {
+    std::lock_guard lock{shard.mutex};
+    if (auto *ptr = TakeFree(shard, class_index, class_size))
+      return ptr;
+  }
+
+  // before mapping new memory, reuse blocks deallocated by other threads
+  if (cached_ >= class_size) {
+    for (auto &other : shards_) {
+      if (&other == &shard)
+        continue;
+      std::lock_guard lock{other.mutex};
+      if (auto *ptr = TakeFree(other, class_index, class_size))
+        return ptr;
+    }
+  }
+
+  if (class_size >= kHugePageSize)
+    return Map(class_size);
+
+  std::lock_guard lock{shard.mutex};
+  auto *next = reinterpret_cast<std::byte *>(RoundUp(
+      reinterpret_cast<uintptr_t>(shard.chunk_next), kHugePagePoolAlignment));
+  if (shard.chunk_next == nullptr or next + class_size > shard.chunk_end) {
+    next = static_cast<std::byte *>(Map(kHugePageSize));
+    shard.chunks.push_back(next);
+    shard.chunk_end = next + kHugePageSize;
+  }
+  shard.chunk_next = next + class_size;
+  return next;
+}
+
+void HugePagePool::Deallocate(void *ptr, size_t byte_size) noexcept {
+  if (ptr == nullptr)
+    return;
+
+  auto const class_size = GetClassByteSize(byte_size);
+  auto const class_index = GetClassIndex(byte_size);
+
+  auto &shard = GetLocalShard();
+  std::lock_guard lock{shard.mutex};
+  try {
+    shard.free[class_index].push_back(ptr);
+    cached_ += class_size;
+    if (class_size >= kHugePageSize)
+      cached_large_ += class_size;
+  } catch (std::bad_alloc const &) {
+    // the block cannot be cached, large blocks can still be released
+    if (class_size >= kHugePageSize)
+      Unmap(ptr, class_size);
+  }
+}
+
+void *HugePagePool::AllocateUntouched(size_t byte_size) {
+  return Map(byte_size);
+}
+
+void HugePagePool::DeallocateUntouched(
+    void *ptr, size_t byte_size) noexcept {
+  if (ptr != nullptr)
+    Unmap(ptr, byte_size);
+}
+
+void HugePagePool::Trim() {
+  auto const first_large = GetClassIndex(kHugePageSize);
+  for (auto &shard : shards_) {
+    std::lock_guard lock{shard.mutex};
+    for (size_t index = first_large; index < kClassCount; ++index) {
+      auto &free = shard.free[index];
+      if (free.empty())
+        continue;
+
+      auto const class_size = GetClassByteSizeOfIndex(index);
+      for (auto *ptr : free) {
+        Unmap(ptr, class_size);
+        cached_ -= class_size;
+        cached_large_ -= class_size;
+      }
+      free.clear();
+      free.shrink_to_fit();
+    }
+  }
+}
+
+bool HugePagePool::TrimExcess() {
+  // the memory of smaller blocks stays with the pool anyway
+  size_t const large = cached_large_;
+  if (large == 0 or large <= mapped_ - large)
+    return false;
+
+  Trim();
+  log::Debug(
+      "lib", "HugePagePool", "trimmed ", large - cached_large_, " of ",
+      cached_.load(), " cached bytes");
+  return true;
+}
+
+size_t HugePagePool::GetMappedByteSize() const { return mapped_; }
+
+size_t HugePagePool::GetCachedByteSize() const { return cached_; }
+
+void *HugePagePool::Map(size_t byte_size) {
+  auto const length = RoundUp(byte_size, kHugePageSize);
+
+  if (mode_ == HugePageMode::kExplicit) {
+    void *ptr = mmap(
+        nullptr, length, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      mapped_ += length;
+      return ptr;
+    }
+
+    if (mode_.exchange(HugePageMode::kTransparent) == HugePageMode::kExplicit)
+      log::Warning(
+          "lib", "HugePagePool",
+          "no explicit huge pages available, using transparent huge pages");
+  }
+
+  // over-allocate to align the mapping to the huge page size
+  void *raw = mmap(
+      nullptr, length + kHugePageSize, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED)
+    throw std::bad_alloc{};
+
+  auto *first = static_cast<std::byte *>(raw);
+  auto *aligned = reinterpret_cast<std::byte *>(
+      RoundUp(reinterpret_cast<uintptr_t>(first), kHugePageSize));
+  if (aligned != first)
+    munmap(first, static_cast<size_t>(aligned - first));
+  munmap(
+      aligned + length, static_cast<size_t>(first + kHugePageSize - aligned));
+
+  if (mode_ == HugePageMode::kTransparent)
+    madvise(aligned, length, MADV_HUGEPAGE);
+
+  mapped_ += length;
+  return aligned;
+}
+
+void HugePagePool::Unmap(void *ptr, size_t byte_size) noexcept {
+  auto const length = RoundUp(byte_size, kHugePageSize);
+  munmap(ptr, length);
+  mapped_ -= length;
+}
+
+} // namespace prtcl
@@ -0,0 +1,174 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_HUGE_PAGE_POOL_HPP
+#define PRTCL_SRC_PRTCL_UTIL_HUGE_PAGE_POOL_HPP
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <cstddef>
+
+namespace prtcl {
+
+//! Size of the huge pages that large blocks are aligned to.
+constexpr size_t kHugePageSize = size_t{2} << 20;
+
+//! Alignment of all blocks handed out by the HugePagePool.
+constexpr size_t kHugePagePoolAlignment = 64;
+
+enum class HugePageMode {
+  //! Plain anonymous mappings, no huge pages are requested.
+  kOff,
+  //! Anonymous mappings advised for transparent huge pages (default).
+  kTransparent,
+  //! Explicit huge pages (MAP_HUGETLB), falls back to transparent huge pages
+  //! if the system has none reserved.
+  kExplicit,
+};
+
+//! Process wide pool of memory backed by huge pages.
+//!
+//! Blocks are rounded up to size classes (four per power of two) and are kept
+//! in per-class free lists when deallocated, such that the buffers that are
+//! reallocated in every step (neighbor lists, grid arrays, solver vectors)
+//! reuse the same, already faulted in, pages instead of going back to the
+//! system.  Blocks smaller than a huge page are carved from huge page sized
+//! chunks, larger blocks are mapped separately at huge page alignment.
+//!
+//! The free lists and chunks are split into shards with a lock each, every
+//! thread allocates from and deallocates to its own shard.  Only if that has
+//! no block of the size class, the other shards are searched before new
+//! memory is mapped.
+//!
+//! The mode is read from the environment variable PRTCL_HUGE_PAGES (one of
+//! "off", "transparent" or "explicit") when the pool is first used.
+class HugePagePool {
+public:
+  static HugePagePool &Get();
+
+public:
+  //! Returns a block of at least byte_size bytes, aligned to at least
+  //! kHugePagePoolAlignment bytes.
+  void *Allocate(size_t byte_size);
+
+  //! Returns a block obtained from Allocate with the same byte_size to the
+  //! pool.
+  void Deallocate(void *ptr, size_t byte_size) noexcept;
+
+  //! Returns a block of at least byte_size bytes on huge pages of its own
+  //! that were never touched, such that the first touch decides their NUMA
+  //! placement (see FirstTouchAllocator).
+  void *AllocateUntouched(size_t byte_size);
+
+  //! Unmaps a block obtained from AllocateUntouched with the same byte_size,
+  //! such blocks are never cached.
+  void DeallocateUntouched(void *ptr, size_t byte_size) noexcept;
+
+  //! Unmaps all cached blocks that are larger than a huge page.  Memory of
+  //! smaller blocks stays with the pool.
+  void Trim();
+
+  //! Trims the pool if the cached blocks that Trim would unmap take more bytes
+  //! than the rest of the mapped memory, e.g. after groups shrunk, and
+  //! returns whether it did.  Called by Neighborhood::Permute whenever items
+  //! were removed.
+  bool TrimExcess();
+
+public:
+  HugePageMode GetMode() const { return mode_; }
+
+  //! Number of bytes that are currently mapped by the pool.
+  size_t GetMappedByteSize() const;
+
+  //! Number of bytes that are currently cached in the free lists.
+  size_t GetCachedByteSize() const;
+
+  //! The size class that byte_size is rounded up to.
+  static size_t GetClassByteSize(size_t byte_size);
+
+public:
+  HugePagePool(HugePagePool const &) = delete;
+  HugePagePool &operator=(HugePagePool const &) = delete;
+
+private:
+  HugePagePool();
+
+  void *Map(size_t byte_size);
+
+  void Unmap(void *ptr, size_t byte_size) noexcept;
+
+private:
+  static constexpr size_t kClassCount = 4 * 48;
+
+  static constexpr size_t kShardCount = 16;
+
+  static size_t GetClassIndex(size_t byte_size);
+
+  static size_t GetClassByteSizeOfIndex(size_t class_index);
+
+private:
+  struct alignas(64) Shard {
+    std::mutex mutex;
+
+    std::array<std::vector<void *>, kClassCount> free;
+
+    // chunks of small blocks and the bump pointer into the last chunk
+    std::vector<std::byte *> chunks;
+    std::byte *chunk_next = nullptr;
+    std::byte *chunk_end = nullptr;
+  };
+
+  //! The shard of the calling thread, threads are assigned round robin.
+  Shard &GetLocalShard();
+
+  //! Takes a cached block from the free list of the (locked) shard.
+  void *TakeFree(Shard &shard, size_t class_index, size_t class_size);
+
+private:
+  std::atomic<HugePageMode> mode_;
+
+  std::array<Shard, kShardCount> shards_;
+  std::atomic<size_t> next_shard_ = 0;
+
+  std::atomic<size_t> mapped_ = 0;
+  std::atomic<size_t> cached_ = 0;
+  // the part of cached_ in blocks of at least kHugePageSize bytes
+  std::atomic<size_t> cached_large_ = 0;
+};
+
+//! Standard allocator that serves all allocations from the HugePagePool.
+template <typename T>
+class PoolAllocator {
+  static_assert(alignof(T) <= kHugePagePoolAlignment);
+
+public:
+  using value_type = T;
+
+public:
+  PoolAllocator() noexcept = default;
+
+  template <typename U>
+  PoolAllocator(PoolAllocator<U> const &) noexcept {}
+
+public:
+  T *allocate(size_t count) {
+    return static_cast<T *>(HugePagePool::Get().Allocate(count * sizeof(T)));
+  }
+
+  void deallocate(T *ptr, size_t count) noexcept {
+    HugePagePool::Get().Deallocate(ptr, count * sizeof(T));
+  }
+
+public:
+  friend bool operator==(PoolAllocator const &, PoolAllocator const &) {
+    return true;
+  }
+
+  friend bool operator!=(PoolAllocator const &, PoolAllocator const &) {
+    return false;
+  }
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_HUGE_PAGE_POOL_HPP
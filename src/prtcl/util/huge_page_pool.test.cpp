@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <prtcl/util/huge_page_pool.hpp>
+
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+namespace {
+
+TEST(HugePagePool, SizeClasses) {
+  using prtcl::HugePagePool;
+
+  EXPECT_EQ(HugePagePool::GetClassByteSize(1), 64);
+  EXPECT_EQ(HugePagePool::GetClassByteSize(64), 64);
+  EXPECT_EQ(HugePagePool::GetClassByteSize(65), 80);
+  EXPECT_EQ(HugePagePool::GetClassByteSize(129), 160);
+  EXPECT_EQ(HugePagePool::GetClassByteSize(1000), 1024);
+  EXPECT_EQ(HugePagePool::GetClassByteSize(prtcl::kHugePageSize + 1), 5 << 19);
+}
+
+TEST(HugePagePool, ReusesBlocks) {
+  auto &pool = prtcl::HugePagePool::Get();
+
+  for (size_t byte_size : {size_t{100}, size_t{3} << 20}) {
+    void *first = pool.Allocate(byte_size);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(
+        reinterpret_cast<uintptr_t>(first) % prtcl::kHugePagePoolAlignment, 0);
+
+    pool.Deallocate(first, byte_size);
+    // a block of the same size class is taken from the free list
+    void *second = pool.Allocate(byte_size - 1);
+    EXPECT_EQ(first, second);
+    pool.Deallocate(second, byte_size - 1);
+  }
+
+  // the cached large block (rounded up to two huge pages) is unmapped
+  auto const mapped = pool.GetMappedByteSize();
+  pool.Trim();
+  EXPECT_LE(pool.GetMappedByteSize(), mapped - 2 * prtcl::kHugePageSize);
+
+  std::vector<double, prtcl::PoolAllocator<double>> values(10000, 1.0);
+  values.resize(20000, 2.0);
+  EXPECT_EQ(values[9999], 1.0);
+  EXPECT_EQ(values[10000], 2.0);
+}
+
+TEST(HugePagePool, TrimExcess) {
+  auto &pool = prtcl::HugePagePool::Get();
+  pool.Trim();
+
+  size_t const large = size_t{64} << 20;
+  size_t const small = size_t{4} << 20;
+
+  // blocks smaller than a huge page are never unmapped by trimming
+  std::vector<void *> blocks;
+  for (size_t i = 0; i < 64; ++i)
+    blocks.push_back(pool.Allocate(size_t{256} << 10));
+  for (auto *block : blocks)
+    pool.Deallocate(block, size_t{256} << 10);
+  EXPECT_FALSE(pool.TrimExcess());
+
+  // a small cached block next to a large one in use is kept
+  void *in_use = pool.Allocate(large);
+  pool.Deallocate(pool.Allocate(small), small);
+  EXPECT_FALSE(pool.TrimExcess());
+
+  // once the large block is cached as well, most of the memory is idle
+  pool.Deallocate(in_use, large);
+  auto const mapped = pool.GetMappedByteSize();
+  EXPECT_TRUE(pool.TrimExcess());
+  EXPECT_LE(pool.GetMappedByteSize(), mapped - large - small);
+}
+
+TEST(HugePagePool, ReusesBlocksOfOtherThreads) {
+  auto &pool = prtcl::HugePagePool::Get();
+  size_t const byte_size = size_t{3} << 20;
+
+  // the block is cached by the shard of another thread
+  void *first = pool.Allocate(byte_size);
+  std::thread{[&] { pool.Deallocate(first, byte_size); }}.join();
+
+  auto const mapped = pool.GetMappedByteSize();
+  void *second = pool.Allocate(byte_size);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(pool.GetMappedByteSize(), mapped);
+  pool.Deallocate(second, byte_size);
+
+  // blocks that are allocated and deallocated concurrently stay intact
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; ++t)
+    threads.emplace_back([&pool, t] {
+      for (size_t i = 0; i < 1000; ++i) {
+        auto *block = static_cast<size_t *>(pool.Allocate(64 * (1 + i % 7)));
+        block[0] = t;
+        block[7] = i;
+        EXPECT_EQ(block[0], t);
+        EXPECT_EQ(block[7], i);
+        pool.Deallocate(block, 64 * (1 + i % 7));
+      }
+    });
+  for (auto &thread : threads)
+    thread.join();
+}
+
+} // namespace
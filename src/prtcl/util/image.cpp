@@ -0,0 +1 @@
+#include "image.hpp"
@@ -0,0 +1,38 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_IMAGE_HPP
+#define PRTCL_SRC_PRTCL_UTIL_IMAGE_HPP
+
+#include <vector>
+
+#include <cstddef>
+
+namespace prtcl {
+
+//! Gray scale image, the intensities are stored row by row.
+class Image {
+public:
+  size_t width() const { return width_; }
+
+  size_t height() const { return height_; }
+
+public:
+  auto &operator()(size_t ix, size_t iy) {
+    return intensity_[iy * width_ + ix];
+  }
+
+  auto const &operator()(size_t ix, size_t iy) const {
+    return intensity_[iy * width_ + ix];
+  }
+
+public:
+  Image(size_t _width, size_t _height)
+      : width_{_width}, height_{_height}, intensity_(_width * _height) {}
+
+private:
+  size_t width_;
+  size_t height_;
+  std::vector<double> intensity_;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_IMAGE_HPP
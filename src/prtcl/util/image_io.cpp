@@ -0,0 +1,231 @@
+#include "image_io.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+namespace prtcl {
+
+namespace {
+
+uint8_t ToGray(double intensity) {
+  return static_cast<uint8_t>(
+      std::floor(std::clamp(intensity, 0., 1.) * 255));
+}
+
+// PNG {{{
+
+std::array<uint32_t, 256> MakeCRCTable() {
+  std::array<uint32_t, 256> table;
+  for (uint32_t n = 0; n < 256; ++n) {
+    uint32_t c = n;
+    for (int k = 0; k < 8; ++k)
+      c = (c & 1) ? 0xEDB8'8320u ^ (c >> 1) : c >> 1;
+    table[n] = c;
+  }
+  return table;
+}
+
+uint32_t UpdateCRC(uint32_t crc, std::vector<uint8_t> const &data) {
+  static auto const table = MakeCRCTable();
+  for (auto const byte : data)
+    crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+  return crc;
+}
+
+void AppendU32(std::vector<uint8_t> &data, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    data.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void WriteChunk(
+    std::ostream &output, std::string_view type,
+    std::vector<uint8_t> const &data) {
+  std::vector<uint8_t> prefix;
+  AppendU32(prefix, static_cast<uint32_t>(data.size()));
+  output.write(reinterpret_cast<char const *>(prefix.data()), 4);
+
+  // the CRC covers the type and the data
+  std::vector<uint8_t> const type_bytes{type.begin(), type.end()};
+  uint32_t crc = UpdateCRC(0xFFFF'FFFFu, type_bytes);
+  crc = UpdateCRC(crc, data) ^ 0xFFFF'FFFFu;
+
+  output.write(type.data(), static_cast<std::streamsize>(type.size()));
+  output.write(
+      reinterpret_cast<char const *>(data.data()),
+      static_cast<std::streamsize>(data.size()));
+
+  std::vector<uint8_t> suffix;
+  AppendU32(suffix, crc);
+  output.write(reinterpret_cast<char const *>(suffix.data()), 4);
+}
+
+//! Writes bits starting with the least significant bit of each byte.
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<uint8_t> &data) : data_{data} {}
+
+  void Write(uint32_t value, int bit_count) {
+    for (int i = 0; i < bit_count; ++i) {
+      if (used_ == 0)
+        data_.push_back(0);
+      data_.back() |= static_cast<uint8_t>(((value >> i) & 1) << used_);
+      used_ = (used_ + 1) % 8;
+    }
+  }
+
+  //! Huffman codes are stored starting with their most significant bit.
+  void WriteCode(uint32_t code, int bit_count) {
+    for (int i = bit_count - 1; i >= 0; --i)
+      Write((code >> i) & 1, 1);
+  }
+
+private:
+  std::vector<uint8_t> &data_;
+  int used_ = 0;
+};
+
+//! Writes a symbol of the fixed literal/length code of deflate.
+void WriteFixedSymbol(BitWriter &bits, uint32_t symbol) {
+  if (symbol < 144)
+    bits.WriteCode(0x30 + symbol, 8);
+  else if (symbol < 256)
+    bits.WriteCode(0x190 + symbol - 144, 9);
+  else if (symbol < 280)
+    bits.WriteCode(symbol - 256, 7);
+  else
+    bits.WriteCode(0xC0 + symbol - 280, 8);
+}
+
+//! Writes a back reference of length [3, 258] and distance one.
+void WriteRun(BitWriter &bits, uint32_t length) {
+  static constexpr std::array<uint32_t, 29> kBase = {
+      3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+  static constexpr std::array<int, 29> kExtra = {
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+  auto const index = static_cast<size_t>(
+      std::upper_bound(kBase.begin(), kBase.end(), length) - kBase.begin() -
+      1);
+  WriteFixedSymbol(bits, 257 + static_cast<uint32_t>(index));
+  bits.Write(length - kBase[index], kExtra[index]);
+  // distance code 0 (distance one) without extra bits
+  bits.WriteCode(0, 5);
+}
+
+//! Compresses the data into a zlib stream with a single fixed Huffman block,
+//! repeated bytes are encoded as back references to the previous byte.
+std::vector<uint8_t> Deflate(std::vector<uint8_t> const &input) {
+  constexpr uint32_t kMaxRun = 258;
+
+  std::vector<uint8_t> output{0x78, 0x01};
+  {
+    BitWriter bits{output};
+    // final block, fixed Huffman codes
+    bits.Write(1, 1);
+    bits.Write(1, 2);
+
+    for (size_t i = 0; i < input.size();) {
+      WriteFixedSymbol(bits, input[i]);
+
+      size_t run = 0;
+      while (i + 1 + run < input.size() and run < kMaxRun and
+             input[i + 1 + run] == input[i])
+        ++run;
+
+      if (run >= 3) {
+        WriteRun(bits, static_cast<uint32_t>(run));
+      } else {
+        for (size_t j = 1; j <= run; ++j)
+          WriteFixedSymbol(bits, input[i + j]);
+      }
+      i += 1 + run;
+    }
+
+    // end of block
+    WriteFixedSymbol(bits, 256);
+  }
+
+  uint32_t a = 1, b = 0;
+  for (auto const byte : input) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  AppendU32(output, (b << 16) | a);
+  return output;
+}
+
+// }}}
+
+} // namespace
+
+void WritePPM(std::ostream &output, Image const &image) {
+  output << "P6\n" << image.width() << ' ' << image.height() << "\n255\n";
+
+  std::vector<uint8_t> row(3 * image.width());
+  for (size_t iy = 0; iy < image.height(); ++iy) {
+    for (size_t ix = 0; ix < image.width(); ++ix)
+      std::fill_n(row.begin() + static_cast<std::ptrdiff_t>(3 * ix), 3,
+                  ToGray(image(ix, iy)));
+    output.write(
+        reinterpret_cast<char const *>(row.data()),
+        static_cast<std::streamsize>(row.size()));
+  }
+}
+
+void WritePNG(std::ostream &output, Image const &image) {
+  static constexpr uint8_t kSignature[] = {0x89, 'P',  'N',  'G',
+                                           '\r', '\n', 0x1A, '\n'};
+  output.write(reinterpret_cast<char const *>(kSignature), 8);
+
+  std::vector<uint8_t> header;
+  AppendU32(header, static_cast<uint32_t>(image.width()));
+  AppendU32(header, static_cast<uint32_t>(image.height()));
+  // bit depth 8, gray scale, deflate, no filter, no interlace
+  header.insert(header.end(), {8, 0, 0, 0, 0});
+  WriteChunk(output, "IHDR", header);
+
+  // each row starts with its filter type (none)
+  std::vector<uint8_t> pixels;
+  pixels.reserve((image.width() + 1) * image.height());
+  for (size_t iy = 0; iy < image.height(); ++iy) {
+    pixels.push_back(0);
+    for (size_t ix = 0; ix < image.width(); ++ix)
+      pixels.push_back(ToGray(image(ix, iy)));
+  }
+  WriteChunk(output, "IDAT", Deflate(pixels));
+
+  WriteChunk(output, "IEND", {});
+}
+
+void SaveImage(std::string const &path, Image const &image) {
+  auto const ends_with = [&path](std::string_view suffix) {
+    return path.size() >= suffix.size() and
+           std::equal(suffix.rbegin(), suffix.rend(), path.rbegin());
+  };
+
+  void (*write)(std::ostream &, Image const &) = nullptr;
+  if (ends_with(".ppm")) {
+    write = &WritePPM;
+  } else if (ends_with(".png")) {
+    write = &WritePNG;
+  } else {
+    throw std::runtime_error{"unknown image format of " + path};
+  }
+
+  std::ofstream file{path, std::ios::binary};
+  if (not file)
+    throw std::runtime_error{"could not open " + path};
+  write(file, image);
+}
+
+} // namespace prtcl
@@ -0,0 +1,26 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_IMAGE_IO_HPP
+#define PRTCL_SRC_PRTCL_UTIL_IMAGE_IO_HPP
+
+#include "image.hpp"
+
+#include <iosfwd>
+#include <string>
+
+namespace prtcl {
+
+//! Writes the image as binary PPM (P6), the intensities in [0, 1] are mapped
+//! to gray values in all three channels.
+void WritePPM(std::ostream &output, Image const &image);
+
+//! Writes the image as 8 bit gray scale PNG.  Without a zlib dependency the
+//! pixel data is run-length encoded with the fixed Huffman codes of deflate,
+//! which compresses the uniform background of rendered frames well.
+void WritePNG(std::ostream &output, Image const &image);
+
+//! Writes the image in the format selected by the extension of the path
+//! (.ppm or .png).
+void SaveImage(std::string const &path, Image const &image);
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_IMAGE_IO_HPP
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <prtcl/util/image_io.hpp>
+
+#include <sstream>
+#include <string>
+
+namespace {
+
+using namespace prtcl;
+
+Image MakeImage() {
+  Image image{4, 2};
+  for (size_t iy = 0; iy < image.height(); ++iy)
+    for (size_t ix = 0; ix < image.width(); ++ix)
+      image(ix, iy) = 0.3;
+  image(1, 0) = 1.0;
+  // out of range intensities are clamped
+  image(2, 1) = -0.5;
+  image(3, 1) = 2.0;
+  return image;
+}
+
+TEST(ImageIO, PPM) {
+  std::ostringstream output;
+  WritePPM(output, MakeImage());
+  auto const data = output.str();
+
+  std::string const header = "P6\n4 2\n255\n";
+  ASSERT_EQ(data.size(), header.size() + 3 * 4 * 2);
+  EXPECT_EQ(data.substr(0, header.size()), header);
+
+  auto pixel = [&](size_t ix, size_t iy) {
+    return static_cast<unsigned char>(data[header.size() + 3 * (iy * 4 + ix)]);
+  };
+  EXPECT_EQ(pixel(0, 0), 76);
+  EXPECT_EQ(pixel(1, 0), 255);
+  EXPECT_EQ(pixel(2, 1), 0);
+  EXPECT_EQ(pixel(3, 1), 255);
+}
+
+TEST(ImageIO, PNG) {
+  std::ostringstream output;
+  WritePNG(output, MakeImage());
+  auto const data = output.str();
+
+  EXPECT_EQ(data.substr(0, 8), std::string("\x89PNG\r\n\x1A\n", 8));
+
+  // the header chunk holds the size, bit depth 8 and gray scale
+  EXPECT_EQ(data.substr(8, 8), std::string("\0\0\0\x0DIHDR", 8));
+  EXPECT_EQ(data.substr(16, 10), std::string("\0\0\0\4\0\0\0\2\x08\0", 10));
+
+  // the image ends with the (constant) end chunk
+  ASSERT_GT(data.size(), 12);
+  EXPECT_EQ(
+      data.substr(data.size() - 12),
+      std::string("\0\0\0\0IEND\xAE\x42\x60\x82", 12));
+}
+
+} // namespace
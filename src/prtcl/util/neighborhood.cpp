@@ -1,8 +1,12 @@
 #include "neighborhood.hpp"
 
+#include "../errors/invalid_shape_error.hpp"
 #include "../errors/not_implemented_error.hpp"
 #include "grouped_uniform_grid.hpp"
+#include "perf_counters.hpp"
+#include "profiler.hpp"
 
+#include <optional>
 #include <variant>
 
 #include <boost/container/flat_set.hpp>
@@ -99,12 +103,16 @@ public:
 
   void Update() {
     log::Debug("lib", "Neighborhood", "Update");
+    PRTCL_PROFILE_SCOPE("neighborhood update");
+    PerfCounterScope counters{"neighborhood update"};
 
     _grid.update(_data);
   }
 
-  void Permute(Model &model) {
+  bool Permute(Model &model, bool grid_is_current) {
     log::Debug("lib", "Neighborhood", "Permute(", &model, ")");
+    PRTCL_PROFILE_SCOPE("neighborhood permute");
+    PerfCounterScope counters{"neighborhood permute"};
 
     perm_it_.clear();
 
@@ -137,11 +145,26 @@ public:
     }
 
     // compute all permutations
-    _grid.compute_group_permutations(perm_it_);
+    {
+      PRTCL_PROFILE_SCOPE("compute permutations");
+      _grid.compute_group_permutations(perm_it_);
+    }
+
+    // groups that are not permuted drop their destroyed items here, the
+    // others drop them while being permuted
+    bool items_destroyed = false;
+    for (auto &group : model.GetGroups()) {
+      if (group.GetDeferredDestroyCount() > 0) {
+        items_destroyed = true;
+        if (not CanBeNeighbor(group))
+          group.CompactItems();
+      }
+    }
 
     // permute all groups
 #pragma omp parallel
     {
+      PRTCL_PROFILE_SCOPE("permute groups");
       for (auto &group : model.GetGroups()) {
         auto const group_index = static_cast<size_t>(group.GetGroupIndex());
         if (CanBeNeighbor(group))
@@ -149,12 +172,28 @@ public:
       }
     }
 
-    // update the grid with the permuted positions
-    Update();
+    if (items_destroyed) {
+      // the groups shrunk, so the spans of the positions are stale and the
+      // model stays dirty for the spans held by the schemes
+      Load(model);
+      Update();
+      model.SetDirty(true);
+      // the buffers of the larger groups are not reused any time soon
+      HugePagePool::Get().TrimExcess();
+    } else if (grid_is_current) {
+      // the grid already matches the permuted positions up to the raw indices
+      PRTCL_PROFILE_SCOPE("relabel grid");
+      _grid.relabel_after_permutation();
+    } else {
+      // update the grid with the permuted positions
+      Update();
+    }
+
+    return items_destroyed;
   }
 
   void CopyNeighbors(
-      size_t g_, size_t i_, std::vector<std::vector<size_t>> &neighbors) const {
+      size_t g_, size_t i_, std::vector<NeighborList> &neighbors) const {
     // log::Debug(
     //    "lib", "Neighborhood", "CopyNeighbors(", g_, ", ", i_, ", ",
     //    &neighbors,
@@ -176,6 +215,24 @@ public:
     //  _grid.neighbors(g_, i_, _data, std::forward<Fn>(fn));
   }
 
+  void CopyNeighbors(
+      cxx::span<double const> position, double radius_multiple,
+      std::vector<NeighborList> &neighbors) const {
+    if (position.size() != N)
+      throw InvalidShapeError{};
+
+    TensorT<T, N> x;
+    for (size_t dim = 0; dim < N; ++dim)
+      x[static_cast<int>(dim)] = static_cast<T>(position[dim]);
+
+    _grid.neighbors(
+        x, radius_multiple, _data, [&neighbors](size_t ng, size_t ni) {
+          neighbors[ng].push_back(ni);
+        });
+  }
+
+  double GetRadius() const { return _grid.get_radius(); }
+
 private:
   grouped_uniform_grid<N> _grid;
   model_data_type _data;
@@ -204,10 +261,8 @@ public:
   }
 
   void Load(Model const &model) {
-    if (std::holds_alternative<std::monostate>(impl_)) {
-      // TODO: HACK: IMPORTANT: this forces a particular ttype for position
-      impl_ = new NeighborhoodImpl<float, 3>;
-    }
+    if (std::holds_alternative<std::monostate>(impl_))
+      impl_ = MakeImpl(model);
 
     std::visit(
         cxx::overloaded{
@@ -224,16 +279,18 @@ public:
         impl_);
   }
 
-  void Permute(Model &model) {
-    std::visit(
+  bool Permute(Model &model, bool grid_is_current) {
+    return std::visit(
         cxx::overloaded{
-            [](std::monostate) { throw NotImplementedError{}; },
-            [&model](auto *impl) { impl->Permute(model); }},
+            [](std::monostate) -> bool { throw NotImplementedError{}; },
+            [&model, grid_is_current](auto *impl) {
+              return impl->Permute(model, grid_is_current);
+            }},
         impl_);
   }
 
   void CopyNeighbors(
-      size_t g_, size_t i_, std::vector<std::vector<size_t>> &neighbors) const {
+      size_t g_, size_t i_, std::vector<NeighborList> &neighbors) const {
     std::visit(
         cxx::overloaded{
             [](std::monostate) { throw NotImplementedError{}; },
@@ -243,13 +300,70 @@ public:
         impl_);
   }
 
+  void CopyNeighbors(
+      cxx::span<double const> position, double radius_multiple,
+      std::vector<NeighborList> &neighbors) const {
+    std::visit(
+        cxx::overloaded{
+            [](std::monostate) { throw NotImplementedError{}; },
+            [position, radius_multiple, &neighbors](auto *impl) {
+              impl->CopyNeighbors(position, radius_multiple, neighbors);
+            }},
+        impl_);
+  }
+
+  double GetRadius() const {
+    return std::visit(
+        cxx::overloaded{
+            [](std::monostate) -> double { throw NotImplementedError{}; },
+            [](auto *impl) { return impl->GetRadius(); }},
+        impl_);
+  }
+
 private:
-  std::variant<
+  using ImplVariant = std::variant<
       std::monostate, NeighborhoodImpl<float, 1> *,
       NeighborhoodImpl<float, 2> *, NeighborhoodImpl<float, 3> *,
       NeighborhoodImpl<double, 1> *, NeighborhoodImpl<double, 2> *,
-      NeighborhoodImpl<double, 3> *>
-      impl_ = {};
+      NeighborhoodImpl<double, 3> *>;
+
+  // Selects the implementation matching the type of the position fields, the
+  // positions of all groups must have the same type.
+  static ImplVariant MakeImpl(Model const &model) {
+    std::optional<TensorType> type;
+    for (auto &group : model.GetGroups()) {
+      for (auto const &[name, field] : group.GetVarying().GetNamedFields()) {
+        if (name != "position")
+          continue;
+
+        if (type and *type != field.GetType()) {
+          log::Warning(
+              "lib", "Neighborhood",
+              "the positions of all groups must have the same type");
+          throw NotImplementedError{};
+        }
+        type = field.GetType();
+      }
+    }
+
+    if (not type or *type == GetTensorTypeCRef<float, 3>())
+      return new NeighborhoodImpl<float, 3>;
+    if (*type == GetTensorTypeCRef<double, 3>())
+      return new NeighborhoodImpl<double, 3>;
+    if (*type == GetTensorTypeCRef<float, 2>())
+      return new NeighborhoodImpl<float, 2>;
+    if (*type == GetTensorTypeCRef<double, 2>())
+      return new NeighborhoodImpl<double, 2>;
+    if (*type == GetTensorTypeCRef<float, 1>())
+      return new NeighborhoodImpl<float, 1>;
+    if (*type == GetTensorTypeCRef<double, 1>())
+      return new NeighborhoodImpl<double, 1>;
+
+    throw NotImplementedError{};
+  }
+
+private:
+  ImplVariant impl_ = {};
 }; // namespace prtcl
 
 void NeighborhoodPImplDeleter::operator()(NeighborhoodPImpl *ptr) {
@@ -264,13 +378,23 @@ void Neighborhood::Load(Model const &model) { pimpl_->Load(model); }
 
 void Neighborhood::Update() { pimpl_->Update(); }
 
-void Neighborhood::Permute(Model &model) { pimpl_->Permute(model); }
+bool Neighborhood::Permute(Model &model, bool grid_is_current) {
+  return pimpl_->Permute(model, grid_is_current);
+}
 
 void Neighborhood::CopyNeighbors(
-    size_t g_, size_t i_, std::vector<std::vector<size_t>> &neighbors) const {
+    size_t g_, size_t i_, std::vector<NeighborList> &neighbors) const {
   pimpl_->CopyNeighbors(g_, i_, neighbors);
 }
 
+void Neighborhood::CopyNeighbors(
+    cxx::span<double const> position, double radius_multiple,
+    std::vector<NeighborList> &neighbors) const {
+  pimpl_->CopyNeighbors(position, radius_multiple, neighbors);
+}
+
+double Neighborhood::GetRadius() const { return pimpl_->GetRadius(); }
+
 } // namespace prtcl
 
 /*
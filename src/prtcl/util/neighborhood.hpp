@@ -3,6 +3,8 @@
 #include "../data/model.hpp"
 #include "../log.hpp"
 #include "../cxx.hpp"
+#include "../cxx/span.hpp"
+#include "huge_page_pool.hpp"
 
 #include <iterator>
 #include <memory>
@@ -14,6 +16,10 @@
 
 namespace prtcl {
 
+//! Indices of the neighbors of one item in one group.  The per-thread lists of
+//! the schemes are served from the HugePagePool.
+using NeighborList = std::vector<size_t, PoolAllocator<size_t>>;
+
 class NeighborhoodPImpl;
 
 struct NeighborhoodPImplDeleter {
@@ -27,15 +33,33 @@ public:
 public:
   void SetRadius(double radius_);
 
+  double GetRadius() const;
+
 public:
   void Load(Model const &model_);
 
   void Update();
 
-  void Permute(Model &model);
+  //! Reorders the items of all groups that can be neighbors along the grid
+  //! and removes all items whose destruction was deferred.  If
+  //! grid_is_current, no position changed since the last Update and the grid
+  //! is relabeled instead of being rebuilt (unless items were removed).
+  //! Returns true if items were removed, the neighborhood is then reloaded
+  //! but the model stays dirty since the spans held by schemes are stale.
+  bool Permute(Model &model, bool grid_is_current = false);
+
+  void CopyNeighbors(
+      size_t g_, size_t i_, std::vector<NeighborList> &neighbors) const;
 
+  //! Appends the items of all groups that can be neighbors within
+  //! radius_multiple * GetRadius() of an arbitrary position to
+  //! neighbors[group].  The position has one component per dimension and is
+  //! relative to the position origin of the model, like the stored positions.
+  //! Multiples above one visit more cells, which lets consumers with a larger
+  //! support (e.g. renderers) share the grid of the simulation.
   void CopyNeighbors(
-      size_t g_, size_t i_, std::vector<std::vector<size_t>> &neighbors) const;
+      cxx::span<double const> position, double radius_multiple,
+      std::vector<NeighborList> &neighbors) const;
 
 private:
   std::unique_ptr<NeighborhoodPImpl, NeighborhoodPImplDeleter> pimpl_;
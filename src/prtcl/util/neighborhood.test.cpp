@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <prtcl/util/neighborhood.hpp>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace prtcl;
+
+using Position = std::array<double, 3>;
+
+double DistanceSquared(Position const &lhs, Position const &rhs) {
+  double result = 0;
+  for (size_t dim = 0; dim < 3; ++dim)
+    result += (lhs[dim] - rhs[dim]) * (lhs[dim] - rhs[dim]);
+  return result;
+}
+
+TEST(Neighborhood, PositionQuery) {
+  constexpr double kRadius = 0.1;
+
+  std::mt19937 generator{3};
+  std::uniform_real_distribution<double> x_dist{-0.5, 0.5};
+  auto random_position = [&] {
+    return Position{x_dist(generator), x_dist(generator), x_dist(generator)};
+  };
+
+  Model model;
+  std::vector<std::vector<Position>> positions(3);
+  for (size_t group_index = 0; group_index < positions.size(); ++group_index) {
+    auto &group = model.AddGroup("g" + std::to_string(group_index), "type");
+    if (group_index == 2)
+      group.AddTag("cannot_be_neighbor");
+
+    group.CreateItems(500);
+    auto x = group.AddVaryingFieldImpl<double, 3>("position");
+    for (size_t i = 0; i < group.GetItemCount(); ++i) {
+      auto const &p = positions[group_index].emplace_back(random_position());
+      x[i] = TensorT<double, 3>{p[0], p[1], p[2]};
+    }
+  }
+
+  Neighborhood nhood;
+  nhood.Load(model);
+  nhood.SetRadius(kRadius);
+  nhood.Update();
+  EXPECT_EQ(nhood.GetRadius(), kRadius);
+
+  std::vector<NeighborList> neighbors(positions.size());
+  for (double const multiple : {0.5, 1.0, 2.5}) {
+    for (size_t query = 0; query < 100; ++query) {
+      auto const x = random_position();
+
+      for (auto &list : neighbors)
+        list.clear();
+      nhood.CopyNeighbors(x, multiple, neighbors);
+
+      for (size_t group_index = 0; group_index < positions.size();
+           ++group_index) {
+        std::vector<size_t> expected;
+        if (group_index != 2) {
+          auto const &group_positions = positions[group_index];
+          for (size_t i = 0; i < group_positions.size(); ++i)
+            if (DistanceSquared(x, group_positions[i]) <
+                (multiple * kRadius) * (multiple * kRadius))
+              expected.push_back(i);
+        }
+
+        std::vector<size_t> found{
+            neighbors[group_index].begin(), neighbors[group_index].end()};
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+      }
+    }
+  }
+
+  // the position needs one component per dimension
+  EXPECT_THROW(
+      nhood.CopyNeighbors(std::vector<double>{0, 0}, 1, neighbors),
+      InvalidShapeError);
+}
+
+TEST(Neighborhood, PermuteRemovesDestroyedItems) {
+  constexpr double kRadius = 0.1;
+
+  std::mt19937 generator{5};
+  std::uniform_real_distribution<double> x_dist{-0.5, 0.5};
+  auto random_position = [&] {
+    return Position{x_dist(generator), x_dist(generator), x_dist(generator)};
+  };
+
+  Model model;
+  auto &group = model.AddGroup("g", "type");
+  group.CreateItems(1000);
+  auto x = group.AddVaryingFieldImpl<double, 3>("position");
+  for (size_t i = 0; i < group.GetItemCount(); ++i) {
+    auto const p = random_position();
+    x[i] = TensorT<double, 3>{p[0], p[1], p[2]};
+  }
+
+  Neighborhood nhood;
+  nhood.Load(model);
+  nhood.SetRadius(kRadius);
+  nhood.Update();
+
+  // without removed items the spans stay valid
+  EXPECT_FALSE(nhood.Permute(model));
+
+  std::vector<size_t> destroyed;
+  for (size_t i = 0; i < group.GetItemCount(); i += 3)
+    destroyed.push_back(i);
+  group.DestroyItemsDeferred(destroyed);
+  model.SetDirty(false);
+
+  EXPECT_TRUE(nhood.Permute(model, true));
+  EXPECT_TRUE(model.IsDirty());
+  ASSERT_EQ(group.GetItemCount(), 1000 - destroyed.size());
+
+  // the grid only contains the remaining items
+  x = group.GetVarying().FieldSpan<double, 3>("position");
+  std::vector<NeighborList> neighbors(1);
+  for (size_t query = 0; query < 100; ++query) {
+    auto const p = random_position();
+
+    neighbors[0].clear();
+    nhood.CopyNeighbors(p, 1.0, neighbors);
+
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < x.size(); ++i)
+      if (DistanceSquared(p, Position{x[i][0], x[i][1], x[i][2]}) <
+          kRadius * kRadius)
+        expected.push_back(i);
+
+    std::vector<size_t> found{neighbors[0].begin(), neighbors[0].end()};
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(found, expected);
+  }
+}
+
+} // namespace
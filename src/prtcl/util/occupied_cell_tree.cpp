@@ -0,0 +1,134 @@
+#include "occupied_cell_tree.hpp"
+
+#include "../log.hpp"
+#include "morton_order.hpp"
+
+#include <algorithm>
+
+namespace prtcl {
+
+namespace {
+
+constexpr uint32_t kMaxLeafSize = 8;
+
+} // namespace
+
+OccupiedCellTree::OccupiedCellTree(
+    std::vector<Cell> cells, Real cell_size, Real padding)
+    : cells_{std::move(cells)}, cell_size_{cell_size}, padding_{padding} {
+  // neighboring cells are close to each other along the z-curve
+  std::sort(cells_.begin(), cells_.end(), morton_order_fn{});
+  cells_.erase(std::unique(cells_.begin(), cells_.end()), cells_.end());
+
+  auto const cell_count = static_cast<uint32_t>(cells_.size());
+  nodes_.reserve(2 * (cell_count / kMaxLeafSize + 1));
+  if (cell_count > 0)
+    Build(0, cell_count);
+
+  log::Debug(
+      "lib", "OccupiedCellTree", "built hierarchy with ", nodes_.size(),
+      " nodes over ", cell_count, " cells");
+}
+
+auto OccupiedCellTree::GetDistance(RVec3 const &x, Real max_distance) const
+    -> Real {
+  if (nodes_.empty())
+    return max_distance;
+
+  Real best = max_distance;
+
+  struct Item {
+    uint32_t node;
+    Real distance;
+  };
+  Item stack[64];
+  size_t stack_size = 0;
+  stack[stack_size++] = {0, GetBoxDistance(x, nodes_[0].lo, nodes_[0].hi)};
+
+  while (stack_size > 0) {
+    auto const item = stack[--stack_size];
+    if (item.distance >= best)
+      continue;
+
+    auto const &node = nodes_[item.node];
+    if (node.count > 0) {
+      for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+        auto const &cell = cells_[i];
+        best = std::min(
+            best, GetBoxDistance(x, GetCellLo(cell), GetCellHi(cell)));
+      }
+      if (best <= 0)
+        return 0;
+    } else {
+      Item near{item.node + 1, 0}, far{node.first, 0};
+      near.distance =
+          GetBoxDistance(x, nodes_[near.node].lo, nodes_[near.node].hi);
+      far.distance =
+          GetBoxDistance(x, nodes_[far.node].lo, nodes_[far.node].hi);
+      if (far.distance < near.distance)
+        std::swap(near, far);
+
+      // the nearer child is visited first
+      if (far.distance < best)
+        stack[stack_size++] = far;
+      if (near.distance < best)
+        stack[stack_size++] = near;
+    }
+  }
+
+  return best;
+}
+
+auto OccupiedCellTree::GetBoxDistance(
+    RVec3 const &x, RVec3 const &lo, RVec3 const &hi) -> Real {
+  RVec3 const d =
+      math::cmax(math::cmax(lo - x, x - hi), math::zeros<Real, 3>());
+  return math::norm(d);
+}
+
+uint32_t OccupiedCellTree::Build(uint32_t first, uint32_t last) {
+  auto const node_index = static_cast<uint32_t>(nodes_.size());
+  nodes_.emplace_back();
+
+  RVec3 lo = math::positive_infinity<Real, 3>(),
+        hi = math::negative_infinity<Real, 3>();
+  for (uint32_t i = first; i < last; ++i) {
+    lo = math::cmin(lo, GetCellLo(cells_[i]));
+    hi = math::cmax(hi, GetCellHi(cells_[i]));
+  }
+  nodes_[node_index].lo = lo;
+  nodes_[node_index].hi = hi;
+
+  if (last - first <= kMaxLeafSize) {
+    nodes_[node_index].first = first;
+    nodes_[node_index].count = last - first;
+    return node_index;
+  }
+
+  // the cells are sorted along the z-curve, halves of the range are compact
+  auto const mid = first + (last - first) / 2;
+  Build(first, mid);
+  auto const right = Build(mid, last);
+
+  nodes_[node_index].first = right;
+  nodes_[node_index].count = 0;
+  return node_index;
+}
+
+auto OccupiedCellTree::GetCellLo(Cell const &cell) const -> RVec3 {
+  RVec3 result;
+  for (size_t dim = 0; dim < 3; ++dim)
+    result[static_cast<Eigen::Index>(dim)] =
+        static_cast<Real>(cell[dim]) * cell_size_ - padding_;
+  return result;
+}
+
+auto OccupiedCellTree::GetCellHi(Cell const &cell) const -> RVec3 {
+  RVec3 result;
+  for (size_t dim = 0; dim < 3; ++dim)
+    result[static_cast<Eigen::Index>(dim)] =
+        static_cast<Real>(cell[dim] + 1) * cell_size_ + padding_;
+  return result;
+}
+
+} // namespace prtcl
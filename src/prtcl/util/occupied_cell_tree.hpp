@@ -0,0 +1,82 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_OCCUPIED_CELL_TREE_HPP
+#define PRTCL_SRC_PRTCL_UTIL_OCCUPIED_CELL_TREE_HPP
+
+#include "../math.hpp"
+
+#include <array>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prtcl {
+
+//! Bounding volume hierarchy over the occupied cells of a uniform grid, for
+//! distance queries against the union of the cells.
+//!
+//! The cells are sorted along the z-curve and grouped into leaves of a few
+//! neighboring cells, the inner nodes split their range of cells in halves.
+//! Like TriangleBVH, the nodes are stored as a flat array in depth-first
+//! order.  A query descends into the nearer child first and prunes all nodes
+//! that are farther away than the closest cell found so far, which typically
+//! visits O(log n) nodes instead of all n cells.  Far away from all cells the
+//! root bounds already decide the query, so empty space costs almost nothing.
+class OccupiedCellTree {
+public:
+  using Real = double;
+  using RVec3 = TensorT<Real, 3>;
+  using Cell = std::array<int32_t, 3>;
+
+public:
+  OccupiedCellTree() = default;
+
+  //! Builds the hierarchy over the boxes [cell * cell_size - padding,
+  //! (cell + 1) * cell_size + padding], duplicate cells are ignored.
+  OccupiedCellTree(std::vector<Cell> cells, Real cell_size, Real padding = 0);
+
+public:
+  bool IsEmpty() const { return cells_.empty(); }
+
+  size_t GetCellCount() const { return cells_.size(); }
+
+  size_t GetNodeCount() const { return nodes_.size(); }
+
+  Real GetCellSize() const { return cell_size_; }
+
+public:
+  //! Euclidean distance from x to the nearest box, zero inside of a box.
+  //! Distances of at least max_distance are returned as max_distance, which
+  //! allows pruning more nodes.  Returns max_distance if there are no cells.
+  Real GetDistance(
+      RVec3 const &x,
+      Real max_distance = math::positive_infinity<Real>()) const;
+
+private:
+  struct Node {
+    RVec3 lo, hi;
+    // leaf: index of the first cell in cells_
+    // inner: index of the right child
+    uint32_t first;
+    // number of cells of a leaf, zero for inner nodes
+    uint32_t count;
+  };
+
+  static Real GetBoxDistance(
+      RVec3 const &x, RVec3 const &lo, RVec3 const &hi);
+
+  uint32_t Build(uint32_t first, uint32_t last);
+
+  RVec3 GetCellLo(Cell const &cell) const;
+
+  RVec3 GetCellHi(Cell const &cell) const;
+
+private:
+  std::vector<Cell> cells_;
+  std::vector<Node> nodes_;
+  Real cell_size_ = 1;
+  Real padding_ = 0;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_OCCUPIED_CELL_TREE_HPP
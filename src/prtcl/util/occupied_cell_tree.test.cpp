@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <prtcl/util/occupied_cell_tree.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+using prtcl::OccupiedCellTree;
+using Real = OccupiedCellTree::Real;
+using RVec3 = OccupiedCellTree::RVec3;
+
+Real BruteForceDistance(
+    std::vector<OccupiedCellTree::Cell> const &cells, Real cell_size,
+    Real padding, RVec3 const &x) {
+  Real result = std::numeric_limits<Real>::infinity();
+  for (auto const &cell : cells) {
+    Real nsq = 0;
+    for (size_t dim = 0; dim < 3; ++dim) {
+      Real const lo = cell[dim] * cell_size - padding;
+      Real const hi = (cell[dim] + 1) * cell_size + padding;
+      auto const x_dim = x[static_cast<Eigen::Index>(dim)];
+      Real const d = std::max({lo - x_dim, x_dim - hi, Real{0}});
+      nsq += d * d;
+    }
+    result = std::min(result, std::sqrt(nsq));
+  }
+  return result;
+}
+
+TEST(OccupiedCellTree, MatchesBruteForce) {
+  constexpr Real kCellSize = 0.1, kPadding = 0.05;
+
+  std::mt19937 generator{7};
+  std::uniform_int_distribution<int32_t> cell_dist{-20, 20};
+  std::uniform_real_distribution<Real> x_dist{-4, 4};
+
+  std::vector<OccupiedCellTree::Cell> cells;
+  for (size_t i = 0; i < 500; ++i)
+    cells.push_back({cell_dist(generator), cell_dist(generator), 3});
+  // duplicates are ignored
+  cells.push_back(cells.front());
+
+  OccupiedCellTree const tree{cells, kCellSize, kPadding};
+  EXPECT_LT(tree.GetCellCount(), cells.size());
+
+  for (size_t i = 0; i < 1000; ++i) {
+    RVec3 const x{x_dist(generator), x_dist(generator), x_dist(generator)};
+    auto const expected = BruteForceDistance(cells, kCellSize, kPadding, x);
+    EXPECT_NEAR(tree.GetDistance(x), expected, 1e-12);
+    EXPECT_NEAR(tree.GetDistance(x, 0.2), std::min<Real>(expected, 0.2), 1e-12);
+  }
+
+  // inside of a cell
+  auto const &cell = cells.front();
+  RVec3 const inside{
+      (cell[0] + 0.5) * kCellSize, (cell[1] + 0.5) * kCellSize,
+      (cell[2] + 0.5) * kCellSize};
+  EXPECT_EQ(tree.GetDistance(inside), 0);
+}
+
+TEST(OccupiedCellTree, Empty) {
+  OccupiedCellTree const tree{{}, 1};
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_EQ(tree.GetDistance(RVec3{0, 0, 0}, 5), 5);
+}
+
+} // namespace
@@ -0,0 +1,111 @@
+#include "particle_sink.hpp"
+
+#include "../errors/invalid_shape_error.hpp"
+#include "../log.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace prtcl {
+
+void ParticleSink::AddBox(RVec3 const &lo, RVec3 const &hi) {
+  regions_.emplace_back(Box{lo, hi});
+}
+
+void ParticleSink::AddHalfSpace(RVec3 const &point, RVec3 const &normal) {
+  regions_.emplace_back(HalfSpace{point, normal});
+}
+
+void ParticleSink::AddMesh(
+    TriangleMesh mesh, SampleVolumeInsideTest inside_test) {
+  RVec3 lo = math::positive_infinity<Real, 3>(),
+        hi = math::negative_infinity<Real, 3>();
+  for (auto const &x : mesh.Vertices()) {
+    lo = math::cmin(lo, x);
+    hi = math::cmax(hi, x);
+  }
+  regions_.emplace_back(Mesh{
+      std::make_shared<Mesh::Data const>(std::move(mesh)), lo, hi,
+      inside_test});
+}
+
+bool ParticleSink::Contains(RVec3 const &x) const {
+  auto const in_box = [&x](RVec3 const &lo, RVec3 const &hi) {
+    for (Eigen::Index dim = 0; dim < 3; ++dim)
+      if (x[dim] < lo[dim] or x[dim] > hi[dim])
+        return false;
+    return true;
+  };
+
+  for (auto const &region : regions_) {
+    bool const inside = std::visit(
+        [&](auto const &r) {
+          using R = std::decay_t<decltype(r)>;
+          if constexpr (std::is_same_v<R, Box>) {
+            return in_box(r.lo, r.hi);
+          } else if constexpr (std::is_same_v<R, HalfSpace>) {
+            return math::dot(r.normal, x - r.point) > 0;
+          } else {
+            return in_box(r.lo, r.hi) and
+                   IsInsideMesh(r.data->bvh, x, r.inside_test);
+          }
+        },
+        region);
+    if (inside)
+      return true;
+  }
+  return false;
+}
+
+size_t ParticleSink::Apply(Group &group) const {
+  if (regions_.empty() or not group.GetVarying().HasField("position"))
+    return 0;
+
+  // the positions are fetched as absolute double precision values, whatever
+  // their type and origin
+  auto const x = group.GetVaryingField("position");
+  if (x.GetType().GetShape() != Shape{3})
+    throw InvalidShapeError{};
+  auto const item_count = group.GetItemCount();
+  auto const block_count = (item_count + kBlockSize - 1) / kBlockSize;
+
+  std::vector<uint8_t> inside(item_count, 0);
+
+  using block_index_t = std::ptrdiff_t;
+#pragma omp parallel
+  {
+    std::vector<Real> block(3 * kBlockSize);
+
+#pragma omp for schedule(dynamic)
+    for (block_index_t b = 0; b < static_cast<block_index_t>(block_count);
+         ++b) {
+      auto const first = static_cast<size_t>(b) * kBlockSize;
+      auto const count = std::min(kBlockSize, item_count - first);
+      x.GetRealRange(first, count, block.data());
+
+      for (size_t i = 0; i < count; ++i) {
+        RVec3 const x_i{block[3 * i], block[3 * i + 1], block[3 * i + 2]};
+        inside[first + i] = Contains(x_i) ? 1 : 0;
+      }
+    }
+  }
+
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < item_count; ++i)
+    if (inside[i])
+      indices.push_back(i);
+  // particles that were already marked (e.g. by another sink) are not
+  // counted again
+  auto const marked_before = group.GetDeferredDestroyCount();
+  group.DestroyItemsDeferred(indices);
+  auto const marked = group.GetDeferredDestroyCount() - marked_before;
+
+  if (marked > 0)
+    log::Debug(
+        "lib", "ParticleSink", "marked ", marked, " of ", item_count,
+        " particles of ", group.GetGroupName(), " for destruction");
+
+  return marked;
+}
+
+} // namespace prtcl
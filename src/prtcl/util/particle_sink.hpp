@@ -0,0 +1,88 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_PARTICLE_SINK_HPP
+#define PRTCL_SRC_PRTCL_UTIL_PARTICLE_SINK_HPP
+
+#include "../data/group.hpp"
+#include "../geometry/sample_volume.hpp"
+#include "../geometry/triangle_bvh.hpp"
+#include "../geometry/triangle_mesh.hpp"
+#include "../math.hpp"
+
+#include <memory>
+#include <variant>
+#include <vector>
+
+#include <cstddef>
+
+namespace prtcl {
+
+//! Removes the particles that enter any of its regions, e.g. the outflow of
+//! a scene or everything far outside of the domain.
+//!
+//! Apply tests the positions of all particles of a group in parallel and
+//! only marks the particles inside of a region for destruction (see
+//! Group::DestroyItemsDeferred).  They are removed in a batch by the next
+//! Neighborhood::Permute, which compacts the group while permuting it, or
+//! by Group::CompactItems.
+class ParticleSink {
+public:
+  using Real = double;
+  using RVec3 = TensorT<Real, 3>;
+
+  //! Number of positions that are fetched at once.
+  static constexpr size_t kBlockSize = 1024;
+
+public:
+  //! Adds the axis-aligned box [lo, hi].
+  void AddBox(RVec3 const &lo, RVec3 const &hi);
+
+  //! Adds the half-space of the points x with dot(normal, x - point) > 0,
+  //! i.e. normal points into the sink.
+  void AddHalfSpace(RVec3 const &point, RVec3 const &normal);
+
+  //! Adds the interior of a closed mesh (see IsInsideMesh).
+  void AddMesh(
+      TriangleMesh mesh, SampleVolumeInsideTest inside_test =
+                             SampleVolumeInsideTest::kNonZeroWinding);
+
+  size_t GetRegionCount() const { return regions_.size(); }
+
+public:
+  bool Contains(RVec3 const &x) const;
+
+  //! Marks the particles of group that are inside of any region for
+  //! destruction and returns how many were not marked before.  Throws
+  //! InvalidShapeError unless the positions have three components.
+  size_t Apply(Group &group) const;
+
+private:
+  struct Box {
+    RVec3 lo, hi;
+  };
+
+  struct HalfSpace {
+    RVec3 point, normal;
+  };
+
+  struct Mesh {
+    // the bvh references the mesh, both are shared by copies of the sink
+    struct Data {
+      explicit Data(TriangleMesh mesh_) : mesh{std::move(mesh_)}, bvh{mesh} {}
+
+      TriangleMesh mesh;
+      TriangleBVH bvh;
+    };
+
+    std::shared_ptr<Data const> data;
+    //! Bounds of the mesh, the points outside are rejected quickly.
+    RVec3 lo, hi;
+    SampleVolumeInsideTest inside_test;
+  };
+
+  using Region = std::variant<Box, HalfSpace, Mesh>;
+
+  std::vector<Region> regions_;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_PARTICLE_SINK_HPP
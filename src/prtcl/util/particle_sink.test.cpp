@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include "particle_sink.hpp"
+
+#include "../data/model.hpp"
+#include "../errors/invalid_shape_error.hpp"
+#include "neighborhood.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+using namespace prtcl;
+
+namespace {
+
+TriangleMesh MakeCube(double lo, double hi) {
+  std::ostringstream obj;
+  for (auto z : {lo, hi})
+    for (auto [x, y] : {std::pair{lo, lo}, {hi, lo}, {hi, hi}, {lo, hi}})
+      obj << "v " << x << ' ' << y << ' ' << z << '\n';
+  obj << "f 1 4 3 2\n"
+      << "f 5 6 7 8\n"
+      << "f 1 2 6 5\n"
+      << "f 2 3 7 6\n"
+      << "f 3 4 8 7\n"
+      << "f 4 1 5 8\n";
+  std::istringstream input{obj.str()};
+  return TriangleMesh::load_from_obj(input);
+}
+
+} // namespace
+
+TEST(ParticleSink, Apply) {
+  Model model;
+  auto &group = model.AddGroup("f", "fluid");
+  group.AddVaryingFieldImpl<float, 3>("position");
+  group.AddVaryingFieldImpl<float>("mass");
+  group.SetFieldOrigin("position", std::vector<double>{100, 0, 0});
+
+  // a line of particles along the x-axis at x = 100 + i / 10
+  size_t const count = 3000;
+  group.CreateItems(count);
+  auto x = group.GetVarying().FieldWrap<double, 3>("position");
+  auto m = group.GetVarying().FieldWrap<float>("mass");
+  for (size_t i = 0; i < count; ++i) {
+    x.Set(i, TensorT<double, 3>{100 + 0.1 * static_cast<double>(i), 0, 0});
+    m.Set(i, static_cast<float>(i));
+  }
+
+  ParticleSink sink;
+  // removes x in [110, 120) ...
+  sink.AddBox(
+      TensorT<double, 3>{109.95, -1, -1}, TensorT<double, 3>{119.95, 1, 1});
+  // ... x in [134, 136) ...
+  sink.AddMesh(MakeCube(-1.05, 0.95).Translate(TensorT<double, 3>{135, 0, 0}));
+  // ... and x >= 250
+  sink.AddHalfSpace(
+      TensorT<double, 3>{249.95, 0, 0}, TensorT<double, 3>{1, 0, 0});
+  EXPECT_EQ(sink.GetRegionCount(), 3);
+
+  auto const is_removed = [](double x_i) {
+    return (110 <= x_i and x_i < 120) or (134 <= x_i and x_i < 136) or
+           250 <= x_i;
+  };
+  size_t expected = 0;
+  for (size_t i = 0; i < count; ++i) {
+    auto const x_i = 100 + 0.1 * static_cast<double>(i);
+    if (is_removed(x_i + 1e-6))
+      ++expected;
+    EXPECT_EQ(sink.Contains(x.Get(i)), is_removed(x_i + 1e-6)) << x_i;
+  }
+
+  // the particles are only marked ...
+  EXPECT_EQ(sink.Apply(group), expected);
+  EXPECT_EQ(group.GetDeferredDestroyCount(), expected);
+  EXPECT_EQ(group.GetItemCount(), count);
+  // marked particles are not counted twice
+  EXPECT_EQ(sink.Apply(group), 0);
+  EXPECT_EQ(group.GetDeferredDestroyCount(), expected);
+
+  // ... and removed in a batch
+  group.CompactItems();
+  ASSERT_EQ(group.GetItemCount(), count - expected);
+  x = group.GetVarying().FieldWrap<double, 3>("position");
+  m = group.GetVarying().FieldWrap<float>("mass");
+  for (size_t i = 0; i < group.GetItemCount(); ++i) {
+    auto const x_i = 100 + 0.1 * static_cast<double>(m.Get(i));
+    EXPECT_FALSE(is_removed(x_i + 1e-6));
+    EXPECT_NEAR(x.Get(i)[0], x_i, 1e-4);
+  }
+
+  // nothing is left to remove
+  EXPECT_EQ(sink.Apply(group), 0);
+}
+
+TEST(ParticleSink, RejectsPositionsWithoutThreeComponents) {
+  Model model;
+  auto &group = model.AddGroup("f", "fluid");
+  group.AddVaryingFieldImpl<float, 2>("position");
+  group.CreateItems(10);
+
+  ParticleSink sink;
+  sink.AddHalfSpace(TensorT<double, 3>{0, 0, 0}, TensorT<double, 3>{1, 0, 0});
+  EXPECT_THROW(sink.Apply(group), InvalidShapeError);
+}
+
+TEST(ParticleSink, RemovedByNeighborhoodPermute) {
+  Model model;
+  auto &group = model.AddGroup("f", "fluid");
+  group.AddVaryingFieldImpl<double, 3>("position");
+
+  // a 20^3 lattice of spacing 0.05 in [0, 1)^3
+  group.CreateItems(20 * 20 * 20);
+  auto x = group.GetVarying().FieldSpan<double, 3>("position");
+  for (size_t i = 0; i < group.GetItemCount(); ++i)
+    x[i] = TensorT<double, 3>{
+        0.05 * static_cast<double>(i % 20),
+        0.05 * static_cast<double>(i / 20 % 20),
+        0.05 * static_cast<double>(i / 400)};
+
+  Neighborhood nhood;
+  nhood.Load(model);
+  nhood.SetRadius(0.12);
+  nhood.Update();
+
+  // removes the half x > 0.5
+  ParticleSink sink;
+  sink.AddHalfSpace(
+      TensorT<double, 3>{0.5, 0, 0}, TensorT<double, 3>{1, 0, 0});
+  EXPECT_EQ(sink.Apply(group), 9 * 20 * 20);
+
+  EXPECT_TRUE(nhood.Permute(model));
+  ASSERT_EQ(group.GetItemCount(), 11 * 20 * 20);
+
+  // the neighbors are valid indices of remaining particles
+  x = group.GetVarying().FieldSpan<double, 3>("position");
+  std::vector<NeighborList> neighbors(1);
+  for (auto const &p : {std::vector<double>{0.5, 0.5, 0.5},
+                        std::vector<double>{0.6, 0.5, 0.5},
+                        std::vector<double>{0.25, 0.1, 0.9}}) {
+    neighbors[0].clear();
+    nhood.CopyNeighbors(p, 1.0, neighbors);
+
+    size_t expected = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+      // not auto, the expression would reference the destroyed temporary
+      TensorT<double, 3> const d = x[i] - TensorT<double, 3>{p[0], p[1], p[2]};
+      if (d.squaredNorm() < 0.12 * 0.12)
+        ++expected;
+    }
+    EXPECT_EQ(neighbors[0].size(), expected);
+    for (auto const j : neighbors[0]) {
+      ASSERT_LT(j, x.size());
+      EXPECT_LE(x[j][0], 0.5 + 1e-9);
+    }
+  }
+}
@@ -0,0 +1,286 @@
+#include "perf_counters.hpp"
+
+#include "../log.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <mutex>
+
+#include <omp.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace prtcl {
+
+namespace {
+
+struct Counter {
+  int fd = -1;
+};
+
+struct CounterRead {
+  uint64_t value;
+  uint64_t time_enabled;
+  uint64_t time_running;
+};
+
+struct Registry {
+  std::mutex mutex;
+
+  // one counter per thread and event
+  std::vector<std::array<Counter, kPerfEventCount>> threads;
+
+  // the statistics in order of their first use
+  std::vector<PerfStats> stats;
+};
+
+Registry &GetRegistry() {
+  static auto *registry = new Registry;
+  return *registry;
+}
+
+double GetSeconds() {
+  using Clock = std::chrono::steady_clock;
+  return std::chrono::duration<double>{Clock::now().time_since_epoch()}
+      .count();
+}
+
+#if defined(__linux__)
+
+int OpenCounter(PerfEvent event) {
+  perf_event_attr attr = {};
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.disabled = 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  switch (event) {
+  case PerfEvent::kCycles:
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case PerfEvent::kInstructions:
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case PerfEvent::kCacheReferences:
+    attr.config = PERF_COUNT_HW_CACHE_REFERENCES;
+    break;
+  case PerfEvent::kCacheMisses:
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    break;
+  default:
+    return -1;
+  }
+
+  // count the calling thread on any cpu
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+void CloseCounter(Counter &counter) {
+  if (counter.fd >= 0)
+    close(counter.fd);
+  counter.fd = -1;
+}
+
+std::optional<double> ReadCounter(Counter const &counter) {
+  if (counter.fd < 0)
+    return std::nullopt;
+
+  CounterRead data;
+  if (read(counter.fd, &data, sizeof(data)) != sizeof(data))
+    return std::nullopt;
+
+  // scale the value up if the counter was multiplexed
+  if (data.time_running == 0)
+    return 0.0;
+  return static_cast<double>(data.value) *
+         static_cast<double>(data.time_enabled) /
+         static_cast<double>(data.time_running);
+}
+
+#else
+
+int OpenCounter(PerfEvent) { return -1; }
+
+void CloseCounter(Counter &counter) { counter.fd = -1; }
+
+std::optional<double> ReadCounter(Counter const &) { return std::nullopt; }
+
+#endif
+
+void CloseAll(Registry &registry) {
+  for (auto &thread : registry.threads)
+    for (auto &counter : thread)
+      CloseCounter(counter);
+  registry.threads.clear();
+}
+
+} // namespace
+
+std::string_view GetPerfEventName(PerfEvent event) {
+  switch (event) {
+  case PerfEvent::kCycles:
+    return "cycles";
+  case PerfEvent::kInstructions:
+    return "instructions";
+  case PerfEvent::kCacheReferences:
+    return "cache_references";
+  case PerfEvent::kCacheMisses:
+    return "cache_misses";
+  default:
+    return "unknown";
+  }
+}
+
+std::optional<double> PerfStats::GetIPC() const {
+  auto const cycles = Get(PerfEvent::kCycles);
+  auto const instructions = Get(PerfEvent::kInstructions);
+  if (not cycles or not instructions or *cycles <= 0)
+    return std::nullopt;
+  return *instructions / *cycles;
+}
+
+std::optional<double> PerfStats::GetCacheMissRate() const {
+  auto const references = Get(PerfEvent::kCacheReferences);
+  auto const misses = Get(PerfEvent::kCacheMisses);
+  if (not references or not misses or *references <= 0)
+    return std::nullopt;
+  return *misses / *references;
+}
+
+std::optional<double> PerfStats::GetEstimatedBandwidth() const {
+  constexpr double kCacheLineSize = 64;
+  auto const misses = Get(PerfEvent::kCacheMisses);
+  if (not misses or seconds <= 0)
+    return std::nullopt;
+  return *misses * kCacheLineSize / seconds;
+}
+
+bool PerfCounters::Enable() {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+
+  CloseAll(registry);
+
+  // each thread opens the counters of itself
+  registry.threads.resize(static_cast<size_t>(omp_get_max_threads()));
+#pragma omp parallel
+  {
+    auto const thread = static_cast<size_t>(omp_get_thread_num());
+    if (thread < registry.threads.size()) {
+      for (size_t event = 0; event < kPerfEventCount; ++event) {
+        registry.threads[thread][event].fd =
+            OpenCounter(static_cast<PerfEvent>(event));
+      }
+    }
+  }
+
+  // an event is only used if it is available on all threads
+  bool any_available = false;
+  for (size_t event = 0; event < kPerfEventCount; ++event) {
+    bool available = true;
+    for (auto &thread : registry.threads)
+      available = available and thread[event].fd >= 0;
+
+    if (available) {
+      any_available = true;
+    } else {
+      log::Warning(
+          "lib", "PerfCounters", "event ",
+          GetPerfEventName(static_cast<PerfEvent>(event)),
+          " is not available");
+      for (auto &thread : registry.threads)
+        CloseCounter(thread[event]);
+    }
+  }
+
+  if (not any_available)
+    CloseAll(registry);
+
+  enabled_.store(any_available, std::memory_order_relaxed);
+  return any_available;
+}
+
+void PerfCounters::Disable() {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+  enabled_.store(false, std::memory_order_relaxed);
+  CloseAll(registry);
+}
+
+void PerfCounters::Reset() {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+  registry.stats.clear();
+}
+
+std::vector<PerfStats> PerfCounters::GetStats() {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+  return registry.stats;
+}
+
+PerfValues PerfCounters::Read() {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+
+  PerfValues result;
+  for (size_t event = 0; event < kPerfEventCount; ++event) {
+    std::optional<double> sum;
+    for (auto &thread : registry.threads) {
+      if (auto value = ReadCounter(thread[event]))
+        sum = sum.value_or(0) + *value;
+    }
+    result[event] = sum;
+  }
+  return result;
+}
+
+void PerfCounters::Accumulate(
+    std::string_view name, double seconds, PerfValues const &begin,
+    PerfValues const &end) {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+
+  auto it = std::find_if(
+      registry.stats.begin(), registry.stats.end(),
+      [name](auto const &entry) { return entry.name == name; });
+  if (it == registry.stats.end()) {
+    registry.stats.push_back(PerfStats{std::string{name}, 0, 0, {}});
+    it = std::prev(registry.stats.end());
+  }
+
+  it->count += 1;
+  it->seconds += seconds;
+  for (size_t event = 0; event < kPerfEventCount; ++event) {
+    if (begin[event] and end[event]) {
+      it->values[event] =
+          it->values[event].value_or(0) + (*end[event] - *begin[event]);
+    }
+  }
+}
+
+PerfCounterScope::PerfCounterScope(std::string_view name) {
+  if (PerfCounters::IsEnabled()) {
+    name_ = name;
+    begin_seconds_ = GetSeconds();
+    begin_ = PerfCounters::Read();
+  }
+}
+
+PerfCounterScope::~PerfCounterScope() {
+  if (not name_.empty()) {
+    auto const end = PerfCounters::Read();
+    auto const seconds = GetSeconds() - begin_seconds_;
+    PerfCounters::Accumulate(name_, seconds, begin_, end);
+  }
+}
+
+} // namespace prtcl
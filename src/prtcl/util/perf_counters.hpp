@@ -0,0 +1,118 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_PERF_COUNTERS_HPP
+#define PRTCL_SRC_PRTCL_UTIL_PERF_COUNTERS_HPP
+
+#include <array>
+#include <atomic>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prtcl {
+
+//! Hardware events counted by the PerfCounters.
+enum class PerfEvent : size_t {
+  kCycles,
+  kInstructions,
+  //! Last level cache references and misses.
+  kCacheReferences,
+  kCacheMisses,
+  //! Number of events, not an event.
+  kCount,
+};
+
+constexpr size_t kPerfEventCount = static_cast<size_t>(PerfEvent::kCount);
+
+//! Name of the event as used in the statistics ("cycles", ...).
+std::string_view GetPerfEventName(PerfEvent event);
+
+//! Counter values summed over all threads, nullopt if the event could not be
+//! counted on this system.  Values are scaled up if the kernel had to
+//! multiplex the counters.
+using PerfValues = std::array<std::optional<double>, kPerfEventCount>;
+
+//! Aggregated counters of one named scope (see PerfCounterScope).
+struct PerfStats {
+  std::string name;
+  uint64_t count;
+  double seconds;
+  PerfValues values;
+
+  std::optional<double> Get(PerfEvent event) const {
+    return values[static_cast<size_t>(event)];
+  }
+
+  //! Instructions per cycle.
+  std::optional<double> GetIPC() const;
+
+  //! Fraction of last level cache references that missed.
+  std::optional<double> GetCacheMissRate() const;
+
+  //! Memory bandwidth estimated from the last level cache misses (one cache
+  //! line each) in bytes per second.  This ignores prefetches and writebacks
+  //! and is thus a lower bound.
+  std::optional<double> GetEstimatedBandwidth() const;
+};
+
+//! Process wide hardware performance counters based on perf_event_open.
+//!
+//! When enabled, one counter per event is opened for each OpenMP thread
+//! (threads created later are not counted).  A PerfCounterScope reads the
+//! counters of all threads when it is entered and left and adds the
+//! difference to the statistics of its name, which accumulate until Reset.
+//! Without support by the kernel (or with a too restrictive
+//! perf_event_paranoid), Enable fails and the scopes stay inactive.
+class PerfCounters {
+public:
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  //! Opens the counters, returns false if none of them are available.
+  static bool Enable();
+
+  //! Closes the counters, the statistics are kept.
+  static void Disable();
+
+  //! Clears the statistics.
+  static void Reset();
+
+  //! Returns the statistics of all scopes in order of their first use.
+  static std::vector<PerfStats> GetStats();
+
+public:
+  //! Returns the current counter values summed over all threads.
+  static PerfValues Read();
+
+  //! Adds the difference of the values to the statistics of name.
+  static void Accumulate(
+      std::string_view name, double seconds, PerfValues const &begin,
+      PerfValues const &end);
+
+private:
+  inline static std::atomic<bool> enabled_ = false;
+};
+
+//! Attributes the counter values during its lifetime to a name, inactive if
+//! the counters are not enabled on construction.  Scopes must be used outside
+//! of parallel regions.
+class PerfCounterScope {
+public:
+  explicit PerfCounterScope(std::string_view name);
+
+  ~PerfCounterScope();
+
+  PerfCounterScope(PerfCounterScope const &) = delete;
+  PerfCounterScope &operator=(PerfCounterScope const &) = delete;
+
+private:
+  //! Empty if the scope is inactive.
+  std::string name_;
+  double begin_seconds_ = 0;
+  PerfValues begin_;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_PERF_COUNTERS_HPP
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <prtcl/util/perf_counters.hpp>
+
+#include <vector>
+
+namespace {
+
+TEST(PerfCounters, DerivedMetrics) {
+  using prtcl::PerfEvent;
+
+  prtcl::PerfStats stats{"test", 1, 2.0, {}};
+  EXPECT_FALSE(stats.GetIPC().has_value());
+  EXPECT_FALSE(stats.GetEstimatedBandwidth().has_value());
+
+  stats.values[static_cast<size_t>(PerfEvent::kCycles)] = 100;
+  stats.values[static_cast<size_t>(PerfEvent::kInstructions)] = 250;
+  stats.values[static_cast<size_t>(PerfEvent::kCacheReferences)] = 40;
+  stats.values[static_cast<size_t>(PerfEvent::kCacheMisses)] = 10;
+
+  EXPECT_DOUBLE_EQ(stats.GetIPC().value(), 2.5);
+  EXPECT_DOUBLE_EQ(stats.GetCacheMissRate().value(), 0.25);
+  EXPECT_DOUBLE_EQ(stats.GetEstimatedBandwidth().value(), 10 * 64 / 2.0);
+}
+
+TEST(PerfCounters, Scope) {
+  using prtcl::PerfCounters;
+  using prtcl::PerfEvent;
+
+  if (not PerfCounters::Enable())
+    GTEST_SKIP() << "perf_event_open is not available";
+
+  PerfCounters::Reset();
+
+  std::vector<double> values(1 << 16, 1.0);
+  double sum = 0;
+  for (int i = 0; i < 2; ++i) {
+    prtcl::PerfCounterScope scope{"sum"};
+    for (auto value : values)
+      sum += value;
+  }
+  EXPECT_EQ(sum, 2 * values.size());
+
+  PerfCounters::Disable();
+  { prtcl::PerfCounterScope scope{"disabled"}; }
+
+  auto const stats = PerfCounters::GetStats();
+  ASSERT_EQ(stats.size(), 1);
+  EXPECT_EQ(stats[0].name, "sum");
+  EXPECT_EQ(stats[0].count, 2);
+  if (auto instructions = stats[0].Get(PerfEvent::kInstructions)) {
+    EXPECT_GT(*instructions, values.size());
+  }
+
+  PerfCounters::Reset();
+}
+
+} // namespace
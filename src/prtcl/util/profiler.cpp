@@ -0,0 +1,341 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace prtcl {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int64_t GetNanoseconds() {
+  static auto const start = Clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now() - start)
+      .count();
+}
+
+struct ThreadNode {
+  // the address is used for the lookup, the copy for the output
+  char const *key;
+  std::string name;
+  uint32_t parent;
+  std::vector<uint32_t> children;
+
+  uint64_t count = 0;
+  int64_t total_ns = 0;
+  int64_t min_ns = std::numeric_limits<int64_t>::max();
+  int64_t max_ns = 0;
+};
+
+struct TraceEvent {
+  uint32_t node;
+  int64_t begin_ns;
+  int64_t end_ns;
+};
+
+// The profile of one thread, only ever accessed by that thread while
+// profiling.  The root node (index 0) is never timed.
+struct ThreadProfile {
+  size_t thread_index;
+
+  std::vector<ThreadNode> nodes{ThreadNode{nullptr, "", 0, {}}};
+  std::vector<std::pair<uint32_t, int64_t>> stack;
+
+  std::vector<TraceEvent> events;
+  size_t trace_capacity = 0;
+  uint64_t dropped_events = 0;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadProfile>> threads;
+  size_t trace_capacity = 0;
+};
+
+Registry &GetRegistry() {
+  static auto *registry = new Registry;
+  return *registry;
+}
+
+ThreadProfile &GetThreadProfile() {
+  thread_local ThreadProfile *profile = [] {
+    auto &registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    auto &thread = registry.threads.emplace_back(new ThreadProfile);
+    thread->thread_index = registry.threads.size() - 1;
+    thread->trace_capacity = registry.trace_capacity;
+    thread->events.reserve(registry.trace_capacity);
+    return thread.get();
+  }();
+  return *profile;
+}
+
+void WriteJSONString(std::ostream &output, std::string_view value) {
+  output << '"';
+  for (char c : value) {
+    if (c == '"' or c == '\\')
+      output << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+      output << ' ';
+    else
+      output << c;
+  }
+  output << '"';
+}
+
+double ToSeconds(int64_t ns) { return static_cast<double>(ns) * 1e-9; }
+
+} // namespace
+
+void Profiler::SetTraceCapacity(size_t capacity) {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+  registry.trace_capacity = capacity;
+  for (auto &thread : registry.threads) {
+    thread->trace_capacity = capacity;
+    thread->events.clear();
+    thread->events.shrink_to_fit();
+    thread->events.reserve(capacity);
+  }
+}
+
+void Profiler::Reset() {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+  // the nodes are kept, scopes that are still open stay valid
+  for (auto &thread : registry.threads) {
+    for (auto &node : thread->nodes) {
+      node.count = 0;
+      node.total_ns = 0;
+      node.min_ns = std::numeric_limits<int64_t>::max();
+      node.max_ns = 0;
+    }
+    thread->events.clear();
+    thread->dropped_events = 0;
+  }
+}
+
+void Profiler::Begin(char const *name) {
+  auto &profile = GetThreadProfile();
+
+  uint32_t const parent =
+      profile.stack.empty() ? 0 : profile.stack.back().first;
+
+  // scopes are identified by the address of their name, which is the same for
+  // each pass through a scope, comparing the names guards against addresses
+  // that are reused for other names
+  uint32_t index = 0;
+  for (auto child : profile.nodes[parent].children) {
+    auto const &node = profile.nodes[child];
+    if (node.key == name and node.name == name) {
+      index = child;
+      break;
+    }
+  }
+
+  if (index == 0) {
+    index = static_cast<uint32_t>(profile.nodes.size());
+    profile.nodes.push_back(ThreadNode{name, name, parent, {}});
+    profile.nodes[parent].children.push_back(index);
+  }
+
+  profile.stack.emplace_back(index, GetNanoseconds());
+}
+
+void Profiler::End() {
+  auto const end_ns = GetNanoseconds();
+  auto &profile = GetThreadProfile();
+
+  auto const [index, begin_ns] = profile.stack.back();
+  profile.stack.pop_back();
+
+  auto &node = profile.nodes[index];
+  auto const duration = end_ns - begin_ns;
+  node.count += 1;
+  node.total_ns += duration;
+  node.min_ns = std::min(node.min_ns, duration);
+  node.max_ns = std::max(node.max_ns, duration);
+
+  if (profile.events.size() < profile.trace_capacity)
+    profile.events.push_back(TraceEvent{index, begin_ns, end_ns});
+  else if (profile.trace_capacity > 0)
+    profile.dropped_events += 1;
+}
+
+std::vector<ProfileNode> Profiler::GetNodes() {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+
+  struct MergedNode {
+    ProfileNode node = {};
+    std::vector<size_t> children;
+    int64_t min_ns = std::numeric_limits<int64_t>::max();
+    int64_t max_ns = 0;
+    int64_t total_ns = 0;
+    int64_t max_thread_ns = 0;
+  };
+
+  // merge the trees of all threads by the names of the scopes
+  std::vector<MergedNode> merged(1);
+  for (auto &thread : registry.threads) {
+    std::vector<std::pair<uint32_t, size_t>> pending{{0, 0}};
+    while (not pending.empty()) {
+      auto const [index, merged_index] = pending.back();
+      pending.pop_back();
+
+      for (auto child_index : thread->nodes[index].children) {
+        auto const &child = thread->nodes[child_index];
+
+        size_t target = merged.size();
+        for (auto candidate : merged[merged_index].children) {
+          if (merged[candidate].node.name == child.name) {
+            target = candidate;
+            break;
+          }
+        }
+
+        if (target == merged.size()) {
+          MergedNode entry;
+          entry.node.name = child.name;
+          if (merged_index == 0) {
+            entry.node.path = child.name;
+            entry.node.depth = 0;
+          } else {
+            auto const &parent = merged[merged_index].node;
+            entry.node.path = parent.path + "/" + child.name;
+            entry.node.depth = parent.depth + 1;
+          }
+          merged.push_back(std::move(entry));
+          merged[merged_index].children.push_back(target);
+        }
+
+        auto &entry = merged[target];
+        if (child.count > 0) {
+          entry.node.count += child.count;
+          entry.node.thread_count += 1;
+          entry.total_ns += child.total_ns;
+          entry.min_ns = std::min(entry.min_ns, child.min_ns);
+          entry.max_ns = std::max(entry.max_ns, child.max_ns);
+          entry.max_thread_ns = std::max(entry.max_thread_ns, child.total_ns);
+        }
+
+        pending.emplace_back(child_index, target);
+      }
+    }
+  }
+
+  // flatten in depth first order
+  std::vector<ProfileNode> result;
+  std::vector<std::pair<size_t, std::optional<size_t>>> pending;
+  for (auto it = merged[0].children.rbegin(); it != merged[0].children.rend();
+       ++it)
+    pending.emplace_back(*it, std::nullopt);
+
+  while (not pending.empty()) {
+    auto const [merged_index, parent] = pending.back();
+    pending.pop_back();
+
+    auto &entry = merged[merged_index];
+    auto node = entry.node;
+    node.parent = parent;
+    node.total_seconds = ToSeconds(entry.total_ns);
+    node.min_seconds = node.count > 0 ? ToSeconds(entry.min_ns) : 0;
+    node.max_seconds = ToSeconds(entry.max_ns);
+    node.max_thread_seconds = ToSeconds(entry.max_thread_ns);
+    node.mean_thread_seconds =
+        node.thread_count > 0
+            ? node.total_seconds / static_cast<double>(node.thread_count)
+            : 0;
+
+    auto const index = result.size();
+    result.push_back(std::move(node));
+
+    for (auto it = entry.children.rbegin(); it != entry.children.rend(); ++it)
+      pending.emplace_back(*it, index);
+  }
+
+  return result;
+}
+
+void Profiler::SaveJSON(std::ostream &output) {
+  auto const nodes = GetNodes();
+
+  // children of each node, in order
+  std::vector<std::vector<size_t>> children(nodes.size());
+  std::vector<size_t> roots;
+  for (size_t index = 0; index < nodes.size(); ++index) {
+    if (nodes[index].parent)
+      children[*nodes[index].parent].push_back(index);
+    else
+      roots.push_back(index);
+  }
+
+  auto write = [&](auto &self, size_t index, size_t indent) -> void {
+    auto const &node = nodes[index];
+    std::string const pad(indent, ' ');
+    output << pad << "{\"name\": ";
+    WriteJSONString(output, node.name);
+    output << ", \"count\": " << node.count
+           << ", \"total_seconds\": " << node.total_seconds
+           << ", \"min_seconds\": " << node.min_seconds
+           << ", \"max_seconds\": " << node.max_seconds
+           << ", \"thread_count\": " << node.thread_count
+           << ", \"mean_thread_seconds\": " << node.mean_thread_seconds
+           << ", \"max_thread_seconds\": " << node.max_thread_seconds
+           << ", \"children\": [";
+    for (size_t i = 0; i < children[index].size(); ++i) {
+      output << (i > 0 ? ",\n" : "\n");
+      self(self, children[index][i], indent + 2);
+    }
+    if (not children[index].empty())
+      output << '\n' << pad;
+    output << "]}";
+  };
+
+  output << "{\"scopes\": [";
+  for (size_t i = 0; i < roots.size(); ++i) {
+    output << (i > 0 ? ",\n" : "\n");
+    write(write, roots[i], 2);
+  }
+  output << "\n]}\n";
+}
+
+void Profiler::SaveChromeTrace(std::ostream &output) {
+  auto &registry = GetRegistry();
+  std::lock_guard lock{registry.mutex};
+
+  bool first = true;
+  output << "{\"traceEvents\": [";
+  for (auto &thread : registry.threads) {
+    for (auto const &event : thread->events) {
+      output << (first ? "\n" : ",\n");
+      first = false;
+
+      // timestamps are given in microseconds
+      output << "{\"name\": ";
+      WriteJSONString(output, thread->nodes[event.node].name);
+      output << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << thread->thread_index
+             << ", \"ts\": " << static_cast<double>(event.begin_ns) * 1e-3
+             << ", \"dur\": "
+             << static_cast<double>(event.end_ns - event.begin_ns) * 1e-3
+             << "}";
+    }
+  }
+
+  uint64_t dropped_events = 0;
+  for (auto &thread : registry.threads)
+    dropped_events += thread->dropped_events;
+
+  output << "\n], \"displayTimeUnit\": \"ms\", \"otherData\": "
+         << "{\"dropped_events\": " << dropped_events << "}}\n";
+}
+
+} // namespace prtcl
@@ -0,0 +1,135 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_PROFILER_HPP
+#define PRTCL_SRC_PRTCL_UTIL_PROFILER_HPP
+
+#include <atomic>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace prtcl {
+
+//! Statistics of one scope of the profile, merged over all threads.
+struct ProfileNode {
+  std::string name;
+  //! Names of all enclosing scopes and this scope, separated by '/'.
+  std::string path;
+  size_t depth;
+  //! Index of the enclosing node, the root scopes have none.
+  std::optional<size_t> parent;
+
+  //! Number of times the scope was entered (by any thread).
+  uint64_t count;
+  //! Time spent in the scope, summed over all threads.
+  double total_seconds;
+  //! Shortest and longest time of a single entry.
+  double min_seconds;
+  double max_seconds;
+
+  //! Number of threads that entered the scope and the mean and largest time
+  //! a single thread spent in it.  For scopes inside parallel regions, a
+  //! large ratio of max to mean indicates load imbalance.
+  size_t thread_count;
+  double mean_thread_seconds;
+  double max_thread_seconds;
+};
+
+//! Process wide hierarchical profiler.
+//!
+//! Scopes (see ProfileScope and PRTCL_PROFILE_SCOPE) form a tree per thread,
+//! each node accumulates the time spent in the scope.  Disabled scopes only
+//! cost a relaxed atomic load; defining PRTCL_DISABLE_PROFILER removes them
+//! altogether.  Optionally, the individual scopes are recorded for a trace in
+//! the Chrome trace event format.
+//!
+//! The profile must only be reset or queried while no profiled code runs.
+class Profiler {
+public:
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  static void SetEnabled(bool value) {
+    enabled_.store(value, std::memory_order_relaxed);
+  }
+
+  //! Sets the number of scopes that are recorded per thread for the trace,
+  //! zero (the default) disables the trace.
+  static void SetTraceCapacity(size_t capacity);
+
+  //! Clears all statistics and recorded scopes.
+  static void Reset();
+
+public:
+  //! Returns the merged profile in depth first order.
+  static std::vector<ProfileNode> GetNodes();
+
+  //! Writes the merged profile as nested JSON objects.
+  static void SaveJSON(std::ostream &output);
+
+  //! Writes the recorded scopes in the Chrome trace event format (to be
+  //! opened with chrome://tracing or Perfetto).
+  static void SaveChromeTrace(std::ostream &output);
+
+public:
+  //! Enters the scope name on this thread.  Scopes are looked up by the
+  //! address of name first, which should thus be stable (e.g. a literal).
+  static void Begin(char const *name);
+
+  //! Leaves the innermost scope of this thread.
+  static void End();
+
+private:
+  inline static std::atomic<bool> enabled_ = false;
+};
+
+//! Times its own lifetime if the Profiler is enabled on construction.
+class ProfileScope {
+public:
+  explicit ProfileScope(char const *name) : active_{Profiler::IsEnabled()} {
+    if (active_)
+      Profiler::Begin(name);
+  }
+
+  ~ProfileScope() {
+    if (active_)
+      Profiler::End();
+  }
+
+  ProfileScope(ProfileScope const &) = delete;
+  ProfileScope &operator=(ProfileScope const &) = delete;
+
+private:
+  bool active_;
+};
+
+} // namespace prtcl
+
+#define PRTCL_PROFILE_CONCAT_IMPL(lhs_, rhs_) lhs_##rhs_
+#define PRTCL_PROFILE_CONCAT(lhs_, rhs_) PRTCL_PROFILE_CONCAT_IMPL(lhs_, rhs_)
+
+#ifndef PRTCL_DISABLE_PROFILER
+
+//! Profiles the rest of the enclosing block.
+#define PRTCL_PROFILE_SCOPE(name_)                                             \
+  ::prtcl::ProfileScope PRTCL_PROFILE_CONCAT(prtcl_profile_scope_, __LINE__) { \
+    name_                                                                      \
+  }
+
+//! An OpenMP barrier whose waiting time is profiled per thread, which
+//! measures the load imbalance of the preceding nowait work sharing loop.
+#define PRTCL_PROFILE_BARRIER()                                                \
+  {                                                                            \
+    PRTCL_PROFILE_SCOPE("barrier");                                            \
+    _Pragma("omp barrier")                                                     \
+  }
+
+#else
+
+#define PRTCL_PROFILE_SCOPE(name_)
+#define PRTCL_PROFILE_BARRIER() _Pragma("omp barrier")
+
+#endif
+
+#endif // PRTCL_SRC_PRTCL_UTIL_PROFILER_HPP
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <prtcl/schemes/scheme_base.hpp>
+#include <prtcl/util/profiler.hpp>
+
+#include <sstream>
+#include <string>
+
+namespace {
+
+template <char Name>
+class NamedScheme : public prtcl::SchemeBase {
+public:
+  NamedScheme() { this->RegisterProcedure("step", &NamedScheme::step); }
+
+  std::string GetFullName() const override { return {Name}; }
+
+  void Load(prtcl::Model &) override {}
+
+  std::string_view GetPrtclSourceCode() const override { return {}; }
+
+private:
+  void step(prtcl::Neighborhood const &) {}
+};
+
+TEST(Profiler, NestedScopes) {
+  using prtcl::Profiler;
+
+  Profiler::SetEnabled(true);
+  Profiler::Reset();
+
+  for (int i = 0; i < 3; ++i) {
+    PRTCL_PROFILE_SCOPE("outer");
+    { PRTCL_PROFILE_SCOPE("inner"); }
+    { PRTCL_PROFILE_SCOPE("inner"); }
+  }
+
+  Profiler::SetEnabled(false);
+  { PRTCL_PROFILE_SCOPE("outer"); }
+
+  auto const nodes = Profiler::GetNodes();
+
+  size_t outer = nodes.size(), inner = nodes.size();
+  for (size_t index = 0; index < nodes.size(); ++index) {
+    if (nodes[index].path == "outer")
+      outer = index;
+    if (nodes[index].path == "outer/inner")
+      inner = index;
+  }
+  ASSERT_LT(outer, nodes.size());
+  ASSERT_LT(inner, nodes.size());
+
+  EXPECT_FALSE(nodes[outer].parent.has_value());
+  EXPECT_EQ(nodes[outer].count, 3);
+  EXPECT_EQ(nodes[outer].thread_count, 1);
+  EXPECT_EQ(nodes[outer].depth, 0);
+
+  ASSERT_TRUE(nodes[inner].parent.has_value());
+  EXPECT_EQ(*nodes[inner].parent, outer);
+  EXPECT_EQ(nodes[inner].count, 6);
+  EXPECT_EQ(nodes[inner].depth, 1);
+  EXPECT_LE(nodes[inner].total_seconds, nodes[outer].total_seconds);
+  EXPECT_LE(nodes[inner].min_seconds, nodes[inner].max_seconds);
+
+  Profiler::Reset();
+  for (auto const &node : Profiler::GetNodes())
+    EXPECT_EQ(node.count, 0);
+}
+
+TEST(Profiler, Output) {
+  using prtcl::Profiler;
+
+  Profiler::SetEnabled(true);
+  Profiler::Reset();
+  Profiler::SetTraceCapacity(4);
+
+  for (int i = 0; i < 3; ++i) {
+    PRTCL_PROFILE_SCOPE("step \"quoted\"");
+  }
+
+  Profiler::SetEnabled(false);
+
+  std::ostringstream json;
+  Profiler::SaveJSON(json);
+  EXPECT_NE(json.str().find("\"name\": \"step \\\"quoted\\\"\""),
+            std::string::npos);
+  EXPECT_NE(json.str().find("\"count\": 3"), std::string::npos);
+
+  std::ostringstream trace;
+  Profiler::SaveChromeTrace(trace);
+  EXPECT_NE(trace.str().find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(trace.str().find("\"ph\": \"X\""), std::string::npos);
+
+  Profiler::SetTraceCapacity(0);
+  Profiler::Reset();
+}
+
+TEST(Profiler, SchemeProcedures) {
+  using prtcl::Profiler;
+
+  Profiler::SetEnabled(true);
+  Profiler::Reset();
+
+  // procedures of the same name in different schemes are profiled apart
+  prtcl::Neighborhood nhood;
+  NamedScheme<'a'> a;
+  NamedScheme<'b'> b;
+  a.RunProcedure("step", nhood);
+  b.RunProcedure("step", nhood);
+  b.RunProcedure("step", nhood);
+
+  Profiler::SetEnabled(false);
+
+  size_t a_count = 0, b_count = 0;
+  for (auto const &node : Profiler::GetNodes()) {
+    if (node.path == "a::step")
+      a_count = node.count;
+    if (node.path == "b::step")
+      b_count = node.count;
+  }
+  EXPECT_EQ(a_count, 1);
+  EXPECT_EQ(b_count, 2);
+
+  Profiler::Reset();
+}
+
+} // namespace
@@ -16,7 +16,9 @@ void WriteVFS(std::ostream &o, VaryingFieldSpan<T> const &v) {
 }
 
 template <typename T, size_t N>
-void WriteVFS(std::ostream &o, VaryingFieldSpan<T, N> const &v) {
+void WriteVFS(
+    std::ostream &o, VaryingFieldSpan<T, N> const &v,
+    cxx::span<double const> origin) {
   auto const comp_n = static_cast<math::Index>(N);
 
   for (size_t item_i = 0; item_i < v.GetSize(); ++item_i) {
@@ -24,7 +26,12 @@ void WriteVFS(std::ostream &o, VaryingFieldSpan<T, N> const &v) {
     for (math::Index comp_i = 0; comp_i < comp_n; ++comp_i) {
       if (comp_i > 0)
         o << ' ';
-      o << std::fixed << item[comp_i];
+      if (origin.empty())
+        o << std::fixed << item[comp_i];
+      else
+        o << std::fixed
+          << static_cast<double>(item[comp_i]) +
+                 origin[static_cast<size_t>(comp_i)];
     }
     o << '\n';
   }
@@ -32,22 +39,25 @@ void WriteVFS(std::ostream &o, VaryingFieldSpan<T, N> const &v) {
 
 void WriteField(
     std::ostream &o, VaryingManager const &varying, std::string_view name) {
+  // items stored relative to an origin are written as absolute values
+  auto const origin = varying.GetFieldOrigin(name);
+
   if (auto field = varying.FieldSpan<float>(name))
     return WriteVFS(o, field);
   if (auto field = varying.FieldSpan<float, 1>(name))
-    return WriteVFS(o, field);
+    return WriteVFS(o, field, origin);
   if (auto field = varying.FieldSpan<float, 2>(name))
-    return WriteVFS(o, field);
+    return WriteVFS(o, field, origin);
   if (auto field = varying.FieldSpan<float, 3>(name))
-    return WriteVFS(o, field);
+    return WriteVFS(o, field, origin);
   if (auto field = varying.FieldSpan<double>(name))
     return WriteVFS(o, field);
   if (auto field = varying.FieldSpan<double, 1>(name))
-    return WriteVFS(o, field);
+    return WriteVFS(o, field, origin);
   if (auto field = varying.FieldSpan<double, 2>(name))
-    return WriteVFS(o, field);
+    return WriteVFS(o, field, origin);
   if (auto field = varying.FieldSpan<double, 3>(name))
-    return WriteVFS(o, field);
+    return WriteVFS(o, field, origin);
 
   throw NotImplementedError{};
 }
@@ -3,16 +3,29 @@
 
 #include "virtual_clock.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
 #include <variant>
+#include <vector>
 
-#include <boost/container/flat_map.hpp>
-
-#include <boost/range/adaptor/map.hpp>
-#include <boost/range/adaptor/reversed.hpp>
+#include <cstddef>
+#include <cstdint>
 
 namespace prtcl {
 
+//! Invokes callbacks (tasks) once their time has come on a clock.
+//!
+//! The due times are kept in a binary min-heap, so scheduling is logarithmic
+//! in the number of tasks.  Canceled and moved tasks leave stale heap entries
+//! behind that are skipped when they surface and dropped in bulk once they
+//! make up most of the heap.  Each task owns a slot that is stable across
+//! reschedules and is referred to by a TaskHandle.
 template <typename Clock>
 class Scheduler {
 public:
@@ -49,12 +62,71 @@ public:
   // callback(self, too_late)
   using CallbackSignature = CallbackReturnType(Scheduler &, Duration);
 
+  //! Selects how Tick dispatches a task.
+  enum class Dispatch {
+    //! The task runs alone, the serial tasks of a tick run in the order of
+    //! their due times.
+    kSerial,
+    //! The task is independent of all other parallel tasks, those that are
+    //! due in the same tick run concurrently after all serial tasks.  They
+    //! may schedule and cancel tasks, but must not tick the scheduler.  Not
+    //! for Lua callbacks, which must not run concurrently on one Lua state.
+    kParallel,
+  };
+
+  //! Refers to a scheduled task across its reschedules, until the task
+  //! finishes (returns DoNothing) or is canceled.
+  class TaskHandle {
+  public:
+    TaskHandle() = default;
+
+  private:
+    TaskHandle(size_t slot, uint64_t generation)
+        : slot_{slot}, generation_{generation} {}
+
+    friend class Scheduler;
+
+    size_t slot_ = std::numeric_limits<size_t>::max();
+    uint64_t generation_ = 0;
+  };
+
 private:
   using CallbackType = std::function<CallbackSignature>;
 
-private:
-  using ScheduleMapType = boost::container::flat_multimap<
-      TimePoint, CallbackType, std::greater<TimePoint>>;
+  struct Slot {
+    CallbackType callback;
+    Dispatch dispatch = Dispatch::kSerial;
+    bool used = false;
+    //! Incremented whenever the task of this slot finishes or is canceled.
+    uint64_t generation = 0;
+    //! Sequence number of the live heap entry, zero if there is none.
+    uint64_t sequence = 0;
+  };
+
+  struct Entry {
+    TimePoint when;
+    //! Breaks ties between equal due times in scheduling order.
+    uint64_t sequence;
+    size_t slot;
+  };
+
+  //! Orders the heap by due time, earliest first.
+  struct EntryIsLater {
+    bool operator()(Entry const &lhs, Entry const &rhs) const {
+      return std::tie(lhs.when, lhs.sequence) >
+             std::tie(rhs.when, rhs.sequence);
+    }
+  };
+
+  struct DueTask {
+    TimePoint when;
+    size_t slot;
+    uint64_t generation;
+    Dispatch dispatch;
+    CallbackType callback;
+    CallbackReturnType result;
+    bool ran = false;
+  };
 
 public:
   Scheduler() : Scheduler(std::make_shared<ClockType>()) {}
@@ -71,71 +143,280 @@ public:
 
 public:
   template <typename Callback_>
-  auto &ScheduleAt(TimePoint after_, Callback_ &&callback_) {
-    using result_type =
-        decltype(std::forward<Callback_>(callback_)(*this, Duration{}));
-    // depending on the result type of the callback ...
-    if constexpr (std::is_same<result_type, void>::value)
-      // ... schedule a callback that does not reschedule
-      schedule_.emplace(
-          after_, CallbackType{[callback = std::forward<Callback_>(callback_)](
-                                   auto &s, auto d) {
-            callback(s, d);
-            return s.do_nothing();
-          }});
-    else
-      // ... simply schedule the callback
-      schedule_.emplace(
-          after_, CallbackType{std::forward<Callback_>(callback_)});
-    return *this;
+  TaskHandle ScheduleAt(
+      TimePoint when_, Callback_ &&callback_,
+      Dispatch dispatch_ = Dispatch::kSerial) {
+    auto callback = MakeCallback(std::forward<Callback_>(callback_));
+    std::lock_guard lock{mutex_};
+    auto const slot = AcquireSlot();
+    slots_[slot].callback = std::move(callback);
+    slots_[slot].dispatch = dispatch_;
+    Push(slot, when_);
+    return {slot, slots_[slot].generation};
   }
 
   template <typename Callback_>
-  auto &ScheduleAfter(Duration after_, Callback_ &&callback_) {
+  TaskHandle ScheduleAfter(
+      Duration after_, Callback_ &&callback_,
+      Dispatch dispatch_ = Dispatch::kSerial) {
     return ScheduleAt(
-        clock_->now() + after_, std::forward<Callback_>(callback_));
+        clock_->now() + after_, std::forward<Callback_>(callback_), dispatch_);
   }
 
 public:
+  //! Removes the task from the schedule, returns false if it had already
+  //! finished or was canceled.  A task that cancels itself while it runs is
+  //! not rescheduled.
+  bool Cancel(TaskHandle const &handle) {
+    std::lock_guard lock{mutex_};
+    if (not IsValid(handle))
+      return false;
+    if (slots_[handle.slot_].sequence != 0)
+      ++stale_count_;
+    ReleaseSlot(handle.slot_);
+    return true;
+  }
+
+  //! Moves the task to a new due time, returns false if it had already
+  //! finished or was canceled.  Overrides the result of a running task.
+  bool Reschedule(TaskHandle const &handle, TimePoint when) {
+    std::lock_guard lock{mutex_};
+    if (not IsValid(handle))
+      return false;
+    if (slots_[handle.slot_].sequence != 0)
+      ++stale_count_;
+    Push(handle.slot_, when);
+    return true;
+  }
+
+  bool IsScheduled(TaskHandle const &handle) const {
+    std::lock_guard lock{mutex_};
+    return IsValid(handle);
+  }
+
+  //! Number of tasks that have neither finished nor been canceled.
+  size_t GetTaskCount() const {
+    std::lock_guard lock{mutex_};
+    return slots_.size() - free_slots_.size();
+  }
+
+  //! Returns the earliest due time of all scheduled tasks.
+  std::optional<TimePoint> GetNextTime() {
+    std::lock_guard lock{mutex_};
+    DropStaleTop();
+    if (heap_.empty())
+      return std::nullopt;
+    return heap_.front().when;
+  }
+
+public:
+  //! Invokes all tasks that are due at the current time in one batch.  The
+  //! tasks that are rescheduled by their result are due again at the
+  //! earliest in the next tick.  If a task throws, it is finished, the tasks
+  //! of the batch that did not run stay due and the exception is rethrown.
   void Tick() {
-    auto now = clock_->now();
-    auto first = schedule_.lower_bound(now);
-    auto range = boost::make_iterator_range(first, schedule_.end());
-    // call all scheduled callbacks
-    for (auto &[when, callback] : range | boost::adaptors::reversed) {
-      // invoke the callback
-      auto result = callback(*this, now - when);
-      // depending on the result, either ...
-      if (auto *noop = std::get_if<DoNothingType>(&result))
-        // ... do nothing
+    auto const now = clock_->now();
+
+    // take the callbacks of all due tasks out of their slots, so that tasks
+    // can be scheduled and canceled while the batch runs
+    std::vector<DueTask> due;
+    {
+      std::lock_guard lock{mutex_};
+      for (DropStaleTop(); not heap_.empty() and heap_.front().when <= now;
+           DropStaleTop()) {
+        auto const entry = PopTop();
+        auto &slot = slots_[entry.slot];
+        slot.sequence = 0;
+        due.push_back(
+            {entry.when, entry.slot, slot.generation, slot.dispatch,
+             std::move(slot.callback), DoNothing()});
+      }
+    }
+
+    try {
+      bool has_parallel = false;
+      for (auto &task : due) {
+        if (task.dispatch != Dispatch::kSerial)
+          has_parallel = true;
+        else
+          Run(task, now);
+      }
+
+      if (has_parallel) {
+        std::exception_ptr error;
+        using task_index_t = std::ptrdiff_t;
+        auto const task_count = static_cast<task_index_t>(due.size());
+#pragma omp parallel for schedule(dynamic, 1)
+        for (task_index_t i = 0; i < task_count; ++i) {
+          auto &task = due[static_cast<size_t>(i)];
+          if (task.dispatch != Dispatch::kParallel)
+            continue;
+          // exceptions must not escape the parallel region
+          try {
+            Run(task, now);
+          } catch (...) {
+#pragma omp critical(prtcl_scheduler_error)
+            if (not error)
+              error = std::current_exception();
+          }
+        }
+        if (error)
+          std::rethrow_exception(error);
+      }
+    } catch (...) {
+      FinishBatch(due, now);
+      throw;
+    }
+
+    FinishBatch(due, now);
+  }
+
+public:
+  void Clear() {
+    std::lock_guard lock{mutex_};
+    for (size_t slot = 0; slot < slots_.size(); ++slot)
+      if (slots_[slot].used)
+        ReleaseSlot(slot);
+    heap_.clear();
+    stale_count_ = 0;
+  }
+
+private:
+  template <typename Callback_>
+  static CallbackType MakeCallback(Callback_ &&callback_) {
+    using result_type =
+        decltype(std::declval<std::decay_t<Callback_> &>()(
+            std::declval<Scheduler &>(), Duration{}));
+    // depending on the result type of the callback ...
+    if constexpr (std::is_same<result_type, void>::value)
+      // ... wrap a callback that does not reschedule
+      return CallbackType{[callback = std::forward<Callback_>(callback_)](
+                              auto &s, auto d) mutable {
+        callback(s, d);
+        return s.DoNothing();
+      }};
+    else
+      // ... simply use the callback
+      return CallbackType{std::forward<Callback_>(callback_)};
+  }
+
+  //! Invokes the callback of the task unless it was canceled.
+  void Run(DueTask &task, TimePoint now) {
+    // a task that throws is finished (its result stays DoNothing)
+    task.ran = true;
+    if (not IsCanceled(task))
+      task.result = task.callback(*this, now - task.when);
+  }
+
+  //! Returns the callbacks of the batch to their slots or releases the slots.
+  void FinishBatch(std::vector<DueTask> &due, TimePoint now) {
+    std::lock_guard lock{mutex_};
+    for (auto &task : due) {
+      auto &slot = slots_[task.slot];
+      // ... the task was canceled while the batch ran
+      if (slot.generation != task.generation)
         continue;
-      else if (auto *raf = std::get_if<RescheduleAfterType>(&result))
+      slot.callback = std::move(task.callback);
+      // ... the task was moved by Reschedule while the batch ran
+      if (slot.sequence != 0)
+        continue;
+      // ... the batch was aborted before the task ran, it stays due
+      if (not task.ran)
+        Push(task.slot, task.when);
+      // ... depending on the result, either ...
+      else if (std::get_if<DoNothingType>(&task.result))
+        // ... finish the task
+        ReleaseSlot(task.slot);
+      else if (auto *raf = std::get_if<RescheduleAfterType>(&task.result))
         // ... reschedule after the specified amount of time
-        next_schedule_.emplace(now + raf->after, callback);
-      else if (auto *rat = std::get_if<RescheduleAtType>(&result))
+        Push(task.slot, now + raf->after);
+      else if (auto *rat = std::get_if<RescheduleAtType>(&task.result))
         // ... reschedule at the specified time point
-        next_schedule_.emplace(rat->when, callback);
+        Push(task.slot, rat->when);
       else
         throw "internal error: callback return type not implemented";
     }
-    // remove the callbacks we just invoked
-    schedule_.erase(first, schedule_.end());
-    // merge the next ScheduleAt
-    schedule_.merge(next_schedule_);
-    next_schedule_.clear();
   }
 
-public:
-  void Clear() {
-    schedule_.clear();
-    next_schedule_.clear();
+  //! Returns true if the task was canceled by a task that ran before it in
+  //! the same tick.
+  bool IsCanceled(DueTask const &task) const {
+    std::lock_guard lock{mutex_};
+    return slots_[task.slot].generation != task.generation;
+  }
+
+  bool IsValid(TaskHandle const &handle) const {
+    return handle.slot_ < slots_.size() and
+           slots_[handle.slot_].used and
+           slots_[handle.slot_].generation == handle.generation_;
+  }
+
+  size_t AcquireSlot() {
+    size_t slot;
+    if (free_slots_.empty()) {
+      slot = slots_.size();
+      slots_.emplace_back();
+    } else {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+    }
+    slots_[slot].used = true;
+    return slot;
+  }
+
+  void ReleaseSlot(size_t slot) {
+    auto &s = slots_[slot];
+    s.callback = nullptr;
+    s.used = false;
+    s.sequence = 0;
+    ++s.generation;
+    free_slots_.push_back(slot);
+  }
+
+  void Push(size_t slot, TimePoint when) {
+    slots_[slot].sequence = ++sequence_;
+    heap_.push_back({when, sequence_, slot});
+    std::push_heap(heap_.begin(), heap_.end(), EntryIsLater{});
+    // drop the stale entries once they make up most of the heap
+    if (stale_count_ > 64 and 2 * stale_count_ > heap_.size()) {
+      heap_.erase(
+          std::remove_if(
+              heap_.begin(), heap_.end(),
+              [this](auto const &e) { return IsStale(e); }),
+          heap_.end());
+      std::make_heap(heap_.begin(), heap_.end(), EntryIsLater{});
+      stale_count_ = 0;
+    }
+  }
+
+  Entry PopTop() {
+    std::pop_heap(heap_.begin(), heap_.end(), EntryIsLater{});
+    auto const entry = heap_.back();
+    heap_.pop_back();
+    return entry;
+  }
+
+  bool IsStale(Entry const &entry) const {
+    return slots_[entry.slot].sequence != entry.sequence;
+  }
+
+  void DropStaleTop() {
+    while (not heap_.empty() and IsStale(heap_.front())) {
+      PopTop();
+      --stale_count_;
+    }
   }
 
 private:
   std::shared_ptr<ClockType> clock_;
 
-  ScheduleMapType schedule_;
-  ScheduleMapType next_schedule_;
+  std::vector<Entry> heap_;
+  std::vector<Slot> slots_;
+  std::vector<size_t> free_slots_;
+  size_t stale_count_ = 0;
+  uint64_t sequence_ = 0;
+
+  mutable std::mutex mutex_;
 };
 
 using VirtualScheduler = Scheduler<VirtualClock>;
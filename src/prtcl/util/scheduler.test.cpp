@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include "scheduler.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace prtcl;
+
+namespace {
+
+using Duration = VirtualScheduler::Duration;
+using TimePoint = VirtualScheduler::TimePoint;
+
+void Step(VirtualScheduler &scheduler, double dt) {
+  scheduler.GetClockPtr()->advance(dt);
+  scheduler.Tick();
+}
+
+} // namespace
+
+TEST(Scheduler, OrderAndReschedule) {
+  VirtualScheduler scheduler;
+  std::vector<int> calls;
+
+  // scheduled out of order, due at 0.2, 0.1 and 0.1
+  scheduler.ScheduleAt(TimePoint{Duration{0.2}}, [&](auto &, auto) {
+    calls.push_back(2);
+  });
+  scheduler.ScheduleAt(TimePoint{Duration{0.1}}, [&](auto &, auto) {
+    calls.push_back(0);
+  });
+  int repeats = 0;
+  scheduler.ScheduleAfter(Duration{0.1}, [&](auto &s, auto) {
+    calls.push_back(1);
+    // rescheduled tasks do not run twice in one tick
+    return ++repeats < 3 ? s.RescheduleAfter(0.0) : s.DoNothing();
+  });
+  EXPECT_EQ(scheduler.GetTaskCount(), 3);
+  EXPECT_EQ(scheduler.GetNextTime(), TimePoint{Duration{0.1}});
+
+  Step(scheduler, 0.05);
+  EXPECT_TRUE(calls.empty());
+  Step(scheduler, 0.1);
+  EXPECT_EQ(calls, (std::vector<int>{0, 1}));
+  Step(scheduler, 0.1);
+  EXPECT_EQ(calls, (std::vector<int>{0, 1, 1, 2}));
+  Step(scheduler, 0.0);
+  EXPECT_EQ(calls, (std::vector<int>{0, 1, 1, 2, 1}));
+  Step(scheduler, 0.0);
+  EXPECT_EQ(calls.size(), 5);
+  EXPECT_EQ(scheduler.GetTaskCount(), 0);
+  EXPECT_FALSE(scheduler.GetNextTime().has_value());
+}
+
+TEST(Scheduler, CancelAndMove) {
+  VirtualScheduler scheduler;
+  std::vector<size_t> calls(100, 0);
+
+  std::vector<VirtualScheduler::TaskHandle> handles;
+  for (size_t i = 0; i < calls.size(); ++i)
+    handles.push_back(
+        scheduler.ScheduleAfter(Duration{0.1}, [&calls, i](auto &s, auto) {
+          ++calls[i];
+          return s.RescheduleAfter(0.1);
+        }));
+
+  // cancel the even and move the odd tasks repeatedly, which leaves many
+  // stale entries behind
+  for (size_t i = 0; i < calls.size(); ++i) {
+    if (i % 2 == 0)
+      EXPECT_TRUE(scheduler.Cancel(handles[i]));
+    else
+      for (size_t k = 0; k < 10; ++k)
+        EXPECT_TRUE(scheduler.Reschedule(
+            handles[i],
+            TimePoint{Duration{0.3 - 0.01 * static_cast<double>(k)}}));
+  }
+  EXPECT_FALSE(scheduler.Cancel(handles[0]));
+  EXPECT_FALSE(scheduler.IsScheduled(handles[0]));
+  EXPECT_TRUE(scheduler.IsScheduled(handles[1]));
+  EXPECT_EQ(scheduler.GetTaskCount(), 50);
+  EXPECT_EQ(scheduler.GetNextTime(), TimePoint{Duration{0.21}});
+
+  Step(scheduler, 0.15);
+  Step(scheduler, 0.1);
+  for (size_t i = 0; i < calls.size(); ++i)
+    EXPECT_EQ(calls[i], i % 2) << i;
+
+  // tasks that are canceled by an earlier task of the same tick do not run
+  scheduler.ScheduleAfter(Duration{0.0}, [&handles](auto &s, auto) {
+    s.Cancel(handles[1]);
+  });
+  Step(scheduler, 0.1);
+  EXPECT_EQ(calls[1], 1);
+  EXPECT_EQ(calls[3], 2);
+  EXPECT_FALSE(scheduler.IsScheduled(handles[1]));
+  EXPECT_EQ(scheduler.GetTaskCount(), 49);
+
+  scheduler.Clear();
+  EXPECT_FALSE(scheduler.IsScheduled(handles[3]));
+  EXPECT_EQ(scheduler.GetTaskCount(), 0);
+}
+
+TEST(Scheduler, ParallelDispatch) {
+  VirtualScheduler scheduler;
+  std::atomic<size_t> parallel_calls = 0;
+  size_t serial_calls = 0, parallel_calls_seen = 0;
+
+  for (size_t i = 0; i < 64; ++i)
+    scheduler.ScheduleAfter(
+        Duration{0.1},
+        [&](auto &s, auto) {
+          // parallel tasks may schedule new tasks
+          if (++parallel_calls == 64)
+            s.ScheduleAfter(Duration{0.0}, [&](auto &, auto) {});
+          return s.RescheduleAfter(0.1);
+        },
+        VirtualScheduler::Dispatch::kParallel);
+  scheduler.ScheduleAfter(Duration{0.1}, [&](auto &s, auto) {
+    // all serial tasks run before the parallel ones
+    ++serial_calls;
+    parallel_calls_seen = parallel_calls;
+    return s.RescheduleAfter(0.1);
+  });
+
+  Step(scheduler, 0.1);
+  EXPECT_EQ(parallel_calls.load(), 64);
+  EXPECT_EQ(serial_calls, 1);
+  EXPECT_EQ(parallel_calls_seen, 0);
+  EXPECT_EQ(scheduler.GetTaskCount(), 66);
+
+  Step(scheduler, 0.1);
+  EXPECT_EQ(parallel_calls.load(), 128);
+  EXPECT_EQ(serial_calls, 2);
+  EXPECT_EQ(scheduler.GetTaskCount(), 65);
+}
+
+TEST(Scheduler, ThrowingTask) {
+  VirtualScheduler scheduler;
+  size_t calls = 0;
+
+  auto before = scheduler.ScheduleAfter(Duration{0.1}, [&](auto &s, auto) {
+    ++calls;
+    return s.RescheduleAfter(0.1);
+  });
+  auto throwing = scheduler.ScheduleAfter(
+      Duration{0.2}, [&](auto &, auto) { throw std::runtime_error{"task"}; });
+  auto after = scheduler.ScheduleAfter(Duration{0.3}, [&](auto &, auto) {
+    ++calls;
+  });
+
+  scheduler.GetClockPtr()->advance(0.3);
+  EXPECT_THROW(scheduler.Tick(), std::runtime_error);
+  EXPECT_EQ(calls, 1);
+
+  // the task that threw is finished, the others are kept
+  EXPECT_TRUE(scheduler.IsScheduled(before));
+  EXPECT_FALSE(scheduler.IsScheduled(throwing));
+  EXPECT_TRUE(scheduler.IsScheduled(after));
+
+  // the task that did not run is still due
+  scheduler.Tick();
+  EXPECT_EQ(calls, 2);
+  EXPECT_FALSE(scheduler.IsScheduled(after));
+  EXPECT_EQ(scheduler.GetTaskCount(), 1);
+}
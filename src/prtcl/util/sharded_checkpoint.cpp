@@ -0,0 +1,404 @@
+#include "sharded_checkpoint.hpp"
+
+#include "../errors/invalid_archive_error.hpp"
+#include "../log.hpp"
+#include "archive.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+#include <boost/range/numeric.hpp>
+
+namespace prtcl {
+
+namespace {
+
+constexpr std::string_view kMagic = "PRTCLSHC";
+constexpr size_t kVersion = 1;
+
+constexpr std::string_view kManifestName = "manifest.bin";
+constexpr std::string_view kManifestTempName = "manifest.bin.tmp";
+
+//! Returns a token that makes the shard names of this save unique, such that
+//! the shards of a previous save are never overwritten.
+std::string MakeSaveToken() {
+  auto const now = std::chrono::system_clock::now().time_since_epoch();
+  std::ostringstream token;
+  token << std::hex
+        << std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  return token.str();
+}
+
+//! Returns the shard file names referenced by the manifest at path, or none
+//! if there is no valid manifest.
+std::vector<std::string> LoadShardNames(std::filesystem::path const &path) {
+  std::ifstream manifest{path, std::ios::binary};
+  if (not manifest)
+    return {};
+
+  std::string magic(kMagic.size(), '@');
+  manifest.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+  if (not manifest or magic != kMagic)
+    return {};
+
+  NativeBinaryArchiveReader archive{manifest};
+  if (archive.LoadSize() != kVersion)
+    return {};
+
+  auto skip_uniform_fields = [&archive] {
+    size_t const field_count = archive.LoadSize();
+    for (size_t field_index = 0; field_index < field_count; ++field_index) {
+      archive.LoadString();
+      TensorType type;
+      type.Load(archive);
+      UniformField::Skip(archive, type);
+    }
+  };
+
+  std::vector<std::string> names;
+  try {
+    skip_uniform_fields();
+
+    size_t const group_count = archive.LoadSize();
+    for (size_t group_index = 0; group_index < group_count and manifest;
+         ++group_index) {
+      archive.LoadString(); // name
+      archive.LoadString(); // type
+
+      size_t const tag_count = archive.LoadSize();
+      for (size_t tag_index = 0; tag_index < tag_count and manifest;
+           ++tag_index)
+        archive.LoadString();
+
+      archive.LoadSize(); // item count
+      skip_uniform_fields();
+
+      size_t const field_count = archive.LoadSize();
+      for (size_t field_index = 0; field_index < field_count and manifest;
+           ++field_index) {
+        archive.LoadString();
+        TensorType type;
+        type.Load(archive);
+      }
+
+      size_t const shard_count = archive.LoadSize();
+      for (size_t shard = 0; shard < shard_count and manifest; ++shard) {
+        names.push_back(archive.LoadString());
+        archive.LoadSize(); // first
+        archive.LoadSize(); // count
+      }
+    }
+  } catch (...) {
+    return {};
+  }
+
+  if (not manifest)
+    return {};
+  return names;
+}
+
+//! Removes the shards of the previous manifest that the new one does not
+//! reference.  Other files in the directory are never touched.
+void RemoveUnreferencedShards(
+    std::filesystem::path const &directory,
+    std::vector<std::string> const &previous,
+    std::vector<std::string> const &referenced) {
+  namespace fs = std::filesystem;
+
+  std::error_code ec;
+  for (auto const &name : previous) {
+    // only plain file names inside the directory
+    if (fs::path{name}.filename() != fs::path{name})
+      continue;
+    if (std::find(referenced.begin(), referenced.end(), name) ==
+        referenced.end())
+      fs::remove(directory / name, ec);
+  }
+}
+
+struct ShardTask {
+  std::string path;
+  size_t first;
+  size_t count;
+  // the fields of the group, nullopt for fields that are skipped on loading
+  std::vector<std::optional<VaryingField>> const *fields;
+  std::vector<TensorType> const *types;
+};
+
+template <typename Function_>
+void RunShardTasks(std::vector<ShardTask> const &tasks, Function_ &&function) {
+  std::atomic<bool> failed = false;
+
+  using task_index_t = std::ptrdiff_t;
+#pragma omp parallel for schedule(dynamic)
+  for (task_index_t i = 0; i < static_cast<task_index_t>(tasks.size()); ++i) {
+    // exceptions must not escape the parallel region
+    try {
+      if (not function(tasks[static_cast<size_t>(i)]))
+        failed = true;
+    } catch (...) {
+      failed = true;
+    }
+  }
+
+  if (failed)
+    throw InvalidArchiveError{};
+}
+
+template <typename Add_>
+void LoadUniformFields(
+    ArchiveReader &archive, FieldFilter const &filter, FieldKind kind,
+    Group const *group, Add_ &&add) {
+  size_t const field_count = archive.LoadSize();
+  for (size_t field_index = 0; field_index < field_count; ++field_index) {
+    auto const name = archive.LoadString();
+
+    TensorType type;
+    type.Load(archive);
+
+    if (filter.Selects(kind, name, group))
+      add(name, type).Load(archive);
+    else
+      UniformField::Skip(archive, type);
+  }
+}
+
+} // namespace
+
+void SaveShardedCheckpoint(
+    Model const &model, std::string const &directory, size_t max_shard_size,
+    FieldFilter const &filter) {
+  namespace fs = std::filesystem;
+
+  fs::create_directories(directory);
+  max_shard_size = std::max<size_t>(1, max_shard_size);
+
+  auto const token = MakeSaveToken();
+  std::vector<std::string> file_names;
+
+  // the shards of the checkpoint that is replaced
+  auto const previous = LoadShardNames(fs::path{directory} / kManifestName);
+
+  auto const group_count = model.GetGroupCount();
+
+  std::vector<std::vector<std::optional<VaryingField>>> fields(group_count);
+  std::vector<std::vector<TensorType>> types(group_count);
+  std::vector<ShardTask> tasks;
+
+  // the manifest is written last, such that it only references complete shards
+  std::ostringstream manifest;
+  manifest.write(kMagic.data(), static_cast<std::streamsize>(kMagic.size()));
+
+  NativeBinaryArchiveWriter archive{manifest};
+  archive.SaveSize(kVersion);
+
+  model.GetGlobal().Save(archive, [&filter](std::string_view name) {
+    return filter.Selects(FieldKind::kGlobal, name, nullptr);
+  });
+
+  archive.SaveSize(group_count);
+
+  size_t group_index = 0;
+  for (auto const &[group_name, group] : model.GetNamedGroups()) {
+    archive.SaveString(group_name);
+    archive.SaveString(group.GetGroupType());
+
+    archive.SaveSize(static_cast<size_t>(
+        std::distance(group.GetTags().begin(), group.GetTags().end())));
+    for (auto const &tag : group.GetTags())
+      archive.SaveString(tag);
+
+    size_t const item_count = group.GetItemCount();
+    archive.SaveSize(item_count);
+
+    group.GetUniform().Save(archive, [&filter, &group](std::string_view name) {
+      return filter.Selects(FieldKind::kUniform, name, &group);
+    });
+
+    auto &group_fields = fields[group_index];
+    auto &group_types = types[group_index];
+
+    std::vector<std::string_view> names;
+    for (auto const &[name, field] : group.GetVarying().GetNamedFields()) {
+      if (filter.Selects(FieldKind::kVarying, name, &group)) {
+        names.emplace_back(name);
+        group_fields.emplace_back(field);
+        group_types.emplace_back(field.GetType());
+      }
+    }
+
+    archive.SaveSize(group_fields.size());
+    for (size_t index = 0; index < group_fields.size(); ++index) {
+      archive.SaveString(names[index]);
+      group_types[index].Save(archive);
+    }
+
+    size_t const shard_count =
+        (item_count + max_shard_size - 1) / max_shard_size;
+    archive.SaveSize(shard_count);
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+      auto const file_name = std::string{group_name} + "." + token + "." +
+                             std::to_string(shard) + ".bin";
+      file_names.push_back(file_name);
+      size_t const first = shard * max_shard_size;
+      size_t const count = std::min(max_shard_size, item_count - first);
+
+      archive.SaveString(file_name);
+      archive.SaveSize(first);
+      archive.SaveSize(count);
+
+      tasks.push_back(
+          {(fs::path{directory} / file_name).string(), first, count,
+           &group_fields, &group_types});
+    }
+
+    ++group_index;
+  }
+
+  RunShardTasks(tasks, [](ShardTask const &task) {
+    std::ofstream file{task.path, std::ios::binary};
+    NativeBinaryArchiveWriter shard_archive{file};
+    for (auto const &field : *task.fields)
+      field->SaveRange(shard_archive, task.first, task.count);
+    return static_cast<bool>(file);
+  });
+
+  // the new manifest replaces the previous one atomically, so a crash leaves
+  // either the previous or the new checkpoint
+  {
+    std::ofstream file{
+        fs::path{directory} / kManifestTempName, std::ios::binary};
+    file << manifest.str();
+    file.close();
+    if (not file)
+      throw InvalidArchiveError{};
+  }
+  fs::rename(
+      fs::path{directory} / kManifestTempName,
+      fs::path{directory} / kManifestName);
+
+  RemoveUnreferencedShards(directory, previous, file_names);
+
+  log::Debug(
+      "lib", "SaveShardedCheckpoint", "directory=", directory,
+      " shards=", tasks.size());
+}
+
+void LoadShardedCheckpoint(
+    std::string const &directory, Model &model, FieldFilter const &filter) {
+  namespace fs = std::filesystem;
+
+  std::ifstream manifest{fs::path{directory} / kManifestName, std::ios::binary};
+  if (not manifest)
+    throw InvalidArchiveError{};
+
+  std::string magic(kMagic.size(), '@');
+  manifest.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+  if (magic != kMagic)
+    throw InvalidArchiveError{};
+
+  NativeBinaryArchiveReader archive{manifest};
+  if (archive.LoadSize() != kVersion)
+    throw InvalidArchiveError{};
+
+  LoadUniformFields(
+      archive, filter, FieldKind::kGlobal, nullptr,
+      [&model](auto const &name, auto const &type) {
+        return model.AddGlobalField(name, type);
+      });
+
+  // points that are loaded are relative to the loaded origin
+  if (auto origin = model.GetPositionOrigin(); not origin.empty())
+    model.SetPositionOrigin(origin, false);
+
+  size_t const group_count = archive.LoadSize();
+
+  std::vector<std::vector<std::optional<VaryingField>>> fields(group_count);
+  std::vector<std::vector<TensorType>> types(group_count);
+  std::vector<ShardTask> tasks;
+
+  for (size_t group_index = 0; group_index < group_count; ++group_index) {
+    auto const group_name = archive.LoadString();
+    auto const group_type = archive.LoadString();
+    auto &group = model.AddGroup(group_name, group_type);
+
+    size_t const tag_count = archive.LoadSize();
+    for (size_t tag_index = 0; tag_index < tag_count; ++tag_index)
+      group.AddTag(archive.LoadString());
+
+    group.Resize(archive.LoadSize());
+
+    LoadUniformFields(
+        archive, filter, FieldKind::kUniform, &group,
+        [&group](auto const &name, auto const &type) {
+          return group.AddUniformField(name, type);
+        });
+
+    // varying fields are created (and sized) here and filled by the shards
+    auto &group_fields = fields[group_index];
+    auto &group_types = types[group_index];
+
+    size_t const field_count = archive.LoadSize();
+    for (size_t field_index = 0; field_index < field_count; ++field_index) {
+      auto const name = archive.LoadString();
+
+      TensorType type;
+      type.Load(archive);
+
+      group_types.push_back(type);
+      if (filter.Selects(FieldKind::kVarying, name, &group))
+        group_fields.emplace_back(group.AddVaryingField(name, type));
+      else
+        group_fields.emplace_back(std::nullopt);
+    }
+
+    size_t const shard_count = archive.LoadSize();
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+      auto const file_name = archive.LoadString();
+      size_t const first = archive.LoadSize();
+      size_t const count = archive.LoadSize();
+
+      if (first + count > group.GetItemCount())
+        throw InvalidArchiveError{};
+
+      tasks.push_back(
+          {(fs::path{directory} / file_name).string(), first, count,
+           &group_fields, &group_types});
+    }
+  }
+
+  if (not manifest)
+    throw InvalidArchiveError{};
+
+  RunShardTasks(tasks, [](ShardTask const &task) {
+    std::ifstream file{task.path, std::ios::binary};
+    NativeBinaryArchiveReader shard_archive{file};
+    for (size_t index = 0; index < task.fields->size(); ++index) {
+      auto const &field = (*task.fields)[index];
+      auto const &type = (*task.types)[index];
+      if (field) {
+        field->LoadRange(shard_archive, task.first, task.count);
+      } else {
+        // scalar items still take one component each in the shard
+        auto const component_count = boost::accumulate(
+            type.GetShape().GetExtents(), size_t{1}, std::multiplies<void>{});
+        shard_archive.SkipValues(
+            task.count * component_count,
+            type.GetComponentType().GetByteSize());
+      }
+    }
+    return static_cast<bool>(file);
+  });
+
+  log::Debug(
+      "lib", "LoadShardedCheckpoint", "directory=", directory,
+      " shards=", tasks.size());
+}
+
+} // namespace prtcl
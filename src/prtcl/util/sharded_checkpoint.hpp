@@ -0,0 +1,45 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_SHARDED_CHECKPOINT_HPP
+#define PRTCL_SRC_PRTCL_UTIL_SHARDED_CHECKPOINT_HPP
+
+#include "../data/field_filter.hpp"
+#include "../data/model.hpp"
+
+#include <string>
+
+#include <cstddef>
+
+namespace prtcl {
+
+// A sharded checkpoint is a directory with a small manifest and one file per
+// shard.  The manifest holds the global fields and for each group its type,
+// tags, item count, uniform fields, the types of its varying fields and the
+// list of shards.  Each shard stores the values of all varying fields for a
+// contiguous range of items of one group.  Groups are permuted in Morton order
+// by the neighborhood, so these ranges are also spatially coherent.
+//
+// Shards are written and read in parallel (one OpenMP thread per shard file),
+// which allows saturating storage that a single stream can not.
+//
+// Saving over an existing checkpoint writes the shards under new names and
+// then atomically replaces the manifest, a crash while saving leaves the
+// previous checkpoint intact.  Afterwards the shards of the previous manifest
+// that the new one does not reference are removed, other files in the
+// directory are kept.
+
+constexpr size_t kDefaultMaxShardSize = size_t{1} << 20;
+
+//! Saves the model into directory (which is created if necessary), groups
+//! with more than max_shard_size items are split into multiple shards.
+void SaveShardedCheckpoint(
+    Model const &model, std::string const &directory,
+    size_t max_shard_size = kDefaultMaxShardSize,
+    FieldFilter const &filter = FieldFilter{});
+
+//! Loads a checkpoint saved by SaveShardedCheckpoint into the model.
+void LoadShardedCheckpoint(
+    std::string const &directory, Model &model,
+    FieldFilter const &filter = FieldFilter{});
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_SHARDED_CHECKPOINT_HPP
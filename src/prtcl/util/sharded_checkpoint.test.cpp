@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include "sharded_checkpoint.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace prtcl;
+
+namespace {
+
+size_t CountFiles(std::string const &directory) {
+  auto const it = std::filesystem::directory_iterator{directory};
+  return static_cast<size_t>(std::distance(begin(it), end(it)));
+}
+
+} // namespace
+
+TEST(ShardedCheckpoint, SaveLoadTest) {
+  auto const directory =
+      (std::filesystem::temp_directory_path() / "prtcl-sharded-checkpoint.test")
+          .string();
+  std::filesystem::remove_all(directory);
+
+  {
+    Model model;
+    model.AddGlobalFieldImpl<double>("t") = 1.5;
+
+    auto &fluid = model.AddGroup("fluid", "fluid");
+    fluid.AddTag("dynamic");
+    fluid.CreateItems(10);
+    auto x = fluid.AddVaryingFieldImpl<float, 3>("x");
+    auto id = fluid.AddVaryingFieldImpl<int64_t>("id");
+    for (size_t i = 0; i < x.size(); ++i) {
+      x[i] = math::Tensor<float, 3>::Constant(static_cast<float>(i));
+      id[i] = static_cast<int64_t>(100 + i);
+    }
+    fluid.AddVaryingFieldImpl<float>("iisph_helper_c");
+
+    model.AddGroup("empty", "boundary");
+
+    // 10 items in shards of 4 items
+    SaveShardedCheckpoint(model, directory, 4, FieldFilter::RestartSet());
+  }
+
+  // the manifest and three shards of the fluid
+  ASSERT_EQ(4, CountFiles(directory));
+
+  {
+    Model model;
+    LoadShardedCheckpoint(directory, model);
+
+    ASSERT_EQ(1.5, *model.GetGlobal().FieldSpan<double>("t"));
+    ASSERT_EQ(2, model.GetGroupCount());
+
+    auto *fluid = model.TryGetGroup("fluid");
+    ASSERT_NE(nullptr, fluid);
+    ASSERT_TRUE(fluid->HasTag("dynamic"));
+    ASSERT_EQ(10, fluid->GetItemCount());
+    ASSERT_FALSE(fluid->GetVarying().HasField("iisph_helper_c"));
+
+    auto x = fluid->GetVarying().FieldSpan<float, 3>("x");
+    auto id = fluid->GetVarying().FieldSpan<int64_t>("id");
+    for (size_t i = 0; i < x.size(); ++i) {
+      ASSERT_EQ(static_cast<float>(i), x[i][1]);
+      ASSERT_EQ(static_cast<int64_t>(100 + i), id[i]);
+    }
+  }
+
+  {
+    // skip a field on loading
+    Model model;
+    LoadShardedCheckpoint(directory, model, FieldFilter{}.Exclude("x"));
+
+    auto *fluid = model.TryGetGroup("fluid");
+    ASSERT_NE(nullptr, fluid);
+    ASSERT_FALSE(fluid->GetVarying().HasField("x"));
+    ASSERT_EQ(109, fluid->GetVarying().FieldSpan<int64_t>("id")[9]);
+  }
+
+  {
+    // saving over the checkpoint removes the shards of the previous save
+    Model model;
+    auto &fluid = model.AddGroup("fluid", "fluid");
+    fluid.CreateItems(3);
+    fluid.AddVaryingFieldImpl<int64_t>("id")[2] = 7;
+
+    // files that do not belong to the checkpoint are kept
+    auto const unrelated = directory + "/model.6.bin";
+    std::ofstream{unrelated} << "frame";
+
+    SaveShardedCheckpoint(model, directory, 4);
+    ASSERT_EQ(3, CountFiles(directory));
+    ASSERT_TRUE(std::filesystem::exists(unrelated));
+
+    Model loaded;
+    LoadShardedCheckpoint(directory, loaded);
+    ASSERT_EQ(3, loaded.TryGetGroup("fluid")->GetItemCount());
+    ASSERT_EQ(7, loaded.TryGetGroup("fluid")->GetVarying().FieldSpan<int64_t>(
+                     "id")[2]);
+  }
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(ShardedCheckpoint, PositionOrigin) {
+  using RVec3 = math::Tensor<double, 3>;
+
+  auto const directory = (std::filesystem::temp_directory_path() /
+                          "prtcl-sharded-checkpoint-origin.test")
+                             .string();
+  std::filesystem::remove_all(directory);
+
+  RVec3 const far{1e5, 2e5, -3e5};
+  RVec3 const center{1, 2, 3};
+  {
+    Model model;
+    double const origin[] = {1e5, 2e5, -3e5};
+    model.SetPositionOrigin(origin);
+    model.AddGlobalFieldImpl<float, 3>("gravity_center");
+    model.GetGlobal().FieldWrap<double, 3>("gravity_center").Set(center);
+
+    auto &group = model.AddGroup("fluid", "fluid");
+    group.AddVaryingFieldImpl<float, 3>("position");
+    group.CreateItems(3);
+    group.GetVarying().FieldWrap<double, 3>("position").Set(2, far);
+
+    SaveShardedCheckpoint(model, directory, 2);
+  }
+
+  {
+    Model model;
+    LoadShardedCheckpoint(directory, model);
+
+    ASSERT_EQ(3, model.GetPositionOrigin().size());
+    auto c = model.GetGlobal().FieldWrap<double, 3>("gravity_center");
+    ASSERT_EQ(center, c.Get());
+    auto x = model.TryGetGroup("fluid")->GetVarying().FieldWrap<double, 3>(
+        "position");
+    ASSERT_EQ(far, x.Get(2));
+  }
+
+  std::filesystem::remove_all(directory);
+}
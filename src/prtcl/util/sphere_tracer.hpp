@@ -3,45 +3,25 @@
 
 #include "../data/model.hpp"
 #include "../math.hpp"
+#include "../log.hpp"
 #include "../math/kernel/cubic_spline_kernel.hpp"
+#include "image.hpp"
+#include "neighborhood.hpp"
+#include "occupied_cell_tree.hpp"
 
+#include <array>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 
 #include <ungrd/compact_grid.hpp>
-#include <ungrd/cxx/lexicographic_indexing.hpp>
 
 namespace prtcl {
 
-class Image {
-public:
-  size_t width() const { return indexing_.extent(0); }
-
-  size_t height() const { return indexing_.extent(1); }
-
-public:
-  auto &operator()(size_t ix, size_t iy) {
-    auto const index = indexing_.encode({ix, iy});
-    return intensity_[index];
-  }
-
-  auto const &operator()(size_t ix, size_t iy) const {
-    auto const index = indexing_.encode({ix, iy});
-    return intensity_[index];
-  }
-
-public:
-  Image(size_t _width, size_t _height) : indexing_{{_width, _height}} {
-    intensity_.resize(indexing_.size());
-  }
-
-private:
-  ungrd::lexicographic_indexing<2> indexing_;
-  std::vector<double> intensity_;
-};
-
 template <typename TCamera>
 class SphereTracer {
 public:
@@ -49,51 +29,189 @@ public:
   using Real = typename Camera::Real;
   using RVec = typename Camera::RVec;
 
+  //! Rays are traced in tiles of kTileSize x kTileSize pixels (of the current
+  //! pass), the rays of a tile share the particles they gathered.
+  static constexpr size_t kTileSize = 8;
+
 private:
   using Grid = ungrd::s32_e32_compact_grid<3>;
   using CPos = typename Grid::space_policy::position;
   using Entry = typename Grid::entry_policy ::entry;
 
   struct GroupData {
+    //! Index of the group in the model.
+    size_t index;
     VaryingFieldWrap<double, 3> x;
     Grid grid;
+    //! The stored positions (one of them is set), only used when the
+    //! particles are gathered from a Neighborhood.
+    VaryingFieldSpan<float, 3> float_x;
+    VaryingFieldSpan<double, 3> double_x;
   };
 
-  struct RayData {
-    size_t ix, iy;
-    RVec origin, direction;
-    Real parameter;
+  struct SceneData {
+    Real grid_diameter;
+    //! Rays end once they reach this distance from their origin.
+    Real max_parameter;
+    std::vector<GroupData> groups;
+    OccupiedCellTree cell_tree;
+    //! If set, the particles are gathered from this neighborhood instead of
+    //! the grids of the groups.
+    Neighborhood const *nhood = nullptr;
+    //! Radius of the query around the center of a cell in multiples of the
+    //! radius of the neighborhood.
+    double radius_multiple = 1;
+    size_t group_count = 0;
+    //! Subtracted from the origin of the rays, the neighborhood works with
+    //! the stored positions, which are relative to the position origin.
+    RVec offset = math::zeros<Real, 3>();
+  };
 
+  //! Positions of the particles in all cells visited by the rays of a tile,
+  //! gathered from all groups and stored per component, such that the
+  //! implicit function is evaluated over contiguous arrays.
+  struct TileCache {
+    std::unordered_map<uint64_t, std::pair<size_t, size_t>> ranges;
+    std::array<std::vector<Real>, 3> x;
+    std::vector<NeighborList> neighbors;
+
+    void Clear() {
+      ranges.clear();
+      for (auto &component : x)
+        component.clear();
+    }
+  };
+
+  struct RayResult {
+    Real parameter;
     RVec normal;
   };
 
 public:
   Image Trace(Model const &model) const {
+    return TraceProgressive(model, 1, [](Image const &, size_t) {});
+  }
+
+  //! Like Trace(model), but gathers the particles from nhood instead of
+  //! building a grid over all visible particles, e.g. from the neighborhood
+  //! of the simulation.  It must be loaded with model and updated, since then
+  //! the particles may have moved by up to a quarter of its radius (a time
+  //! step).  Visible groups that cannot be neighbors are not part of the grid
+  //! of nhood and thus not rendered.
+  Image Trace(Model const &model, Neighborhood const &nhood) const {
+    return TraceProgressive(model, nhood, 1, [](Image const &, size_t) {});
+  }
+
+  //! Traces the image in pass_count passes from coarse to fine.  The first
+  //! pass traces every 2^(pass_count - 1)-th pixel in both directions, each
+  //! following pass halves the stride and only traces the pixels that were
+  //! not traced yet.  Every traced pixel fills the block of stride x stride
+  //! pixels it is the corner of, such that on_pass(image, pass) is called
+  //! with a complete (but blocky) image after each pass.
+  template <typename OnPass>
+  Image TraceProgressive(
+      Model const &model, size_t pass_count, OnPass &&on_pass) const {
+    return TraceScene(Prepare(model), pass_count, on_pass);
+  }
+
+  //! Like TraceProgressive(model, pass_count, on_pass), but gathers the
+  //! particles from nhood (see Trace(model, nhood)).
+  template <typename OnPass>
+  Image TraceProgressive(
+      Model const &model, Neighborhood const &nhood, size_t pass_count,
+      OnPass &&on_pass) const {
+    return TraceScene(Prepare(model, nhood), pass_count, on_pass);
+  }
+
+private:
+  template <typename OnPass>
+  Image TraceScene(
+      SceneData const &scene, size_t pass_count, OnPass &on_pass) const {
+    size_t const width = camera_.sensor.width,
+                 height = camera_.sensor.height;
+    Image image{width, height};
+    auto const projection = camera_.GetProjection();
+
+    for (size_t pass = 0; pass < pass_count; ++pass) {
+      size_t const stride = size_t{1} << (pass_count - 1 - pass);
+      bool const first_pass = pass == 0;
+
+      // tiles cover kTileSize x kTileSize pixels of this pass
+      size_t const tiles_x = (width + kTileSize * stride - 1) /
+                             (kTileSize * stride),
+                   tiles_y = (height + kTileSize * stride - 1) /
+                             (kTileSize * stride);
+      auto const tile_count = static_cast<std::ptrdiff_t>(tiles_x * tiles_y);
+
+#pragma omp parallel default(none) shared(                                     \
+    scene, projection, image, width, height, stride, first_pass, tiles_x,      \
+    tile_count)
+      {
+        TileCache cache;
+
+#pragma omp for schedule(dynamic)
+        for (std::ptrdiff_t tile = 0; tile < tile_count; ++tile) {
+          cache.Clear();
+
+          size_t const tile_x = static_cast<size_t>(tile) % tiles_x,
+                       tile_y = static_cast<size_t>(tile) / tiles_x;
+
+          for (size_t ly = 0; ly < kTileSize; ++ly) {
+            for (size_t lx = 0; lx < kTileSize; ++lx) {
+              size_t const ix = (tile_x * kTileSize + lx) * stride,
+                           iy = (tile_y * kTileSize + ly) * stride;
+              if (ix >= width or iy >= height)
+                continue;
+
+              // skip the pixels that were traced by a previous pass
+              if (not first_pass and ix % (2 * stride) == 0 and
+                  iy % (2 * stride) == 0)
+                continue;
+
+              auto const [origin, direction] = projection.GetRay(ix, iy);
+              auto const value = Shade(
+                  scene, March(scene, cache, origin - scene.offset, direction),
+                  direction);
+
+              for (size_t by = iy; by < std::min(iy + stride, height); ++by)
+                for (size_t bx = ix; bx < std::min(ix + stride, width); ++bx)
+                  image(bx, by) = value;
+            }
+          }
+        }
+      }
+
+      on_pass(static_cast<Image const &>(image), pass);
+    }
+
+    return image;
+  }
+
+  SceneData Prepare(Model const &model) const {
     std::vector<std::pair<CPos, Entry>> input;
     Real const grid_diameter =
         4 * model.GetGlobal().FieldWrap<Real>("smoothing_scale");
 
-    RVec const cell_center_delta = [&grid_diameter] {
-      RVec result;
-      for (size_t dim = 0; dim < 3; ++dim)
-        result[dim] = grid_diameter / 2;
-      return result;
-    }();
-
     std::vector<GroupData> groups;
+    std::vector<OccupiedCellTree::Cell> cells;
     for (auto const &group : model.GetGroups()) {
       if (group.HasTag("visible")) {
         if (auto x = group.GetVarying().FieldWrap<Real, 3>("position")) {
-          auto &gd = groups.emplace_back(GroupData{std::move(x), Grid{}});
+          auto &gd = groups.emplace_back(GroupData{
+              static_cast<size_t>(group.GetGroupIndex()), std::move(x), Grid{},
+              {}, {}});
 
           input.resize(gd.x.GetSize());
           for (size_t entry = 0; entry < gd.x.GetSize(); ++entry) {
             auto const entry_x = gd.x.Get(entry);
+            OccupiedCellTree::Cell cell;
             for (size_t dim = 0; dim < 3; ++dim) {
               input[entry].first[dim] =
                   std::floor(entry_x[dim] / grid_diameter);
+              cell[dim] = static_cast<int32_t>(input[entry].first[dim]);
             }
             input[entry].second = static_cast<Entry>(entry);
+            cells.push_back(cell);
           }
 
           gd.grid.update(input);
@@ -101,152 +219,250 @@ public:
       }
     }
 
-    std::vector<RayData> rays;
-    camera_.Cast([&rays](size_t ix, size_t iy, auto origin, auto direction) {
-      rays.emplace_back(
-          RayData{ix, iy, origin, direction, Real{0}, math::zeros<Real, 3>()});
-    });
-
-    Real const max_parameter = grid_diameter * 10'000;
-    size_t const max_sdf_steps = max_sdf_steps_;
-
-#pragma omp parallel for default(none) schedule(guided) shared(                \
-    cell_center_delta, rays, grid_diameter, groups, max_parameter,             \
-    max_sdf_steps)
-    for (size_t ray_i = 0; ray_i < size(rays); ++ray_i) {
-      auto &rd = rays[ray_i];
-
-      size_t sdf_steps = 0;
-      for (; sdf_steps < max_sdf_steps; ++sdf_steps) {
-        RVec const ray_x = rd.origin + rd.parameter * rd.direction;
-
-        Real sdf = math::most_positive<Real>();
-
-        for (auto &gd : groups) {
-          gd.grid.foreach_position([&](CPos const &cpos) {
-            RVec const cell_center = [&] {
-              RVec result;
-              for (size_t dim = 0; dim < 3; ++dim)
-                result[dim] =
-                    grid_diameter * cpos[dim] + cell_center_delta[dim];
-              return result;
-            }();
-
-            RVec const q = math::cabs(ray_x - cell_center) - grid_diameter;
-            Real const l = math::norm(math::cmax(q, math::zeros<Real, 3>())) +
-                           std::min(math::maximum_component(q), Real{0}) -
-                           grid_diameter;
-            sdf = std::min(sdf, l);
-          });
-        }
+    // the coarse distance is the distance to the union of all occupied cells,
+    // each enlarged by half a cell, minus one cell
+    OccupiedCellTree cell_tree{
+        std::move(cells), grid_diameter, grid_diameter / 2};
 
-        // if sdf < grid_diameter -> do neighborhood search and compute CSG
-        // intersection (max) with the sdf value
-        if (sdf < grid_diameter) {
-          constexpr auto W = math::cubic_spline_kernel<Real, 3>{};
-          auto const L = W.lipschitz(grid_diameter / 2);
+    return {
+        grid_diameter, grid_diameter * 10'000, std::move(groups),
+        std::move(cell_tree)};
+  }
 
-          CPos const ray_c = [&] {
-            CPos cpos;
-            for (size_t dim = 0; dim < 3; ++dim)
-              cpos[dim] = std::floor(ray_x[dim] / grid_diameter);
-            return cpos;
-          }();
-
-          Real phi = threshold_ * W.evalr(0, grid_diameter / 2, 3);
-          RVec phi_grad = math::zeros<Real, 3>();
-
-          // size_t n_sdf_count = 0;
-          // Real n_sdf = math::most_positive<Real>();
-
-          size_t L_count = 0;
-
-          for (int cx = -1; cx <= 1; ++cx) {
-            for (int cy = -1; cy <= 1; ++cy) {
-              for (int cz = -1; cz <= 1; ++cz) {
-                CPos const cpos{ray_c[0] + cx, ray_c[1] + cy, ray_c[2] + cz};
-
-                for (auto &gd : groups) {
-                  gd.grid.foreach_entry_at_position(
-                      cpos, [&](auto const entry) {
-                        auto const entry_x = gd.x.Get(entry);
-
-                        // n_sdf = std::min(
-                        //    n_sdf, math::norm(ray_x - entry_x) -
-                        //    grid_diameter);
-                        //++n_sdf_count;
-
-                        auto const w =
-                            W.eval(ray_x - entry_x, grid_diameter / 2);
-
-                        if (w > 0) {
-                          phi -= w;
-                          phi_grad -=
-                              W.evalgrad(ray_x - entry_x, grid_diameter / 2);
-                          ++L_count;
-                        }
-                      });
-                }
-              }
-            }
-          }
+  SceneData
+  Prepare(Model const &model, Neighborhood const &nhood) const {
+    Real const grid_diameter =
+        4 * model.GetGlobal().FieldWrap<Real>("smoothing_scale");
 
-          if (L_count > 0) {
-            phi /= L * L_count;
-            rd.normal = phi_grad / (L * L_count);
+    std::vector<GroupData> groups;
+    std::vector<OccupiedCellTree::Cell> cells;
+    for (auto const &group : model.GetGroups()) {
+      auto const &varying = group.GetVarying();
+      if (not group.HasTag("visible") or not varying.HasField("position"))
+        continue;
 
-            sdf = std::max(sdf, phi);
-          } else {
-            sdf = std::max(sdf, grid_diameter / 4);
-          }
-          // else if (n_sdf_count > 0) {
-          //  sdf = std::max(sdf, n_sdf);
-          //}
-        }
+      if (group.HasTag("cannot_be_neighbor")) {
+        log::Warning(
+            "lib", "SphereTracer", "group ", group.GetGroupName(),
+            " cannot be neighbor and is not rendered");
+        continue;
+      }
 
-        if (sdf < static_cast<Real>(1e-6))
-          break;
+      auto &gd = groups.emplace_back(GroupData{
+          static_cast<size_t>(group.GetGroupIndex()), {}, Grid{},
+          varying.FieldSpan<float, 3>("position"),
+          varying.FieldSpan<double, 3>("position")});
 
-        rd.parameter += sdf;
+      VisitPositions(gd, [&cells, grid_diameter](auto const &x) {
+        for (size_t entry = 0; entry < x.GetSize(); ++entry)
+          cells.push_back(GetCell(x[entry], grid_diameter));
+      });
+    }
 
-        if (rd.parameter >= max_parameter)
-          break;
-      }
+    OccupiedCellTree cell_tree{
+        std::move(cells), grid_diameter, grid_diameter / 2};
+
+    SceneData scene{
+        grid_diameter, grid_diameter * 10'000, std::move(groups),
+        std::move(cell_tree)};
+    scene.nhood = &nhood;
+    // the circumsphere of a cell, enlarged for the particles that moved since
+    // the last update of the neighborhood
+    scene.radius_multiple =
+        std::sqrt(Real{3}) / 2 * grid_diameter / nhood.GetRadius() + 0.25;
+    scene.group_count = model.GetGroupCount();
+    if (auto const origin = model.GetPositionOrigin(); origin.size() == 3)
+      scene.offset = RVec{origin[0], origin[1], origin[2]};
+    return scene;
+  }
 
-      if (sdf_steps >= max_sdf_steps)
-        rd.parameter = max_parameter;
-    }
+  //! Calls fn with the span of stored positions of the group.
+  template <typename Fn>
+  static void VisitPositions(GroupData const &gd, Fn &&fn) {
+    if (gd.float_x)
+      fn(gd.float_x);
+    else if (gd.double_x)
+      fn(gd.double_x);
+  }
 
-    Image image{camera_.sensor.width, camera_.sensor.height};
+  template <typename X>
+  static OccupiedCellTree::Cell GetCell(X const &x, Real grid_diameter) {
+    OccupiedCellTree::Cell cell;
+    for (size_t dim = 0; dim < 3; ++dim)
+      cell[dim] = static_cast<int32_t>(
+          std::floor(static_cast<Real>(x[dim]) / grid_diameter));
+    return cell;
+  }
 
-    Real smallest_good_parameter = math::most_positive<Real>();
-    Real largest_good_parameter = Real{0};
-    for (auto const &ray : rays) {
-      if (ray.parameter >= max_parameter)
-        continue;
+  //! Appends the particles in cpos to the cache.  The neighborhood is
+  //! queried at the center of the cell with the radius of its circumsphere,
+  //! the particles outside of the cell are discarded.
+  static void GatherFromNeighborhood(
+      SceneData const &scene, TileCache &cache, CPos const &cpos) {
+    Real const grid_diameter = scene.grid_diameter;
+    OccupiedCellTree::Cell cell;
+    std::array<double, 3> center;
+    for (size_t dim = 0; dim < 3; ++dim) {
+      cell[dim] = static_cast<int32_t>(cpos[dim]);
+      center[dim] = (static_cast<Real>(cell[dim]) + Real{0.5}) * grid_diameter;
+    }
 
-      smallest_good_parameter =
-          std::min(ray.parameter, smallest_good_parameter);
-      largest_good_parameter = std::max(ray.parameter, largest_good_parameter);
+    cache.neighbors.resize(scene.group_count);
+    for (auto &list : cache.neighbors)
+      list.clear();
+    scene.nhood->CopyNeighbors(center, scene.radius_multiple, cache.neighbors);
+
+    for (auto const &gd : scene.groups) {
+      VisitPositions(gd, [&](auto const &x) {
+        for (auto const entry : cache.neighbors[gd.index]) {
+          auto const &entry_x = x[entry];
+          if (GetCell(entry_x, grid_diameter) != cell)
+            continue;
+          for (size_t dim = 0; dim < 3; ++dim)
+            cache.x[dim].push_back(static_cast<Real>(entry_x[dim]));
+        }
+      });
     }
+  }
 
-    for (auto const &ray : rays) {
-      if (ray.parameter == max_parameter) {
-        image(ray.ix, ray.iy) = Real{0};
-      } else if (ray.parameter > max_parameter) {
-        image(ray.ix, ray.iy) = Real{0.3};
+  //! Returns the range of the positions of the particles in cpos in the
+  //! cache, gathering them on the first access.
+  static std::pair<size_t, size_t>
+  GetCellRange(SceneData const &scene, TileCache &cache, CPos const &cpos) {
+    // 21 bits per component suffice for any sensible scene
+    uint64_t key = 0;
+    for (size_t dim = 0; dim < 3; ++dim)
+      key = (key << 21) | (static_cast<uint64_t>(cpos[dim]) & 0x1F'FFFF);
+
+    auto [it, inserted] = cache.ranges.try_emplace(key);
+    if (inserted) {
+      it->second.first = cache.x[0].size();
+      if (scene.nhood) {
+        GatherFromNeighborhood(scene, cache, cpos);
       } else {
-        image(ray.ix, ray.iy) = -math::dot(
-            math::normalized(ray.direction), math::normalized(ray.normal));
+        for (auto const &gd : scene.groups) {
+          gd.grid.foreach_entry_at_position(cpos, [&](auto const entry) {
+            auto const entry_x = gd.x.Get(entry);
+            for (size_t dim = 0; dim < 3; ++dim)
+              cache.x[dim].push_back(entry_x[dim]);
+          });
+        }
+      }
+      it->second.second = cache.x[0].size();
+    }
+    return it->second;
+  }
+
+  RayResult March(
+      SceneData const &scene, TileCache &cache, RVec const &origin,
+      RVec const &direction) const {
+    constexpr auto W = math::cubic_spline_kernel<Real, 3>{};
+
+    Real const grid_diameter = scene.grid_diameter;
+    Real const h = grid_diameter / 2;
+    Real const L = W.lipschitz(h);
+    // W(0) = 4 * w_scale for the cubic spline kernel
+    Real const w_scale = W.evalr(0, h, 3) / 4;
+    Real const max_parameter = scene.max_parameter;
+
+    RayResult result{Real{0}, math::zeros<Real, 3>()};
+
+    size_t sdf_steps = 0;
+    for (; sdf_steps < max_sdf_steps_; ++sdf_steps) {
+      RVec const ray_x = origin + result.parameter * direction;
+
+      // distances beyond max_parameter all let the ray leave the scene
+      Real const max_distance =
+          max_parameter - result.parameter + 2 * grid_diameter;
+      Real sdf =
+          scene.cell_tree.GetDistance(ray_x, max_distance) - grid_diameter;
+
+      // if sdf < grid_diameter -> evaluate the implicit function of the
+      // particles in the neighboring cells and compute the CSG intersection
+      // (max) with the sdf value
+      if (sdf < grid_diameter) {
+        CPos const ray_c = [&] {
+          CPos cpos;
+          for (size_t dim = 0; dim < 3; ++dim)
+            cpos[dim] = std::floor(ray_x[dim] / grid_diameter);
+          return cpos;
+        }();
+
+        Real const rx = ray_x[0], ry = ray_x[1], rz = ray_x[2];
+        Real phi_sum = 0, grad_x = 0, grad_y = 0, grad_z = 0;
+        size_t L_count = 0;
+
+        for (int cx = -1; cx <= 1; ++cx) {
+          for (int cy = -1; cy <= 1; ++cy) {
+            for (int cz = -1; cz <= 1; ++cz) {
+              CPos const cpos{ray_c[0] + cx, ray_c[1] + cy, ray_c[2] + cz};
+              auto const [first, last] = GetCellRange(scene, cache, cpos);
+
+              Real const *xs = cache.x[0].data(), *ys = cache.x[1].data(),
+                         *zs = cache.x[2].data();
+
+#pragma omp simd reduction(+ : phi_sum, grad_x, grad_y, grad_z, L_count)
+              for (size_t i = first; i < last; ++i) {
+                Real const dx = rx - xs[i], dy = ry - ys[i], dz = rz - zs[i];
+                Real const r = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+                // branch free cubic spline kernel and its derivative
+                Real const q = r / h;
+                Real const t1 = std::max(Real{1} - q, Real{0}),
+                           t2 = std::max(Real{2} - q, Real{0});
+                Real const w = w_scale * (t2 * t2 * t2 - 4 * t1 * t1 * t1);
+                Real const dw_r =
+                    r > math::epsilon<Real>()
+                        ? w_scale / h * (12 * t1 * t1 - 3 * t2 * t2) / r
+                        : Real{0};
+
+                bool const inside = w > 0;
+                phi_sum += inside ? w : Real{0};
+                grad_x += inside ? dw_r * dx : Real{0};
+                grad_y += inside ? dw_r * dy : Real{0};
+                grad_z += inside ? dw_r * dz : Real{0};
+                L_count += inside ? 1 : 0;
+              }
+            }
+          }
+        }
+
+        if (L_count > 0) {
+          Real const phi = threshold_ * W.evalr(0, h, 3) - phi_sum;
+          auto const scale = L * static_cast<Real>(L_count);
+          result.normal = RVec{-grad_x, -grad_y, -grad_z} / scale;
 
-        // image(ray.ix, ray.iy) = std::clamp(
-        //    (ray.parameter - smallest_good_parameter) /
-        //        (largest_good_parameter - smallest_good_parameter),
-        //    Real{0}, Real{1});
+          sdf = std::max(sdf, phi / scale);
+        } else {
+          sdf = std::max(sdf, grid_diameter / 4);
+        }
       }
+
+      if (sdf < static_cast<Real>(1e-6))
+        break;
+
+      result.parameter += sdf;
+
+      if (result.parameter >= max_parameter)
+        break;
     }
 
-    return image;
+    if (sdf_steps >= max_sdf_steps_)
+      result.parameter = max_parameter;
+
+    return result;
+  }
+
+  static Real Shade(
+      SceneData const &scene, RayResult const &ray, RVec const &direction) {
+    // the ray ran out of steps
+    if (ray.parameter == scene.max_parameter)
+      return Real{0};
+    // the ray left the scene
+    if (ray.parameter > scene.max_parameter)
+      return Real{0.3};
+    return -math::dot(
+        math::normalized(direction), math::normalized(ray.normal));
   }
 
 public:
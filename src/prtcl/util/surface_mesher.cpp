@@ -0,0 +1,424 @@
+#include "surface_mesher.hpp"
+
+#include "../log.hpp"
+#include "../math/kernel/cubic_spline_kernel.hpp"
+#include "morton_order.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+namespace prtcl {
+
+namespace {
+
+using Real = SurfaceMesher::Real;
+using RVec3 = TensorT<Real, 3>;
+using Face = TriangleMesh::Face;
+using Block = std::array<int32_t, 3>;
+
+constexpr size_t kBlockSize = SurfaceMesher::kBlockSize;
+constexpr size_t kSampleCount =
+    (kBlockSize + 1) * (kBlockSize + 1) * (kBlockSize + 1);
+
+// the corners of a cell are numbered by their offsets, bit 0 is x, bit 1 is
+// y and bit 2 is z; the six tetrahedra are the paths from corner 0 to
+// corner 7 along the edges of the cell (the Freudenthal subdivision), thus
+// of any two corners of a tetrahedron one is a bit subset of the other
+constexpr std::array<std::array<uint8_t, 4>, 6> kTetrahedra{{
+    {0, 1, 3, 7},
+    {0, 1, 5, 7},
+    {0, 2, 3, 7},
+    {0, 2, 6, 7},
+    {0, 4, 5, 7},
+    {0, 4, 6, 7},
+}};
+
+struct Particles {
+  //! The occupied blocks in Morton order and the range of their particles.
+  std::vector<Block> blocks;
+  std::vector<size_t> first;
+  //! The positions sorted by block and stored per component.
+  std::array<std::vector<Real>, 3> x;
+
+  //! Returns the range of the particles in block, empty if it has none.
+  std::pair<size_t, size_t> GetRange(Block const &block) const {
+    auto it = std::lower_bound(
+        blocks.begin(), blocks.end(), block, morton_order_fn{});
+    if (it == blocks.end() or *it != block)
+      return {0, 0};
+    auto const index = static_cast<size_t>(it - blocks.begin());
+    return {first[index], first[index + 1]};
+  }
+};
+
+//! The part of the mesh of one block.  Each vertex is identified by the
+//! edge of the grid it lies on.
+struct BlockMesh {
+  std::vector<RVec3> vertices;
+  std::vector<uint64_t> keys;
+  std::vector<Face> faces;
+};
+
+size_t GetSampleIndex(size_t ix, size_t iy, size_t iz) {
+  return (iz * (kBlockSize + 1) + iy) * (kBlockSize + 1) + ix;
+}
+
+//! Identifies the edge from the sample lower into the direction of the
+//! corner offsets in mask, with 20 bits per component.
+uint64_t EncodeEdge(std::array<int64_t, 3> const &lower, uint8_t mask) {
+  uint64_t key = 0;
+  for (size_t dim = 0; dim < 3; ++dim)
+    key = (key << 20) | (static_cast<uint64_t>(lower[dim] + (1 << 19)) &
+                         0xF'FFFF);
+  return (key << 3) | mask;
+}
+
+Particles CollectParticles(Model const &model, Real block_diameter) {
+  std::vector<std::pair<Block, std::array<Real, 3>>> items;
+  for (auto const &group : model.GetGroups()) {
+    auto const &varying = group.GetVarying();
+    if (not group.HasTag("visible") or not varying.HasField("position"))
+      continue;
+
+    auto const collect = [&](auto const &x) {
+      for (size_t entry = 0; entry < x.GetSize(); ++entry) {
+        auto &[block, position] = items.emplace_back();
+        for (size_t dim = 0; dim < 3; ++dim) {
+          position[dim] =
+              static_cast<Real>(x[entry][static_cast<Eigen::Index>(dim)]);
+          block[dim] =
+              static_cast<int32_t>(std::floor(position[dim] / block_diameter));
+        }
+      }
+    };
+    if (auto x = varying.FieldSpan<float, 3>("position"))
+      collect(x);
+    else if (auto x = varying.FieldSpan<double, 3>("position"))
+      collect(x);
+  }
+
+  // the particles of a block are contiguous and neighboring blocks are close
+  std::sort(
+      items.begin(), items.end(), [](auto const &lhs, auto const &rhs) {
+        return morton_order_fn{}(lhs.first, rhs.first);
+      });
+
+  Particles particles;
+  for (auto &component : particles.x)
+    component.reserve(items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (i == 0 or items[i].first != items[i - 1].first) {
+      particles.blocks.push_back(items[i].first);
+      particles.first.push_back(i);
+    }
+    for (size_t dim = 0; dim < 3; ++dim)
+      particles.x[dim].push_back(items[i].second[dim]);
+  }
+  particles.first.push_back(items.size());
+  return particles;
+}
+
+struct Sampling {
+  Real h;
+  Real spacing;
+  Real threshold;
+  //! Number of blocks in each direction that particles influence.
+  int32_t reach;
+};
+
+//! Samples phi at the (kBlockSize + 1)^3 corners of the cells of the block,
+//! returns false if phi has no sign change within the block.
+bool SampleBlock(
+    Sampling const &sampling, Particles const &particles, Block const &block,
+    std::vector<Real> &phi) {
+  constexpr auto W = math::cubic_spline_kernel<Real, 3>{};
+  Real const h = sampling.h, spacing = sampling.spacing;
+  Real const support = 2 * h;
+  // W(0) = 4 * w_scale for the cubic spline kernel
+  Real const w_scale = W.evalr(0, h, 3) / 4;
+
+  std::array<Real, 3> block_origin;
+  for (size_t dim = 0; dim < 3; ++dim)
+    block_origin[dim] =
+        static_cast<Real>(block[dim]) * static_cast<Real>(kBlockSize) *
+        spacing;
+
+  phi.assign(kSampleCount, sampling.threshold * W.evalr(0, h, 3));
+
+  auto const sample_bounds = [&](Real x, size_t dim) {
+    Real const lo = std::ceil((x - support - block_origin[dim]) / spacing),
+               hi = std::floor((x + support - block_origin[dim]) / spacing);
+    auto const max = static_cast<Real>(kBlockSize);
+    return std::make_pair(
+        static_cast<size_t>(std::clamp(lo, Real{0}, max)),
+        static_cast<size_t>(std::clamp(hi, Real{-1}, max) + 1));
+  };
+
+  int32_t const reach = sampling.reach;
+  for (int32_t oz = -reach; oz <= reach; ++oz) {
+    for (int32_t oy = -reach; oy <= reach; ++oy) {
+      for (int32_t ox = -reach; ox <= reach; ++ox) {
+        auto const [first, last] = particles.GetRange(
+            Block{block[0] + ox, block[1] + oy, block[2] + oz});
+
+        for (size_t i = first; i < last; ++i) {
+          Real const px = particles.x[0][i], py = particles.x[1][i],
+                     pz = particles.x[2][i];
+          auto const [x_lo, x_hi] = sample_bounds(px, 0);
+          auto const [y_lo, y_hi] = sample_bounds(py, 1);
+          auto const [z_lo, z_hi] = sample_bounds(pz, 2);
+
+          for (size_t iz = z_lo; iz < z_hi; ++iz) {
+            Real const dz =
+                block_origin[2] + static_cast<Real>(iz) * spacing - pz;
+            for (size_t iy = y_lo; iy < y_hi; ++iy) {
+              Real const dy =
+                  block_origin[1] + static_cast<Real>(iy) * spacing - py;
+              Real *row = phi.data() + GetSampleIndex(0, iy, iz);
+
+#pragma omp simd
+              for (size_t ix = x_lo; ix < x_hi; ++ix) {
+                Real const dx =
+                    block_origin[0] + static_cast<Real>(ix) * spacing - px;
+                Real const q = std::sqrt(dx * dx + dy * dy + dz * dz) / h;
+                // branch free cubic spline kernel
+                Real const t1 = std::max(Real{1} - q, Real{0}),
+                           t2 = std::max(Real{2} - q, Real{0});
+                row[ix] -= w_scale * (t2 * t2 * t2 - 4 * t1 * t1 * t1);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  auto const [min, max] = std::minmax_element(phi.begin(), phi.end());
+  return *min < 0 and *max >= 0;
+}
+
+//! Triangulates the cells of the block with marching tetrahedra.
+void TriangulateBlock(
+    Sampling const &sampling, Block const &block,
+    std::vector<Real> const &phi, std::vector<int32_t> &vertex_index,
+    BlockMesh &mesh) {
+  Real const spacing = sampling.spacing;
+  vertex_index.assign(8 * kSampleCount, -1);
+
+  std::array<int64_t, 3> block_first;
+  for (size_t dim = 0; dim < 3; ++dim)
+    block_first[dim] =
+        static_cast<int64_t>(block[dim]) * static_cast<int64_t>(kBlockSize);
+
+  auto const corner_sample = [](size_t cx, size_t cy, size_t cz,
+                                uint8_t corner) {
+    return std::array<size_t, 3>{
+        cx + (corner & 1u), cy + ((corner >> 1) & 1u),
+        cz + ((corner >> 2) & 1u)};
+  };
+  auto const sample_position = [&](std::array<size_t, 3> const &s) {
+    RVec3 result;
+    for (size_t dim = 0; dim < 3; ++dim)
+      result[static_cast<Eigen::Index>(dim)] =
+          static_cast<Real>(block_first[dim] + static_cast<int64_t>(s[dim])) *
+          spacing;
+    return result;
+  };
+
+  for (size_t cz = 0; cz < kBlockSize; ++cz) {
+    for (size_t cy = 0; cy < kBlockSize; ++cy) {
+      for (size_t cx = 0; cx < kBlockSize; ++cx) {
+        std::array<Real, 8> value;
+        std::array<size_t, 8> index;
+        uint8_t inside = 0;
+        for (uint8_t corner = 0; corner < 8; ++corner) {
+          auto const s = corner_sample(cx, cy, cz, corner);
+          index[corner] = GetSampleIndex(s[0], s[1], s[2]);
+          value[corner] = phi[index[corner]];
+          if (value[corner] < 0)
+            inside |= static_cast<uint8_t>(1u << corner);
+        }
+        if (inside == 0 or inside == 0xFF)
+          continue;
+
+        // returns the vertex on the edge between the corners a and b
+        auto const get_vertex = [&](uint8_t a, uint8_t b) {
+          // the corner with fewer bits is the lower end of the edge
+          if ((a & b) != a)
+            std::swap(a, b);
+          auto const mask = static_cast<uint8_t>(a ^ b);
+          auto &slot = vertex_index[8 * index[a] + mask];
+          if (slot < 0) {
+            slot = static_cast<int32_t>(mesh.vertices.size());
+            auto const sa = corner_sample(cx, cy, cz, a),
+                       sb = corner_sample(cx, cy, cz, b);
+            RVec3 const xa = sample_position(sa), xb = sample_position(sb);
+            Real const t = value[a] / (value[a] - value[b]);
+            mesh.vertices.push_back(xa + t * (xb - xa));
+
+            std::array<int64_t, 3> lower;
+            for (size_t dim = 0; dim < 3; ++dim)
+              lower[dim] = block_first[dim] + static_cast<int64_t>(sa[dim]);
+            mesh.keys.push_back(EncodeEdge(lower, mask));
+          }
+          return static_cast<TriangleMesh::index_type>(slot);
+        };
+
+        // emits the triangle oriented such that its normal points from the
+        // inside corner towards the outside corner
+        auto const emit = [&](Face face, uint8_t in, uint8_t out) {
+          auto const &v = mesh.vertices;
+          RVec3 const normal = math::cross(
+              v[face[1]] - v[face[0]], v[face[2]] - v[face[0]]);
+          RVec3 const direction =
+              sample_position(corner_sample(cx, cy, cz, out)) -
+              sample_position(corner_sample(cx, cy, cz, in));
+          if (math::dot(normal, direction) < 0)
+            std::swap(face[1], face[2]);
+          mesh.faces.push_back(face);
+        };
+
+        for (auto const &tet : kTetrahedra) {
+          std::array<uint8_t, 4> in, out;
+          size_t in_count = 0, out_count = 0;
+          for (auto const corner : tet) {
+            if (inside & (1u << corner))
+              in[in_count++] = corner;
+            else
+              out[out_count++] = corner;
+          }
+
+          if (in_count == 1 or in_count == 3) {
+            // a single corner is separated from the other three
+            bool const single_inside = in_count == 1;
+            auto const single = single_inside ? in[0] : out[0];
+            auto const &others = single_inside ? out : in;
+            Face const face{
+                get_vertex(single, others[0]), get_vertex(single, others[1]),
+                get_vertex(single, others[2])};
+            emit(face, in[0], out[0]);
+          } else if (in_count == 2) {
+            // the quad between two inside and two outside corners
+            auto const v0 = get_vertex(in[0], out[0]),
+                       v1 = get_vertex(in[0], out[1]),
+                       v2 = get_vertex(in[1], out[1]),
+                       v3 = get_vertex(in[1], out[0]);
+            emit(Face{v0, v1, v2}, in[0], out[0]);
+            emit(Face{v0, v2, v3}, in[0], out[0]);
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+TriangleMesh SurfaceMesher::Extract(Model const &model) const {
+  Sampling sampling;
+  sampling.h = model.GetGlobal().FieldWrap<Real>("smoothing_scale");
+  sampling.spacing = cell_size_ * sampling.h;
+  sampling.threshold = threshold_;
+
+  Real const block_diameter =
+      static_cast<Real>(kBlockSize) * sampling.spacing;
+  sampling.reach =
+      static_cast<int32_t>(std::ceil(2 * sampling.h / block_diameter));
+
+  auto const particles = CollectParticles(model, block_diameter);
+
+  // the blocks within the support of the kernel around any particle, phi is
+  // positive everywhere else
+  std::vector<Block> blocks;
+  int32_t const reach = sampling.reach;
+  for (auto const &block : particles.blocks)
+    for (int32_t oz = -reach; oz <= reach; ++oz)
+      for (int32_t oy = -reach; oy <= reach; ++oy)
+        for (int32_t ox = -reach; ox <= reach; ++ox)
+          blocks.push_back(
+              Block{block[0] + ox, block[1] + oy, block[2] + oz});
+  std::sort(blocks.begin(), blocks.end(), morton_order_fn{});
+  blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+
+  std::vector<BlockMesh> block_meshes(blocks.size());
+  auto const block_count = static_cast<std::ptrdiff_t>(blocks.size());
+
+#pragma omp parallel default(none)                                             \
+    shared(sampling, particles, blocks, block_meshes, block_count)
+  {
+    std::vector<Real> phi;
+    std::vector<int32_t> vertex_index;
+
+#pragma omp for schedule(dynamic)
+    for (std::ptrdiff_t i = 0; i < block_count; ++i) {
+      auto const &block = blocks[static_cast<size_t>(i)];
+      if (SampleBlock(sampling, particles, block, phi))
+        TriangulateBlock(
+            sampling, block, phi, vertex_index,
+            block_meshes[static_cast<size_t>(i)]);
+    }
+  }
+
+  // the vertices on the faces of the blocks exist in both blocks, the first
+  // occurrence (in Morton order of the blocks) is kept
+  std::vector<std::pair<uint64_t, size_t>> keys;
+  std::vector<size_t> vertex_offsets{0};
+  for (auto const &mesh : block_meshes) {
+    for (auto const key : mesh.keys)
+      keys.emplace_back(key, keys.size());
+    vertex_offsets.push_back(keys.size());
+  }
+  std::sort(keys.begin(), keys.end());
+
+  std::vector<size_t> representative(keys.size());
+  std::vector<uint8_t> is_representative(keys.size(), 0);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (i == 0 or keys[i].first != keys[i - 1].first)
+      is_representative[keys[i].second] = 1;
+    representative[keys[i].second] =
+        (i == 0 or keys[i].first != keys[i - 1].first)
+            ? keys[i].second
+            : representative[keys[i - 1].second];
+  }
+
+  RVec3 offset = math::zeros<Real, 3>();
+  if (auto const origin = model.GetPositionOrigin(); origin.size() == 3)
+    offset = RVec3{origin[0], origin[1], origin[2]};
+
+  std::vector<RVec3> vertices;
+  std::vector<TriangleMesh::index_type> new_index(keys.size());
+  for (size_t b = 0; b < block_meshes.size(); ++b) {
+    auto const &mesh = block_meshes[b];
+    for (size_t v = 0; v < mesh.vertices.size(); ++v) {
+      auto const global = vertex_offsets[b] + v;
+      if (is_representative[global]) {
+        new_index[global] =
+            static_cast<TriangleMesh::index_type>(vertices.size());
+        vertices.push_back(mesh.vertices[v] + offset);
+      }
+    }
+  }
+
+  std::vector<Face> faces;
+  for (size_t b = 0; b < block_meshes.size(); ++b) {
+    for (auto face : block_meshes[b].faces) {
+      for (auto &index : face)
+        index = new_index[representative[vertex_offsets[b] + index]];
+      faces.push_back(face);
+    }
+  }
+
+  log::Debug(
+      "lib", "SurfaceMesher", "extracted ", vertices.size(), " vertices and ",
+      faces.size(), " faces from ", blocks.size(), " blocks around ",
+      particles.x[0].size(), " particles");
+
+  return TriangleMesh{std::move(vertices), std::move(faces)};
+}
+
+} // namespace prtcl
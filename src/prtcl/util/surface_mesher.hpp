@@ -0,0 +1,60 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_SURFACE_MESHER_HPP
+#define PRTCL_SRC_PRTCL_UTIL_SURFACE_MESHER_HPP
+
+#include "../data/model.hpp"
+#include "../geometry/triangle_mesh.hpp"
+
+#include <cstddef>
+
+namespace prtcl {
+
+//! Extracts a triangle mesh of the surface of the visible particles, the
+//! zero level set of the implicit function of SphereTracer,
+//! phi(x) = threshold * W(0, h) - sum_j W(|x - x_j|, h).
+//!
+//! The implicit function is sampled on a grid of spacing cell_size * h that
+//! is split into blocks of kBlockSize^3 cells.  Only the blocks within the
+//! support of the kernel around the particles are visited, sorted along the
+//! z-curve and processed in parallel.  Each particle adds its kernel to the
+//! samples of a block within its support, and the blocks without a sign
+//! change are skipped.  The cells of the others are split into six
+//! tetrahedra along their main diagonal (marching tetrahedra), which yields a
+//! closed mesh without the ambiguous cases of the marching cubes table.
+//! Vertices on the same edge of the grid are shared, also between blocks.
+//!
+//! The particles are bucketed into the blocks by their own Morton sort
+//! instead of the grid of a Neighborhood: the mesher works on frames that
+//! were only loaded (like SphereTracer), it visits only the visible groups,
+//! and it needs all particles of a block at once, which the position query of
+//! Neighborhood::CopyNeighbors would return again for each sample.
+class SurfaceMesher {
+public:
+  using Real = double;
+
+  //! Number of cells of a block along each axis.
+  static constexpr size_t kBlockSize = 8;
+
+public:
+  //! Extracts the surface of the visible groups of the model, the vertices
+  //! are absolute positions.
+  TriangleMesh Extract(Model const &model) const;
+
+public:
+  Real GetThreshold() const { return threshold_; }
+
+  void SetThreshold(Real value) { threshold_ = value; }
+
+  //! The spacing of the samples in multiples of the smoothing scale.
+  Real GetCellSize() const { return cell_size_; }
+
+  void SetCellSize(Real value) { cell_size_ = value; }
+
+private:
+  // the default of SphereTracer
+  Real threshold_ = 0.5;
+  Real cell_size_ = 0.5;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_SURFACE_MESHER_HPP
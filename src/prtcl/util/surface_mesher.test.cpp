@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include "surface_mesher.hpp"
+
+#include <map>
+#include <utility>
+
+#include <cmath>
+
+using namespace prtcl;
+
+TEST(SurfaceMesher, ClosedMeshOfSphere) {
+  constexpr double kSmoothingScale = 0.025, kRadius = 0.3;
+
+  Model model;
+  model.AddGlobalFieldImpl<float>("smoothing_scale") =
+      static_cast<float>(kSmoothingScale);
+  auto &group = model.AddGroup("f", "fluid");
+  group.AddTag("visible");
+
+  auto const n = static_cast<int>(kRadius / kSmoothingScale);
+  std::vector<TensorT<float, 3>> positions;
+  for (int i = -n; i <= n; ++i)
+    for (int j = -n; j <= n; ++j)
+      for (int k = -n; k <= n; ++k)
+        if (i * i + j * j + k * k <= n * n)
+          positions.push_back(TensorT<float, 3>{
+              static_cast<float>(i * kSmoothingScale + 1),
+              static_cast<float>(j * kSmoothingScale),
+              static_cast<float>(k * kSmoothingScale - 1)});
+
+  group.CreateItems(positions.size());
+  auto x = group.AddVaryingFieldImpl<float, 3>("position");
+  for (size_t i = 0; i < positions.size(); ++i)
+    x[i] = positions[i];
+
+  SurfaceMesher mesher;
+  auto const mesh = mesher.Extract(model);
+  ASSERT_GT(mesh.Faces().size(), 0);
+
+  // every directed edge occurs once and its reverse occurs once, i.e. the
+  // mesh is closed and consistently oriented, also across blocks
+  std::map<std::pair<size_t, size_t>, size_t> edges;
+  for (auto const &face : mesh.Faces())
+    for (size_t c = 0; c < 3; ++c)
+      ++edges[{face[c], face[(c + 1) % 3]}];
+  for (auto const &[edge, count] : edges) {
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(edges.count({edge.second, edge.first}), 1);
+  }
+
+  TensorT<double, 3> const center{1, 0, -1};
+  for (auto const &vertex : mesh.Vertices())
+    EXPECT_NEAR(math::norm(vertex - center), kRadius, 2 * kSmoothingScale);
+
+  // the enclosed volume is positive for outward facing normals
+  double volume = 0;
+  auto const &v = mesh.Vertices();
+  for (auto const &face : mesh.Faces())
+    volume += math::dot(
+                  v[face[0]] - center,
+                  math::cross(v[face[1]] - center, v[face[2]] - center)) /
+              6;
+  EXPECT_NEAR(volume, 4. / 3 * M_PI * std::pow(kRadius, 3), 0.15 * volume);
+}
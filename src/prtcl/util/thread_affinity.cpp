@@ -0,0 +1,95 @@
+#include "thread_affinity.hpp"
+
+#include "../log.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <omp.h>
+
+namespace prtcl {
+
+namespace {
+
+// the process affinity mask before the threads were pinned
+std::mutex process_mask_mutex;
+cpu_set_t process_mask;
+bool has_process_mask = false;
+
+} // namespace
+
+ThreadAffinity ApplyThreadAffinityPolicy(bool allow_pinning) {
+  if (omp_get_proc_bind() != omp_proc_bind_false) {
+    log::Info(
+        "lib", "ThreadAffinity", "OpenMP threads are bound by the runtime (",
+        omp_get_num_places(), " places)");
+    return ThreadAffinity::kRuntime;
+  }
+
+  if (auto const *env = std::getenv("PRTCL_PIN_THREADS");
+      env and std::string_view{env} == "0")
+    allow_pinning = false;
+
+  std::vector<size_t> cpus;
+  if (allow_pinning) {
+    std::lock_guard lock{process_mask_mutex};
+    // the mask of this thread is pinned after the first call
+    if (not has_process_mask) {
+      CPU_ZERO(&process_mask);
+      has_process_mask =
+          0 == sched_getaffinity(0, sizeof(process_mask), &process_mask);
+    }
+    if (has_process_mask) {
+      for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        if (CPU_ISSET(cpu, &process_mask))
+          cpus.push_back(cpu);
+    }
+  }
+
+  if (cpus.empty()) {
+    log::Warning(
+        "lib", "ThreadAffinity",
+        "OpenMP threads are not bound, set OMP_PROC_BIND and OMP_PLACES for "
+        "NUMA-local memory accesses");
+    return ThreadAffinity::kUnbound;
+  }
+
+  std::atomic<bool> failed = false;
+#pragma omp parallel
+  {
+    auto const thread = static_cast<size_t>(omp_get_thread_num());
+
+    cpu_set_t thread_mask;
+    CPU_ZERO(&thread_mask);
+    CPU_SET(cpus[thread % cpus.size()], &thread_mask);
+    if (0 != pthread_setaffinity_np(
+                 pthread_self(), sizeof(thread_mask), &thread_mask))
+      failed = true;
+  }
+
+  if (failed) {
+    log::Warning("lib", "ThreadAffinity", "failed to pin OpenMP threads");
+#pragma omp parallel
+    ApplyProcessAffinity();
+    return ThreadAffinity::kUnbound;
+  }
+
+  log::Info(
+      "lib", "ThreadAffinity", "pinned ", omp_get_max_threads(),
+      " OpenMP threads to ", cpus.size(), " cpus");
+  return ThreadAffinity::kPinned;
+}
+
+void ApplyProcessAffinity() {
+  std::lock_guard lock{process_mask_mutex};
+  if (has_process_mask)
+    pthread_setaffinity_np(pthread_self(), sizeof(process_mask), &process_mask);
+}
+
+} // namespace prtcl
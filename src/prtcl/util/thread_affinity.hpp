@@ -0,0 +1,40 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_THREAD_AFFINITY_HPP
+#define PRTCL_SRC_PRTCL_UTIL_THREAD_AFFINITY_HPP
+
+namespace prtcl {
+
+//! Thread-affinity policy
+//!
+//! The storage of particle fields is first touched with the static partition
+//! of the OpenMP loops (see FirstTouchAllocator).  This only keeps memory
+//! accesses local if each OpenMP thread stays on one core for the whole run.
+//! Therefore the threads must be bound, preferably by the OpenMP runtime
+//! (e.g. OMP_PROC_BIND=close OMP_PLACES=cores, or spread to use the memory
+//! bandwidth of all sockets with fewer threads).  If the runtime does not bind
+//! the threads, ApplyThreadAffinityPolicy pins OpenMP thread i to the i-th
+//! cpu of the process affinity mask instead.  This includes the initial
+//! thread (thread 0), so threads that are created later by the initial thread
+//! (e.g. the workers of the BatchRenderer) must call ApplyProcessAffinity
+//! before they start to work, otherwise they all inherit its single cpu.
+enum class ThreadAffinity {
+  //! The threads are not bound, memory placement is not predictable.
+  kUnbound,
+  //! The threads are bound by the OpenMP runtime.
+  kRuntime,
+  //! The threads were pinned by ApplyThreadAffinityPolicy.
+  kPinned,
+};
+
+//! Applies the thread-affinity policy and returns the resulting affinity.
+//! Pinning can be disabled by passing false or by setting the environment
+//! variable PRTCL_PIN_THREADS=0.
+ThreadAffinity ApplyThreadAffinityPolicy(bool allow_pinning = true);
+
+//! Gives the calling thread the process affinity mask that was saved before
+//! ApplyThreadAffinityPolicy pinned the OpenMP threads.  Does nothing if the
+//! threads were not pinned.
+void ApplyProcessAffinity();
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_THREAD_AFFINITY_HPP
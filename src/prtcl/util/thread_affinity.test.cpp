@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "thread_affinity.hpp"
+
+#include <thread>
+
+#include <sched.h>
+
+using namespace prtcl;
+
+TEST(ThreadAffinity, RestoresProcessMask) {
+  cpu_set_t before;
+  CPU_ZERO(&before);
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(before), &before));
+
+  auto const affinity = ApplyThreadAffinityPolicy();
+
+  // threads created after pinning get the process mask back explicitly
+  cpu_set_t after;
+  CPU_ZERO(&after);
+  std::thread{[&after] {
+    ApplyProcessAffinity();
+    sched_getaffinity(0, sizeof(after), &after);
+  }}.join();
+  ASSERT_TRUE(CPU_EQUAL(&before, &after));
+
+  if (affinity == ThreadAffinity::kPinned) {
+    // the calling thread is pinned as well
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(pinned), &pinned));
+    ASSERT_EQ(1, CPU_COUNT(&pinned));
+  }
+
+  ApplyProcessAffinity();
+}
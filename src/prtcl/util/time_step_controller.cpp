@@ -0,0 +1,176 @@
+#include "time_step_controller.hpp"
+
+#include "../log.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <cmath>
+
+namespace prtcl {
+
+namespace {
+
+constexpr auto kInfinity = std::numeric_limits<double>::infinity();
+
+//! Returns the value of the global field or zero if it does not exist.
+double GetGlobalOrZero(Model const &model, std::string_view name) {
+  auto const &global = model.GetGlobal();
+  if (not global.HasField(name))
+    return 0;
+  return global.FieldWrap<double>(name).Get();
+}
+
+//! Returns the largest norm of the velocities of the dynamic groups.
+double GetMaximumVelocityNorm(Model &model) {
+  constexpr size_t kChunkSize = 1024;
+
+  double max_norm_sq = 0;
+  std::vector<double> values;
+  for (auto &group : model.GetGroups()) {
+    if (not group.HasTag("dynamic") or
+        not group.GetVarying().HasField("velocity"))
+      continue;
+
+    auto const field = group.GetVaryingField("velocity");
+    auto const components = field.GetType().GetComponentCount();
+    auto const item_count = field.GetSize();
+    for (size_t first = 0; first < item_count; first += kChunkSize) {
+      auto const count = std::min(kChunkSize, item_count - first);
+      values.resize(count * components);
+      field.GetRealRange(first, count, values.data());
+      for (size_t item = 0; item < count; ++item) {
+        double norm_sq = 0;
+        for (size_t c = 0; c < components; ++c)
+          norm_sq += values[item * components + c] *
+                     values[item * components + c];
+        max_norm_sq = std::max(max_norm_sq, norm_sq);
+      }
+    }
+  }
+  return std::sqrt(max_norm_sq);
+}
+
+//! Returns the norm of the global field gravity or zero if it does not exist.
+double GetGravityNorm(Model const &model) {
+  for (auto const &[name, field] : model.GetGlobal().GetNamedFields()) {
+    if (name != "gravity")
+      continue;
+
+    RealVector value;
+    field.Get(value);
+    return value.norm();
+  }
+  return 0;
+}
+
+} // namespace
+
+auto TimeStepController::ComputeTimeStep(Model &model) -> Real {
+  auto const h = GetGlobalOrZero(model, "smoothing_scale");
+  auto max_speed = GetGlobalOrZero(model, "maximum_speed");
+  auto max_accel = GetGlobalOrZero(model, "maximum_acceleration");
+
+  // nothing was reduced before the first step, start from the initial
+  // velocities and gravity instead
+  if (not smoothed_) {
+    max_speed = std::max(max_speed, GetMaximumVelocityNorm(model));
+    max_accel = std::max(max_accel, GetGravityNorm(model));
+  }
+
+  limits_.cfl = max_speed > 0 ? cfl_number_ * h / max_speed : kInfinity;
+  limits_.force =
+      max_accel > 0 ? force_number_ * std::sqrt(h / max_accel) : kInfinity;
+
+  // the largest kinematic viscosity of the dynamic groups
+  Real max_nu = 0;
+  for (auto const &group : model.GetGroups()) {
+    auto const &uniform = group.GetUniform();
+    if (not group.HasTag("dynamic") or
+        not uniform.HasField("dynamic_viscosity") or
+        not uniform.HasField("rest_density"))
+      continue;
+    auto const mu = uniform.FieldWrap<double>("dynamic_viscosity").Get();
+    auto const rho0 = uniform.FieldWrap<double>("rest_density").Get();
+    if (rho0 > 0)
+      max_nu = std::max(max_nu, mu / rho0);
+  }
+  limits_.viscosity = viscosity_number_ > 0 and max_nu > 0
+                          ? viscosity_number_ * h * h / max_nu
+                          : kInfinity;
+
+  auto const limit = std::min({limits_.cfl, limits_.force, limits_.viscosity});
+  if (limit < min_time_step_)
+    log::Warning(
+        "lib", "TimeStepController", "min_time_step=", min_time_step_,
+        " exceeds the limits cfl=", limits_.cfl, " force=", limits_.force,
+        " viscosity=", limits_.viscosity);
+
+  auto target = std::min(limit, max_time_step_);
+
+  // grow slowly, but shrink immediately
+  if (smoothed_)
+    target = std::min(target, max_growth_ * *smoothed_);
+
+  smoothed_ = std::clamp(target, min_time_step_, max_time_step_);
+  return *smoothed_;
+}
+
+void TimeStepController::StoreTimeStep(Model &model, Real time_step) {
+  time_step_ = time_step;
+
+  // the fields exist once the schemes are loaded, in their precision
+  auto const &global = model.GetGlobal();
+  if (global.HasField("time_step"))
+    global.FieldWrap<double>("time_step").Set(time_step);
+
+  // reduce the maxima of the next step from scratch
+  for (auto name : {"maximum_speed", "maximum_acceleration"})
+    if (global.HasField(name))
+      global.FieldWrap<double>(name).Set(0);
+
+  log::Debug(
+      "lib", "TimeStepController", "time_step=", time_step,
+      " cfl=", limits_.cfl, " force=", limits_.force,
+      " viscosity=", limits_.viscosity);
+}
+
+auto TimeStepController::Update(Model &model) -> Real {
+  auto const time_step = ComputeTimeStep(model);
+  aligned_to_.reset();
+  StoreTimeStep(model, time_step);
+  return time_step;
+}
+
+auto TimeStepController::Update(Model &model, VirtualScheduler &scheduler)
+    -> Real {
+  auto time_step = ComputeTimeStep(model);
+  aligned_to_.reset();
+
+  auto const now = scheduler.GetClock().now();
+  if (auto const next = scheduler.GetNextTime(); next and *next > now) {
+    auto const remaining = (*next - now).count();
+    if (remaining <= time_step) {
+      // end exactly at the task
+      time_step = remaining;
+      aligned_to_ = *next;
+    } else if (remaining < 2 * time_step) {
+      // avoid a sliver of a step right before the task
+      time_step = remaining / 2;
+    }
+  }
+
+  StoreTimeStep(model, time_step);
+  return time_step;
+}
+
+void TimeStepController::Advance(VirtualScheduler &scheduler) const {
+  auto clock = scheduler.GetClockPtr();
+  if (aligned_to_)
+    clock->set(*aligned_to_);
+  else
+    clock->advance(time_step_);
+}
+
+} // namespace prtcl
@@ -0,0 +1,109 @@
+#ifndef PRTCL_SRC_PRTCL_UTIL_TIME_STEP_CONTROLLER_HPP
+#define PRTCL_SRC_PRTCL_UTIL_TIME_STEP_CONTROLLER_HPP
+
+#include "../data/model.hpp"
+#include "scheduler.hpp"
+
+#include <optional>
+
+namespace prtcl {
+
+//! Chooses the global time_step from the state of the previous step.
+//!
+//! The time step is the smallest of the limits
+//!   CFL:       cfl_number * h / maximum_speed,
+//!   force:     force_number * sqrt(h / maximum_acceleration),
+//!   viscosity: viscosity_number * h^2 / max(dynamic_viscosity / rest_density),
+//! and max_time_step.  The maxima are reduced by the symplectic_euler scheme
+//! during integrate_velocity* and integrate_position, Update resets them
+//! after reading.  Before the first step nothing was reduced, so the first
+//! Update also takes the velocities of the dynamic groups and the norm of the
+//! global gravity into account.  The viscosity limit covers the dynamic
+//! groups with both uniform fields, a viscosity_number of zero disables it
+//! (e.g. for implicit viscosity).  The time step grows by at most max_growth
+//! per step but shrinks immediately, and is shortened to end exactly at the
+//! next task of a scheduler, e.g. the next output frame.
+class TimeStepController {
+public:
+  using Real = double;
+  using Duration = typename VirtualScheduler::Duration;
+  using TimePoint = typename VirtualScheduler::TimePoint;
+
+  struct Limits {
+    Real cfl, force, viscosity;
+  };
+
+public:
+  //! Computes the time step, stores it in the global field time_step (if it
+  //! exists), resets the reduced maxima and returns the time step.
+  Real Update(Model &model);
+
+  //! Like Update(model) but the time step ends at the next task of the
+  //! scheduler if that is due within the next two steps, the remaining time
+  //! is then split into one or two equal steps.
+  Real Update(Model &model, VirtualScheduler &scheduler);
+
+  //! Advances the clock of the scheduler to the end of the last time step,
+  //! exactly onto the due time of the task it was aligned to.
+  void Advance(VirtualScheduler &scheduler) const;
+
+public:
+  //! The limits of the last Update (infinite if they do not apply).
+  Limits const &GetLimits() const { return limits_; }
+
+  //! The last time step, zero before the first Update.
+  Real GetTimeStep() const { return time_step_; }
+
+  Real GetCFLNumber() const { return cfl_number_; }
+
+  void SetCFLNumber(Real value) { cfl_number_ = value; }
+
+  Real GetForceNumber() const { return force_number_; }
+
+  void SetForceNumber(Real value) { force_number_ = value; }
+
+  Real GetViscosityNumber() const { return viscosity_number_; }
+
+  void SetViscosityNumber(Real value) { viscosity_number_ = value; }
+
+  //! The time step never falls below this, a warning is logged if one of the
+  //! limits is smaller.
+  Real GetMinTimeStep() const { return min_time_step_; }
+
+  void SetMinTimeStep(Real value) { min_time_step_ = value; }
+
+  Real GetMaxTimeStep() const { return max_time_step_; }
+
+  void SetMaxTimeStep(Real value) { max_time_step_ = value; }
+
+  //! The largest factor by which the time step grows from one step to the
+  //! next.
+  Real GetMaxGrowth() const { return max_growth_; }
+
+  void SetMaxGrowth(Real value) { max_growth_ = value; }
+
+private:
+  //! Computes the limits and returns the smoothed time step.
+  Real ComputeTimeStep(Model &model);
+
+  void StoreTimeStep(Model &model, Real time_step);
+
+private:
+  Real cfl_number_ = 0.4;
+  Real force_number_ = 0.25;
+  Real viscosity_number_ = 0.125;
+  Real min_time_step_ = 1e-6;
+  Real max_time_step_ = 0.01;
+  Real max_growth_ = 1.1;
+
+  Limits limits_;
+  Real time_step_ = 0;
+  //! The smoothed time step before it was aligned to the scheduler.
+  std::optional<Real> smoothed_;
+  //! The due time of the task that the last time step was aligned to.
+  std::optional<TimePoint> aligned_to_;
+};
+
+} // namespace prtcl
+
+#endif // PRTCL_SRC_PRTCL_UTIL_TIME_STEP_CONTROLLER_HPP
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include "time_step_controller.hpp"
+
+#include <cmath>
+
+using namespace prtcl;
+
+namespace {
+
+struct Fields {
+  UniformFieldSpan<float> time_step, max_speed, max_accel, mu;
+};
+
+Fields AddFields(Model &model) {
+  model.AddGlobalFieldImpl<float>("smoothing_scale") = 0.1f;
+  auto &group = model.AddGroup("f", "fluid");
+  group.AddTag("dynamic");
+  group.AddUniformFieldImpl<float>("rest_density") = 1000;
+  auto mu = group.AddUniformFieldImpl<float>("dynamic_viscosity");
+  *mu = 0;
+  Fields fields{
+      model.AddGlobalFieldImpl<float>("time_step"),
+      model.AddGlobalFieldImpl<float>("maximum_speed"),
+      model.AddGlobalFieldImpl<float>("maximum_acceleration"), mu};
+  // new fields are not initialized
+  *fields.max_speed = 0;
+  *fields.max_accel = 0;
+  return fields;
+}
+
+} // namespace
+
+TEST(TimeStepController, Limits) {
+  Model model;
+  auto fields = AddFields(model);
+
+  TimeStepController controller;
+  controller.SetMaxTimeStep(1);
+  controller.SetMaxGrowth(2);
+
+  // at rest the time step is only bounded by max_time_step
+  EXPECT_DOUBLE_EQ(controller.Update(model), 1);
+  EXPECT_TRUE(std::isinf(controller.GetLimits().cfl));
+
+  // CFL: 0.4 * 0.1 / 2
+  *fields.max_speed = 2;
+  *fields.max_accel = 1;
+  EXPECT_NEAR(controller.Update(model), 0.02, 1e-7);
+  EXPECT_NEAR(*fields.time_step, 0.02, 1e-7);
+  EXPECT_NEAR(controller.GetLimits().force, 0.25 * std::sqrt(0.1), 1e-7);
+  // the maxima are reduced from scratch in the next step
+  EXPECT_EQ(*fields.max_speed, 0);
+  EXPECT_EQ(*fields.max_accel, 0);
+
+  // force: 0.25 * sqrt(0.1 / 1000), shrinks immediately
+  *fields.max_accel = 1000;
+  EXPECT_NEAR(controller.Update(model), 0.25 * 0.01, 1e-7);
+
+  // viscosity: 0.125 * 0.1^2 / (100 / 1000), limited by the growth of 2
+  *fields.mu = 100;
+  EXPECT_NEAR(controller.Update(model), 0.005, 1e-7);
+  EXPECT_NEAR(controller.GetLimits().viscosity, 0.0125, 1e-7);
+  EXPECT_NEAR(controller.Update(model), 0.01, 1e-7);
+  EXPECT_NEAR(controller.Update(model), 0.0125, 1e-7);
+
+  controller.SetViscosityNumber(0);
+  controller.SetMinTimeStep(0.5);
+  EXPECT_DOUBLE_EQ(controller.Update(model), 0.5);
+}
+
+TEST(TimeStepController, AlignsToScheduler) {
+  Model model;
+  auto fields = AddFields(model);
+
+  TimeStepController controller;
+  controller.SetMaxTimeStep(0.03);
+
+  // output frames every 0.1 seconds
+  VirtualScheduler scheduler;
+  size_t frames = 0;
+  scheduler.ScheduleAfter(VirtualScheduler::Duration{0.1}, [&](auto &s, auto) {
+    ++frames;
+    return s.RescheduleAfter(0.1);
+  });
+
+  // 0.03, 0.03, 0.02 and 0.02 until the first frame
+  for (double expected : {0.03, 0.03, 0.02, 0.02}) {
+    EXPECT_NEAR(controller.Update(model, scheduler), expected, 1e-12);
+    controller.Advance(scheduler);
+    scheduler.Tick();
+  }
+  EXPECT_EQ(frames, 1);
+  // the clock lands exactly on the frame
+  EXPECT_EQ(
+      scheduler.GetClock().now().time_since_epoch().count(), 0.1);
+
+  for (size_t step = 0; step < 1000; ++step) {
+    *fields.max_speed =
+        static_cast<float>(1 + std::sin(0.1 * static_cast<double>(step)));
+    controller.Update(model, scheduler);
+    controller.Advance(scheduler);
+    scheduler.Tick();
+  }
+  auto const now = scheduler.GetClock().now().time_since_epoch().count();
+  EXPECT_EQ(frames, static_cast<size_t>(std::floor(now / 0.1 + 1e-9)));
+}
+
+TEST(TimeStepController, FirstStepFromInitialState) {
+  Model model;
+  auto fields = AddFields(model);
+
+  auto &group = *model.TryGetGroup("f");
+  group.CreateItems(2);
+  auto v = group.AddVaryingFieldImpl<float, 3>("velocity");
+  v[0] = math::Tensor<float, 3>{0, 0, 0};
+  v[1] = math::Tensor<float, 3>{0, 4, 0};
+
+  TimeStepController controller;
+  controller.SetMaxTimeStep(1);
+
+  // CFL from the initial velocities: 0.4 * 0.1 / 4
+  EXPECT_NEAR(controller.Update(model), 0.01, 1e-7);
+
+  // later steps only use the reduced maxima (and grow by 1.1)
+  EXPECT_NEAR(controller.Update(model), 0.011, 1e-7);
+
+  // gravity: 0.25 * sqrt(0.1 / 10)
+  auto g = model.AddGlobalFieldImpl<float, 3>("gravity");
+  *g = math::Tensor<float, 3>{0, -10, 0};
+  TimeStepController other;
+  other.SetMaxTimeStep(1);
+  v[1] = math::Tensor<float, 3>{0, 0, 0};
+  EXPECT_NEAR(other.Update(model), 0.025, 1e-7);
+  EXPECT_EQ(*fields.max_speed, 0);
+}